@@ -0,0 +1,118 @@
+/**
+ * @file acqplan.cpp
+ * @author Riccardo Iacob
+ * @brief Multi-rate acquisition planner grouping the due channels into forced conversions
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "acqplan.h"
+
+AcquisitionPlanner::AcquisitionPlanner()
+{
+    for (uint8_t c = 0; c < CHANNELS; c++)
+    {
+        periods[c] = 0;
+        due[c] = 0;
+    }
+    forced = 0;
+    conversions = 0;
+    skippedReadings = 0;
+}
+
+void AcquisitionPlanner::setPeriod(uint8_t channel, uint16_t seconds)
+{
+    if (channel < CHANNELS)
+    {
+        periods[channel] = seconds;
+        due[channel] = 0;
+    }
+}
+
+void AcquisitionPlanner::setForced(uint8_t channels)
+{
+    forced = channels;
+}
+
+uint16_t AcquisitionPlanner::getPeriod(uint8_t channel)
+{
+    return channel < CHANNELS ? periods[channel] : 0;
+}
+
+bool AcquisitionPlanner::isDue(uint8_t channel, uint32_t now)
+{
+    // A due time more than a period ahead means the clock was set back: due now
+    return periods[channel] == 0 || (forced & (1 << channel)) || (int32_t)(now - due[channel]) >= 0 || due[channel] - now > periods[channel];
+}
+
+uint8_t AcquisitionPlanner::plan(uint32_t now, uint8_t available)
+{
+    uint8_t channels = 0;
+    for (uint8_t c = 0; c < CHANNELS; c++)
+    {
+        if ((available & (1 << c)) && isDue(c, now))
+        {
+            channels |= 1 << c;
+        }
+    }
+    if (channels & (channel_humidity | channel_pressure))
+    {
+        channels |= channel_temperature;
+    }
+    return channels;
+}
+
+void AcquisitionPlanner::commit(uint8_t channels, uint32_t now, uint8_t available)
+{
+    for (uint8_t c = 0; c < CHANNELS; c++)
+    {
+        if (!(available & (1 << c)))
+        {
+            continue;
+        }
+        if (!(channels & (1 << c)))
+        {
+            skippedReadings++;
+        }
+        else if (periods[c] != 0)
+        {
+            // Next multiple of the period, so the instants stay aligned whatever the conversion timing
+            due[c] = (now / periods[c] + 1) * periods[c];
+        }
+    }
+    conversions++;
+}
+
+uint32_t AcquisitionPlanner::getNextDue(uint32_t now, uint8_t available)
+{
+    uint32_t next = now;
+    bool found = false;
+    for (uint8_t c = 0; c < CHANNELS; c++)
+    {
+        if (!(available & (1 << c)))
+        {
+            continue;
+        }
+        if (isDue(c, now))
+        {
+            return now;
+        }
+        if (!found || (int32_t)(due[c] - next) < 0)
+        {
+            next = due[c];
+            found = true;
+        }
+    }
+    return next;
+}
+
+uint32_t AcquisitionPlanner::getConversions()
+{
+    return conversions;
+}
+
+uint32_t AcquisitionPlanner::getSkippedReadings()
+{
+    return skippedReadings;
+}
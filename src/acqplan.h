@@ -0,0 +1,112 @@
+/**
+ * @file acqplan.h
+ * @author Riccardo Iacob
+ * @brief Multi-rate acquisition planner grouping the due channels into forced conversions
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ACQPLAN_H
+#define ACQPLAN_H
+
+#include <Arduino.h>
+
+#include "sample.h"
+
+/**
+ * Each channel has its own period, in seconds (0 = every conversion). A channel is due at the
+ * multiples of its period on the wall clock, so channels with commensurate periods (3 s and 60 s)
+ * fall on the same instants and share one forced conversion, and records of different devices
+ * line up. The channels not due are written as osrs skip (gas: heater off), which shortens the
+ * conversion and the bus traffic of the readout.
+ * Pressure and humidity are compensated with the temperature of the same conversion, so a
+ * conversion measuring either always measures the temperature too.
+ * Forced channels are due on every conversion whatever their period (gas during burn-in and warm
+ * start, whose stability detector and heater schedule count on the sample period).
+ *
+ * Channel indices are the bit positions of SampleChannels: 0 temperature, 1 humidity, 2 pressure, 3 gas.
+ */
+class AcquisitionPlanner
+{
+public:
+    static const uint8_t CHANNELS = 4;
+
+private:
+    uint16_t periods[CHANNELS];
+    // Next due time of each channel, in seconds
+    uint32_t due[CHANNELS];
+    // Channels due on every conversion (SampleChannels flags)
+    uint8_t forced;
+    uint32_t conversions;
+    uint32_t skippedReadings;
+
+    bool isDue(uint8_t channel, uint32_t now);
+
+public:
+    /**
+     * @brief Constructs a new AcquisitionPlanner object, every channel on every conversion
+     */
+    AcquisitionPlanner();
+
+    /**
+     * @brief Sets the period of a channel, which becomes due immediately
+     *
+     * @param channel: The channel index
+     * @param seconds: The period in seconds, 0 for every conversion
+     */
+    void setPeriod(uint8_t channel, uint16_t seconds);
+
+    /**
+     * @brief Gets the period of a channel in seconds (0 = every conversion)
+     *
+     * @param channel: The channel index
+     */
+    uint16_t getPeriod(uint8_t channel);
+
+    /**
+     * @brief Makes channels due on every conversion, regardless of their period
+     *
+     * @param channels: The channels (SampleChannels flags), 0 to follow the periods again
+     */
+    void setForced(uint8_t channels);
+
+    /**
+     * @brief Gets the channels due for a conversion now
+     *
+     * @param now: The current time in seconds
+     * @param available: The channels that can be measured (SampleChannels flags)
+     * @return uint8_t: The channels to measure (SampleChannels flags), 0 if none is due
+     */
+    uint8_t plan(uint32_t now, uint8_t available);
+
+    /**
+     * @brief Records a started conversion, moving its channels to their next due time
+     *
+     * @param channels: The channels measured (from plan())
+     * @param now: The time passed to plan()
+     * @param available: The channels passed to plan()
+     */
+    void commit(uint8_t channels, uint32_t now, uint8_t available);
+
+    /**
+     * @brief Gets the earliest time a channel is due
+     *
+     * @param now: The current time in seconds
+     * @param available: The channels that can be measured (SampleChannels flags)
+     * @return uint32_t: The time in seconds, now if a channel is due
+     */
+    uint32_t getNextDue(uint32_t now, uint8_t available);
+
+    /**
+     * @brief Gets the number of conversions started
+     */
+    uint32_t getConversions();
+
+    /**
+     * @brief Gets the number of channel readings skipped, compared to every channel on every conversion
+     */
+    uint32_t getSkippedReadings();
+};
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file alerts.cpp
+ * @author Riccardo Iacob
+ * @brief Threshold alert rules with hysteresis and dwell
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "alerts.h"
+
+AlertEngine::AlertEngine(const Rule *ruleTable, uint8_t count)
+{
+    rules = ruleTable;
+    ruleCount = count > MAX_RULES ? MAX_RULES : count;
+    for (uint8_t i = 0; i < MAX_RULES; i++)
+    {
+        state[i] = 0;
+    }
+}
+
+void AlertEngine::evaluate(const SampleRecord *sample, DerivedMetrics *derived)
+{
+    for (uint8_t i = 0; i < ruleCount; i++)
+    {
+        Rule rule;
+        memcpy_P(&rule, &rules[i], sizeof(Rule));
+
+        int32_t value;
+        uint8_t channel;
+        switch (rule.source)
+        {
+        case source_temperature:
+        {
+            value = sample->temperature;
+            channel = channel_temperature;
+        }
+        break;
+
+        case source_humidity:
+        {
+            value = sample->humidity;
+            channel = channel_humidity;
+        }
+        break;
+
+        case source_pressure:
+        {
+            value = (int32_t)sample->pressure;
+            channel = channel_pressure;
+        }
+        break;
+
+        case source_gas:
+        {
+            value = (int32_t)sample->gasResistance;
+            channel = channel_gas;
+        }
+        break;
+
+#if FEATURE_HUMIDITY
+        case source_dew_point:
+        {
+            value = derived->getDewPoint();
+            channel = channel_temperature | channel_humidity;
+        }
+        break;
+
+        case source_abs_humidity:
+        {
+            value = derived->getAbsoluteHumidity();
+            channel = channel_temperature | channel_humidity;
+        }
+        break;
+#endif
+
+#if FEATURE_PRESSURE
+        case source_altitude:
+        {
+            value = derived->getAltitude();
+            channel = channel_pressure;
+        }
+        break;
+#endif
+
+        default:
+        {
+            continue;
+        }
+        }
+        // Only rules whose inputs are fresh in this sample
+        if ((sample->channels & channel) != channel)
+        {
+            continue;
+        }
+
+        bool below = rule.flags & rule_below;
+        bool active = state[i] & STATE_ACTIVE;
+        bool towardsChange;
+        if (!active)
+        {
+            towardsChange = below ? value < rule.threshold : value > rule.threshold;
+        }
+        else
+        {
+            towardsChange = below ? value > rule.threshold + (int32_t)rule.hysteresis
+                                  : value < rule.threshold - (int32_t)rule.hysteresis;
+        }
+
+        if (!towardsChange)
+        {
+            state[i] &= STATE_ACTIVE;
+            continue;
+        }
+        uint8_t count = (state[i] & STATE_COUNT) + 1;
+        if (count < rule.dwell)
+        {
+            state[i] = (state[i] & STATE_ACTIVE) | count;
+            continue;
+        }
+
+        active = !active;
+        state[i] = active ? STATE_ACTIVE : 0;
+        AlertEvent event = {i, active, value};
+        events.push(event);
+    }
+}
+
+uint8_t AlertEngine::getLevel()
+{
+    uint8_t level = level_none;
+    for (uint8_t i = 0; i < ruleCount; i++)
+    {
+        if (state[i] & STATE_ACTIVE)
+        {
+            uint8_t ruleLevel = pgm_read_byte(&rules[i].level);
+            if (ruleLevel > level)
+            {
+                level = ruleLevel;
+            }
+        }
+    }
+    return level;
+}
+
+bool AlertEngine::isActive(uint8_t rule)
+{
+    return rule < ruleCount && (state[rule] & STATE_ACTIVE);
+}
+
+bool AlertEngine::popEvent(AlertEvent &event)
+{
+    return events.pop(event);
+}
+
+uint16_t AlertEngine::getLostEvents()
+{
+    return events.getOverruns();
+}
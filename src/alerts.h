@@ -0,0 +1,147 @@
+/**
+ * @file alerts.h
+ * @author Riccardo Iacob
+ * @brief Threshold alert rules with hysteresis and dwell
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <Arduino.h>
+
+#include "sample.h"
+#include "derived.h"
+#include "spscqueue.h"
+#include "buildcfg.h"
+
+/**
+ * Rules live in a PROGMEM table supplied by the application. Each new sample is checked against
+ * every rule once (at most MAX_RULES, so the cost per sample is bounded); a rule only keeps one
+ * byte of state in RAM.
+ *
+ * A rule becomes active after its condition held for `dwell` consecutive samples, and clears
+ * after the value was back beyond the threshold by more than `hysteresis` for `dwell` consecutive
+ * samples. Every change is queued as an AlertEvent for the telemetry consumers.
+ * Derived metrics are only computed when a rule refers to them.
+ */
+class AlertEngine
+{
+public:
+    static const uint8_t MAX_RULES = 16;
+    static const uint8_t EVENT_QUEUE_LENGTH = 8;
+
+    /**
+     * @brief Values a rule can watch, in SampleRecord / DerivedMetrics units
+     */
+    enum Sources
+    {
+        source_temperature,  // centi-°C
+        source_humidity,     // centi-%
+        source_pressure,     // Pa
+        source_gas,          // Ohm
+        source_dew_point,    // centi-°C
+        source_abs_humidity, // centi-g/m^3
+        source_altitude      // dm
+    };
+
+    /**
+     * @brief Severity of a rule, the most severe active one selects the LED pattern
+     */
+    enum Levels
+    {
+        level_none,
+        level_info,
+        level_warning,
+        level_alarm
+    };
+
+    /**
+     * @brief Rule flags
+     */
+    enum RuleFlags
+    {
+        // Active when the value is below the threshold instead of above
+        rule_below = 0x01
+    };
+
+    /**
+     * @brief A rule, 10 bytes in PROGMEM
+     */
+    typedef struct
+    {
+        uint8_t source;
+        uint8_t flags;
+        uint8_t level;
+        // Consecutive samples needed to raise or clear, 1 to 127
+        uint8_t dwell;
+        uint16_t hysteresis;
+        int32_t threshold;
+    } Rule;
+
+    /**
+     * @brief A change of state of a rule
+     */
+    typedef struct
+    {
+        uint8_t rule;
+        bool active;
+        int32_t value;
+    } AlertEvent;
+
+private:
+    const Rule *rules;
+    uint8_t ruleCount;
+    // Per rule: bit 7 active, bits 6..0 consecutive samples counted towards a change
+    uint8_t state[MAX_RULES];
+    SpscQueue<AlertEvent, EVENT_QUEUE_LENGTH> events;
+
+    static const uint8_t STATE_ACTIVE = 0x80;
+    static const uint8_t STATE_COUNT = 0x7F;
+
+public:
+    /**
+     * @brief Constructs a new AlertEngine object
+     *
+     * @param ruleTable: The rules, in PROGMEM
+     * @param count: The number of rules (at most MAX_RULES, the rest is ignored)
+     */
+    AlertEngine(const Rule *ruleTable, uint8_t count);
+
+    /**
+     * @brief Checks a new sample against every rule
+     *
+     * @param sample: The (filtered) sample
+     * @param derived: The derived metrics of the same sample
+     */
+    void evaluate(const SampleRecord *sample, DerivedMetrics *derived);
+
+    /**
+     * @brief Gets the most severe level among the active rules
+     */
+    uint8_t getLevel();
+
+    /**
+     * @brief Checks whether a rule is active
+     *
+     * @param rule: The rule index
+     */
+    bool isActive(uint8_t rule);
+
+    /**
+     * @brief Takes the oldest queued state change
+     *
+     * @param event: Output event (written only on success)
+     * @return bool: True if an event was taken
+     */
+    bool popEvent(AlertEvent &event);
+
+    /**
+     * @brief Gets the number of events lost because the queue was full
+     */
+    uint16_t getLostEvents();
+};
+
+#endif
@@ -8,43 +8,115 @@
  * @copyright Copyright (c) 2023
  */
 #include "bme680.h"
+#include "i2cbus.h"
+
+#if FEATURE_GAS
+// Gas resistance range constants, from the Bosch Sensor API (integer variant)
+static const uint32_t gasRangeTable1[16] PROGMEM = {
+    2147483647UL, 2147483647UL, 2147483647UL, 2147483647UL, 2147483647UL, 2126008810UL, 2147483647UL, 2130303777UL,
+    2147483647UL, 2147483647UL, 2143188679UL, 2136746228UL, 2147483647UL, 2126008810UL, 2147483647UL, 2147483647UL};
+static const uint32_t gasRangeTable2[16] PROGMEM = {
+    4096000000UL, 2048000000UL, 1024000000UL, 512000000UL, 255744255UL, 127110228UL, 64000000UL, 32258064UL,
+    16016016UL, 8000000UL, 4000000UL, 2000000UL, 1000000UL, 500000UL, 250000UL, 125000UL};
+#endif
 
 BME680::BME680(uint8_t i2cAddress)
 {
     i2cAdd = i2cAddress;
+    i2cErrno = I2CBus::Errors::error_none;
+    i2cErrorCount = 0;
 }
 
-void BME680::begin()
+bool BME680::begin()
 {
-    Wire.begin();
-    // Soft reset
-    i2c_writeByte(RegisterAddresses::ADD_RESET, 255);
+    // Wire is started (with its timeout) by I2CBus
+    clearError();
+    // The reset clears the control registers
+    ctrlHum = 0xFF;
+    ctrlGas = 0xFF;
+#if FEATURE_GAS
+    heaterPoint = 0xFF;
+#endif
+    // Soft reset (takes 2 ms)
+    i2c_writeByte(RegisterAddresses::ADD_RESET, 0xB6);
+    delay(2);
     // Read chip id
-    i2c_readByte(RegisterAddresses::ADD_ID);
+    if (i2c_readByte(RegisterAddresses::ADD_ID) != BME680_CHIP_ID)
+    {
+        return false;
+    }
     // Read variant id
     i2c_readByte(RegisterAddresses::ADD_VARIANT_ID);
     // Get calibration data
     readCalibrationParameters();
+    return getError() == I2CBus::Errors::error_none;
+}
+
+uint8_t BME680::getError()
+{
+    return i2cErrno;
+}
+
+void BME680::clearError()
+{
+    i2cErrno = I2CBus::Errors::error_none;
+}
+
+uint16_t BME680::getErrorCount()
+{
+    return i2cErrorCount;
 }
 
-void BME680::i2c_writeByte(uint8_t registerAddress, uint8_t registerData)
+bool BME680::writeCached(uint8_t registerAddress, uint8_t registerData, uint8_t *cache)
+{
+    if (*cache == registerData)
+    {
+        return true;
+    }
+    bool ok = i2c_writeByte(registerAddress, registerData);
+    *cache = ok ? registerData : 0xFF;
+    return ok;
+}
+
+bool BME680::i2c_writeByte(uint8_t registerAddress, uint8_t registerData)
 {
     Wire.beginTransmission(i2cAdd);
     Wire.write(registerAddress);
     Wire.write(registerData);
-    i2cErrno = Wire.endTransmission(true);
+    uint8_t result = Wire.endTransmission(true);
+    if (result != I2CBus::Errors::error_none)
+    {
+        i2cErrorCount++;
+        if (i2cErrno == I2CBus::Errors::error_none)
+        {
+            i2cErrno = result;
+        }
+        return false;
+    }
+    return true;
 }
 
 uint8_t BME680::i2c_readByte(uint8_t registerAddress)
 {
-    uint8_t byte;
     Wire.beginTransmission(i2cAdd);
     Wire.write(registerAddress);
-    i2cErrno = Wire.endTransmission(true);
-    Wire.requestFrom(i2cAdd, 1, true);
+    uint8_t result = Wire.endTransmission(true);
+    // requestFrom() returns the bytes actually received, 0 after a NACK or a timeout
+    if (result == I2CBus::Errors::error_none && Wire.requestFrom(i2cAdd, (uint8_t)1, (uint8_t) true) != 1)
+    {
+        result = Wire.getWireTimeoutFlag() ? I2CBus::Errors::error_timeout : I2CBus::Errors::error_address_nack;
+    }
+    if (result != I2CBus::Errors::error_none)
+    {
+        i2cErrorCount++;
+        if (i2cErrno == I2CBus::Errors::error_none)
+        {
+            i2cErrno = result;
+        }
+        return 0;
+    }
     delayMicroseconds(i2cReadDelayMicros);
-    byte = Wire.read();
-    return byte;
+    return Wire.read();
 }
 
 void BME680::setConfig(BMEConfig *cfg)
@@ -58,32 +130,115 @@ void BME680::setDefaultConfig()
     config->osrs_p = OversamplingMultipliers::orsrs_x16;
     config->osrs_t = OversamplingMultipliers::orsrs_x16;
     config->filter = FilterCoefficients::filter_127;
+#if FEATURE_GAS
     config->run_gas = true;
+    config->target_temp = 320;
     config->set_point = HeaterSetPoints::point_0;
+    // 25 x 4 = 100 ms on every set point
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        config->set_point_cfg[i].gas_wait = GasWaitMillis::millis_25;
+        config->set_point_cfg[i].gas_wait_multiplier = HeaterTimeMultipliers::time_x4;
+    }
+#endif
 }
 
-uint8_t BME680::calculateHeaterResistance(double targetTemp, double ambientTemp)
+bool BME680::applyConfig()
 {
-    // Calculate the heater resistance based on calibration parameters and desired temperature range
-    // Refer to BME680 datasheet for further details on this operation
-    float var1 = (calibration->par_t1 / 16) + 49.0;
-    float var2 = ((calibration->par_t2 / 32768.0) * 0.0005) + 0.00235;
-    float var3 = calibration->par_t3 / 1024.0;
-    float var4 = var1 * (1.0 + (var2 * targetTemp));
-    float var5 = var4 + (var3 * ambientTemp);
-    return (3.4 * ((var5 * (4.0 / calibration->res_heat_range)) * (1.0 / (1.0 + calibration->res_heat_val * 0.002)) - 25));
+    bool ok = true;
+    // ctrl_hum: osrs_h<2:0> (skipped when humidity is compiled out); always written
+    ctrlHum = 0xFF;
+    ok &= writeCached(RegisterAddresses::ADD_CTRL_HUM, FEATURE_HUMIDITY ? (uint8_t)config->osrs_h & 0x07 : 0, &ctrlHum);
+    // config: filter<4:2>
+    ok &= i2c_writeByte(RegisterAddresses::ADD_CONFIG, ((uint8_t)config->filter & 0x07) << 2);
+    // Heater profile of the selected set point and ctrl_gas_1 (heater off when gas is compiled out)
+    ctrlGas = 0xFF;
+#if FEATURE_GAS
+    ok &= applyHeater(config->set_point, config->target_temp < 0 ? 0 : (uint16_t)config->target_temp, heaterAmbient);
+#else
+    ok &= writeCached(RegisterAddresses::ADD_CTRL_GAS_1, 0x00, &ctrlGas);
+#endif
+    return ok;
+}
+
+#if FEATURE_GAS
+bool BME680::applyHeater(uint8_t point, uint16_t targetTemp, int8_t ambientTemp)
+{
+    if (point > (uint8_t)HeaterSetPoints::point_9)
+    {
+        point = (uint8_t)HeaterSetPoints::point_9;
+    }
+    targetTemp = targetTemp > 400 ? 400 : targetTemp;
+    bool ok = true;
+    ok &= i2c_writeByte(RegisterAddresses::ADD_RES_HEAT_0 + point, calculateHeaterResistance(targetTemp, ambientTemp));
+    ok &= i2c_writeByte(RegisterAddresses::ADD_GAS_WAIT_0 + point, encodeGasWait(&config->set_point_cfg[point]));
+    // ctrl_gas_1: run_gas<4>, nb_conv<3:0>
+    ok &= writeCached(RegisterAddresses::ADD_CTRL_GAS_1, (config->run_gas ? 0x10 : 0x00) | (point & 0x0F), &ctrlGas);
+    // A failed write is retried by the next call
+    heaterPoint = ok ? point : 0xFF;
+    heaterTemp = targetTemp;
+    heaterAmbient = ambientTemp;
+    return ok;
+}
+
+uint8_t BME680::getHeaterPoint()
+{
+    return heaterPoint;
+}
+
+uint16_t BME680::getHeaterTemp()
+{
+    return heaterTemp;
+}
+
+int8_t BME680::getHeaterAmbient()
+{
+    return heaterAmbient;
 }
 
-void BME680::writeConfig(uint16_t addressOffset)
+uint8_t BME680::encodeGasWait(const BMESetPointConfig *point)
 {
-    EEPROM.put(addressOffset, config);
+    return (((uint8_t)point->gas_wait_multiplier & 0x03) << 6) | ((uint8_t)point->gas_wait & 0x3F);
 }
+#endif
 
-void BME680::readConfig(uint16_t addressOffset)
+bool BME680::startConversion(uint8_t channels)
 {
-    EEPROM.get(addressOffset, config);
+    bool ok = true;
+    // ctrl_hum and ctrl_gas_1 only take a bus write when the channels measured change
+#if FEATURE_HUMIDITY
+    ok &= writeCached(RegisterAddresses::ADD_CTRL_HUM, (channels & channel_humidity) ? (uint8_t)config->osrs_h & 0x07 : 0, &ctrlHum);
+#endif
+#if FEATURE_GAS
+    uint8_t point = heaterPoint == 0xFF ? (uint8_t)config->set_point : heaterPoint;
+    ok &= writeCached(RegisterAddresses::ADD_CTRL_GAS_1, ((config->run_gas && (channels & channel_gas)) ? 0x10 : 0x00) | (point & 0x0F), &ctrlGas);
+#endif
+    // ctrl_meas: osrs_t<7:5>, osrs_p<4:2>, mode<1:0> (01 = forced mode); pressure skipped when compiled out
+    uint8_t osrsT = (channels & channel_temperature) ? (uint8_t)config->osrs_t & 0x07 : 0;
+    uint8_t osrsP = (FEATURE_PRESSURE && (channels & channel_pressure)) ? (uint8_t)config->osrs_p & 0x07 : 0;
+    return ok && i2c_writeByte(RegisterAddresses::ADD_CTRL_MEAS, (osrsT << 5) | (osrsP << 2) | 0x01);
 }
 
+bool BME680::isMeasuring()
+{
+    // eas_status_0: measuring<5>
+    return (i2c_readByte(RegisterAddresses::ADD_EAS_STATUS_0) & 0x20) != 0;
+}
+
+#if FEATURE_GAS
+uint8_t BME680::calculateHeaterResistance(double targetTemp, double ambientTemp)
+{
+    // Calculate the heater resistance based on calibration parameters and desired temperature range
+    // Refer to BME680 datasheet for further details on this operation (the gas heater parameters, not the temperature ones)
+    float var1 = (calibration->par_gh1 / 16.0) + 49.0;
+    float var2 = ((calibration->par_gh2 / 32768.0) * 0.0005) + 0.00235;
+    float var3 = calibration->par_gh3 / 1024.0;
+    float var4 = var1 * (1.0 + (var2 * targetTemp));
+    float var5 = var4 + (var3 * ambientTemp);
+    return (uint8_t)(3.4 * ((var5 * (4.0 / (4.0 + calibration->res_heat_range)) * (1.0 / (1.0 + calibration->res_heat_val * 0.002))) - 25));
+}
+#endif
+
 void BME680::readCalibrationParameters()
 {
     /*
@@ -153,6 +308,7 @@ void BME680::readCalibrationParameters()
     calibration->par_t1 = (uint16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_T1_MSB), i2c_readByte(cal::ADD_T1_LSB));
     calibration->par_t2 = (int16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_T2_MSB), i2c_readByte(cal::ADD_T2_LSB));
     calibration->par_t3 = (int8_t)i2c_readByte(cal::ADD_T3);
+#if FEATURE_PRESSURE
     calibration->par_p1 = (uint16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_P1_MSB), i2c_readByte(cal::ADD_P1_LSB));
     calibration->par_p2 = (int16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_P2_MSB), i2c_readByte(cal::ADD_P2_LSB));
     calibration->par_p3 = (int8_t)i2c_readByte(cal::ADD_P3);
@@ -163,37 +319,52 @@ void BME680::readCalibrationParameters()
     calibration->par_p8 = (int16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_P8_MSB), i2c_readByte(cal::ADD_P8_LSB));
     calibration->par_p9 = (int16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_P9_MSB), i2c_readByte(cal::ADD_P9_LSB));
     calibration->par_p10 = (uint8_t)i2c_readByte(cal::ADD_P10);
-    // w
-    //calibration->par_h1 = CONCAT_BYTES(i2c_readByte(cal::ADD_H1_MSB), i2c_readByte(cal::ADD_H1_LSB));
-    // w
-    //calibration->par_h2 = CONCAT_BYTES(i2c_readByte(cal::ADD_H2_MSB), i2c_readByte(cal::ADD_H2_LSB));
+#endif
+#if FEATURE_HUMIDITY
+    // par_h1 and par_h2 are 12-bit and share 0xE2: h1<3:0> in its low nibble, h2<3:0> in its high one
+    uint8_t h12 = i2c_readByte(cal::ADD_H1_LSB);
+    calibration->par_h1 = ((uint16_t)i2c_readByte(cal::ADD_H1_MSB) << 4) | (h12 & 0x0F);
+    calibration->par_h2 = ((uint16_t)i2c_readByte(cal::ADD_H2_MSB) << 4) | (h12 >> 4);
     calibration->par_h3 = (int8_t)i2c_readByte(cal::ADD_H3);
     calibration->par_h4 = (int8_t)i2c_readByte(cal::ADD_H4);
     calibration->par_h5 = (int8_t)i2c_readByte(cal::ADD_H5);
     calibration->par_h6 = (uint8_t)i2c_readByte(cal::ADD_H6);
     calibration->par_h7 = (int8_t)i2c_readByte(cal::ADD_H7);
+#endif
+#if FEATURE_GAS
     calibration->par_gh1 = (int8_t)i2c_readByte(cal::ADD_GH1);
     calibration->par_gh2 = (int16_t)CONCAT_BYTES(i2c_readByte(cal::ADD_GH2_MSB), i2c_readByte(cal::ADD_GH2_LSB));
     calibration->par_gh3 = (int8_t)i2c_readByte(cal::ADD_GH3);
     calibration->res_heat_val = (int8_t)i2c_readByte(cal::ADD_RES_HEAT_VAL);
-    // w
-    //calibration->res_heat_range = i2c_readByte(cal::ADD_RES_HEAT_RANGE);
-    calibration->range_sw_err = (uint8_t)i2c_readByte(cal::ADD_RANGE_SW_ERR);
+    // res_heat_range<5:4>, range_sw_err<7:4> (signed)
+    calibration->res_heat_range = (i2c_readByte(cal::ADD_RES_HEAT_RANGE) & 0x30) >> 4;
+    calibration->range_sw_err = (int8_t)(i2c_readByte(cal::ADD_RANGE_SW_ERR) & 0xF0) / 16;
+#endif
 }
 
-double BME680::calculateTemperature(uint32_t adcValue)
+int16_t BME680::calculateTemperature(uint32_t adcValue)
 {
+#if FEATURE_FLOAT_COMPENSATION
     double var1 = (((double)adcValue / 16384.0) - ((double)calibration->par_t1 / 1024.0)) * (double)calibration->par_t2;
     double var2 = ((((double)adcValue / 131072.0) - ((double)calibration->par_t1 / 8192.0)) * (((double)adcValue / 131072.0) - ((double)calibration->par_t1 / 8192.0))) * ((double)calibration->par_t3 * 16.0);
     calibration->t_fine = var1 + var2;
-    double temp_comp = calibration->t_fine / 5120.0;
-    //Serial.println(calibration->par_t1);
-    //Serial.println(calibration->par_t2);
-    //Serial.println(calibration->par_t3);
-    return temp_comp;
+#else
+    // Same t_fine scale as the floating point formula (t_fine / 5120 = °C)
+    int32_t var1 = ((int32_t)adcValue >> 3) - ((int32_t)calibration->par_t1 * 2);
+    int32_t var2 = (var1 * (int32_t)calibration->par_t2) >> 11;
+    int32_t var3 = ((((var1 >> 1) * (var1 >> 1)) >> 12) * ((int32_t)calibration->par_t3 * 16)) >> 14;
+    calibration->t_fine = var2 + var3;
+#endif
+    return getTemperatureCentiC();
 }
 
-double BME680::calculateHumidity(uint32_t adcValue)
+int16_t BME680::getTemperatureCentiC()
+{
+    return (((int32_t)calibration->t_fine * 5) + 128) >> 8;
+}
+
+#if FEATURE_HUMIDITY
+uint32_t BME680::calculateHumidity(uint32_t adcValue)
 {
     int32_t var1, var2, var3, var4, var5, var6, temp_scaled, calc_hum;
     temp_scaled = (((int32_t)calibration->t_fine * 5) + 128) >> 8;
@@ -215,34 +386,37 @@ double BME680::calculateHumidity(uint32_t adcValue)
     }
     return (uint32_t)calc_hum;
 }
+#endif
 
-double BME680::calculatePressure(uint32_t adcValue)
+#if FEATURE_PRESSURE
+uint32_t BME680::calculatePressure(uint32_t adcValue)
 {
     int32_t var1, var2, var3, pressure_comp;
-    const int32_t pres_ovf_check = INT32_C(0x40000000);
     var1 = (((int32_t)calibration->t_fine) >> 1) - 64000;
     var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calibration->par_p6) >> 2;
-    var2 = var2 + ((var1 * (int32_t)calibration->par_p5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)calibration->par_p4 << 16);
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)calibration->par_p3 << 5)) >> 3) + (((int32_t)calibration->par_p2 * var1) >> 1);
+    var2 = var2 + ((var1 * (int32_t)calibration->par_p5) * 2);
+    var2 = (var2 >> 2) + ((int32_t)calibration->par_p4 * 65536);
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)calibration->par_p3 * 32)) >> 3) + (((int32_t)calibration->par_p2 * var1) >> 1);
     var1 = var1 >> 18;
     var1 = ((32768 + var1) * (int32_t)calibration->par_p1) >> 15;
-    pressure_comp = 1048576 - adcValue;
-    pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
-    if (pressure_comp >= pres_ovf_check)
+    // Unsigned, as in the Bosch BME280 32-bit formula: the scaled value passes 2^31 in the cold above about 105 kPa
+    uint32_t scaled = (uint32_t)((int32_t)(1048576 - adcValue) - (var2 >> 12)) * (uint32_t)3125;
+    if (scaled >= UINT32_C(0x80000000))
     {
-        pressure_comp = ((pressure_comp / var1) << 1);
+        pressure_comp = (int32_t)((scaled / (uint32_t)var1) << 1);
     }
     else
     {
-        pressure_comp = ((pressure_comp << 1) / var1);
+        pressure_comp = (int32_t)((scaled << 1) / (uint32_t)var1);
     }
     var1 = ((int32_t)calibration->par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
     var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)calibration->par_p8) >> 13;
-    var3 = ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)calibration->par_p10) >> 17;
-    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)calibration->par_p7 << 7)) >> 4);
+    // The cube times par_p10 overflows 32 bits above about 105 kPa: drop 8 of the 17 bits first
+    var3 = ((((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8)) >> 8) * (int32_t)calibration->par_p10) >> 9;
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)calibration->par_p7 * 128)) >> 4);
     return (uint32_t)pressure_comp;
 }
+#endif
 
 uint32_t BME680::readRawTemperature()
 {
@@ -256,6 +430,7 @@ uint32_t BME680::readRawTemperature()
     return temp;
 }
 
+#if FEATURE_HUMIDITY
 uint32_t BME680::readRawHumidity()
 {
     // Read humidity ADC data (16-bit)
@@ -266,15 +441,41 @@ uint32_t BME680::readRawHumidity()
     hum = hum_msb * 256 + hum_lsb;
     return hum;
 }
+#endif
 
+#if FEATURE_PRESSURE
 uint32_t BME680::readRawPressure()
 {
     // Read pressure ADC data (24-bit)
     uint8_t press_lsb, press_msb, press_xlsb;
     uint32_t press;
-    press_xlsb = i2c_readByte(RegisterAddresses::ADD_TEMP_XLSB);
-    press_lsb = i2c_readByte(RegisterAddresses::ADD_TEMP_LSB);
-    press_msb = i2c_readByte(RegisterAddresses::ADD_TEMP_MSB);
+    press_xlsb = i2c_readByte(RegisterAddresses::ADD_PRESS_XLSB);
+    press_lsb = i2c_readByte(RegisterAddresses::ADD_PRESS_LSB);
+    press_msb = i2c_readByte(RegisterAddresses::ADD_PRESS_MSB);
     press = (uint32_t)(((uint32_t)press_msb * 4096) | ((uint32_t)press_lsb * 16) | ((uint32_t)press_xlsb / 16));
     return press;
 }
+#endif
+
+#if FEATURE_GAS
+bool BME680::readRawGas(uint16_t *adc, uint8_t *range)
+{
+    // Read gas ADC data (10-bit): gas_r_lsb holds adc<7:6>, gas_valid_r<5>, heat_stab_r<4>, gas_range_r<3:0>
+    uint8_t gas_msb, gas_lsb;
+    gas_msb = i2c_readByte(RegisterAddresses::ADD_GAS_R_MSB);
+    gas_lsb = i2c_readByte(RegisterAddresses::ADD_GAS_R_LSB);
+    *adc = ((uint16_t)gas_msb << 2) | (gas_lsb >> 6);
+    *range = gas_lsb & 0x0F;
+    return (gas_lsb & 0x30) == 0x30;
+}
+
+uint32_t BME680::calculateGasResistance(uint16_t adcValue, uint8_t range)
+{
+    int64_t var1, var2, var3;
+    range &= 0x0F;
+    var1 = (int64_t)((1340 + (5 * (int64_t)calibration->range_sw_err)) * ((int64_t)pgm_read_dword(&gasRangeTable1[range]))) >> 16;
+    var2 = (((int64_t)((int64_t)adcValue << 15) - (int64_t)(16777216)) + var1);
+    var3 = (((int64_t)pgm_read_dword(&gasRangeTable2[range]) * (int64_t)var1) >> 9);
+    return (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
+}
+#endif
@@ -12,10 +12,14 @@
 
 #include <Arduino.h>
 #include <Wire.h>
-#include <EEPROM.h>
+
+#include "buildcfg.h"
 
 #define CONCAT_BYTES(msb, lsb) (((uint16_t)msb << 8) | (uint16_t)lsb)
 
+// Content of the chip id register
+#define BME680_CHIP_ID 0x61
+
 class BME680
 {
 public:
@@ -39,6 +43,9 @@ public:
         ADD_RES_HEAT_X_LAST = 0x5A,
         ADD_IDAC_HEAT_X_FIRST = 0x59,
         ADD_IDAC_HEAT_X_LAST = 0x50,
+        // Set point 0 of the heater registers (set point n is at +n)
+        ADD_GAS_WAIT_0 = 0x64,
+        ADD_RES_HEAT_0 = 0x5A,
         ADD_GAS_R_LSB = 0x2B,
         ADD_GAS_R_MSB = 0x2A,
         ADD_HUM_LSB = 0x26,
@@ -293,6 +300,7 @@ public:
      */
     typedef struct
     {
+#if FEATURE_HUMIDITY
         /*! Variable to store calibrated humidity data */
         uint16_t par_h1;
         /*! Variable to store calibrated humidity data */
@@ -307,18 +315,22 @@ public:
         uint8_t par_h6;
         /*! Variable to store calibrated humidity data */
         int8_t par_h7;
+#endif
+#if FEATURE_GAS
         /*! Variable to store calibrated gas data */
         int8_t par_gh1;
         /*! Variable to store calibrated gas data */
         int16_t par_gh2;
         /*! Variable to store calibrated gas data */
         int8_t par_gh3;
+#endif
         /*! Variable to store calibrated temperature data */
         uint16_t par_t1;
         /*! Variable to store calibrated temperature data */
         int16_t par_t2;
         /*! Variable to store calibrated temperature data */
         int8_t par_t3;
+#if FEATURE_PRESSURE
         /*! Variable to store calibrated pressure data */
         uint16_t par_p1;
         /*! Variable to store calibrated pressure data */
@@ -339,14 +351,21 @@ public:
         int16_t par_p9;
         /*! Variable to store calibrated pressure data */
         uint8_t par_p10;
+#endif
         /*! Variable to store t_fine size */
+#if FEATURE_FLOAT_COMPENSATION
         double t_fine;
+#else
+        int32_t t_fine;
+#endif
+#if FEATURE_GAS
         /*! Variable to store heater resistance range */
         uint8_t res_heat_range;
         /*! Variable to store heater resistance value */
         int8_t res_heat_val;
         /*! Variable to store error range */
         int8_t range_sw_err;
+#endif
     } BMECalibrationParameters;
 
     /**
@@ -390,6 +409,7 @@ public:
         // Value boundaries: 0 to 7
         FilterCoefficients filter;
 
+#if FEATURE_GAS
         // Enable gas measurements
         bool run_gas;
 
@@ -400,17 +420,41 @@ public:
         // Value boundaries: 0 to 9
         BMESetPointConfig set_point_cfg[10];
         HeaterSetPoints set_point;
+#endif
     } BMEConfig;
 
     // set to private
 public:
     uint8_t i2cAdd;
+    // First error (I2CBus::Errors) since the last clearError(), 0 if none
     uint8_t i2cErrno;
+    // Failed transactions since boot
+    uint16_t i2cErrorCount;
     uint8_t i2cReadDelayMicros = 10;
+    // Last value written to ctrl_hum and ctrl_gas_1, 0xFF if unknown (after a reset or a failed write)
+    uint8_t ctrlHum = 0xFF;
+    uint8_t ctrlGas = 0xFF;
+#if FEATURE_GAS
+    // Heater profile written last by applyHeater() (set point, °C, ambient °C), 0xFF if none yet
+    uint8_t heaterPoint = 0xFF;
+    uint16_t heaterTemp = 0;
+    int8_t heaterAmbient = 25;
+#endif
 
     BMEConfig *config;
     BMECalibrationParameters *calibration;
 
+    /**
+     * @brief Writes a control register unless it already holds the value
+     *
+     * @param registerAddress: The address of the BME680's register
+     * @param registerData: The data to be written
+     * @param cache: The last value written to the register
+     * @return bool: True if the register holds the value
+     */
+    bool writeCached(uint8_t registerAddress, uint8_t registerData, uint8_t *cache);
+
+#if FEATURE_GAS
     /**
      * @brief Calculate heater resistance based on calibration parameters and desired temperature range
      *
@@ -420,6 +464,15 @@ public:
      */
     uint8_t calculateHeaterResistance(double targetTemp, double ambientTemp);
 
+    /**
+     * @brief Encodes a heater wait time setting for a gas_wait_x register
+     *
+     * @param point: The set point configuration
+     * @return uint8_t: The register value, multiplier<7:6> and wait time<5:0>
+     */
+    static uint8_t encodeGasWait(const BMESetPointConfig *point);
+#endif
+
 public:
     /**
      * @brief Constructs a new BME680 object
@@ -428,7 +481,31 @@ public:
      */
     BME680(uint8_t i2cAddress);
 
-    void begin();
+    /**
+     * @brief Resets the sensor and reads its calibration parameters
+     *
+     * @return bool: True if the sensor answered with the right chip id
+     */
+    bool begin();
+
+    /**
+     * @brief Gets the first bus error since the last clearError()
+     * Every transaction is bounded by the I2CBus timeout and a failed read returns 0, so a sequence of
+     * reads can be run and checked once
+     *
+     * @return uint8_t: The error (I2CBus::Errors), 0 if none
+     */
+    uint8_t getError();
+
+    /**
+     * @brief Clears the error returned by getError()
+     */
+    void clearError();
+
+    /**
+     * @brief Gets the number of failed transactions since boot
+     */
+    uint16_t getErrorCount();
 
     /**
      * @brief Sets a custom configuration
@@ -443,19 +520,57 @@ public:
     void setDefaultConfig();
 
     /**
-     * @brief Writes the configuration to EEPROM
+     * @brief Writes the humidity oversampling, IIR filter and gas control registers from the current configuration
+     * @note Temperature and pressure oversampling are written by startConversion() together with the mode bits
+     *
+     * @return bool: True if all registers were written
+     */
+    bool applyConfig();
+
+#if FEATURE_GAS
+    /**
+     * @brief Programs the heater temperature and wait time of a set point and selects it for the next conversions
+     * The wait time comes from the set point configuration, run_gas from the current configuration
+     *
+     * @param point: The set point (HeaterSetPoints)
+     * @param targetTemp: The heater temperature in °C (at most 400)
+     * @param ambientTemp: The ambient temperature in °C
+     * @return bool: True if all registers were written
+     */
+    bool applyHeater(uint8_t point, uint16_t targetTemp, int8_t ambientTemp);
+
+    /**
+     * @brief Gets the set point selected by the last applyHeater() call (0xFF if none)
+     */
+    uint8_t getHeaterPoint();
+
+    /**
+     * @brief Gets the heater temperature, in °C, of the last applyHeater() call
      */
-    void writeConfig(uint16_t addressOffset = 0);
+    uint16_t getHeaterTemp();
 
     /**
-     * @brief Reads the configuration from EEPROM
+     * @brief Gets the ambient temperature, in °C, the heater resistance was computed for
      */
-    void readConfig(uint16_t addressOffset = 0);
+    int8_t getHeaterAmbient();
+#endif
 
     /**
      * @brief Starts conversion of read data
+     * Triggers a forced mode measurement using the oversampling set in the current configuration;
+     * the channels not requested are skipped (gas: heater off for this conversion)
+     *
+     * @param channels: The channels to measure (SampleChannels flags)
+     * @return bool: True if the conversion was started
      */
-    void startConversion();
+    bool startConversion(uint8_t channels = channel_all);
+
+    /**
+     * @brief Checks whether a conversion is still running
+     *
+     * @return bool: True if the sensor is measuring (false on a bus error, see getError())
+     */
+    bool isMeasuring();
 
     /**
      * @brief Reads data from the sensor
@@ -474,35 +589,46 @@ public:
      *
      * @param registerAddress: The address of the BME680's register
      * @param registerData: The data to be written at registerAddress
+     * @return bool: True if the sensor acknowledged the write
      */
-    void i2c_writeByte(uint8_t registerAddress, uint8_t registerData);
+    bool i2c_writeByte(uint8_t registerAddress, uint8_t registerData);
 
     /**
      * @brief Reads a byte of data from the i2c bus
      *
      * @param registerAddress: The address of the BME680's register
-     * @return uint8_t: The data read from registerAddress
+     * @return uint8_t: The data read from registerAddress, 0 on a bus error
      */
     uint8_t i2c_readByte(uint8_t registerAddress);
 
     /**
-     * @brief Calculates temperature from raw ADC data
+     * @brief Calculates temperature from raw ADC data, with the engine selected by FEATURE_FLOAT_COMPENSATION
      * @note This function was provided by Bosch's Sensor API
      *
      * @param adcValue: The raw ADC data
-     * @return double: The temperature value in °C
+     * @return int16_t: The temperature value in hundredths of °C
      */
-    double calculateTemperature(uint32_t adcValue);
+    int16_t calculateTemperature(uint32_t adcValue);
 
+    /**
+     * @brief Gets the temperature from the last calculateTemperature() call as a scaled integer
+     *
+     * @return int16_t: The temperature value in hundredths of °C
+     */
+    int16_t getTemperatureCentiC();
+
+#if FEATURE_HUMIDITY
     /**
      * @brief Calculates humidity from raw ADC data
      * @note This function was provided by Bosch's Sensor API
      *
      * @param adcValue: The raw ADC data
-     * @return uint32_t: The relative humidity value in %
+     * @return uint32_t: The relative humidity value in thousandths of %
      */
-    double calculateHumidity(uint32_t adcValue);
+    uint32_t calculateHumidity(uint32_t adcValue);
+#endif
 
+#if FEATURE_PRESSURE
     /**
      * @brief Calculates pressure from raw ADC data
      * @note This function was provided by Bosch's Sensor API
@@ -510,7 +636,8 @@ public:
      * @param adcValue: The raw ADC data
      * @return uint32_t: The pressure value in Pascal
      */
-    double calculatePressure(uint32_t adcValue);
+    uint32_t calculatePressure(uint32_t adcValue);
+#endif
 
     /**
      * @brief Reads raw ADC temperature data
@@ -519,19 +646,44 @@ public:
      */
     uint32_t readRawTemperature();
 
+#if FEATURE_HUMIDITY
     /**
      * @brief Reads raw ADC humidity data
      *
      * @return uint32_t: The raw ADC humidity data
      */
     uint32_t readRawHumidity();
+#endif
 
+#if FEATURE_PRESSURE
     /**
      * @brief Reads raw ADC pressure data
      *
      * @return uint32_t: The raw ADC pressure data
      */
     uint32_t readRawPressure();
+#endif
+
+#if FEATURE_GAS
+    /**
+     * @brief Reads raw gas ADC data and range
+     *
+     * @param adc: Output 10-bit ADC value
+     * @param range: Output ADC range (0 to 15)
+     * @return bool: True if the reading is valid and the heater reached its target temperature
+     */
+    bool readRawGas(uint16_t *adc, uint8_t *range);
+
+    /**
+     * @brief Calculates gas resistance from raw ADC data
+     * @note This function was provided by Bosch's Sensor API
+     *
+     * @param adcValue: The raw ADC data
+     * @param range: The ADC range
+     * @return uint32_t: The gas resistance in Ohm
+     */
+    uint32_t calculateGasResistance(uint16_t adcValue, uint8_t range);
+#endif
 };
 
 #endif
\ No newline at end of file
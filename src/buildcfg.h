@@ -0,0 +1,48 @@
+/**
+ * @file buildcfg.h
+ * @author Riccardo Iacob
+ * @brief Compile-time selection of the sensor channels and of the compensation engine
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef BUILDCFG_H
+#define BUILDCFG_H
+
+#include "sample.h"
+
+/**
+ * Every flag can be overridden by the build (build_flags = -DFEATURE_PRESSURE=0, see the
+ * environments in platformio.ini). Temperature is always built, its t_fine term is an input to
+ * every other compensation.
+ *
+ * A disabled channel is compiled out of the driver (calibration fields and reads, register reads,
+ * compensation) and of the pipeline (output columns, display field, derived metrics and alert
+ * sources depending on it), and its oversampling is written as skip so the sensor does not
+ * measure it either. The sample record and the log format stay the same: the channel is never
+ * flagged fresh.
+ */
+#ifndef FEATURE_HUMIDITY
+#define FEATURE_HUMIDITY 1
+#endif
+
+#ifndef FEATURE_PRESSURE
+#define FEATURE_PRESSURE 1
+#endif
+
+// Gas heater, resistance readings and the burn-in baseline (GasBaseline)
+#ifndef FEATURE_GAS
+#define FEATURE_GAS 1
+#endif
+
+// Temperature compensation: 1 = Bosch floating point formula, 0 = Bosch integer formula, which
+// together with FEATURE_GAS 0 leaves no floating point code in the firmware
+#ifndef FEATURE_FLOAT_COMPENSATION
+#define FEATURE_FLOAT_COMPENSATION 1
+#endif
+
+// Channels delivered by the sensor (SampleChannels flags)
+static const uint8_t SENSOR_CHANNELS = channel_temperature | (FEATURE_HUMIDITY ? channel_humidity : 0) | (FEATURE_PRESSURE ? channel_pressure : 0);
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file clock.cpp
+ * @author Riccardo Iacob
+ * @brief Wall clock of the samples and of the acquisition schedule, kept from the DS3231
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "clock.h"
+
+DS3231 *Clock::rtc = nullptr;
+uint32_t Clock::offset = 0;
+bool Clock::synced = false;
+
+void Clock::begin(DS3231 *device)
+{
+    rtc = device;
+    read(true);
+}
+
+bool Clock::sync()
+{
+    return read(false);
+}
+
+bool Clock::read(bool force)
+{
+    uint32_t rtcSeconds;
+    if (rtc == nullptr || !rtc->readTime(&rtcSeconds))
+    {
+        return false;
+    }
+    uint32_t measured = rtcSeconds - millis() / 1000;
+    int32_t error = (int32_t)(measured - offset);
+    if (force || !synced || error >= RESYNC_S || error <= -RESYNC_S)
+    {
+        offset = measured;
+    }
+    synced = true;
+    return true;
+}
+
+uint32_t Clock::toSeconds(unsigned long ms)
+{
+    return ms / 1000 + offset;
+}
+
+unsigned long Clock::toMillis(uint32_t seconds)
+{
+    return (seconds - offset) * 1000UL;
+}
+
+uint32_t Clock::now()
+{
+    return toSeconds(millis());
+}
+
+bool Clock::isSynced()
+{
+    return synced;
+}
+
+bool Clock::accessTime(bool set, uint32_t *seconds)
+{
+    if (set)
+    {
+        if (rtc == nullptr || !rtc->setTime(*seconds))
+        {
+            return false;
+        }
+        // The offset follows at once, so the next samples carry the new time
+        read(true);
+        return true;
+    }
+    *seconds = now();
+    return synced;
+}
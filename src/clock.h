@@ -0,0 +1,100 @@
+/**
+ * @file clock.h
+ * @author Riccardo Iacob
+ * @brief Wall clock of the samples and of the acquisition schedule, kept from the DS3231
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+#include "ds3231.h"
+
+/**
+ * The RTC time is kept as an offset to millis(), in seconds, and synced by sync() (at boot and at
+ * every device check), so stamping a sample or planning a conversion costs no bus traffic. A
+ * missing or unset RTC keeps the last offset: until the RTC is first read the clock counts uptime.
+ * The RTC seconds and millis() / 1000 tick at different phases, so the offset read at each sync
+ * wavers by a second; it is only moved once it is RESYNC_S off (drift, or the RTC was set
+ * elsewhere), and the stamped times never step back and forth.
+ *
+ * The acquisition planner runs on this clock, its channels fall due at wall-clock multiples of
+ * their periods; accessTime() is the console's time handler.
+ */
+class Clock
+{
+public:
+    // Difference between the offset read and the one in use that moves it, in seconds
+    static const uint8_t RESYNC_S = 2;
+
+private:
+    static DS3231 *rtc;
+    // RTC time minus uptime, in seconds
+    static uint32_t offset;
+    // The RTC was read since boot
+    static bool synced;
+
+    /**
+     * @brief Reads the RTC and moves the offset if it is RESYNC_S off, or always when forced
+     *
+     * @param force: Take the offset read, as after setting the RTC
+     * @return bool: True if the RTC was read
+     */
+    static bool read(bool force);
+
+public:
+    /**
+     * @brief Attaches the RTC and reads the time
+     *
+     * @param device: The RTC
+     */
+    static void begin(DS3231 *device);
+
+    /**
+     * @brief Reads the RTC and updates the offset if it drifted by RESYNC_S or more
+     *
+     * @return bool: True if the RTC was read
+     */
+    static bool sync();
+
+    /**
+     * @brief Converts a millis() value to wall-clock time
+     *
+     * @param ms: The millis() value
+     * @return uint32_t: The time in seconds (Unix time once the RTC was read)
+     */
+    static uint32_t toSeconds(unsigned long ms);
+
+    /**
+     * @brief Converts wall-clock time to the millis() value it falls on
+     *
+     * @param seconds: The time in seconds
+     * @return unsigned long: The millis() value
+     */
+    static unsigned long toMillis(uint32_t seconds);
+
+    /**
+     * @brief Gets the current wall-clock time in seconds
+     */
+    static uint32_t now();
+
+    /**
+     * @brief Checks whether the RTC was read since boot
+     */
+    static bool isSynced();
+
+    /**
+     * @brief Reads (set false) or sets the time in Unix seconds (Console::TimeHandler)
+     *
+     * @param set: True to set the RTC to *seconds
+     * @param seconds: The time, read or to set
+     * @return bool: Reading, false if the RTC was never read; setting, false if the RTC refused it
+     */
+    static bool accessTime(bool set, uint32_t *seconds);
+};
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ * @file configstore.cpp
+ * @author Riccardo Iacob
+ * @brief Versioned, wear-levelled record storage in the on-chip EEPROM
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "configstore.h"
+
+ConfigStore::ConfigStore(uint16_t address, uint8_t slots, uint8_t size, uint8_t type)
+{
+    baseAddress = address;
+    slotCount = slots;
+    slotSize = size;
+    recordType = type;
+    newestSlot = slots;
+    newestSequence = 0;
+    newestVersion = 0;
+    newestLength = 0;
+}
+
+uint16_t ConfigStore::crc16(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (crc & 0x8000)
+        {
+            crc = (crc << 1) ^ 0x1021;
+        }
+        else
+        {
+            crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t ConfigStore::slotAddress(uint8_t slot)
+{
+    return baseAddress + (uint16_t)slot * slotSize;
+}
+
+bool ConfigStore::checkSlot(uint8_t slot, uint16_t *sequence)
+{
+    uint16_t address = slotAddress(slot);
+    uint8_t length = EEPROM.read(address + 2);
+
+    if (EEPROM.read(address) != recordType || length > slotSize - HEADER_SIZE - CRC_SIZE)
+    {
+        return false;
+    }
+
+    uint16_t crc = 0xFFFF;
+    uint8_t total = HEADER_SIZE + length;
+    for (uint8_t i = 0; i < total; i++)
+    {
+        crc = crc16(crc, EEPROM.read(address + i));
+    }
+    uint16_t stored = CONCAT_BYTES(EEPROM.read(address + total), EEPROM.read(address + total + 1));
+    if (crc != stored)
+    {
+        return false;
+    }
+
+    *sequence = CONCAT_BYTES(EEPROM.read(address + 3), EEPROM.read(address + 4));
+    return true;
+}
+
+bool ConfigStore::begin()
+{
+    newestSlot = slotCount;
+
+    // Single pass: keep the valid slot with the highest sequence number,
+    // comparing with serial number arithmetic so the counter can wrap around
+    for (uint8_t slot = 0; slot < slotCount; slot++)
+    {
+        uint16_t sequence;
+        if (!checkSlot(slot, &sequence))
+        {
+            continue;
+        }
+        if (newestSlot == slotCount || (int16_t)(sequence - newestSequence) > 0)
+        {
+            newestSlot = slot;
+            newestSequence = sequence;
+        }
+    }
+
+    if (newestSlot == slotCount)
+    {
+        return false;
+    }
+
+    uint16_t address = slotAddress(newestSlot);
+    newestVersion = EEPROM.read(address + 1);
+    newestLength = EEPROM.read(address + 2);
+    return true;
+}
+
+bool ConfigStore::loadRecord(void *payload, uint8_t maxLength, uint8_t *version)
+{
+    if (newestSlot == slotCount)
+    {
+        return false;
+    }
+
+    uint16_t address = slotAddress(newestSlot) + HEADER_SIZE;
+    uint8_t length = newestLength < maxLength ? newestLength : maxLength;
+    uint8_t *bytes = (uint8_t *)payload;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        bytes[i] = EEPROM.read(address + i);
+    }
+    if (version != nullptr)
+    {
+        *version = newestVersion;
+    }
+    return true;
+}
+
+bool ConfigStore::saveRecord(const void *payload, uint8_t length, uint8_t version)
+{
+    if (length > slotSize - HEADER_SIZE - CRC_SIZE)
+    {
+        return false;
+    }
+
+    uint8_t slot = (newestSlot >= slotCount - 1) ? 0 : newestSlot + 1;
+    uint16_t sequence = (newestSlot == slotCount) ? 0 : newestSequence + 1;
+    uint16_t address = slotAddress(slot);
+    const uint8_t *bytes = (const uint8_t *)payload;
+
+    uint8_t header[HEADER_SIZE] = {recordType, version, length, (uint8_t)(sequence >> 8), (uint8_t)sequence};
+    uint16_t crc = 0xFFFF;
+
+    // update() only erases/writes the cells that actually change
+    for (uint8_t i = 0; i < HEADER_SIZE; i++)
+    {
+        EEPROM.update(address + i, header[i]);
+        crc = crc16(crc, header[i]);
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        EEPROM.update(address + HEADER_SIZE + i, bytes[i]);
+        crc = crc16(crc, bytes[i]);
+    }
+    // The CRC goes last: until it is in place the slot is invalid and the previous one is used
+    EEPROM.update(address + HEADER_SIZE + length, crc >> 8);
+    EEPROM.update(address + HEADER_SIZE + length + 1, crc & 0xFF);
+
+    // Read back: the slot must now hold exactly this record
+    uint16_t check;
+    if (!checkSlot(slot, &check) || check != sequence)
+    {
+        return false;
+    }
+
+    newestSlot = slot;
+    newestSequence = sequence;
+    newestVersion = version;
+    newestLength = length;
+    return true;
+}
+
+void ConfigStore::encodeConfig(const BME680::BMEConfig *cfg, StoredConfig *stored)
+{
+    stored->osrs_t = cfg->osrs_t;
+    stored->osrs_p = cfg->osrs_p;
+    stored->osrs_h = cfg->osrs_h;
+    stored->filter = cfg->filter;
+    // The record layout does not depend on the build, gas fields are stored as 0 without gas
+#if FEATURE_GAS
+    stored->run_gas = cfg->run_gas ? 1 : 0;
+    stored->set_point = cfg->set_point;
+    stored->target_temp = cfg->target_temp < 0 ? 0 : (uint16_t)cfg->target_temp;
+#else
+    stored->run_gas = 0;
+    stored->set_point = 0;
+    stored->target_temp = 0;
+#endif
+    for (uint8_t i = 0; i < 10; i++)
+    {
+#if FEATURE_GAS
+        stored->gas_wait[i] = cfg->set_point_cfg[i].gas_wait;
+        stored->gas_wait_multiplier[i] = cfg->set_point_cfg[i].gas_wait_multiplier;
+#else
+        stored->gas_wait[i] = 0;
+        stored->gas_wait_multiplier[i] = 0;
+#endif
+    }
+}
+
+void ConfigStore::decodeConfig(const StoredConfig *stored, BME680::BMEConfig *cfg)
+{
+    // Out of range values are clamped rather than trusted
+    cfg->osrs_t = (BME680::OversamplingMultipliers)min(stored->osrs_t, (uint8_t)BME680::orsrs_x16);
+    cfg->osrs_p = (BME680::OversamplingMultipliers)min(stored->osrs_p, (uint8_t)BME680::orsrs_x16);
+    cfg->osrs_h = (BME680::OversamplingMultipliers)min(stored->osrs_h, (uint8_t)BME680::orsrs_x16);
+    cfg->filter = (BME680::FilterCoefficients)min(stored->filter, (uint8_t)BME680::filter_127);
+#if FEATURE_GAS
+    cfg->run_gas = stored->run_gas != 0;
+    cfg->set_point = (BME680::HeaterSetPoints)min(stored->set_point, (uint8_t)BME680::point_9);
+    cfg->target_temp = stored->target_temp;
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        cfg->set_point_cfg[i].gas_wait = (BME680::GasWaitMillis)min(stored->gas_wait[i], (uint8_t)BME680::millis_63);
+        cfg->set_point_cfg[i].gas_wait_multiplier = (BME680::HeaterTimeMultipliers)min(stored->gas_wait_multiplier[i], (uint8_t)BME680::time_x64);
+    }
+#endif
+}
+
+bool ConfigStore::load(BME680::BMEConfig *cfg, AcquisitionPlanner *planner)
+{
+    StoredConfig stored;
+
+    // Start from the current values, so fields a shorter (older) record lacks keep them
+    encodeConfig(cfg, &stored);
+    for (uint8_t i = 0; i < AcquisitionPlanner::CHANNELS; i++)
+    {
+        stored.periods[i] = planner != nullptr ? planner->getPeriod(i) : 0;
+    }
+    if (!loadRecord(&stored, sizeof(StoredConfig)))
+    {
+        return false;
+    }
+    decodeConfig(&stored, cfg);
+    if (planner != nullptr)
+    {
+        for (uint8_t i = 0; i < AcquisitionPlanner::CHANNELS; i++)
+        {
+            planner->setPeriod(i, stored.periods[i]);
+        }
+    }
+    return true;
+}
+
+bool ConfigStore::save(const BME680::BMEConfig *cfg, AcquisitionPlanner *planner)
+{
+    StoredConfig stored;
+    encodeConfig(cfg, &stored);
+    for (uint8_t i = 0; i < AcquisitionPlanner::CHANNELS; i++)
+    {
+        stored.periods[i] = planner != nullptr ? planner->getPeriod(i) : 0;
+    }
+    return saveRecord(&stored, sizeof(StoredConfig), CONFIG_VERSION);
+}
+
+uint16_t ConfigStore::getSequence()
+{
+    return newestSequence;
+}
+
+uint8_t ConfigStore::getSlot()
+{
+    return newestSlot;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file configstore.h
+ * @author Riccardo Iacob
+ * @brief Versioned, wear-levelled record storage in the on-chip EEPROM
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "bme680.h"
+#include "acqplan.h"
+
+/**
+ * The store owns SLOT_COUNT consecutive slots of slotSize bytes.
+ * Every save goes to the slot following the newest one, so writes rotate across all slots.
+ * Each slot holds:
+ *   [0]      type      record type, tells apart stores sharing the EEPROM
+ *   [1]      version   payload layout version
+ *   [2]      length    payload length in bytes
+ *   [3..4]   sequence  incremented on every save (wraps around)
+ *   [5..]    payload
+ *   [5+len]  crc       CRC-16/CCITT over header and payload
+ * A write torn by a power loss fails the CRC check, so the previous slot stays the newest valid one.
+ * Payload layouts are append-only: a record written by an older firmware is shorter, and the
+ * missing trailing fields keep the value they had before loading (usually the defaults).
+ */
+class ConfigStore
+{
+public:
+    // Size of the slot header in bytes
+    static const uint8_t HEADER_SIZE = 5;
+    // Size of the CRC in bytes
+    static const uint8_t CRC_SIZE = 2;
+    // Record type of the sensor configuration
+    static const uint8_t TYPE_CONFIG = 0xC1;
+    // Record type of the gas baseline checkpoint (GasBaseline::Checkpoint)
+    static const uint8_t TYPE_GAS_BASELINE = 0xC2;
+    // Current sensor configuration layout version
+    static const uint8_t CONFIG_VERSION = 2;
+
+    /**
+     * @brief Persistent layout of BME680::BMEConfig and the acquisition periods (version 2)
+     * Only append new fields at the end, and bump CONFIG_VERSION when doing so
+     */
+    typedef struct
+    {
+        uint8_t osrs_t;
+        uint8_t osrs_p;
+        uint8_t osrs_h;
+        uint8_t filter;
+        uint8_t run_gas;
+        uint8_t set_point;
+        // Heater target temperature in °C
+        uint16_t target_temp;
+        uint8_t gas_wait[10];
+        uint8_t gas_wait_multiplier[10];
+        // Version 2: acquisition period of each channel in seconds, in AcquisitionPlanner order
+        uint16_t periods[AcquisitionPlanner::CHANNELS];
+    } StoredConfig;
+
+private:
+    uint16_t baseAddress;
+    uint8_t slotCount;
+    uint8_t slotSize;
+    uint8_t recordType;
+
+    // Index of the newest valid slot, slotCount if none
+    uint8_t newestSlot;
+    // Sequence number of the newest valid slot
+    uint16_t newestSequence;
+    // Version and length of the newest valid record
+    uint8_t newestVersion;
+    uint8_t newestLength;
+
+    uint16_t slotAddress(uint8_t slot);
+
+    /**
+     * @brief Validates a slot
+     *
+     * @param slot: The slot index
+     * @param sequence: The sequence number of the record (written only if valid)
+     * @return bool: True if the slot contains a record of this store with a valid CRC
+     */
+    bool checkSlot(uint8_t slot, uint16_t *sequence);
+
+public:
+    /**
+     * @brief Constructs a new ConfigStore object
+     *
+     * @param address: EEPROM address of the first slot
+     * @param slots: Number of slots to rotate across
+     * @param size: Size of each slot in bytes, header and CRC included
+     * @param type: Record type identifying this store
+     */
+    ConfigStore(uint16_t address, uint8_t slots, uint8_t size, uint8_t type);
+
+    /**
+     * @brief Scans all slots once and selects the newest valid record
+     *
+     * @return bool: True if a valid record was found
+     */
+    bool begin();
+
+    /**
+     * @brief Reads the newest valid record
+     *
+     * @param payload: Output buffer, bytes beyond the stored length are left untouched
+     * @param maxLength: Size of the output buffer
+     * @param version: The layout version of the record (optional)
+     * @return bool: True if a valid record was found
+     */
+    bool loadRecord(void *payload, uint8_t maxLength, uint8_t *version = nullptr);
+
+    /**
+     * @brief Writes a record to the slot following the newest one
+     *
+     * @param payload: The record payload
+     * @param length: The payload length, at most slotSize - HEADER_SIZE - CRC_SIZE
+     * @param version: The layout version of the payload
+     * @return bool: True if the record was written and read back correctly
+     */
+    bool saveRecord(const void *payload, uint8_t length, uint8_t version);
+
+    /**
+     * @brief Loads the sensor configuration, migrating older layouts
+     *
+     * @param cfg: The configuration, fields missing from the record are left untouched
+     * @param planner: The acquisition planner whose periods are loaded too (optional)
+     * @return bool: True if a valid record was found
+     */
+    bool load(BME680::BMEConfig *cfg, AcquisitionPlanner *planner = nullptr);
+
+    /**
+     * @brief Saves the sensor configuration
+     *
+     * @param cfg: The configuration
+     * @param planner: The acquisition planner whose periods are saved too (optional, 0 if absent)
+     * @return bool: True on success
+     */
+    bool save(const BME680::BMEConfig *cfg, AcquisitionPlanner *planner = nullptr);
+
+    /**
+     * @brief Gets the sequence number of the newest valid record
+     */
+    uint16_t getSequence();
+
+    /**
+     * @brief Gets the index of the newest valid slot (slot count if there is none)
+     */
+    uint8_t getSlot();
+
+    /**
+     * @brief Updates a CRC-16/CCITT (polynomial 0x1021) with one byte
+     *
+     * @param crc: The current CRC value (0xFFFF initially)
+     * @param data: The data byte
+     * @return uint16_t: The updated CRC
+     */
+    static uint16_t crc16(uint16_t crc, uint8_t data);
+
+    /**
+     * @brief Converts a configuration to its persistent layout
+     */
+    static void encodeConfig(const BME680::BMEConfig *cfg, StoredConfig *stored);
+
+    /**
+     * @brief Converts a persistent layout to a configuration
+     */
+    static void decodeConfig(const StoredConfig *stored, BME680::BMEConfig *cfg);
+};
+
+#endif
@@ -0,0 +1,809 @@
+/**
+ * @file console.cpp
+ * @author Riccardo Iacob
+ * @brief Line-oriented command console for runtime reconfiguration
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "console.h"
+#include "sampleout.h"
+#include "osctrl.h"
+#include "power.h"
+
+// Keys of the "set" command, as built (buildcfg.h)
+#if FEATURE_PRESSURE
+#define HELP_KEY_PRESSURE " osrs_p"
+#else
+#define HELP_KEY_PRESSURE ""
+#endif
+#if FEATURE_HUMIDITY
+#define HELP_KEY_HUMIDITY " osrs_h"
+#else
+#define HELP_KEY_HUMIDITY ""
+#endif
+
+Console::OutputMode Console::outputMode = Console::OutputMode::mode_human;
+Console::StatsHandler Console::statsHandler = nullptr;
+Console::ScreenHandler Console::screenHandler = nullptr;
+Console::ExportHandler Console::exportHandler = nullptr;
+Console::FilterHandler Console::filterHandler = nullptr;
+Console::AdaptHandler Console::adaptHandler = nullptr;
+Console::DerivedHandler Console::derivedHandler = nullptr;
+Console::PowerHandler Console::powerHandler = nullptr;
+Console::RateHandler Console::rateHandler = nullptr;
+Console::TimeHandler Console::timeHandler = nullptr;
+
+Console::Console(Stream *io, BME680 *bme, ConfigStore *cfgStore)
+{
+    stream = io;
+    sensor = bme;
+    store = cfgStore;
+    length = 0;
+    overflow = false;
+    replying = reply_none;
+    replyLine = 0;
+    replySeaLevel = 0;
+}
+
+void Console::setStatsHandler(StatsHandler handler)
+{
+    statsHandler = handler;
+}
+
+void Console::setScreenHandler(ScreenHandler handler)
+{
+    screenHandler = handler;
+}
+
+void Console::setExportHandler(ExportHandler handler)
+{
+    exportHandler = handler;
+}
+
+void Console::setFilterHandler(FilterHandler handler)
+{
+    filterHandler = handler;
+}
+
+void Console::setAdaptHandler(AdaptHandler handler)
+{
+    adaptHandler = handler;
+}
+
+void Console::setDerivedHandler(DerivedHandler handler)
+{
+    derivedHandler = handler;
+}
+
+void Console::setPowerHandler(PowerHandler handler)
+{
+    powerHandler = handler;
+}
+
+void Console::setRateHandler(RateHandler handler)
+{
+    rateHandler = handler;
+}
+
+void Console::setTimeHandler(TimeHandler handler)
+{
+    timeHandler = handler;
+}
+
+void Console::poll()
+{
+    // Only consume what has already been received, and at most POLL_BUDGET bytes,
+    // so that the sampling loop is never held up by a chatty peer. A command is read only once the
+    // previous reply is complete and the next one fits, so the output never waits either
+    continueReply();
+    uint8_t budget = POLL_BUDGET;
+    while (budget > 0 && replying == reply_none && stream->availableForWrite() >= REPLY_ROOM && stream->available() > 0)
+    {
+        int c = stream->read();
+        if (c < 0)
+        {
+            break;
+        }
+        feed((char)c);
+        budget--;
+    }
+}
+
+bool Console::isReplying()
+{
+    return replying != reply_none;
+}
+
+bool Console::feed(char c)
+{
+    if (c == '\r' || c == '\n')
+    {
+        bool complete = false;
+        if (overflow)
+        {
+            replyError(F("line too long"));
+            complete = true;
+        }
+        else if (length > 0)
+        {
+            line[length] = '\0';
+            execute(line);
+            complete = true;
+        }
+        length = 0;
+        overflow = false;
+        return complete;
+    }
+
+    // Keep room for the terminator, drop the rest of an overlong line
+    if (length < LINE_LENGTH - 1)
+    {
+        line[length++] = c;
+    }
+    else
+    {
+        overflow = true;
+    }
+    return false;
+}
+
+uint8_t Console::tokenize(char *cmd, char **tokens)
+{
+    uint8_t count = 0;
+    while (*cmd != '\0')
+    {
+        // Skip separators
+        while (*cmd == ' ' || *cmd == '\t')
+        {
+            *cmd++ = '\0';
+        }
+        if (*cmd == '\0')
+        {
+            break;
+        }
+        if (count == MAX_TOKENS)
+        {
+            return MAX_TOKENS + 1;
+        }
+        tokens[count++] = cmd;
+        // Skip token
+        while (*cmd != '\0' && *cmd != ' ' && *cmd != '\t')
+        {
+            cmd++;
+        }
+    }
+    return count;
+}
+
+bool Console::parseUnsigned(const char *str, uint16_t *value)
+{
+    uint32_t result;
+    if (!parseUnsignedLong(str, &result) || result > 65535)
+    {
+        return false;
+    }
+    *value = (uint16_t)result;
+    return true;
+}
+
+bool Console::parseUnsignedLong(const char *str, uint32_t *value)
+{
+    uint32_t result = 0;
+    if (*str == '\0')
+    {
+        return false;
+    }
+    while (*str != '\0')
+    {
+        if (*str < '0' || *str > '9')
+        {
+            return false;
+        }
+        uint8_t digit = *str - '0';
+        if (result > (0xFFFFFFFFUL - digit) / 10)
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+        str++;
+    }
+    *value = result;
+    return true;
+}
+
+void Console::execute(char *cmd)
+{
+    char *tokens[MAX_TOKENS];
+    uint8_t count = tokenize(cmd, tokens);
+
+    if (count == 0)
+    {
+        return;
+    }
+    if (count > MAX_TOKENS)
+    {
+        replyError(F("too many arguments"));
+        return;
+    }
+
+    if (strcmp_P(tokens[0], PSTR("help")) == 0)
+    {
+        startReply(reply_help);
+    }
+    else if (strcmp_P(tokens[0], PSTR("get")) == 0)
+    {
+        commandGet();
+        reply(F("OK"));
+    }
+    else if (strcmp_P(tokens[0], PSTR("set")) == 0)
+    {
+        if (count != 3)
+        {
+            replyError(F("usage: set <key> <value>"));
+            return;
+        }
+        commandSet(tokens[1], tokens[2]);
+    }
+    else if (strcmp_P(tokens[0], PSTR("defaults")) == 0)
+    {
+        sensor->setDefaultConfig();
+        sensor->applyConfig();
+        reply(F("OK"));
+    }
+    else if (strcmp_P(tokens[0], PSTR("save")) == 0)
+    {
+        if (store->save(sensor->config, rateHandler != nullptr ? rateHandler() : nullptr))
+        {
+            reply(F("OK"));
+        }
+        else
+        {
+            replyError(F("write failed"));
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("load")) == 0)
+    {
+        if (store->load(sensor->config, rateHandler != nullptr ? rateHandler() : nullptr))
+        {
+            sensor->applyConfig();
+            reply(F("OK"));
+        }
+        else
+        {
+            replyError(F("no valid configuration"));
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("stats")) == 0)
+    {
+        if (statsHandler != nullptr)
+        {
+            startReply(reply_stats);
+        }
+        else
+        {
+            reply(F("OK"));
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("mode")) == 0)
+    {
+        if (count != 2)
+        {
+            replyError(F("usage: mode <off|human|csv|sparse>"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("off")) == 0)
+        {
+            outputMode = OutputMode::mode_off;
+            reply(F("OK"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("human")) == 0)
+        {
+            outputMode = OutputMode::mode_human;
+            reply(F("OK"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("csv")) == 0)
+        {
+            outputMode = OutputMode::mode_csv;
+            reply(F("OK"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("sparse")) == 0)
+        {
+            outputMode = OutputMode::mode_sparse;
+            reply(F("OK"));
+        }
+        else
+        {
+            replyError(F("unknown mode"));
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("policy")) == 0)
+    {
+        if (count != 2)
+        {
+            replyError(F("usage: policy <drop|coalesce|aggregate>"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("drop")) == 0)
+        {
+            SampleOutput::policy = SampleOutput::Policy::policy_drop;
+            reply(F("OK"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("coalesce")) == 0)
+        {
+            SampleOutput::policy = SampleOutput::Policy::policy_coalesce;
+            reply(F("OK"));
+        }
+        else if (strcmp_P(tokens[1], PSTR("aggregate")) == 0)
+        {
+            SampleOutput::policy = SampleOutput::Policy::policy_aggregate;
+            reply(F("OK"));
+        }
+        else
+        {
+            replyError(F("unknown policy"));
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("filter")) == 0)
+    {
+        commandFilter(tokens, count);
+    }
+    else if (strcmp_P(tokens[0], PSTR("adapt")) == 0)
+    {
+        commandAdapt(tokens, count);
+    }
+    else if (strcmp_P(tokens[0], PSTR("power")) == 0)
+    {
+        commandPower(tokens, count);
+    }
+    else if (strcmp_P(tokens[0], PSTR("rate")) == 0)
+    {
+        commandRate(tokens, count);
+    }
+    else if (strcmp_P(tokens[0], PSTR("time")) == 0)
+    {
+        commandTime(tokens, count);
+    }
+    else if (strcmp_P(tokens[0], PSTR("derived")) == 0)
+    {
+        uint16_t seaLevel = 0;
+        if (count > 2 || (count == 2 && (!parseUnsigned(tokens[1], &seaLevel) || seaLevel < 300 || seaLevel > 1100)))
+        {
+            replyError(F("usage: derived [sea_level_hpa], 300 to 1100"));
+        }
+        else if (derivedHandler == nullptr)
+        {
+            replyError(F("derived metrics not available"));
+        }
+        else
+        {
+            replySeaLevel = seaLevel;
+            startReply(reply_derived);
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("screen")) == 0)
+    {
+        uint16_t screen;
+        if (count != 2 || !parseUnsigned(tokens[1], &screen) || screen > 255)
+        {
+            replyError(F("usage: screen <n>"));
+        }
+        else if (screenHandler == nullptr || !screenHandler((uint8_t)screen))
+        {
+            replyError(F("unknown screen"));
+        }
+        else
+        {
+            reply(F("OK"));
+        }
+    }
+    else if (strcmp_P(tokens[0], PSTR("export")) == 0)
+    {
+        uint16_t block = 0;
+        if (count > 2 || (count == 2 && !parseUnsigned(tokens[1], &block)))
+        {
+            replyError(F("usage: export [block]"));
+        }
+        else if (exportHandler == nullptr)
+        {
+            replyError(F("export not available"));
+        }
+        else
+        {
+            // Reply first: once the export starts, the stream only carries frames
+            reply(F("OK"));
+            if (!exportHandler(stream, count == 2, block))
+            {
+                replyError(F("block out of range"));
+            }
+        }
+    }
+    else
+    {
+        replyError(F("unknown command"));
+    }
+}
+
+void Console::commandGet()
+{
+    BME680::BMEConfig *cfg = sensor->config;
+    stream->print(F("osrs_t="));
+    stream->println((uint8_t)cfg->osrs_t);
+#if FEATURE_PRESSURE
+    stream->print(F("osrs_p="));
+    stream->println((uint8_t)cfg->osrs_p);
+#endif
+#if FEATURE_HUMIDITY
+    stream->print(F("osrs_h="));
+    stream->println((uint8_t)cfg->osrs_h);
+#endif
+    stream->print(F("filter="));
+    stream->println((uint8_t)cfg->filter);
+#if FEATURE_GAS
+    stream->print(F("gas="));
+    stream->println(cfg->run_gas ? 1 : 0);
+    stream->print(F("target="));
+    stream->println((int)cfg->target_temp);
+    stream->print(F("point="));
+    stream->println((uint8_t)cfg->set_point);
+#endif
+}
+
+void Console::commandSet(char *key, char *value)
+{
+    BME680::BMEConfig *cfg = sensor->config;
+    uint16_t v;
+
+    if (!parseUnsigned(value, &v))
+    {
+        replyError(F("invalid value"));
+        return;
+    }
+
+    if (strcmp_P(key, PSTR("osrs_t")) == 0 && v <= BME680::OversamplingMultipliers::orsrs_x16)
+    {
+        cfg->osrs_t = (BME680::OversamplingMultipliers)v;
+    }
+#if FEATURE_PRESSURE
+    else if (strcmp_P(key, PSTR("osrs_p")) == 0 && v <= BME680::OversamplingMultipliers::orsrs_x16)
+    {
+        cfg->osrs_p = (BME680::OversamplingMultipliers)v;
+    }
+#endif
+#if FEATURE_HUMIDITY
+    else if (strcmp_P(key, PSTR("osrs_h")) == 0 && v <= BME680::OversamplingMultipliers::orsrs_x16)
+    {
+        cfg->osrs_h = (BME680::OversamplingMultipliers)v;
+    }
+#endif
+    else if (strcmp_P(key, PSTR("filter")) == 0 && v <= BME680::FilterCoefficients::filter_127)
+    {
+        cfg->filter = (BME680::FilterCoefficients)v;
+    }
+#if FEATURE_GAS
+    else if (strcmp_P(key, PSTR("gas")) == 0 && v <= 1)
+    {
+        cfg->run_gas = (v == 1);
+    }
+    else if (strcmp_P(key, PSTR("target")) == 0 && v <= 400)
+    {
+        cfg->target_temp = v;
+    }
+    else if (strcmp_P(key, PSTR("point")) == 0 && v <= BME680::HeaterSetPoints::point_9)
+    {
+        cfg->set_point = (BME680::HeaterSetPoints)v;
+    }
+#endif
+    else
+    {
+        replyError(F("unknown key or value out of range"));
+        return;
+    }
+
+    sensor->applyConfig();
+    reply(F("OK"));
+}
+
+void Console::commandFilter(char **tokens, uint8_t count)
+{
+    // Channel letters, in SampleFilter::Channels order
+    static const char names[] PROGMEM = "thpg";
+
+    if (filterHandler == nullptr)
+    {
+        replyError(F("filter not available"));
+        return;
+    }
+
+    if (count == 1)
+    {
+        startReply(reply_filter);
+        return;
+    }
+
+    uint16_t window;
+    ChannelFilter::Parameters params;
+    const char *name = (tokens[1][1] == '\0') ? strchr_P(names, tokens[1][0]) : nullptr;
+    if (count != 5 || name == nullptr ||
+        !parseUnsigned(tokens[2], &window) || !parseUnsigned(tokens[3], &params.measurementNoise) ||
+        !parseUnsigned(tokens[4], &params.processNoise))
+    {
+        replyError(F("usage: filter [<t|h|p|g> <window> <noise> <process>]"));
+        return;
+    }
+    if (window < 1 || window > ChannelFilter::MEDIAN_MAX)
+    {
+        replyError(F("window out of range"));
+        return;
+    }
+    ChannelFilter *filter = filterHandler(name - names);
+    if (filter == nullptr)
+    {
+        replyError(F("channel not filtered"));
+        return;
+    }
+    params.window = (uint8_t)window;
+    filter->configure(&params);
+    reply(F("OK"));
+}
+
+void Console::commandAdapt(char **tokens, uint8_t count)
+{
+    if (adaptHandler == nullptr)
+    {
+        replyError(F("adapt not available"));
+        return;
+    }
+
+    if (count == 2 && strcmp_P(tokens[1], PSTR("off")) == 0)
+    {
+        adaptHandler(0, nullptr);
+        reply(F("OK"));
+        return;
+    }
+
+    uint16_t period;
+    uint8_t priorities[OversamplingController::CHANNELS];
+    if (count != 2 + OversamplingController::CHANNELS || !parseUnsigned(tokens[1], &period) || period == 0)
+    {
+        replyError(F("usage: adapt off | adapt <period_ms> <prio_t> <prio_p> <prio_h>"));
+        return;
+    }
+    for (uint8_t i = 0; i < OversamplingController::CHANNELS; i++)
+    {
+        uint16_t priority;
+        if (!parseUnsigned(tokens[2 + i], &priority) || priority > OversamplingController::MAX_PRIORITY)
+        {
+            replyError(F("priority out of range"));
+            return;
+        }
+        priorities[i] = (uint8_t)priority;
+    }
+    if (!adaptHandler(period, priorities))
+    {
+        replyError(F("period too short"));
+        return;
+    }
+    reply(F("OK"));
+}
+
+void Console::commandPower(char **tokens, uint8_t count)
+{
+    if (powerHandler == nullptr)
+    {
+        replyError(F("power not available"));
+        return;
+    }
+
+    if (count == 2 && strcmp_P(tokens[1], PSTR("off")) == 0)
+    {
+        powerHandler(false, PowerManager::display_bright);
+        reply(F("OK"));
+        return;
+    }
+
+    uint8_t display = PowerManager::display_dim;
+    bool valid = (count == 2 || count == 3) && strcmp_P(tokens[1], PSTR("on")) == 0;
+    if (valid && count == 3)
+    {
+        if (strcmp_P(tokens[2], PSTR("bright")) == 0)
+        {
+            display = PowerManager::display_bright;
+        }
+        else if (strcmp_P(tokens[2], PSTR("blank")) == 0)
+        {
+            display = PowerManager::display_blank;
+        }
+        else if (strcmp_P(tokens[2], PSTR("dim")) != 0)
+        {
+            valid = false;
+        }
+    }
+    if (!valid)
+    {
+        replyError(F("usage: power off | power on [bright|dim|blank]"));
+        return;
+    }
+    powerHandler(true, display);
+    reply(F("OK"));
+}
+
+void Console::commandRate(char **tokens, uint8_t count)
+{
+    // Channel letters, in AcquisitionPlanner channel order
+    static const char names[] PROGMEM = "thpg";
+
+    AcquisitionPlanner *planner = rateHandler != nullptr ? rateHandler() : nullptr;
+    if (planner == nullptr)
+    {
+        replyError(F("rate not available"));
+        return;
+    }
+
+    if (count == 1)
+    {
+        for (uint8_t i = 0; i < AcquisitionPlanner::CHANNELS; i++)
+        {
+            stream->print((char)pgm_read_byte(&names[i]));
+            stream->print('=');
+            stream->println(planner->getPeriod(i));
+        }
+        reply(F("OK"));
+        return;
+    }
+
+    uint16_t seconds;
+    const char *name = (tokens[1][1] == '\0') ? strchr_P(names, tokens[1][0]) : nullptr;
+    if (count != 3 || name == nullptr || !parseUnsigned(tokens[2], &seconds))
+    {
+        replyError(F("usage: rate [<t|h|p|g> <seconds>]"));
+        return;
+    }
+    planner->setPeriod(name - names, seconds);
+    reply(F("OK"));
+}
+
+void Console::commandTime(char **tokens, uint8_t count)
+{
+    if (timeHandler == nullptr)
+    {
+        replyError(F("time not available"));
+        return;
+    }
+
+    uint32_t seconds;
+    if (count == 1)
+    {
+        bool set = timeHandler(false, &seconds);
+        stream->print(F("time="));
+        stream->println(seconds);
+        stream->print(F("rtc="));
+        stream->println(set ? F("ok") : F("not set"));
+        reply(F("OK"));
+        return;
+    }
+    if (count != 2 || !parseUnsignedLong(tokens[1], &seconds))
+    {
+        replyError(F("usage: time [unix_s]"));
+        return;
+    }
+    if (!timeHandler(true, &seconds))
+    {
+        replyError(F("rtc not set"));
+        return;
+    }
+    reply(F("OK"));
+}
+
+void Console::startReply(uint8_t type)
+{
+    replying = type;
+    replyLine = 0;
+    continueReply();
+}
+
+void Console::continueReply()
+{
+    while (replying != reply_none && stream->availableForWrite() >= REPLY_ROOM)
+    {
+        if (!printReplyLine(replyLine++))
+        {
+            replying = reply_none;
+            reply(F("OK"));
+        }
+    }
+}
+
+bool Console::printReplyLine(uint8_t n)
+{
+    switch (replying)
+    {
+    case reply_help:
+        return printHelp(n);
+    case reply_stats:
+        return statsHandler(stream, n);
+    case reply_derived:
+    {
+        // The sea level pressure is set once, before the first line
+        uint16_t seaLevel = replySeaLevel;
+        replySeaLevel = 0;
+        return derivedHandler(stream, n, seaLevel);
+    }
+    case reply_filter:
+        return printFilter(n);
+    default:
+        return false;
+    }
+}
+
+bool Console::printHelp(uint8_t n)
+{
+    // Lines shorter than REPLY_ROOM
+    switch (n)
+    {
+    case 0:
+        stream->println(F("get | set <key> <value> | defaults | save | load | stats"));
+        break;
+    case 1:
+        stream->println(F("mode <off|human|csv|sparse> | policy <drop|coalesce|aggregate>"));
+        break;
+    case 2:
+        stream->println(F("filter [<t|h|p|g> <window> <noise> <process>]"));
+        break;
+    case 3:
+        stream->println(F("adapt off | adapt <period_ms> <prio_t> <prio_p> <prio_h>"));
+        break;
+    case 4:
+        stream->println(F("derived [sea_level_hpa] | power off | power on [bright|dim|blank]"));
+        break;
+    case 5:
+        stream->println(F("rate [<t|h|p|g> <seconds>] | time [unix_s] | screen <n> | export [block]"));
+        break;
+    case 6:
+        stream->println(F("keys: osrs_t" HELP_KEY_PRESSURE HELP_KEY_HUMIDITY " (0-5) filter (0-7)"));
+        break;
+    case 7:
+#if FEATURE_GAS
+        stream->println(F("keys: gas (0-1) target (degC) point (0-9)"));
+#endif
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool Console::printFilter(uint8_t n)
+{
+    // Channel letters, in SampleFilter::Channels order
+    static const char names[] PROGMEM = "thpg";
+
+    if (n >= SampleFilter::filter_channels)
+    {
+        return false;
+    }
+    ChannelFilter *filter = filterHandler(n);
+    if (filter == nullptr)
+    {
+        return true;
+    }
+    const ChannelFilter::Parameters *params = filter->getParameters();
+    stream->print((char)pgm_read_byte(&names[n]));
+    stream->print(F(": window="));
+    stream->print(params->window);
+    stream->print(F(" noise="));
+    stream->print(params->measurementNoise);
+    stream->print(F(" process="));
+    stream->println(params->processNoise);
+    return true;
+}
+
+void Console::reply(const __FlashStringHelper *message)
+{
+    stream->println(message);
+}
+
+void Console::replyError(const __FlashStringHelper *reason)
+{
+    stream->print(F("ERR "));
+    stream->println(reason);
+}
@@ -0,0 +1,328 @@
+/**
+ * @file console.h
+ * @author Riccardo Iacob
+ * @brief Line-oriented command console for runtime reconfiguration
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+#include "bme680.h"
+#include "configstore.h"
+#include "filter.h"
+#include "acqplan.h"
+
+/**
+ * Commands (one per line, terminated by CR and/or LF):
+ * help                  Lists the available commands
+ * get                   Prints the current sensor configuration
+ * set <key> <value>     Changes a configuration field (osrs_t, osrs_p, osrs_h, filter, gas, target, point)
+ * defaults              Restores the default configuration
+ * save                  Persists the configuration to EEPROM
+ * load                  Loads the newest valid configuration from EEPROM
+ * stats                 Prints runtime statistics
+ * mode <off|human|csv|sparse>
+ *                       Selects the sample output mode (sparse: RTC-stamped records of the
+ *                       channels measured, see sampleout.h)
+ * policy <drop|coalesce|aggregate>
+ *                       Selects what happens to samples the link is too slow for (see sampleout.h)
+ * filter [<t|h|p|g> <window> <noise> <process>]
+ *                       Prints the software filter parameters, or sets those of a channel (see filter.h)
+ * adapt off | adapt <period_ms> <prio_t> <prio_p> <prio_h>
+ *                       Disables, or enables with a sample period and noise priorities (0-3), the
+ *                       adaptive oversampling controller (see osctrl.h); it overrides osrs_* and filter
+ * derived [sea_level_hpa] Prints dew point (degC), absolute humidity (g/m3) and altitude (m),
+ *                       optionally setting the sea level pressure used for the altitude
+ * power off | power on [bright|dim|blank]
+ *                       Disables, or enables with a display mode, low-power operation (see power.h)
+ * rate [<t|h|p|g> <seconds>]
+ *                       Prints the acquisition period of each channel, or sets one (0 = every
+ *                       conversion, see acqplan.h)
+ * time [unix_s]         Prints the time records are stamped with, or sets the RTC
+ * screen <n>            Selects the display screen (0 welcome, 1 live, 2 trends, 3 status)
+ * export [block]        Starts a binary history transfer from the oldest block, or resumes it from
+ *                       a block sequence number (see histxfer.h)
+ *
+ * Every command is answered with "OK" or "ERR <reason>".
+ *
+ * Replies never wait for the link: a command is only read once the stream has REPLY_ROOM bytes of
+ * room, which holds any single-piece reply. The long ones (help, stats, derived, the filter list)
+ * are written one line at a time, each once there is room for it again, from the following calls
+ * of poll(); no command is read until the reply is complete.
+ */
+class Console
+{
+public:
+    /**
+     * @brief Sample output modes
+     */
+    enum class OutputMode
+    {
+        mode_off,
+        mode_human,
+        mode_csv,
+        mode_sparse
+    };
+
+    /**
+     * @brief Callback printing a line of the runtime statistics on the given output, returns false
+     * past the last line; a line may be empty (a statistic compiled out)
+     */
+    typedef bool (*StatsHandler)(Print *out, uint8_t line);
+
+    /**
+     * @brief Callback selecting a display screen, returns false if the screen does not exist
+     */
+    typedef bool (*ScreenHandler)(uint8_t screen);
+
+    /**
+     * @brief Callback starting a history export on the given stream, returns false if it cannot start
+     */
+    typedef bool (*ExportHandler)(Stream *io, bool resume, uint16_t blockSequence);
+
+    /**
+     * @brief Callback returning the software filter of a channel (SampleFilter::Channels), nullptr if none
+     */
+    typedef ChannelFilter *(*FilterHandler)(uint8_t channel);
+
+    /**
+     * @brief Callback configuring adaptive oversampling (period 0 disables it), returns false if the period is too short
+     */
+    typedef bool (*AdaptHandler)(uint16_t periodMillis, const uint8_t *priorities);
+
+    /**
+     * @brief Callback printing a line of the derived metrics, returns false past the last line; the
+     * sea level pressure is set first if not 0 (it is only passed with line 0)
+     */
+    typedef bool (*DerivedHandler)(Print *out, uint8_t line, uint16_t seaLevelHpa);
+
+    /**
+     * @brief Callback turning low-power operation on or off, with a display mode (PowerManager::DisplayModes)
+     */
+    typedef void (*PowerHandler)(bool enable, uint8_t display);
+
+    /**
+     * @brief Callback returning the acquisition planner, nullptr if none
+     */
+    typedef AcquisitionPlanner *(*RateHandler)();
+
+    /**
+     * @brief Callback reading (set false) or setting the time in Unix seconds, returns false if
+     * the RTC is not set (read) or could not be written (set)
+     */
+    typedef bool (*TimeHandler)(bool set, uint32_t *seconds);
+
+    // Maximum line length, including the terminator
+    static const uint8_t LINE_LENGTH = 48;
+    // Maximum number of tokens in a line
+    static const uint8_t MAX_TOKENS = 5;
+    // Maximum number of bytes consumed from the receive buffer in a single poll()
+    static const uint8_t POLL_BUDGET = 32;
+    // Output room needed to read a command or to write the next line of a long reply
+    static const uint8_t REPLY_ROOM = 80;
+
+    // Output mode shared by all consoles
+    static OutputMode outputMode;
+
+private:
+    /**
+     * @brief Replies written one line at a time
+     */
+    enum Replies
+    {
+        reply_none,
+        reply_help,
+        reply_stats,
+        reply_derived,
+        reply_filter
+    };
+
+    Stream *stream;
+    BME680 *sensor;
+    ConfigStore *store;
+    static StatsHandler statsHandler;
+    static ScreenHandler screenHandler;
+    static ExportHandler exportHandler;
+    static FilterHandler filterHandler;
+    static AdaptHandler adaptHandler;
+    static DerivedHandler derivedHandler;
+    static PowerHandler powerHandler;
+    static RateHandler rateHandler;
+    static TimeHandler timeHandler;
+
+    char line[LINE_LENGTH];
+    uint8_t length;
+    bool overflow;
+
+    // Reply in progress (Replies), its next line and the sea level pressure of "derived"
+    uint8_t replying;
+    uint8_t replyLine;
+    uint16_t replySeaLevel;
+
+    /**
+     * @brief Executes a complete, NUL-terminated line
+     *
+     * @param cmd: The line (tokenized in place)
+     */
+    void execute(char *cmd);
+
+    void commandGet();
+    void commandSet(char *key, char *value);
+    void commandFilter(char **tokens, uint8_t count);
+    void commandAdapt(char **tokens, uint8_t count);
+    void commandPower(char **tokens, uint8_t count);
+    void commandRate(char **tokens, uint8_t count);
+    void commandTime(char **tokens, uint8_t count);
+
+    /**
+     * @brief Starts a reply written one line at a time, and writes what fits now
+     *
+     * @param type: The reply (Replies)
+     */
+    void startReply(uint8_t type);
+
+    /**
+     * @brief Writes the next lines of the reply in progress while the stream has room, then "OK"
+     */
+    void continueReply();
+
+    /**
+     * @brief Prints a line of the reply in progress
+     *
+     * @param n: The line number
+     * @return bool: False past the last line
+     */
+    bool printReplyLine(uint8_t n);
+
+    bool printHelp(uint8_t n);
+    bool printFilter(uint8_t n);
+
+    void reply(const __FlashStringHelper *message);
+    void replyError(const __FlashStringHelper *reason);
+
+public:
+    /**
+     * @brief Constructs a new Console object
+     *
+     * @param io: The stream commands are read from and replies are written to
+     * @param bme: The sensor whose configuration is exposed
+     * @param cfgStore: The storage used by the "save" and "load" commands
+     */
+    Console(Stream *io, BME680 *bme, ConfigStore *cfgStore);
+
+    /**
+     * @brief Sets the callback used by the "stats" command
+     *
+     * @param handler: The statistics callback
+     */
+    static void setStatsHandler(StatsHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "screen" command
+     *
+     * @param handler: The screen selection callback
+     */
+    static void setScreenHandler(ScreenHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "export" command
+     *
+     * @param handler: The export callback
+     */
+    static void setExportHandler(ExportHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "filter" command
+     *
+     * @param handler: The filter lookup callback
+     */
+    static void setFilterHandler(FilterHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "adapt" command
+     *
+     * @param handler: The adaptive oversampling callback
+     */
+    static void setAdaptHandler(AdaptHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "derived" command
+     *
+     * @param handler: The derived metrics callback
+     */
+    static void setDerivedHandler(DerivedHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "power" command
+     *
+     * @param handler: The low-power mode callback
+     */
+    static void setPowerHandler(PowerHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "rate" command
+     *
+     * @param handler: The acquisition planner callback
+     */
+    static void setRateHandler(RateHandler handler);
+
+    /**
+     * @brief Sets the callback used by the "time" command
+     *
+     * @param handler: The time callback
+     */
+    static void setTimeHandler(TimeHandler handler);
+
+    /**
+     * @brief Continues the reply in progress, then consumes the bytes already in the receive
+     * buffer, never waiting for more input or for room in the output
+     */
+    void poll();
+
+    /**
+     * @brief Checks whether a reply is still being written (its command was answered in part)
+     */
+    bool isReplying();
+
+    /**
+     * @brief Feeds a single character to the parser
+     *
+     * @param c: The received character
+     * @return bool: True if the character completed a line (which was then executed)
+     */
+    bool feed(char c);
+
+    /**
+     * @brief Splits a line into whitespace separated tokens, in place
+     *
+     * @param cmd: The line to be tokenized
+     * @param tokens: Output token array of MAX_TOKENS elements
+     * @return uint8_t: The number of tokens found, MAX_TOKENS + 1 if there are too many
+     */
+    static uint8_t tokenize(char *cmd, char **tokens);
+
+    /**
+     * @brief Parses an unsigned decimal number
+     *
+     * @param str: The string to be parsed
+     * @param value: The parsed value (written only on success)
+     * @return bool: True if the whole string is a valid number not greater than 65535
+     */
+    static bool parseUnsigned(const char *str, uint16_t *value);
+
+    /**
+     * @brief Parses an unsigned decimal number of up to 32 bits
+     *
+     * @param str: The string to be parsed
+     * @param value: The parsed value (written only on success)
+     * @return bool: True if the whole string is a valid number not greater than 4294967295
+     */
+    static bool parseUnsignedLong(const char *str, uint32_t *value);
+};
+
+#endif
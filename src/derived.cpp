@@ -0,0 +1,207 @@
+/**
+ * @file derived.cpp
+ * @author Riccardo Iacob
+ * @brief Dew point, absolute humidity and barometric altitude from PROGMEM interpolation tables
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "derived.h"
+
+// Saturation vapour pressure in deci-Pa, from -40 °C in steps of 1 °C
+#define ES_FIRST_CENTI_C -4000
+#define ES_STEP_CENTI_C 100
+#define ES_ENTRIES 126
+static const uint32_t saturationTable[ES_ENTRIES] PROGMEM = {
+    190, 211, 234, 259, 286, 316, 348, 384, 423, 465,
+    512, 562, 617, 676, 741, 811, 887, 970, 1059, 1155,
+    1260, 1372, 1494, 1625, 1766, 1919, 2083, 2259, 2448, 2652,
+    2870, 3105, 3356, 3625, 3913, 4222, 4552, 4904, 5281, 5683,
+    6112, 6569, 7057, 7576, 8129, 8717, 9343, 10008, 10714, 11464,
+    12260, 13105, 14000, 14948, 15953, 17017, 18142, 19333, 20591, 21921,
+    23326, 24809, 26374, 28025, 29766, 31601, 33533, 35569, 37711, 39966,
+    42337, 44830, 47450, 50203, 53094, 56128, 59313, 62653, 66156, 69827,
+    73675, 77704, 81924, 86341, 90963, 95797, 100852, 106137, 111659, 117427,
+    123452, 129741, 136304, 143152, 150294, 157742, 165504, 173593, 182020, 190796,
+    199933, 209443, 219338, 229632, 240337, 251467, 263035, 275056, 287543, 300512,
+    313977, 327954, 342458, 357506, 373114, 389299, 406077, 423468, 441487, 460155,
+    479489, 499508, 520232, 541681, 563875, 586834};
+
+// Altitude in tenths of m, for p / p0 from 38/128 in steps of 1/128
+#define ALT_FIRST_INDEX 38
+#define ALT_ENTRIES 105
+// Fractional bits of p / p0, and of the position within a step
+#define ALT_RATIO_BITS 24
+#define ALT_STEP_BITS (ALT_RATIO_BITS - 7)
+static const int32_t altitudeTable[ALT_ENTRIES] PROGMEM = {
+    91459, 89716, 88009, 86336, 84695, 83086, 81507, 79957, 78434, 76938,
+    75468, 74022, 72599, 71200, 69823, 68467, 67131, 65816, 64519, 63242,
+    61982, 60740, 59514, 58305, 57112, 55935, 54772, 53625, 52491, 51371,
+    50265, 49172, 48091, 47023, 45967, 44923, 43890, 42869, 41859, 40859,
+    39870, 38891, 37922, 36962, 36013, 35072, 34141, 33219, 32305, 31400,
+    30503, 29615, 28734, 27862, 26997, 26140, 25290, 24448, 23612, 22784,
+    21963, 21148, 20340, 19539, 18743, 17955, 17172, 16395, 15625, 14860,
+    14101, 13348, 12600, 11858, 11121, 10389, 9663, 8942, 8226, 7515,
+    6808, 6107, 5410, 4718, 4031, 3348, 2670, 1996, 1326, 661,
+    0, -657, -1310, -1958, -2603, -3244, -3881, -4514, -5143, -5769,
+    -6390, -7009, -7623, -8234, -8842};
+
+DerivedMetrics::DerivedMetrics()
+{
+    temperature = 0;
+    humidity = 0;
+    pressure = STANDARD_SEA_LEVEL;
+    seaLevel = STANDARD_SEA_LEVEL;
+    valid = 0;
+}
+
+void DerivedMetrics::update(const SampleRecord *sample)
+{
+    temperature = sample->temperature;
+    humidity = sample->humidity;
+    pressure = sample->pressure;
+    valid = 0;
+}
+
+void DerivedMetrics::setSeaLevelPressure(uint32_t pascal)
+{
+    seaLevel = pascal;
+    valid &= ~metric_altitude;
+}
+
+uint32_t DerivedMetrics::getSeaLevelPressure()
+{
+    return seaLevel;
+}
+
+uint32_t DerivedMetrics::saturationPressure(int16_t centiC)
+{
+    int32_t position = (int32_t)centiC - ES_FIRST_CENTI_C;
+    if (position <= 0)
+    {
+        return pgm_read_dword(&saturationTable[0]);
+    }
+    uint8_t index = position / ES_STEP_CENTI_C;
+    if (index >= ES_ENTRIES - 1)
+    {
+        return pgm_read_dword(&saturationTable[ES_ENTRIES - 1]);
+    }
+    uint16_t fraction = position % ES_STEP_CENTI_C;
+    uint32_t a = pgm_read_dword(&saturationTable[index]);
+    uint32_t b = pgm_read_dword(&saturationTable[index + 1]);
+    return a + ((b - a) * fraction + ES_STEP_CENTI_C / 2) / ES_STEP_CENTI_C;
+}
+
+int16_t DerivedMetrics::saturationTemperature(uint32_t deciPa)
+{
+    if (deciPa <= pgm_read_dword(&saturationTable[0]))
+    {
+        return ES_FIRST_CENTI_C;
+    }
+    if (deciPa >= pgm_read_dword(&saturationTable[ES_ENTRIES - 1]))
+    {
+        return ES_FIRST_CENTI_C + (ES_ENTRIES - 1) * ES_STEP_CENTI_C;
+    }
+
+    // Binary search of the segment holding deciPa, the table is increasing
+    uint8_t low = 0;
+    uint8_t high = ES_ENTRIES - 1;
+    while (high - low > 1)
+    {
+        uint8_t middle = (low + high) / 2;
+        if (pgm_read_dword(&saturationTable[middle]) <= deciPa)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    uint32_t a = pgm_read_dword(&saturationTable[low]);
+    uint32_t b = pgm_read_dword(&saturationTable[high]);
+    uint32_t span = b - a;
+    return ES_FIRST_CENTI_C + low * ES_STEP_CENTI_C + (int16_t)(((deciPa - a) * ES_STEP_CENTI_C + span / 2) / span);
+}
+
+int32_t DerivedMetrics::barometricAltitude(uint32_t pascal, uint32_t seaLevelPascal)
+{
+    if (seaLevelPascal == 0)
+    {
+        return 0;
+    }
+
+    // p / p0 in Q24 by long division, every step fits 32 bits for pressures below 262 kPa
+    uint32_t high = (pascal << 14) / seaLevelPascal;
+    uint32_t remainder = (pascal << 14) % seaLevelPascal;
+    uint32_t ratio = (high << 10) + (remainder << 10) / seaLevelPascal;
+
+    uint32_t index = ratio >> ALT_STEP_BITS;
+    if (index < ALT_FIRST_INDEX)
+    {
+        return (int32_t)pgm_read_dword(&altitudeTable[0]);
+    }
+    index -= ALT_FIRST_INDEX;
+    if (index >= ALT_ENTRIES - 1)
+    {
+        return (int32_t)pgm_read_dword(&altitudeTable[ALT_ENTRIES - 1]);
+    }
+    int32_t fraction = ratio & (((uint32_t)1 << ALT_STEP_BITS) - 1);
+    int32_t a = (int32_t)pgm_read_dword(&altitudeTable[index]);
+    int32_t b = (int32_t)pgm_read_dword(&altitudeTable[index + 1]);
+    // b < a, the step is at most about 1800 dm, so the product fits 31 bits
+    return a - (((a - b) * fraction + ((int32_t)1 << (ALT_STEP_BITS - 1))) >> ALT_STEP_BITS);
+}
+
+uint32_t DerivedMetrics::getVapourPressure()
+{
+    if (!(valid & metric_vapour))
+    {
+        // e = es * RH / 10000, RH in centi-%; pre-scaled when es * RH would not fit 32 bits
+        uint32_t saturation = saturationPressure(temperature);
+        uint16_t rh = humidity > 10000 ? 10000 : humidity;
+        if (saturation < 0xFFFFFFFF / 10000)
+        {
+            vapourPressure = (saturation * rh + 5000) / 10000;
+        }
+        else
+        {
+            vapourPressure = ((saturation >> 4) * rh + 312) / 625;
+        }
+        valid |= metric_vapour;
+    }
+    return vapourPressure;
+}
+
+int16_t DerivedMetrics::getDewPoint()
+{
+    if (!(valid & metric_dew_point))
+    {
+        dewPoint = saturationTemperature(getVapourPressure());
+        valid |= metric_dew_point;
+    }
+    return dewPoint;
+}
+
+uint16_t DerivedMetrics::getAbsoluteHumidity()
+{
+    if (!(valid & metric_absolute_humidity))
+    {
+        // 2.167 * e[Pa] / T[K] g/m^3 = 2167 * e[dPa] / T[cK] centi-g/m^3
+        uint32_t kelvin = (uint32_t)((int32_t)temperature + 27315);
+        absoluteHumidity = (uint16_t)((getVapourPressure() * 2167 + kelvin / 2) / kelvin);
+        valid |= metric_absolute_humidity;
+    }
+    return absoluteHumidity;
+}
+
+int32_t DerivedMetrics::getAltitude()
+{
+    if (!(valid & metric_altitude))
+    {
+        altitude = barometricAltitude(pressure, seaLevel);
+        valid |= metric_altitude;
+    }
+    return altitude;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file derived.h
+ * @author Riccardo Iacob
+ * @brief Dew point, absolute humidity and barometric altitude from PROGMEM interpolation tables
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef DERIVED_H
+#define DERIVED_H
+
+#include <Arduino.h>
+
+#include "sample.h"
+
+/**
+ * No log, exp or pow at runtime: the functions are tabulated in PROGMEM and linearly interpolated
+ * in integer arithmetic.
+ *
+ * Saturation vapour pressure (Magnus, over water): es(T) = 611.2 * exp(17.62 T / (243.12 + T)) Pa,
+ * tabulated every 1 °C from -40 to +85 °C (504 bytes). The actual vapour pressure is e = es(T) * RH;
+ *   dew point          T such that es(T) = e (the table searched backwards)
+ *   absolute humidity  2.167 * e / T[K] g/m^3
+ * Barometric altitude: h = 44330.77 * (1 - (p / p0)^0.190263) m, tabulated every 1/128 of p / p0
+ * from 0.297 to 1.109 (about +9100 m to -880 m, 420 bytes).
+ *
+ * Largest error against the double-precision formulas, interpolation and rounding included:
+ *   dew point          0.07 °C for dew points from -40 to +85 °C
+ *   absolute humidity  0.06 g/m^3 (at 85 °C, where it exceeds 300 g/m^3), 0.03 g/m^3 below 50 °C
+ *   altitude           0.16 m below 2000 m, 0.51 m up to 9000 m
+ * Outside the tables the result is clamped to the nearest table end.
+ *
+ * Values are computed lazily: update() only stores the inputs, each getter computes its value
+ * the first time it is asked for after an update.
+ */
+class DerivedMetrics
+{
+public:
+    // Standard sea level pressure, in Pa
+    static const uint32_t STANDARD_SEA_LEVEL = 101325;
+
+private:
+    int16_t temperature;
+    uint16_t humidity;
+    uint32_t pressure;
+    uint32_t seaLevel;
+
+    // Cached results and their validity (Metrics flags)
+    uint8_t valid;
+    // Vapour pressure, in deci-Pa
+    uint32_t vapourPressure;
+    int16_t dewPoint;
+    uint16_t absoluteHumidity;
+    int32_t altitude;
+
+    enum Metrics
+    {
+        metric_vapour = 0x01,
+        metric_dew_point = 0x02,
+        metric_absolute_humidity = 0x04,
+        metric_altitude = 0x08
+    };
+
+    uint32_t getVapourPressure();
+
+public:
+    DerivedMetrics();
+
+    /**
+     * @brief Stores new inputs, invalidating the cached results
+     *
+     * @param sample: A compensated sample (temperature, humidity and pressure are used)
+     */
+    void update(const SampleRecord *sample);
+
+    /**
+     * @brief Sets the pressure at sea level used for the altitude
+     *
+     * @param pascal: The reference pressure, in Pa
+     */
+    void setSeaLevelPressure(uint32_t pascal);
+
+    /**
+     * @brief Gets the pressure at sea level used for the altitude, in Pa
+     */
+    uint32_t getSeaLevelPressure();
+
+    /**
+     * @brief Gets the dew point, in hundredths of °C
+     */
+    int16_t getDewPoint();
+
+    /**
+     * @brief Gets the absolute humidity, in hundredths of g/m^3
+     */
+    uint16_t getAbsoluteHumidity();
+
+    /**
+     * @brief Gets the barometric altitude, in tenths of m
+     */
+    int32_t getAltitude();
+
+    /**
+     * @brief Computes the saturation vapour pressure
+     *
+     * @param centiC: Temperature, in hundredths of °C
+     * @return uint32_t: Saturation vapour pressure, in deci-Pa
+     */
+    static uint32_t saturationPressure(int16_t centiC);
+
+    /**
+     * @brief Computes the temperature at which the vapour pressure is saturated
+     *
+     * @param deciPa: Vapour pressure, in deci-Pa
+     * @return int16_t: The temperature, in hundredths of °C
+     */
+    static int16_t saturationTemperature(uint32_t deciPa);
+
+    /**
+     * @brief Computes the barometric altitude
+     *
+     * @param pascal: The pressure, in Pa
+     * @param seaLevelPascal: The pressure at sea level, in Pa
+     * @return int32_t: The altitude, in tenths of m
+     */
+    static int32_t barometricAltitude(uint32_t pascal, uint32_t seaLevelPascal);
+};
+
+#endif
@@ -9,7 +9,143 @@
  */
 #include "ds3231.h"
 
+// Days before the first of each month, in a non-leap year
+static const uint16_t daysBeforeMonth[12] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+static uint8_t fromBcd(uint8_t value)
+{
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+static uint8_t toBcd(uint8_t value)
+{
+    return ((value / 10) << 4) | (value % 10);
+}
+
 DS3231::DS3231(uint8_t i2cAddress)
 {
     i2cAdd = i2cAddress;
-}
\ No newline at end of file
+}
+
+bool DS3231::readRegisters(uint8_t registerAddress, uint8_t *data, uint8_t count)
+{
+    // Bounded by the I2CBus timeout like every other transaction
+    Wire.beginTransmission(i2cAdd);
+    Wire.write(registerAddress);
+    if (Wire.endTransmission(true) != 0 || Wire.requestFrom(i2cAdd, count, (uint8_t) true) != count)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        data[i] = Wire.read();
+    }
+    return true;
+}
+
+bool DS3231::writeRegisters(uint8_t registerAddress, const uint8_t *data, uint8_t count)
+{
+    Wire.beginTransmission(i2cAdd);
+    Wire.write(registerAddress);
+    Wire.write(data, count);
+    return Wire.endTransmission(true) == 0;
+}
+
+bool DS3231::readTime(uint32_t *seconds)
+{
+    // status: OSF<7>, set when the oscillator stopped (first power-up, flat backup battery)
+    uint8_t status;
+    uint8_t registers[7];
+    if (!readRegisters(RegisterAddresses::ADD_STATUS, &status, 1) || (status & 0x80) ||
+        !readRegisters(RegisterAddresses::ADD_SECONDS, registers, 7))
+    {
+        return false;
+    }
+    *seconds = registersToUnix(registers);
+    return true;
+}
+
+bool DS3231::setTime(uint32_t seconds)
+{
+    if (seconds < EPOCH_2000 || seconds >= EPOCH_2100)
+    {
+        return false;
+    }
+    uint8_t registers[7];
+    unixToRegisters(seconds, registers);
+    uint8_t status;
+    if (!writeRegisters(RegisterAddresses::ADD_SECONDS, registers, 7) ||
+        !readRegisters(RegisterAddresses::ADD_STATUS, &status, 1))
+    {
+        return false;
+    }
+    status &= ~0x80;
+    return writeRegisters(RegisterAddresses::ADD_STATUS, &status, 1);
+}
+
+uint32_t DS3231::registersToUnix(const uint8_t *registers)
+{
+    // seconds, minutes, hours (12-hour mode<6>, PM<5>), day of week, date, month (century<7>), year
+    uint8_t second = fromBcd(registers[0] & 0x7F);
+    uint8_t minute = fromBcd(registers[1] & 0x7F);
+    uint8_t hour;
+    if (registers[2] & 0x40)
+    {
+        hour = fromBcd(registers[2] & 0x1F) % 12 + ((registers[2] & 0x20) ? 12 : 0);
+    }
+    else
+    {
+        hour = fromBcd(registers[2] & 0x3F);
+    }
+    uint8_t date = fromBcd(registers[4] & 0x3F);
+    uint8_t month = fromBcd(registers[5] & 0x1F);
+    uint8_t year = fromBcd(registers[6]);
+    month = month < 1 ? 1 : (month > 12 ? 12 : month);
+
+    // Every fourth year from 2000 is a leap year up to 2099
+    uint16_t days = (uint16_t)year * 365 + (year + 3) / 4 + pgm_read_word(&daysBeforeMonth[month - 1]) + date - 1;
+    if ((year & 0x03) == 0 && month > 2)
+    {
+        days++;
+    }
+    return EPOCH_2000 + (uint32_t)days * 86400UL + (uint32_t)hour * 3600UL + (uint16_t)minute * 60 + second;
+}
+
+void DS3231::unixToRegisters(uint32_t seconds, uint8_t *registers)
+{
+    seconds -= EPOCH_2000;
+    uint16_t days = seconds / 86400UL;
+    uint32_t time = seconds % 86400UL;
+    registers[0] = toBcd(time % 60);
+    registers[1] = toBcd((time / 60) % 60);
+    registers[2] = toBcd(time / 3600);
+    // 2000-01-01 was a Saturday; day of week 1 = Sunday
+    registers[3] = (days + 6) % 7 + 1;
+
+    uint8_t year = 0;
+    while (true)
+    {
+        uint16_t yearDays = (year & 0x03) == 0 ? 366 : 365;
+        if (days < yearDays)
+        {
+            break;
+        }
+        days -= yearDays;
+        year++;
+    }
+    bool leap = (year & 0x03) == 0;
+    uint8_t month = 12;
+    while (month > 1)
+    {
+        uint16_t start = pgm_read_word(&daysBeforeMonth[month - 1]) + (leap && month > 2 ? 1 : 0);
+        if (days >= start)
+        {
+            days -= start;
+            break;
+        }
+        month--;
+    }
+    registers[4] = toBcd(days + 1);
+    registers[5] = toBcd(month);
+    registers[6] = toBcd(year);
+}
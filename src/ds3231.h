@@ -11,14 +11,68 @@
 #define DS3231_H
 
 #include <Arduino.h>
+#include <Wire.h>
 
+/**
+ * Time is exchanged as Unix time (seconds since 1970-01-01 00:00:00 UTC); the DS3231 calendar
+ * covers 2000 to 2099, in 24-hour mode.
+ */
 class DS3231
 {
+public:
+    /**
+     * @brief DS3231 register addresses
+     */
+    enum RegisterAddresses
+    {
+        ADD_SECONDS = 0x00,
+        ADD_CONTROL = 0x0E,
+        ADD_STATUS = 0x0F
+    };
+
+    // Unix time of 2000-01-01 00:00:00 and of 2100-01-01 00:00:00, the calendar range
+    static const uint32_t EPOCH_2000 = 946684800UL;
+    static const uint32_t EPOCH_2100 = 4102444800UL;
+
 private:
     uint8_t i2cAdd;
 
+    bool readRegisters(uint8_t registerAddress, uint8_t *data, uint8_t count);
+    bool writeRegisters(uint8_t registerAddress, const uint8_t *data, uint8_t count);
+
 public:
+    /**
+     * @brief Constructs a new DS3231 object
+     *
+     * @param i2cAddress: The I2C address of the DS3231 (0x68)
+     */
     DS3231(uint8_t i2cAddress);
+
+    /**
+     * @brief Reads the current time
+     *
+     * @param seconds: Output Unix time (written only on success)
+     * @return bool: False on a bus error, or if the oscillator stopped since the time was last set
+     */
+    bool readTime(uint32_t *seconds);
+
+    /**
+     * @brief Sets the time and clears the oscillator stop flag
+     *
+     * @param seconds: Unix time, from EPOCH_2000 to EPOCH_2100
+     * @return bool: True if the time is in range and was written
+     */
+    bool setTime(uint32_t seconds);
+
+    /**
+     * @brief Converts the time registers (seconds to year, 7 bytes, BCD) to Unix time
+     */
+    static uint32_t registersToUnix(const uint8_t *registers);
+
+    /**
+     * @brief Converts Unix time (from EPOCH_2000 to EPOCH_2100) to the time registers (7 bytes, BCD)
+     */
+    static void unixToRegisters(uint32_t seconds, uint8_t *registers);
 };
 
-#endif
\ No newline at end of file
+#endif
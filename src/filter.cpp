@@ -0,0 +1,209 @@
+/**
+ * @file filter.cpp
+ * @author Riccardo Iacob
+ * @brief Fixed-point per-channel filtering: median spike rejection and a 1-D Kalman filter
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "filter.h"
+
+// Default window, measurement noise and process noise of each channel, in SampleRecord units
+static const ChannelFilter::Parameters defaultParameters[SampleFilter::filter_channels] = {
+    {3, 4, 1},     // Temperature, centi-°C
+    {3, 20, 4},    // Humidity, centi-%
+    {3, 3, 1},     // Pressure, Pa
+    {5, 2000, 300} // Gas resistance, Ohm
+};
+
+static const uint32_t ONE = (uint32_t)1 << ChannelFilter::FRACTION_BITS;
+
+ChannelFilter::ChannelFilter()
+{
+    configure(&defaultParameters[0]);
+}
+
+void ChannelFilter::configure(const Parameters *params)
+{
+    parameters = *params;
+    if (parameters.window < 1)
+    {
+        parameters.window = 1;
+    }
+    if (parameters.window > MEDIAN_MAX)
+    {
+        parameters.window = MEDIAN_MAX;
+    }
+
+    // Computed once here, so update() only needs 32-bit division. q^2 / r^2 is divided in 32 bits
+    // and the fractional bits are produced one at a time, which avoids the 64-bit division routine
+    uint32_t r = parameters.measurementNoise > 0 ? parameters.measurementNoise : 1;
+    uint32_t divisor = r * r;
+    uint32_t square = (uint32_t)parameters.processNoise * parameters.processNoise;
+    uint32_t ratio = square / divisor;
+    uint32_t rest = square % divisor;
+    for (uint8_t i = 0; i < FRACTION_BITS; i++)
+    {
+        if (ratio > 0x3FFFFFFF)
+        {
+            ratio = 0x7FFFFFFF;
+            break;
+        }
+        bool carry = rest & 0x80000000UL;
+        rest <<= 1;
+        ratio <<= 1;
+        if (carry || rest >= divisor)
+        {
+            rest -= divisor;
+            ratio |= 1;
+        }
+    }
+    noiseRatio = ratio;
+    reset();
+}
+
+const ChannelFilter::Parameters *ChannelFilter::getParameters()
+{
+    return &parameters;
+}
+
+void ChannelFilter::reset()
+{
+    historyLength = 0;
+    historyNext = 0;
+    initialized = false;
+}
+
+int32_t ChannelFilter::median(int32_t value)
+{
+    history[historyNext] = value;
+    historyNext = (historyNext + 1) % parameters.window;
+    if (historyLength < parameters.window)
+    {
+        historyLength++;
+    }
+
+    // Insertion sort of a copy, the window is at most MEDIAN_MAX values
+    int32_t sorted[MEDIAN_MAX];
+    for (uint8_t i = 0; i < historyLength; i++)
+    {
+        int32_t v = history[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[historyLength / 2];
+}
+
+int32_t ChannelFilter::update(int32_t value)
+{
+    value = median(value);
+    if (!initialized || parameters.processNoise == 0)
+    {
+        // Start from the first value, with an uncertainty equal to the measurement noise
+        initialized = true;
+        estimate = value;
+        remainder = 0;
+        variance = ONE;
+        return value;
+    }
+
+    // Predict
+    variance += noiseRatio;
+
+    // Gain p / (p + 1), scaling both terms down until the numerator fits 16 bits
+    uint32_t numerator = variance;
+    uint32_t denominator = variance + ONE;
+    while (numerator >= ONE)
+    {
+        numerator >>= 1;
+        denominator >>= 1;
+    }
+    uint16_t gain = (numerator << FRACTION_BITS) / denominator;
+    variance = gain;
+
+    // Update, carrying the fraction that does not fit the integer estimate. The innovation is taken
+    // against the whole estimate, so the fraction's share k * f is removed first; otherwise the
+    // fraction would never decay and the output could stay a unit off. The 32x16 product
+    // |z - x| * k is built from two 16x16 -> 32 partial products, split at the binary point
+    remainder -= (uint16_t)(((uint32_t)remainder * gain) >> FRACTION_BITS);
+    // The difference of two int32 values can take 33 bits, so its magnitude is taken unsigned, and
+    // the estimate moves in unsigned arithmetic: it lands between itself and the value, in range
+    bool rising = value >= estimate;
+    uint32_t magnitude = rising ? (uint32_t)value - (uint32_t)estimate : (uint32_t)estimate - (uint32_t)value;
+    uint32_t low = (uint32_t)(uint16_t)magnitude * gain;
+    uint32_t whole = (uint32_t)(uint16_t)(magnitude >> 16) * gain + (low >> FRACTION_BITS);
+    uint16_t fraction = (uint16_t)low;
+    if (rising)
+    {
+        uint32_t sum = (uint32_t)remainder + fraction;
+        estimate = (int32_t)((uint32_t)estimate + whole + (sum >> FRACTION_BITS));
+        remainder = (uint16_t)sum;
+    }
+    else
+    {
+        // Subtracting the product keeps the remainder non-negative, as an arithmetic shift would
+        estimate = (int32_t)((uint32_t)estimate - whole);
+        if (remainder < fraction)
+        {
+            estimate--;
+        }
+        remainder = (uint16_t)(remainder - fraction);
+    }
+
+    // Round to the nearest unit
+    return estimate + (remainder >> (FRACTION_BITS - 1));
+}
+
+uint16_t ChannelFilter::getGain()
+{
+    return (uint16_t)variance;
+}
+
+SampleFilter::SampleFilter()
+{
+    setDefaults();
+}
+
+void SampleFilter::setDefaults()
+{
+    for (uint8_t i = 0; i < filter_channels; i++)
+    {
+        filters[i].configure(&defaultParameters[i]);
+    }
+}
+
+ChannelFilter *SampleFilter::getChannel(uint8_t channel)
+{
+    return channel < filter_channels ? &filters[channel] : nullptr;
+}
+
+void SampleFilter::apply(SampleRecord *sample)
+{
+    int32_t value;
+    if (sample->channels & channel_temperature)
+    {
+        value = filters[filter_temperature].update(sample->temperature);
+        sample->temperature = (int16_t)(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+    }
+    if (sample->channels & channel_humidity)
+    {
+        value = filters[filter_humidity].update(sample->humidity);
+        sample->humidity = (uint16_t)(value < 0 ? 0 : (value > 10000 ? 10000 : value));
+    }
+    if (sample->channels & channel_pressure)
+    {
+        value = filters[filter_pressure].update((int32_t)sample->pressure);
+        sample->pressure = (uint32_t)(value < 0 ? 0 : value);
+    }
+    if (sample->channels & channel_gas)
+    {
+        value = filters[filter_gas].update((int32_t)sample->gasResistance);
+        sample->gasResistance = (uint32_t)(value < 0 ? 0 : value);
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file filter.h
+ * @author Riccardo Iacob
+ * @brief Fixed-point per-channel filtering: median spike rejection and a 1-D Kalman filter
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+
+#include "sample.h"
+
+/**
+ * Each compensated value first goes through a median of the last `window` values, which removes
+ * isolated spikes (a window of 1 disables it, a window of N delays steps by (N - 1) / 2 samples),
+ * then through a scalar Kalman filter with a random-walk model.
+ *
+ * Noise is given as standard deviations in channel units: measurement noise r and process noise q
+ * (how much the true value moves per sample). Only their ratio matters, so the filter tracks the
+ * error variance relative to r, p = P / r, in Q16:
+ *   predict  p += q^2 / r^2
+ *   update   k = p / (p + 1), x += k * (z - x), p = k
+ * The gain converges to the steady state of the equivalent alpha filter. A process noise of 0
+ * disables the Kalman stage. The fraction of x lost to the shift is carried to the next update
+ * and is part of the innovation, so small gains do not leave a dead band around the estimate.
+ * update() uses 32-bit arithmetic only.
+ */
+class ChannelFilter
+{
+public:
+    // Largest median window
+    static const uint8_t MEDIAN_MAX = 5;
+    // Fractional bits of the gain and of the relative variance
+    static const uint8_t FRACTION_BITS = 16;
+
+    /**
+     * @brief Filter parameters of a channel
+     */
+    typedef struct
+    {
+        // Median window, 1 to MEDIAN_MAX (odd values make sense)
+        uint8_t window;
+        // Measurement noise, standard deviation in channel units
+        uint16_t measurementNoise;
+        // Process noise, standard deviation in channel units per sample (0 = no Kalman stage)
+        uint16_t processNoise;
+    } Parameters;
+
+private:
+    Parameters parameters;
+    // q^2 / r^2, in Q16
+    uint32_t noiseRatio;
+
+    int32_t history[MEDIAN_MAX];
+    uint8_t historyLength;
+    uint8_t historyNext;
+
+    bool initialized;
+    int32_t estimate;
+    // Fraction of the estimate, in Q16
+    uint16_t remainder;
+    // Error variance relative to the measurement noise, in Q16
+    uint32_t variance;
+
+    int32_t median(int32_t value);
+
+public:
+    ChannelFilter();
+
+    /**
+     * @brief Sets the parameters and restarts the filter
+     *
+     * @param params: The parameters (the window is clamped to 1..MEDIAN_MAX)
+     */
+    void configure(const Parameters *params);
+
+    /**
+     * @brief Gets the current parameters
+     */
+    const Parameters *getParameters();
+
+    /**
+     * @brief Forgets the history, the next value is passed through unchanged
+     */
+    void reset();
+
+    /**
+     * @brief Filters a value
+     *
+     * @param value: The new value
+     * @return int32_t: The filtered value
+     */
+    int32_t update(int32_t value);
+
+    /**
+     * @brief Gets the current Kalman gain, in Q16
+     */
+    uint16_t getGain();
+};
+
+/**
+ * @brief The filter stage of all channels of a SampleRecord
+ */
+class SampleFilter
+{
+public:
+    /**
+     * @brief Channel indices, in SampleChannels bit order
+     */
+    enum Channels
+    {
+        filter_temperature,
+        filter_humidity,
+        filter_pressure,
+        filter_gas,
+        filter_channels
+    };
+
+private:
+    ChannelFilter filters[filter_channels];
+
+public:
+    /**
+     * @brief Constructs a new SampleFilter object with the default parameters
+     */
+    SampleFilter();
+
+    /**
+     * @brief Restores the default parameters of every channel
+     */
+    void setDefaults();
+
+    /**
+     * @brief Gets the filter of a channel
+     *
+     * @param channel: The channel index (Channels)
+     * @return ChannelFilter*: The filter, nullptr if the channel does not exist
+     */
+    ChannelFilter *getChannel(uint8_t channel);
+
+    /**
+     * @brief Filters the fresh channels of a sample in place
+     *
+     * @param sample: The sample
+     */
+    void apply(SampleRecord *sample);
+};
+
+#endif
@@ -0,0 +1,298 @@
+/**
+ * @file gasbaseline.cpp
+ * @author Riccardo Iacob
+ * @brief Gas sensor burn-in, stability detection and persistent baseline
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "gasbaseline.h"
+
+GasBaseline::GasBaseline(const BurnInStep *schedule, uint8_t count)
+{
+    steps = schedule;
+    stepCount = count;
+    state = state_burn_in;
+    step = 0;
+    started = false;
+    stepStart = 0;
+    stateStart = 0;
+    bootTime = 0;
+    settleSeconds = 0;
+    baseline = 0;
+    savedBaseline = 0;
+    savedFlags = 0;
+    lastCheckpoint = 0;
+    checkpointFailed = false;
+    resetWindows(0);
+}
+
+bool GasBaseline::restore(const Checkpoint *checkpoint)
+{
+    // The stored content is what later checkpoints are compared against
+    savedBaseline = checkpoint->baseline;
+    savedFlags = checkpoint->flags;
+    if (!(checkpoint->flags & checkpoint_valid) || checkpoint->baseline == 0)
+    {
+        return false;
+    }
+    baseline = checkpoint->baseline;
+    state = state_warm_start;
+    step = stepCount;
+    return true;
+}
+
+void GasBaseline::startState(uint8_t newState, uint32_t now)
+{
+    state = newState;
+    stateStart = now;
+    stepStart = now;
+    // A full burn-in starts over from the first conditioning step
+    if (newState == state_burn_in)
+    {
+        step = 0;
+    }
+    resetWindows(now);
+}
+
+void GasBaseline::resetWindows(uint32_t now)
+{
+    windowStart = now;
+    windowSum = 0;
+    windowCount = 0;
+    meanCount = 0;
+    meanHead = 0;
+    slope = 0;
+    stableWindows = 0;
+}
+
+void GasBaseline::update(uint32_t resistance, bool valid, uint32_t now)
+{
+    if (!started)
+    {
+        started = true;
+        bootTime = now;
+        startState(state, now);
+    }
+
+    // Conditioning steps run on time alone, readings taken on them are not used
+    if (step < stepCount)
+    {
+        bool advanced = false;
+        uint16_t duration;
+        while (step < stepCount && now - stepStart >= (duration = pgm_read_word(&steps[step].duration_s)))
+        {
+            stepStart += duration;
+            step++;
+            advanced = true;
+        }
+        if (advanced)
+        {
+            resetWindows(now);
+        }
+        if (step < stepCount)
+        {
+            return;
+        }
+    }
+
+    if (state == state_warm_start && now - stateStart >= WARM_TIMEOUT_S)
+    {
+        startState(state_burn_in, now);
+        return;
+    }
+
+    if (valid && windowCount < UINT16_MAX)
+    {
+        windowSum += resistance > MAX_RESISTANCE ? MAX_RESISTANCE : resistance;
+        windowCount++;
+    }
+    if (now - windowStart >= WINDOW_S)
+    {
+        closeWindow(now);
+    }
+}
+
+void GasBaseline::closeWindow(uint32_t now)
+{
+    windowStart = now;
+    checkpointFailed = false;
+    if (windowCount == 0)
+    {
+        return;
+    }
+    uint32_t mean = (uint32_t)(windowSum / windowCount);
+    windowSum = 0;
+    windowCount = 0;
+
+    means[meanHead] = mean;
+    meanHead = (meanHead + 1) % SLOPE_WINDOWS;
+    if (meanCount < SLOPE_WINDOWS)
+    {
+        meanCount++;
+        return;
+    }
+
+    slope = computeSlope();
+    bool stable = slope <= STABLE_SLOPE_PERMILLE && slope >= -(int16_t)STABLE_SLOPE_PERMILLE;
+    stableWindows = stable ? (stableWindows < 255 ? stableWindows + 1 : 255) : 0;
+
+    switch (state)
+    {
+    case state_burn_in:
+    {
+        if (stableWindows >= COLD_STABLE_WINDOWS)
+        {
+            baseline = mean;
+            state = state_valid;
+        }
+    }
+    break;
+
+    case state_warm_start:
+    {
+        uint32_t distance = mean > baseline ? mean - baseline : baseline - mean;
+        if (stableWindows >= WARM_STABLE_WINDOWS && distance <= (uint32_t)((uint64_t)baseline * WARM_TOLERANCE_PERMILLE / 1000))
+        {
+            state = state_valid;
+        }
+    }
+    break;
+
+    default:
+    {
+        // Clean air is the highest resistance: follow it up quickly, down slowly
+        if (mean > baseline)
+        {
+            baseline += (mean - baseline) >> BASELINE_UP_SHIFT;
+        }
+        else
+        {
+            baseline -= (baseline - mean) >> BASELINE_DOWN_SHIFT;
+        }
+    }
+    break;
+    }
+
+    if (state == state_valid && settleSeconds == 0)
+    {
+        settleSeconds = now - bootTime;
+    }
+}
+
+int16_t GasBaseline::computeSlope()
+{
+    // Least squares over x = -(N-1)/2 .. (N-1)/2, with c = 2x to stay in integers:
+    // slope per window = 2 * sum(c * y) / sum(c * c)
+    int64_t weighted = 0;
+    uint64_t sum = 0;
+    int32_t squares = 0;
+    for (uint8_t i = 0; i < SLOPE_WINDOWS; i++)
+    {
+        uint32_t y = means[(meanHead + i) % SLOPE_WINDOWS];
+        int8_t c = 2 * i - (SLOPE_WINDOWS - 1);
+        weighted += (int64_t)c * y;
+        sum += y;
+        squares += (int32_t)c * c;
+    }
+    if (sum == 0)
+    {
+        return 0;
+    }
+    // Relative to the mean (sum / N), in permille per hour
+    int64_t value = weighted * 2 * 1000 * 3600 * SLOPE_WINDOWS / ((int64_t)squares * WINDOW_S * (int64_t)sum);
+    return value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : (int16_t)value);
+}
+
+bool GasBaseline::getHeater(uint8_t *setPoint, uint16_t *targetTemp)
+{
+    if (step >= stepCount)
+    {
+        return false;
+    }
+    *setPoint = pgm_read_byte(&steps[step].set_point);
+    *targetTemp = pgm_read_word(&steps[step].target_temp);
+    return true;
+}
+
+uint8_t GasBaseline::getState()
+{
+    return state;
+}
+
+bool GasBaseline::isValid()
+{
+    return state == state_valid;
+}
+
+uint32_t GasBaseline::getBaseline()
+{
+    return baseline;
+}
+
+uint16_t GasBaseline::getAirQuality(uint32_t resistance)
+{
+    // resistance / (baseline / MAX) is MAX times the ratio, without a 32-bit overflow
+    uint32_t step = baseline / AIR_QUALITY_MAX;
+    if (step == 0)
+    {
+        step = 1;
+    }
+    uint32_t ratio = resistance / step;
+    return ratio >= AIR_QUALITY_MAX ? 0 : AIR_QUALITY_MAX - (uint16_t)ratio;
+}
+
+int16_t GasBaseline::getSlope()
+{
+    return slope;
+}
+
+uint32_t GasBaseline::getSettleSeconds()
+{
+    return settleSeconds;
+}
+
+bool GasBaseline::isCheckpointDue(uint32_t now)
+{
+    if (checkpointFailed)
+    {
+        return false;
+    }
+    bool storedValid = savedFlags & checkpoint_valid;
+    if (state != state_valid)
+    {
+        // Only a failed warm start invalidates the stored baseline
+        return state == state_burn_in && storedValid;
+    }
+    if (!storedValid)
+    {
+        return true;
+    }
+    if (now - lastCheckpoint < CHECKPOINT_INTERVAL_S)
+    {
+        return false;
+    }
+    uint32_t distance = baseline > savedBaseline ? baseline - savedBaseline : savedBaseline - baseline;
+    return (uint64_t)distance * 1000 >= (uint64_t)savedBaseline * CHECKPOINT_DELTA_PERMILLE;
+}
+
+void GasBaseline::getCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->baseline = baseline;
+    checkpoint->flags = state == state_valid ? checkpoint_valid : 0;
+}
+
+void GasBaseline::markCheckpoint(uint32_t now, bool saved)
+{
+    if (!saved)
+    {
+        checkpointFailed = true;
+        return;
+    }
+    Checkpoint checkpoint;
+    getCheckpoint(&checkpoint);
+    savedBaseline = checkpoint.baseline;
+    savedFlags = checkpoint.flags;
+    lastCheckpoint = now;
+}
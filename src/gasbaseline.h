@@ -0,0 +1,238 @@
+/**
+ * @file gasbaseline.h
+ * @author Riccardo Iacob
+ * @brief Gas sensor burn-in, stability detection and persistent baseline
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef GASBASELINE_H
+#define GASBASELINE_H
+
+#include <Arduino.h>
+
+/**
+ * A new (or long unpowered) MOX sensor drifts for hours. Cold start: the heater first runs the
+ * burn-in schedule, a PROGMEM table of conditioning steps (set point, temperature, duration), then
+ * the operating profile of the sensor configuration, until the readings are stable.
+ *
+ * Stability: the gas resistance is averaged over WINDOW_S windows, and the running slope is the
+ * least-squares slope of the last SLOPE_WINDOWS window means, relative to their mean, in permille
+ * per hour. Readings are valid after COLD_STABLE_WINDOWS consecutive windows within
+ * STABLE_SLOPE_PERMILLE; the baseline (clean air resistance) then follows the window means, quickly
+ * upwards and slowly downwards, so gas events do not pull it down.
+ *
+ * Warm start: the baseline and the valid flag are checkpointed to the EEPROM. After a restart the
+ * conditioning steps are skipped, and the readings are valid again as soon as the slope is flat
+ * for WARM_STABLE_WINDOWS windows and the window mean is within WARM_TOLERANCE_PERMILLE of the
+ * stored baseline (minutes instead of hours). A sensor that does not get there within
+ * WARM_TIMEOUT_S goes through the full burn-in.
+ *
+ * Checkpoints are written when the readings become valid or are invalidated, then at most every
+ * CHECKPOINT_INTERVAL_S and only if the baseline moved by CHECKPOINT_DELTA_PERMILLE, so with the
+ * ConfigStore rotation a slot is rewritten at most once every slot count hours. A failed write is
+ * retried once per window.
+ */
+class GasBaseline
+{
+public:
+    // Length of an averaging window, in seconds
+    static const uint8_t WINDOW_S = 60;
+    // Window means in the running slope
+    static const uint8_t SLOPE_WINDOWS = 8;
+    // Largest slope counted as stable, in permille per hour
+    static const uint8_t STABLE_SLOPE_PERMILLE = 60;
+    // Consecutive stable windows needed after a cold and a warm start
+    static const uint8_t COLD_STABLE_WINDOWS = 20;
+    static const uint8_t WARM_STABLE_WINDOWS = 2;
+    // Largest distance of the warm readings from the stored baseline, in permille
+    static const uint16_t WARM_TOLERANCE_PERMILLE = 250;
+    // Longest warm start before falling back to the full burn-in, in seconds
+    static const uint16_t WARM_TIMEOUT_S = 1800;
+    // Baseline tracking: weight of a new window mean is 1 / (1 << shift)
+    static const uint8_t BASELINE_UP_SHIFT = 3;
+    static const uint8_t BASELINE_DOWN_SHIFT = 6;
+    // Shortest interval between periodic checkpoints, in seconds, and baseline change that needs one
+    static const uint16_t CHECKPOINT_INTERVAL_S = 3600;
+    static const uint8_t CHECKPOINT_DELTA_PERMILLE = 20;
+    // Current checkpoint layout version
+    static const uint8_t CHECKPOINT_VERSION = 1;
+    // Readings above this are clamped (an open heater or a bus glitch), in Ohm
+    static const uint32_t MAX_RESISTANCE = 16000000UL;
+    // Air quality index of a reading with no resistance left
+    static const uint16_t AIR_QUALITY_MAX = 500;
+
+    /**
+     * @brief Phases of the sensor
+     */
+    enum States
+    {
+        state_burn_in,
+        state_warm_start,
+        state_valid
+    };
+
+    /**
+     * @brief A conditioning step of the burn-in schedule, in PROGMEM
+     */
+    typedef struct
+    {
+        // HeaterSetPoints
+        uint8_t set_point;
+        // Heater temperature in °C
+        uint16_t target_temp;
+        // Duration in seconds
+        uint16_t duration_s;
+    } BurnInStep;
+
+    /**
+     * @brief Checkpoint flags
+     */
+    enum CheckpointFlags
+    {
+        // The sensor completed its burn-in and the baseline is valid
+        checkpoint_valid = 0x01
+    };
+
+    /**
+     * @brief Persistent layout of the checkpoint (version 1)
+     * Only append new fields at the end, and bump CHECKPOINT_VERSION when doing so
+     */
+    typedef struct
+    {
+        // Baseline resistance in Ohm
+        uint32_t baseline;
+        uint8_t flags;
+    } Checkpoint;
+
+private:
+    const BurnInStep *steps;
+    uint8_t stepCount;
+    uint8_t state;
+    // Current conditioning step, stepCount once on the operating profile
+    uint8_t step;
+    bool started;
+    uint32_t stepStart;
+    uint32_t stateStart;
+    uint32_t bootTime;
+    // Seconds from the first update to valid readings, 0 until then
+    uint32_t settleSeconds;
+
+    // Averaging window
+    uint32_t windowStart;
+    uint64_t windowSum;
+    uint16_t windowCount;
+    // Window means, oldest first once SLOPE_WINDOWS are in
+    uint32_t means[SLOPE_WINDOWS];
+    uint8_t meanCount;
+    uint8_t meanHead;
+    int16_t slope;
+    uint8_t stableWindows;
+
+    uint32_t baseline;
+    // Content and time of the last checkpoint
+    uint32_t savedBaseline;
+    uint8_t savedFlags;
+    uint32_t lastCheckpoint;
+    bool checkpointFailed;
+
+    void startState(uint8_t newState, uint32_t now);
+    void resetWindows(uint32_t now);
+    void closeWindow(uint32_t now);
+    int16_t computeSlope();
+
+public:
+    /**
+     * @brief Constructs a new GasBaseline object, in cold burn-in
+     *
+     * @param schedule: The conditioning steps, in PROGMEM
+     * @param count: The number of steps
+     */
+    GasBaseline(const BurnInStep *schedule, uint8_t count);
+
+    /**
+     * @brief Resumes from a checkpoint, before the first update()
+     *
+     * @param checkpoint: The stored checkpoint
+     * @return bool: True if the checkpoint allows a warm start
+     */
+    bool restore(const Checkpoint *checkpoint);
+
+    /**
+     * @brief Feeds a sample
+     *
+     * @param resistance: The raw gas resistance in Ohm
+     * @param valid: False if the sample has no gas reading (time still advances)
+     * @param now: The sample time in seconds
+     */
+    void update(uint32_t resistance, bool valid, uint32_t now);
+
+    /**
+     * @brief Gets the heater profile of the current conditioning step
+     *
+     * @param setPoint: Output set point (written only during conditioning)
+     * @param targetTemp: Output heater temperature in °C (written only during conditioning)
+     * @return bool: True during conditioning, false on the operating profile of the configuration
+     */
+    bool getHeater(uint8_t *setPoint, uint16_t *targetTemp);
+
+    /**
+     * @brief Gets the phase (States)
+     */
+    uint8_t getState();
+
+    /**
+     * @brief Checks whether gas readings are valid (burn-in or warm start completed)
+     */
+    bool isValid();
+
+    /**
+     * @brief Gets the baseline resistance in Ohm, 0 if unknown
+     */
+    uint32_t getBaseline();
+
+    /**
+     * @brief Gets the air quality index of a reading from its ratio to the baseline
+     * 0 at or above the baseline (clean air), rising linearly to AIR_QUALITY_MAX as the resistance
+     * drops to 0. Meaningful only while isValid()
+     *
+     * @param resistance: The gas resistance in Ohm
+     * @return uint16_t: The index, 0 to AIR_QUALITY_MAX
+     */
+    uint16_t getAirQuality(uint32_t resistance);
+
+    /**
+     * @brief Gets the running slope in permille per hour (0 until SLOPE_WINDOWS windows are in)
+     */
+    int16_t getSlope();
+
+    /**
+     * @brief Gets the time from the first update to valid readings, in seconds (0 until valid)
+     */
+    uint32_t getSettleSeconds();
+
+    /**
+     * @brief Checks whether a checkpoint should be written now
+     *
+     * @param now: The current time in seconds
+     */
+    bool isCheckpointDue(uint32_t now);
+
+    /**
+     * @brief Gets the state to checkpoint
+     *
+     * @param checkpoint: Output checkpoint
+     */
+    void getCheckpoint(Checkpoint *checkpoint);
+
+    /**
+     * @brief Records the outcome of writing the checkpoint from getCheckpoint()
+     *
+     * @param now: The current time in seconds
+     * @param saved: True if the checkpoint was written
+     */
+    void markCheckpoint(uint32_t now, bool saved);
+};
+
+#endif
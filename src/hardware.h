@@ -13,14 +13,38 @@
 #define BAUDRATE_SERIAL 115200
 #define BAUDRATE_SERIALBT 38400
 
+// Transmit queue sizes, in bytes (RAM)
+#define TX_QUEUE_SERIAL 256
+#define TX_QUEUE_SERIALBT 256
+
 #define I2C_DS3231_ADD 0x68
 #define I2C_BME680_ADD 0x77
 #define I2C_OLED_ADD 0x3C
 #define I2C_EEPROM_ADD 0x57
 
+// I2C pins (TWI), transaction timeout and half clock period of the recovery sequence
+#define PIN_I2C_SDA 20
+#define PIN_I2C_SCL 21
+#define I2C_TIMEOUT_US 5000
+#define I2C_HALF_PERIOD_US 5
+
+// On-chip EEPROM layout
+#define EEPROM_CONFIG_ADD 0
+#define EEPROM_CONFIG_SLOTS 8
+#define EEPROM_CONFIG_SLOT_SIZE 48
+// Gas baseline checkpoints: written at most hourly, rotated across the slots
+#define EEPROM_GAS_ADD 384
+#define EEPROM_GAS_SLOTS 16
+#define EEPROM_GAS_SLOT_SIZE 16
+
 #define PIN_LED_GREEN 52
 #define PIN_LED_YELLOW 51
 #define PIN_LED_RED 49
 #define PIN_LED_BLUE 47
 
+// Estimated board current while awake, in idle sleep and in power-down, in uA (charge estimate)
+#define POWER_ACTIVE_UA 20000
+#define POWER_IDLE_UA 8000
+#define POWER_DOWN_UA 150
+
 #endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+/**
+ * @file histxfer.cpp
+ * @author Riccardo Iacob
+ * @brief Windowed bulk transfer of the EEPROM sample log
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "histxfer.h"
+
+HistoryExport::HistoryExport(SampleLog *sampleLog)
+{
+    log = sampleLog;
+    stream = nullptr;
+    active = false;
+    retransmissions = 0;
+}
+
+bool HistoryExport::start(Stream *io, bool resume, uint16_t blockSequence)
+{
+    // Make the block being filled readable, and include it if it holds anything
+    log->flush();
+    uint16_t blocks = log->getBlockCount() + (log->getPendingRecords() > 0 ? 1 : 0);
+    uint16_t oldest = log->getOldestSequence();
+    int16_t offset = resume ? (int16_t)(blockSequence - oldest) : 0;
+    if (offset > (int16_t)blocks)
+    {
+        return false;
+    }
+    if (offset < 0)
+    {
+        // Overwritten since the previous transfer: continue with what is left
+        offset = 0;
+    }
+
+    stream = io;
+    total = blocks;
+    firstSequence = oldest;
+    base = offset;
+    next = offset;
+    endSent = false;
+    txLength = 0;
+    txPosition = 0;
+    rxLength = 0;
+    retransmissions = 0;
+    lastProgressMillis = millis();
+    lastRxMillis = millis();
+    active = true;
+    return true;
+}
+
+void HistoryExport::buildFrame(uint8_t type, uint16_t seq, uint8_t payloadLength)
+{
+    // The payload is expected at frame + 5 already
+    frame[0] = SYNC;
+    frame[1] = type;
+    frame[2] = (uint8_t)seq;
+    frame[3] = (uint8_t)(seq >> 8);
+    frame[4] = payloadLength;
+
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 1; i < 5 + payloadLength; i++)
+    {
+        crc = ConfigStore::crc16(crc, frame[i]);
+    }
+    frame[5 + payloadLength] = crc >> 8;
+    frame[6 + payloadLength] = crc & 0xFF;
+
+    txLength = payloadLength + FRAME_OVERHEAD;
+    txPosition = 0;
+}
+
+bool HistoryExport::buildDataFrame(uint16_t position)
+{
+    // The ring index is looked up now, so blocks completed since start() do not shift the numbering
+    uint16_t seq = firstSequence + position;
+    uint16_t address = (uint16_t)log->getBlockIndex(seq) * SampleLog::BLOCK_SIZE;
+    uint8_t *payload = frame + 5;
+
+    // Read the EEPROM straight into the frame; the header tells how much of the block is used
+    if (log->readBytes(address, payload, READ_SIZE) != READ_SIZE)
+    {
+        return false;
+    }
+    uint8_t used = payload[2];
+    uint16_t stored = (uint16_t)payload[0] | ((uint16_t)payload[1] << 8);
+    if (stored != seq || used <= SampleLog::HEADER_SIZE || used > SampleLog::BLOCK_SIZE)
+    {
+        // Overwritten since the transfer started: send it empty so the host can skip it
+        used = 0;
+    }
+    for (uint8_t position = READ_SIZE; position < used; position += READ_SIZE)
+    {
+        if (log->readBytes(address + position, payload + position, READ_SIZE) != READ_SIZE)
+        {
+            return false;
+        }
+    }
+
+    buildFrame(FRAME_DATA, seq, used);
+    return true;
+}
+
+void HistoryExport::receive()
+{
+    while (stream->available() > 0)
+    {
+        uint8_t c = stream->read();
+        lastRxMillis = millis();
+
+        // Resynchronize on SYNC
+        if (rxLength == 0 && c != SYNC)
+        {
+            continue;
+        }
+        rx[rxLength++] = c;
+        if (rxLength == FRAME_OVERHEAD)
+        {
+            handleFrame();
+            rxLength = 0;
+        }
+    }
+}
+
+void HistoryExport::handleFrame()
+{
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 1; i < 5; i++)
+    {
+        crc = ConfigStore::crc16(crc, rx[i]);
+    }
+    if (rx[4] != 0 || crc != CONCAT_BYTES(rx[5], rx[6]))
+    {
+        return;
+    }
+
+    // Counted from the first block of the transfer, like base and next
+    uint16_t seq = ((uint16_t)rx[2] | ((uint16_t)rx[3] << 8)) - firstSequence;
+    if (rx[1] == FRAME_ABORT)
+    {
+        active = false;
+    }
+    else if (rx[1] == FRAME_ACK)
+    {
+        if (endSent && seq == total + 1)
+        {
+            active = false;
+        }
+        else if (seq > base && seq <= total)
+        {
+            // Cumulative acknowledgement, possibly of frames sent before a go-back-N
+            base = seq;
+            if (next < base)
+            {
+                next = base;
+            }
+            lastProgressMillis = millis();
+        }
+    }
+}
+
+void HistoryExport::poll()
+{
+    if (!active)
+    {
+        return;
+    }
+
+    receive();
+    if (!active)
+    {
+        return;
+    }
+
+    // Finish the frame in progress, only with what fits in the TX buffer
+    if (txPosition < txLength)
+    {
+        int room = stream->availableForWrite();
+        if (room > 0)
+        {
+            int count = txLength - txPosition;
+            if (count > room)
+            {
+                count = room;
+            }
+            stream->write(frame + txPosition, count);
+            txPosition += count;
+        }
+        return;
+    }
+
+    if (millis() - lastRxMillis > IDLE_TIMEOUT_MS)
+    {
+        // Peer gone: give the stream back to the console, "export <base>" resumes
+        active = false;
+        return;
+    }
+
+    if (millis() - lastProgressMillis > ACK_TIMEOUT_MS)
+    {
+        // Go back N
+        next = base;
+        endSent = false;
+        retransmissions++;
+        lastProgressMillis = millis();
+    }
+
+    if (next < total && next < base + WINDOW)
+    {
+        if (buildDataFrame(next))
+        {
+            next++;
+        }
+    }
+    else if (base == total && !endSent)
+    {
+        buildFrame(FRAME_END, firstSequence + total, 0);
+        endSent = true;
+    }
+}
+
+bool HistoryExport::isActive()
+{
+    return active;
+}
+
+Stream *HistoryExport::getStream()
+{
+    return stream;
+}
+
+uint16_t HistoryExport::getRetransmissions()
+{
+    return retransmissions;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file histxfer.h
+ * @author Riccardo Iacob
+ * @brief Windowed bulk transfer of the EEPROM sample log
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef HISTXFER_H
+#define HISTXFER_H
+
+#include <Arduino.h>
+
+#include "samplelog.h"
+#include "configstore.h"
+
+/**
+ * Started by the console command "export [block]"; the stream then carries binary frames until
+ * the transfer ends, is aborted, or the peer stays silent for IDLE_TIMEOUT_MS.
+ *
+ * Frame: SYNC | type | seq (uint16, little endian) | len | payload[len] | crc (uint16, big endian)
+ * The CRC is CRC-16/CCITT (ConfigStore::crc16) over type, seq, len and payload.
+ *
+ * Frames are numbered with the SampleLog block sequence numbers, which do not depend on where
+ * the ring currently starts (modulo 2^16 arithmetic throughout).
+ *
+ * Device to host:
+ *   FRAME_DATA  seq = block sequence number, payload = one raw SampleLog block; empty if the
+ *               block was overwritten since the transfer started
+ *   FRAME_END   seq = sequence number after the last block, no payload
+ * Host to device (no payload):
+ *   FRAME_ACK   seq = next block expected (cumulative); acknowledging the END frame with
+ *               its seq + 1 completes the transfer
+ *   FRAME_ABORT stops the transfer
+ *
+ * Up to WINDOW data frames are in flight. If the acknowledged sequence does not move for
+ * ACK_TIMEOUT_MS the window is sent again (go-back-N). Blocks are read from the EEPROM straight
+ * into the frame buffer, also when retransmitting, so no copy of the window is kept in RAM.
+ * After a disconnect, "export <block>" resumes from the first block not received, even if the log
+ * has moved on meanwhile; if that block was overwritten, the transfer starts at the oldest one.
+ */
+class HistoryExport
+{
+public:
+    static const uint8_t SYNC = 0x7E;
+    static const uint8_t FRAME_DATA = 'D';
+    static const uint8_t FRAME_END = 'E';
+    static const uint8_t FRAME_ACK = 'A';
+    static const uint8_t FRAME_ABORT = 'X';
+
+    // Frame bytes besides the payload
+    static const uint8_t FRAME_OVERHEAD = 7;
+    // Maximum number of unacknowledged data frames
+    static const uint8_t WINDOW = 4;
+    static const uint16_t ACK_TIMEOUT_MS = 1500;
+    static const uint16_t IDLE_TIMEOUT_MS = 10000;
+    // EEPROM read size, limited by the Wire buffer
+    static const uint8_t READ_SIZE = 32;
+
+private:
+    Stream *stream;
+    SampleLog *log;
+    bool active;
+
+    // Blocks to be sent, in export order, from the block numbered firstSequence
+    uint16_t total;
+    uint16_t firstSequence;
+    // Oldest unacknowledged and next block to be sent, counted from firstSequence
+    uint16_t base;
+    uint16_t next;
+    bool endSent;
+
+    uint8_t frame[SampleLog::BLOCK_SIZE + FRAME_OVERHEAD];
+    uint8_t txLength;
+    uint8_t txPosition;
+
+    // Receive state of the host frames
+    uint8_t rx[FRAME_OVERHEAD];
+    uint8_t rxLength;
+
+    unsigned long lastProgressMillis;
+    unsigned long lastRxMillis;
+
+    // Statistics
+    uint16_t retransmissions;
+
+    void buildFrame(uint8_t type, uint16_t seq, uint8_t payloadLength);
+    bool buildDataFrame(uint16_t position);
+    void receive();
+    void handleFrame();
+
+public:
+    /**
+     * @brief Constructs a new HistoryExport object
+     *
+     * @param sampleLog: The log to be exported
+     */
+    HistoryExport(SampleLog *sampleLog);
+
+    /**
+     * @brief Starts a transfer
+     *
+     * @param io: The stream used for the transfer
+     * @param resume: False to start from the oldest block, true to start from blockSequence
+     * @param blockSequence: The sequence number of the first block to be sent, when resuming
+     * @return bool: True if the transfer started
+     */
+    bool start(Stream *io, bool resume, uint16_t blockSequence);
+
+    /**
+     * @brief Advances the transfer without blocking: reads acknowledgements and sends what fits in the TX buffer
+     */
+    void poll();
+
+    /**
+     * @brief Checks whether a transfer is running
+     */
+    bool isActive();
+
+    /**
+     * @brief Gets the stream of the running transfer
+     */
+    Stream *getStream();
+
+    /**
+     * @brief Gets the number of go-back-N retransmissions of the last transfer
+     */
+    uint16_t getRetransmissions();
+};
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * @file i2cbus.cpp
+ * @author Riccardo Iacob
+ * @brief Bounded I2C transactions and bus recovery
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "i2cbus.h"
+
+uint16_t I2CBus::timeouts = 0;
+uint16_t I2CBus::recoveries = 0;
+uint16_t I2CBus::errors = 0;
+bool I2CBus::stuck = false;
+
+void I2CBus::begin()
+{
+    Wire.begin();
+    // Abort and reset the TWI hardware instead of waiting forever
+    Wire.setWireTimeout(I2C_TIMEOUT_US, true);
+}
+
+void I2CBus::poll()
+{
+    if (Wire.getWireTimeoutFlag())
+    {
+        Wire.clearWireTimeoutFlag();
+        timeouts++;
+        recover();
+    }
+}
+
+bool I2CBus::recover()
+{
+    recoveries++;
+    Wire.end();
+
+    // Lines are only ever pulled low (open drain): a released line floats high on the pull-up
+    pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+    pinMode(PIN_I2C_SCL, INPUT_PULLUP);
+    delayMicroseconds(I2C_HALF_PERIOD_US);
+    for (uint8_t i = 0; i < RECOVERY_PULSES && digitalRead(PIN_I2C_SDA) == LOW; i++)
+    {
+        pinMode(PIN_I2C_SCL, OUTPUT);
+        digitalWrite(PIN_I2C_SCL, LOW);
+        delayMicroseconds(I2C_HALF_PERIOD_US);
+        pinMode(PIN_I2C_SCL, INPUT_PULLUP);
+        delayMicroseconds(I2C_HALF_PERIOD_US);
+    }
+
+    // STOP: SDA rises while SCL is high
+    pinMode(PIN_I2C_SDA, OUTPUT);
+    digitalWrite(PIN_I2C_SDA, LOW);
+    delayMicroseconds(I2C_HALF_PERIOD_US);
+    pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+    delayMicroseconds(I2C_HALF_PERIOD_US);
+    stuck = digitalRead(PIN_I2C_SDA) == LOW || digitalRead(PIN_I2C_SCL) == LOW;
+
+    begin();
+    return !stuck;
+}
+
+bool I2CBus::probe(uint8_t i2cAddress)
+{
+    Wire.beginTransmission(i2cAddress);
+    return Wire.endTransmission() == error_none;
+}
+
+uint8_t I2CBus::write(uint8_t i2cAddress, const uint8_t *prefix, uint8_t prefixLength, const uint8_t *data, uint8_t length)
+{
+    Wire.beginTransmission(i2cAddress);
+    Wire.write(prefix, prefixLength);
+    Wire.write(data, length);
+    uint8_t result = Wire.endTransmission(true);
+    if (result != error_none)
+    {
+        errors++;
+    }
+    return result;
+}
+
+uint8_t I2CBus::read(uint8_t i2cAddress, const uint8_t *prefix, uint8_t prefixLength, uint8_t *buf, uint8_t length)
+{
+    Wire.beginTransmission(i2cAddress);
+    Wire.write(prefix, prefixLength);
+    // requestFrom() returns the bytes actually received, 0 after a NACK or a timeout
+    uint8_t received = 0;
+    if (Wire.endTransmission(false) == error_none)
+    {
+        received = Wire.requestFrom(i2cAddress, length, (uint8_t) true);
+    }
+    if (received != length)
+    {
+        errors++;
+        return 0;
+    }
+    for (uint8_t i = 0; i < received; i++)
+    {
+        buf[i] = Wire.read();
+    }
+    return received;
+}
+
+uint16_t I2CBus::getErrors()
+{
+    return errors;
+}
+
+uint16_t I2CBus::getTimeouts()
+{
+    return timeouts;
+}
+
+uint16_t I2CBus::getRecoveries()
+{
+    return recoveries;
+}
+
+bool I2CBus::isStuck()
+{
+    return stuck;
+}
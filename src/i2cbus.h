@@ -0,0 +1,128 @@
+/**
+ * @file i2cbus.h
+ * @author Riccardo Iacob
+ * @brief Bounded I2C transactions and bus recovery
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "hardware.h"
+
+/**
+ * Every device on the bus shares Wire, so one stuck transaction used to stall the whole firmware.
+ * begin() arms the Wire timeout: a transaction that does not complete within I2C_TIMEOUT_US is
+ * aborted (endTransmission() returns error_timeout, requestFrom() returns 0 bytes) and the TWI
+ * hardware is reset.
+ *
+ * A reset of the master does not free a slave that was interrupted mid-byte and holds SDA low.
+ * recover() then takes the pins over and clocks SCL up to RECOVERY_PULSES times until the slave
+ * releases SDA, generates a STOP and restarts Wire. poll() runs it after every timeout, and
+ * drivers call it when they see the bus hang.
+ *
+ * write() and read() are bounded transactions for drivers without their own error accounting;
+ * their failures are counted in getErrors(). probe() is not counted, a NACK is its answer.
+ */
+class I2CBus
+{
+public:
+    /**
+     * @brief Wire endTransmission() results
+     */
+    enum Errors
+    {
+        error_none = 0,
+        error_too_long = 1,
+        error_address_nack = 2,
+        error_data_nack = 3,
+        error_other = 4,
+        error_timeout = 5
+    };
+
+    // Clock pulses needed to finish any byte a slave may be sending, plus its acknowledge
+    static const uint8_t RECOVERY_PULSES = 9;
+
+private:
+    static uint16_t timeouts;
+    static uint16_t recoveries;
+    static uint16_t errors;
+    static bool stuck;
+
+public:
+    /**
+     * @brief Starts Wire with the transaction timeout armed
+     */
+    static void begin();
+
+    /**
+     * @brief Recovers the bus after a timeout, called from the main loop
+     */
+    static void poll();
+
+    /**
+     * @brief Frees the bus from a slave holding SDA low and restarts Wire
+     *
+     * @return bool: True if both lines are released
+     */
+    static bool recover();
+
+    /**
+     * @brief Checks whether a device answers at an address
+     *
+     * @param i2cAddress: The address
+     * @return bool: True if the address was acknowledged
+     */
+    static bool probe(uint8_t i2cAddress);
+
+    /**
+     * @brief Writes a register or memory address followed by data in one transaction
+     *
+     * @param i2cAddress: The device address
+     * @param prefix: The register or memory address bytes
+     * @param prefixLength: The number of address bytes
+     * @param data: The data
+     * @param length: The number of data bytes; prefix and data must fit the Wire buffer
+     * @return uint8_t: The Errors result
+     */
+    static uint8_t write(uint8_t i2cAddress, const uint8_t *prefix, uint8_t prefixLength, const uint8_t *data, uint8_t length);
+
+    /**
+     * @brief Writes a register or memory address, then reads from it with a repeated start
+     *
+     * @param i2cAddress: The device address
+     * @param prefix: The register or memory address bytes
+     * @param prefixLength: The number of address bytes
+     * @param buf: Output buffer
+     * @param length: The number of bytes, at most the Wire buffer size
+     * @return uint8_t: The number of bytes read, 0 on error
+     */
+    static uint8_t read(uint8_t i2cAddress, const uint8_t *prefix, uint8_t prefixLength, uint8_t *buf, uint8_t length);
+
+    /**
+     * @brief Gets the number of failed write() and read() transactions
+     */
+    static uint16_t getErrors();
+
+    /**
+     * @brief Gets the number of transactions aborted by the timeout
+     */
+    static uint16_t getTimeouts();
+
+    /**
+     * @brief Gets the number of recovery sequences run
+     */
+    static uint16_t getRecoveries();
+
+    /**
+     * @brief Checks whether the last recovery failed to release the lines
+     */
+    static bool isStuck();
+};
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file leds.cpp
+ * @author Riccardo Iacob
+ * @brief Status LED patterns played from a timer interrupt
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "leds.h"
+
+// Pins in Leds order
+static const uint8_t ledPins[StatusLeds::led_count] PROGMEM = {PIN_LED_GREEN, PIN_LED_YELLOW, PIN_LED_RED, PIN_LED_BLUE};
+
+volatile uint8_t StatusLeds::patterns[StatusLeds::led_count] = {0, 0, 0, 0};
+uint8_t StatusLeds::tick = 0;
+
+void StatusLeds::begin()
+{
+    for (uint8_t i = 0; i < led_count; i++)
+    {
+        pinMode(pgm_read_byte(&ledPins[i]), OUTPUT);
+    }
+
+    // Timer 3, CTC mode, prescaler 256: 16 MHz / 256 / 7812 = 8.0005 Hz
+    noInterrupts();
+    TCCR3A = 0;
+    TCCR3B = _BV(WGM32) | _BV(CS32);
+    TCNT3 = 0;
+    OCR3A = F_CPU / 256 / TICKS_PER_SECOND - 1;
+    TIMSK3 = _BV(OCIE3A);
+    interrupts();
+}
+
+void StatusLeds::setPattern(uint8_t led, uint8_t pattern)
+{
+    if (led < led_count)
+    {
+        patterns[led] = pattern;
+    }
+}
+
+void StatusLeds::suspend()
+{
+    TIMSK3 = 0;
+    for (uint8_t i = 0; i < led_count; i++)
+    {
+        digitalWrite(pgm_read_byte(&ledPins[i]), LOW);
+    }
+}
+
+void StatusLeds::resume()
+{
+    TIMSK3 = _BV(OCIE3A);
+}
+
+void StatusLeds::update()
+{
+    uint8_t mask = 1 << tick;
+    for (uint8_t i = 0; i < led_count; i++)
+    {
+        digitalWrite(pgm_read_byte(&ledPins[i]), (patterns[i] & mask) ? HIGH : LOW);
+    }
+    tick = (tick + 1) % TICKS_PER_SECOND;
+}
+
+ISR(TIMER3_COMPA_vect)
+{
+    StatusLeds::update();
+}
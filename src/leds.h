@@ -0,0 +1,85 @@
+/**
+ * @file leds.h
+ * @author Riccardo Iacob
+ * @brief Status LED patterns played from a timer interrupt
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef LEDS_H
+#define LEDS_H
+
+#include <Arduino.h>
+
+#include "hardware.h"
+
+/**
+ * Timer 3 (unused by the Arduino core on the ATmega2560) interrupts TICKS_PER_SECOND times per
+ * second. A pattern is one byte per LED, bit n giving the state during tick n of the second,
+ * so setting a pattern is a single atomic byte write and the main loop never waits on an LED.
+ */
+class StatusLeds
+{
+public:
+    /**
+     * @brief LEDs, in the order of the pins in hardware.h
+     */
+    enum Leds
+    {
+        led_green,
+        led_yellow,
+        led_red,
+        led_blue,
+        led_count
+    };
+
+    /**
+     * @brief Common patterns
+     */
+    enum Patterns
+    {
+        pattern_off = 0x00,
+        pattern_on = 0xFF,
+        pattern_blip = 0x01,
+        pattern_slow = 0x0F,
+        pattern_fast = 0x55
+    };
+
+    static const uint8_t TICKS_PER_SECOND = 8;
+
+private:
+    static volatile uint8_t patterns[led_count];
+    static uint8_t tick;
+
+public:
+    /**
+     * @brief Configures the LED pins and starts the timer
+     */
+    static void begin();
+
+    /**
+     * @brief Sets the pattern of a LED
+     *
+     * @param led: The LED (Leds)
+     * @param pattern: The pattern (Patterns or any bit mask)
+     */
+    static void setPattern(uint8_t led, uint8_t pattern);
+
+    /**
+     * @brief Stops the timer and turns all LEDs off, before the CPU powers down
+     */
+    static void suspend();
+
+    /**
+     * @brief Restarts the timer after suspend()
+     */
+    static void resume();
+
+    /**
+     * @brief Advances the patterns by one tick, called by the timer interrupt
+     */
+    static void update();
+};
+
+#endif
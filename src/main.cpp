@@ -12,69 +12,921 @@
 #include <Wire.h>
 
 #include "hardware.h"
+#include "buildcfg.h"
+#include "i2cbus.h"
 #include "bme680.h"
 #include "ds3231.h"
 #include "ssd1306.h"
+#include "console.h"
+#include "configstore.h"
+#include "numfmt.h"
+#include "samplelog.h"
+#include "histxfer.h"
+#include "txqueue.h"
+#include "sampleout.h"
+#include "spscqueue.h"
+#include "filter.h"
+#include "osctrl.h"
+#include "derived.h"
+#include "alerts.h"
+#include "leds.h"
+#include "power.h"
+#include "gasbaseline.h"
+#include "acqplan.h"
+#include "clock.h"
+
+// Cadence of the samples stored in the EEPROM log, in seconds
+#define LOG_PERIOD_S 60
+// Completed samples waiting for the consumers (power of two)
+#define SAMPLE_QUEUE_LENGTH 4
+// Interval of the I2C device presence checks, in seconds
+#define DEVICE_CHECK_S 10
+// Ambient temperature change, in °C, that recomputes the heater resistance
+#define HEATER_AMBIENT_STEP_C 5
+// Line of the stats reply the output statistics start at, and their number per output
+#define STATS_OUTPUT_LINE 31
+#define OUTPUT_STATS 5
+// Default acquisition periods, in seconds (console "rate", saved with the configuration): pressure
+// for weather trends once a minute, temperature, humidity and the gas heater profile every few
+// seconds; 0 = every conversion. A conversion only starts once a channel is due, so the sample
+// period of the oversampling controller only matters while it is longer than the shortest of
+// these. Filter windows count samples, so they span the channel's period times the window
+#define RATE_TEMPERATURE_S 3
+#define RATE_HUMIDITY_S 3
+#define RATE_PRESSURE_S 60
+#define RATE_GAS_S 3
 
 BME680 bme680(I2C_BME680_ADD);
+BME680::BMEConfig bmeConfig;
+BME680::BMECalibrationParameters bmeCalibration;
 DS3231 rtc(I2C_DS3231_ADD);
 SSD1306 oled;
+ConfigStore configStore(EEPROM_CONFIG_ADD, EEPROM_CONFIG_SLOTS, EEPROM_CONFIG_SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+uint8_t serialTxBuffer[TX_QUEUE_SERIAL];
+uint8_t serialBTTxBuffer[TX_QUEUE_SERIALBT];
+TxQueue serialOut(&Serial, serialTxBuffer, sizeof(serialTxBuffer));
+TxQueue serialBTOut(&Serial1, serialBTTxBuffer, sizeof(serialBTTxBuffer));
+SampleOutput sampleOut(&serialOut);
+SampleOutput sampleBTOut(&serialBTOut);
+Console console(&serialOut, &bme680, &configStore);
+Console consoleBT(&serialBTOut, &bme680, &configStore);
+SampleLog sampleLog(I2C_EEPROM_ADD, LOG_PERIOD_S);
+HistoryExport historyExport(&sampleLog);
+SpscQueue<SampleRecord, SAMPLE_QUEUE_LENGTH> sampleQueue;
+SampleFilter sampleFilter;
+OversamplingController oversampling(&bme680);
+DerivedMetrics derivedMetrics;
+AcquisitionPlanner planner;
+
+// Alert rules: source, flags, level, dwell (samples), hysteresis, threshold
+const AlertEngine::Rule alertRules[] PROGMEM = {
+    {AlertEngine::source_temperature, 0, AlertEngine::level_warning, 3, 50, 3000},
+    {AlertEngine::source_temperature, 0, AlertEngine::level_alarm, 3, 50, 3500},
+    {AlertEngine::source_temperature, AlertEngine::rule_below, AlertEngine::level_warning, 3, 50, 500},
+#if FEATURE_HUMIDITY
+    {AlertEngine::source_humidity, 0, AlertEngine::level_warning, 5, 200, 7000},
+    {AlertEngine::source_humidity, AlertEngine::rule_below, AlertEngine::level_info, 5, 200, 2500},
+    {AlertEngine::source_dew_point, 0, AlertEngine::level_info, 5, 100, 2000},
+#endif
+#if FEATURE_PRESSURE
+    {AlertEngine::source_pressure, AlertEngine::rule_below, AlertEngine::level_info, 10, 100, 98000},
+#endif
+};
+AlertEngine alerts(alertRules, sizeof(alertRules) / sizeof(alertRules[0]));
+PowerManager power;
+#if FEATURE_GAS
+// Burn-in conditioning steps: set point, heater temperature (°C), duration (s); the operating
+// profile of the configuration follows
+const GasBaseline::BurnInStep burnInSchedule[] PROGMEM = {
+    {BME680::point_1, 400, 1800},
+    {BME680::point_2, 360, 1800},
+};
+GasBaseline gasBaseline(burnInSchedule, sizeof(burnInSchedule) / sizeof(burnInSchedule[0]));
+ConfigStore gasStore(EEPROM_GAS_ADD, EEPROM_GAS_SLOTS, EEPROM_GAS_SLOT_SIZE, ConfigStore::TYPE_GAS_BASELINE);
+#endif
+
+// Number of completed samples since boot
+uint32_t sampleCount = 0;
+// Time of the last logged sample
+unsigned long lastLogMillis = 0;
+// Forced conversion state
+bool converting = false;
+uint8_t convertingChannels = 0;
+unsigned long lastConversionMillis = 0;
+// Last value of every channel, for the outputs showing all of them
+SampleRecord latestSample;
+// Degraded mode: a missing device is skipped and probed again every DEVICE_CHECK_S
+bool sensorPresent = false;
+bool displayPresent = false;
+unsigned long lastDeviceCheckMillis = 0;
 
 void setupGPIO();
 void setupUART();
 void setupOLED();
+bool setupSensor();
+void checkDevices();
+void setPower(bool enable, uint8_t display);
+void applyDisplayPower();
+bool isDisplayShown();
+uint32_t nextWakeMillis();
+bool isBusy();
+bool printStats(Print *out, uint8_t line);
+uint8_t availableChannels();
+void startConversion();
+void holdSample(SampleRecord *sample);
+#if FEATURE_GAS
+void setupGas();
+void updateGas(const SampleRecord *sample, SampleRecord *filtered);
+void updateHeater(int16_t ambient);
+#endif
+void readSample(uint8_t channels);
+void processSample(const SampleRecord *sample);
+
+bool selectScreen(uint8_t screen);
+bool startExport(Stream *io, bool resume, uint16_t blockSequence);
+ChannelFilter *getFilter(uint8_t channel);
+bool setAdaptive(uint16_t periodMillis, const uint8_t *priorities);
+AcquisitionPlanner *getPlanner();
+bool printDerived(Print *out, uint8_t line, uint16_t seaLevelHpa);
+void updateLeds();
+void sendAlertEvents();
+void updateDisplay(int16_t t, uint32_t h, uint32_t p);
+void printSample(SampleOutput *out, TxQueue *queue, const SampleRecord *sample, uint32_t h);
+void printOutputStats(Print *out, const __FlashStringHelper *name, SampleOutput *output, TxQueue *queue, uint8_t field);
 
 void setup()
 {
   setupUART();
   setupGPIO();
+  I2CBus::begin();
+  Clock::begin(&rtc);
+  planner.setPeriod(0, RATE_TEMPERATURE_S);
+  planner.setPeriod(1, RATE_HUMIDITY_S);
+  planner.setPeriod(2, RATE_PRESSURE_S);
+  planner.setPeriod(3, RATE_GAS_S);
   setupOLED();
-  bme680.begin();
-  oled.printScreen(SSD1306::Screens::screen_welcome);
+  bme680.config = &bmeConfig;
+  bme680.calibration = &bmeCalibration;
+  bme680.setDefaultConfig();
+  // Override the defaults with the newest persisted configuration, if any
+  if (configStore.begin())
+  {
+    configStore.load(&bmeConfig, &planner);
+  }
+#if FEATURE_GAS
+  setupGas();
+#endif
+  sensorPresent = setupSensor();
+  lastDeviceCheckMillis = millis();
+  sampleLog.begin();
+  Console::setStatsHandler(printStats);
+  Console::setScreenHandler(selectScreen);
+  Console::setExportHandler(startExport);
+  Console::setFilterHandler(getFilter);
+  Console::setAdaptHandler(setAdaptive);
+  Console::setDerivedHandler(printDerived);
+  Console::setPowerHandler(setPower);
+  Console::setRateHandler(getPlanner);
+  Console::setTimeHandler(Clock::accessTime);
+  if (displayPresent)
+  {
+    oled.printScreen(SSD1306::Screens::screen_welcome);
+  }
+  updateLeds();
 }
 
 void loop()
 {
-  // Set humidity oversampling to x16
-  bme680.i2c_writeByte(0x72, 0b1110000);
-  // Set temperature and pressure oversampling to x16
-  bme680.i2c_writeByte(0x74, 0b00111111);
+  // Handle operator commands without waiting for input, except on a stream busy with an export
+  historyExport.poll();
+  // Input holds off power-down, so the rest of a command line is not lost
+  if (Serial.available() || Serial1.available())
+  {
+    power.noteActivity();
+  }
+  bool exporting = historyExport.isActive();
+  if (!exporting || historyExport.getStream() != &serialOut)
+  {
+    console.poll();
+    sampleOut.poll();
+  }
+  if (!exporting || historyExport.getStream() != &serialBTOut)
+  {
+    consoleBT.poll();
+    sampleBTOut.poll();
+  }
+  // Hand queued output to the UARTs, only what fits in their buffers
+  serialOut.pump();
+  serialBTOut.pump();
 
-  // Read temperature
-  uint32_t rawt = bme680.readRawTemperature();
-  double calct = bme680.calculateTemperature(rawt);
+  // Bus recovery after a timed out transaction, then missing devices are probed again
+  I2CBus::poll();
+  // One queued log chunk per pass, once the EEPROM has finished the previous write cycle
+  sampleLog.poll();
+  if (millis() - lastDeviceCheckMillis >= DEVICE_CHECK_S * 1000UL)
+  {
+    lastDeviceCheckMillis = millis();
+    checkDevices();
+    Clock::sync();
+  }
+
+  // Producer: completed conversions go to the sample queue, the next one starts at the sample
+  // period (immediately if the adaptive controller is off) if the planner has a channel due
+  if (sensorPresent && converting)
+  {
+    bme680.clearError();
+    if (!bme680.isMeasuring())
+    {
+      readSample(convertingChannels);
+      converting = false;
+    }
+    // A sensor that stops answering is dropped until a presence check finds it again
+    if (bme680.getError() != I2CBus::Errors::error_none)
+    {
+      sensorPresent = false;
+      converting = false;
+      updateLeds();
+    }
+  }
+  if (sensorPresent && !converting && millis() - lastConversionMillis >= oversampling.getPeriodMillis())
+  {
+    startConversion();
+  }
+
+  // Consumers: unchanged if the producer moves to an interrupt
+  SampleRecord sample;
+  bool consumed = false;
+  while (sampleQueue.pop(sample))
+  {
+    processSample(&sample);
+    consumed = true;
+  }
+  sendAlertEvents();
+
+  // Low-power operation: sleep until the next scheduled work instead of spinning
+  if (power.isEnabled())
+  {
+    power.sleep(nextWakeMillis(), isBusy());
+  }
+  else if (consumed)
+  {
+    delay(5);
+  }
+}
+
+void startConversion()
+{
+  // Only the channels due, one forced conversion; nothing due, no bus traffic
+  uint32_t now = Clock::now();
+  uint8_t available = availableChannels();
+  uint8_t channels = planner.plan(now, available);
+  if (channels == 0)
+  {
+    return;
+  }
+  lastConversionMillis = millis();
+  converting = bme680.startConversion(channels);
+  if (converting)
+  {
+    convertingChannels = channels;
+    planner.commit(channels, now, available);
+  }
+}
+
+uint8_t availableChannels()
+{
+#if FEATURE_GAS
+  return SENSOR_CHANNELS | (bmeConfig.run_gas ? channel_gas : 0);
+#else
+  return SENSOR_CHANNELS;
+#endif
+}
+
+void readSample(uint8_t channels)
+{
+  // Only the registers of the channels measured are read
+  SampleRecord sample;
+  sample.timestamp = Clock::now();
+  sample.temperature = 0;
+  sample.humidity = 0;
+  sample.pressure = 0;
+  sample.gasResistance = 0;
+  sample.channels = channels & SENSOR_CHANNELS;
+
+  // Read temperature (always measured with humidity and pressure, which are compensated with it)
+  if (channels & channel_temperature)
+  {
+    uint32_t rawt = bme680.readRawTemperature();
+    bme680.calculateTemperature(rawt);
+    sample.temperature = bme680.getTemperatureCentiC();
+  }
 
   // Read humidity
-  uint32_t rawh = bme680.readRawHumidity();
-  double calch = bme680.calculateHumidity(rawh);
+#if FEATURE_HUMIDITY
+  if (channels & channel_humidity)
+  {
+    uint32_t rawh = bme680.readRawHumidity();
+    sample.humidity = NumberFormat::dropDecimals(bme680.calculateHumidity(rawh), 1);
+  }
+#endif
 
   // Read pressure
-  uint32_t rawp = bme680.readRawPressure();
-  double calcp = bme680.calculatePressure(rawp);
+#if FEATURE_PRESSURE
+  if (channels & channel_pressure)
+  {
+    uint32_t rawp = bme680.readRawPressure();
+    sample.pressure = bme680.calculatePressure(rawp);
+  }
+#endif
+
+  // Read gas, only a reading taken with the heater at its target temperature
+#if FEATURE_GAS
+  uint16_t rawg;
+  uint8_t range;
+  if ((channels & channel_gas) && bme680.readRawGas(&rawg, &range))
+  {
+    sample.gasResistance = bme680.calculateGasResistance(rawg, range);
+    sample.channels |= channel_gas;
+  }
+#endif
+
+  // Values read over a failed transaction are 0, not a sample
+  if (bme680.getError() != I2CBus::Errors::error_none)
+  {
+    return;
+  }
+  sampleQueue.push(sample);
+}
+
+void processSample(const SampleRecord *sample)
+{
+  // Median spike rejection and Kalman smoothing, in place of heavy IIR filtering in the sensor
+  SampleRecord filtered = *sample;
+  sampleFilter.apply(&filtered);
+#if FEATURE_GAS
+  updateGas(sample, &filtered);
+#endif
+  // Noise is measured on the raw values
+  oversampling.observe(sample);
+  // Channels not measured in this conversion keep their last value; channels still flags the fresh ones
+  holdSample(&filtered);
+  // Only stored, derived values are computed when asked for
+  derivedMetrics.update(&filtered);
+  alerts.evaluate(&filtered, &derivedMetrics);
+  updateLeds();
+
+  // t in centi-°C, h in milli-%, p in Pa
+  int16_t t = filtered.temperature;
+  uint32_t h = (uint32_t)filtered.humidity * 10;
+  uint32_t p = filtered.pressure;
+  sampleCount++;
+  power.noteSample();
 
   // Print readings
-  //Serial.print("Temperature [RAW/CALC]: ");
-  Serial.println(calct);
-  /*Serial.print("/");
-  Serial.print(calct);
-  Serial.println();
-  Serial.print("Humidity [RAW]: ");
-  Serial.print(rawh);
-  Serial.println();
-  Serial.print("Pressure [RAW]: ");
-  Serial.print(rawp);
-  Serial.println();
-  Serial.println();*/
-
-  delay(5);
+  printSample(&sampleOut, &serialOut, &filtered, h);
+  printSample(&sampleBTOut, &serialBTOut, &filtered, h);
+  if (isDisplayShown())
+  {
+    updateDisplay(t, h, p);
+  }
+
+  // Log at a fixed cadence, so timestamps are implied by the position in the log
+  if (millis() - lastLogMillis >= LOG_PERIOD_S * 1000UL)
+  {
+    lastLogMillis += LOG_PERIOD_S * 1000UL;
+    SampleRecord record = filtered;
+    record.timestamp = Clock::toSeconds(lastLogMillis);
+    record.channels = latestSample.channels;
+    sampleLog.append(&record);
+  }
+}
+
+void holdSample(SampleRecord *sample)
+{
+  uint8_t fresh = sample->channels;
+  if (fresh & channel_temperature)
+  {
+    latestSample.temperature = sample->temperature;
+  }
+  if (fresh & channel_humidity)
+  {
+    latestSample.humidity = sample->humidity;
+  }
+  if (fresh & channel_pressure)
+  {
+    latestSample.pressure = sample->pressure;
+  }
+  if (fresh & channel_gas)
+  {
+    latestSample.gasResistance = sample->gasResistance;
+  }
+  latestSample.channels |= fresh;
+  latestSample.timestamp = sample->timestamp;
+  *sample = latestSample;
+  sample->channels = fresh;
+}
+
+void printSample(SampleOutput *out, TxQueue *queue, const SampleRecord *sample, uint32_t h)
+{
+  // Text would corrupt the frames of a running export
+  if (historyExport.isActive() && historyExport.getStream() == queue)
+  {
+    return;
+  }
+
+  // Sparse: the channels measured, as they were measured. Otherwise every channel (held values),
+  // once per conversion measuring temperature; t in centi-°C, h in milli-%, p in Pa; never waits
+  // for the link
+  if (Console::outputMode == Console::OutputMode::mode_sparse)
+  {
+    out->submitSparse(sample);
+  }
+  else if (sample->channels & channel_temperature)
+  {
+    out->submit(sample->temperature, h, sample->pressure);
+  }
+}
+
+#if FEATURE_GAS
+void setupGas()
+{
+  // Warm start from the newest checkpoint; fields missing from an older, shorter record stay 0
+  GasBaseline::Checkpoint checkpoint = {0, 0};
+  if (gasStore.begin() && gasStore.loadRecord(&checkpoint, sizeof(checkpoint)))
+  {
+    gasBaseline.restore(&checkpoint);
+  }
+  planner.setForced(channel_gas);
+}
+
+void updateGas(const SampleRecord *sample, SampleRecord *filtered)
+{
+  // The stability detector works on raw readings; until burn-in completes gas is not a valid reading
+  // Uptime, not the wall clock: setting the RTC must not shorten or stretch the burn-in
+  uint32_t uptime = millis() / 1000;
+  gasBaseline.update(sample->gasResistance, (sample->channels & channel_gas) != 0, uptime);
+  if (!gasBaseline.isValid())
+  {
+    filtered->channels &= ~channel_gas;
+  }
+  // Burn-in steps and the settling windows are timed on uptime and need a reading on every
+  // conversion, so gas ignores its rate until the readings are valid
+  planner.setForced(gasBaseline.isValid() ? 0 : channel_gas);
+  updateHeater(filtered->temperature);
+
+  if (gasBaseline.isCheckpointDue(uptime))
+  {
+    GasBaseline::Checkpoint checkpoint;
+    gasBaseline.getCheckpoint(&checkpoint);
+    gasBaseline.markCheckpoint(uptime, gasStore.saveRecord(&checkpoint, sizeof(checkpoint), GasBaseline::CHECKPOINT_VERSION));
+  }
+}
+
+void updateHeater(int16_t ambient)
+{
+  // Conditioning steps override the configured profile; a profile written by the console or by a
+  // sensor setup is brought back in line on the next sample
+  uint8_t point = bmeConfig.set_point;
+  uint16_t temp = bmeConfig.target_temp < 0 ? 0 : (uint16_t)bmeConfig.target_temp;
+  gasBaseline.getHeater(&point, &temp);
+  int8_t ambientC = ambient / 100;
+  if (point != bme680.getHeaterPoint() || temp != bme680.getHeaterTemp() ||
+      abs(ambientC - bme680.getHeaterAmbient()) >= HEATER_AMBIENT_STEP_C)
+  {
+    bme680.applyHeater(point, temp, ambientC);
+  }
+}
+#endif
+
+void updateDisplay(int16_t t, uint32_t h, uint32_t p)
+{
+  // Leave the welcome screen once the first samples are in
+  if (oled.getScreen() == SSD1306::Screens::screen_welcome && millis() > 2000)
+  {
+    oled.printScreen(SSD1306::Screens::screen_live);
+  }
+
+  // Fields of screens not currently shown are ignored
+  oled.updateField(SSD1306::field_temperature, t, 2);
+#if FEATURE_HUMIDITY
+  oled.updateField(SSD1306::field_humidity, NumberFormat::dropDecimals(h, 1), 2);
+#else
+  (void)h;
+#endif
+#if FEATURE_PRESSURE
+  oled.updateField(SSD1306::field_pressure, NumberFormat::dropDecimals(p, 1), 1);
+#else
+  (void)p;
+#endif
+#if FEATURE_GAS
+  // Held gas reading against the baseline; dashes until the burn-in or warm start completes
+  if (gasBaseline.isValid() && (latestSample.channels & channel_gas))
+  {
+    oled.updateField(SSD1306::field_iaq, gasBaseline.getAirQuality(latestSample.gasResistance), 0);
+  }
+  else
+  {
+    oled.clearField(SSD1306::field_iaq);
+  }
+#endif
+  oled.pushTrend(t);
+  oled.updateStatus(SSD1306::status_samples, sampleCount, 0);
+  oled.updateStatus(SSD1306::status_uptime, millis() / 1000, 0);
+  oled.updateStatus(SSD1306::status_config, configStore.getSequence(), 0);
+  oled.updateStatus(SSD1306::status_i2c_errors, bme680.getErrorCount(), 0);
+
+  // Only the changed glyph columns are sent
+  oled.flush();
+}
+
+bool selectScreen(uint8_t screen)
+{
+  if (!displayPresent || screen > (uint8_t)SSD1306::Screens::screen_status)
+  {
+    return false;
+  }
+  oled.printScreen((SSD1306::Screens)screen);
+  return true;
+}
+
+bool startExport(Stream *io, bool resume, uint16_t blockSequence)
+{
+  return historyExport.start(io, resume, blockSequence);
+}
+
+ChannelFilter *getFilter(uint8_t channel)
+{
+  return sampleFilter.getChannel(channel);
+}
+
+bool setAdaptive(uint16_t periodMillis, const uint8_t *priorities)
+{
+  if (periodMillis == 0)
+  {
+    oversampling.disable();
+    return true;
+  }
+  return oversampling.configure(periodMillis, priorities);
+}
+
+AcquisitionPlanner *getPlanner()
+{
+  return &planner;
+}
+
+void setPower(bool enable, uint8_t display)
+{
+  if (enable)
+  {
+    power.enable(display);
+  }
+  else
+  {
+    power.disable();
+  }
+  applyDisplayPower();
+}
+
+void applyDisplayPower()
+{
+  if (!displayPresent)
+  {
+    return;
+  }
+  uint8_t mode = power.isEnabled() ? power.getDisplayMode() : (uint8_t)PowerManager::display_bright;
+  oled.ssd1306_command(mode == PowerManager::display_blank ? SSD1306_DISPLAYOFF : SSD1306_DISPLAYON);
+  oled.dim(mode == PowerManager::display_dim);
+}
+
+bool isDisplayShown()
+{
+  // A blanked display is not updated at all
+  return displayPresent && !(power.isEnabled() && power.getDisplayMode() == PowerManager::display_blank);
+}
+
+uint32_t nextWakeMillis()
+{
+  // The earliest of: end of the running conversion, next conversion (sample period, then the next
+  // channel due), next device check
+  uint32_t next = lastDeviceCheckMillis + DEVICE_CHECK_S * 1000UL;
+  if (sensorPresent)
+  {
+    uint32_t sensorNext = lastConversionMillis + (converting ? OversamplingController::measurementMillis(&bmeConfig) : oversampling.getPeriodMillis());
+    if (!converting)
+    {
+      uint32_t dueNext = Clock::toMillis(planner.getNextDue(Clock::now(), availableChannels()));
+      if ((int32_t)(dueNext - sensorNext) > 0)
+      {
+        sensorNext = dueNext;
+      }
+    }
+    if ((int32_t)(sensorNext - next) < 0)
+    {
+      next = sensorNext;
+    }
+  }
+  return next;
+}
+
+bool isBusy()
+{
+  // Power-down would cut off queued output, unread input, a running export and queued log writes
+  return serialOut.getQueued() != 0 || serialBTOut.getQueued() != 0 ||
+         Serial.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1 || Serial1.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1 ||
+         Serial.available() != 0 || Serial1.available() != 0 || historyExport.isActive() || !sampleLog.isIdle();
+}
+
+void updateLeds()
+{
+  // Only the most severe active level is shown, a green blip means no alert; a red blip means
+  // a missing device (unless an alarm is shown)
+  uint8_t level = alerts.getLevel();
+  bool fault = !sensorPresent || !displayPresent;
+  uint8_t red = level == AlertEngine::level_alarm ? StatusLeds::pattern_fast : (fault ? StatusLeds::pattern_blip : StatusLeds::pattern_off);
+  StatusLeds::setPattern(StatusLeds::led_green, level == AlertEngine::level_none ? StatusLeds::pattern_blip : StatusLeds::pattern_off);
+  StatusLeds::setPattern(StatusLeds::led_blue, level == AlertEngine::level_info ? StatusLeds::pattern_on : StatusLeds::pattern_off);
+  StatusLeds::setPattern(StatusLeds::led_yellow, level == AlertEngine::level_warning ? StatusLeds::pattern_slow : StatusLeds::pattern_off);
+  StatusLeds::setPattern(StatusLeds::led_red, red);
+}
+
+void sendAlertEvents()
+{
+  // "ALERT <rule> <on|off> <value>", sent to both ports; an event stays queued until both have room
+  AlertEngine::AlertEvent event;
+  char line[8 + 2 * NumberFormat::BUFFER_SIZE];
+  bool toSerial = !historyExport.isActive() || historyExport.getStream() != &serialOut;
+  bool toSerialBT = !historyExport.isActive() || historyExport.getStream() != &serialBTOut;
+
+  while (true)
+  {
+    if (Console::outputMode != Console::OutputMode::mode_off &&
+        ((toSerial && serialOut.availableForWrite() < (int)sizeof(line)) ||
+         (toSerialBT && serialBTOut.availableForWrite() < (int)sizeof(line))))
+    {
+      return;
+    }
+    if (!alerts.popEvent(event))
+    {
+      return;
+    }
+    if (Console::outputMode == Console::OutputMode::mode_off)
+    {
+      continue;
+    }
+
+    memcpy_P(line, PSTR("ALERT "), 6);
+    uint8_t length = 6;
+    length += NumberFormat::formatUnsigned(line + length, event.rule);
+    memcpy_P(line + length, event.active ? PSTR(" on ") : PSTR(" off "), event.active ? 4 : 5);
+    length += event.active ? 4 : 5;
+    length += NumberFormat::formatFixed(line + length, event.value, 0);
+    line[length++] = '\r';
+    line[length++] = '\n';
+    if (toSerial)
+    {
+      serialOut.tryWrite((const uint8_t *)line, length);
+    }
+    if (toSerialBT)
+    {
+      serialBTOut.tryWrite((const uint8_t *)line, length);
+    }
+  }
+}
+
+bool printDerived(Print *out, uint8_t line, uint16_t seaLevelHpa)
+{
+  // One metric per line. Metrics of channels compiled out are not referenced, so the linker drops
+  // their tables; their lines stay empty
+#if FEATURE_PRESSURE
+  if (seaLevelHpa != 0)
+  {
+    derivedMetrics.setSeaLevelPressure((uint32_t)seaLevelHpa * 100);
+  }
+#else
+  (void)seaLevelHpa;
+#endif
+  switch (line)
+  {
+#if FEATURE_HUMIDITY
+  case 0:
+    out->print(F("dew_point="));
+    NumberFormat::print(out, derivedMetrics.getDewPoint(), 2);
+    out->println();
+    break;
+  case 1:
+    out->print(F("abs_humidity="));
+    NumberFormat::print(out, derivedMetrics.getAbsoluteHumidity(), 2);
+    out->println();
+    break;
+#endif
+#if FEATURE_PRESSURE
+  case 2:
+    out->print(F("altitude="));
+    NumberFormat::print(out, derivedMetrics.getAltitude(), 1);
+    out->println();
+    break;
+  case 3:
+    out->print(F("sea_level_pa="));
+    out->println(derivedMetrics.getSeaLevelPressure());
+    break;
+#endif
+  default:
+    return line < 4;
+  }
+  return true;
+}
+
+bool printStats(Print *out, uint8_t line)
+{
+  // One statistic per line, so the console writes them as the link takes them
+  switch (line)
+  {
+  case 0:
+    out->print(F("samples="));
+    out->println(sampleCount);
+    break;
+  case 1:
+    out->print(F("uptime_ms="));
+    out->println(millis());
+    break;
+  case 2:
+    out->print(F("log_blocks="));
+    out->println(sampleLog.getBlockCount());
+    break;
+  case 3:
+    out->print(F("log_pending="));
+    out->println(sampleLog.getPendingRecords());
+    break;
+  case 4:
+    out->print(F("log_failed_writes="));
+    out->println(sampleLog.getFailedWrites());
+    break;
+  case 5:
+    out->print(F("sample_overruns="));
+    out->println(sampleQueue.getOverruns());
+    break;
+  case 6:
+    out->print(F("clock="));
+    out->println(Clock::isSynced() ? F("rtc") : F("uptime"));
+    break;
+  case 7:
+    out->print(F("conversions="));
+    out->println(planner.getConversions());
+    break;
+  case 8:
+    out->print(F("skipped_readings="));
+    out->println(planner.getSkippedReadings());
+    break;
+  case 9:
+    out->print(F("sensor="));
+    out->println(sensorPresent ? F("ok") : F("missing"));
+    break;
+  case 10:
+    out->print(F("display="));
+    out->println(displayPresent ? F("ok") : F("missing"));
+    break;
+  case 11:
+    out->print(F("i2c_errors="));
+    out->println(bme680.getErrorCount());
+    break;
+  case 12:
+    out->print(F("i2c_bus_errors="));
+    out->println(I2CBus::getErrors());
+    break;
+  case 13:
+    out->print(F("i2c_timeouts="));
+    out->println(I2CBus::getTimeouts());
+    break;
+  case 14:
+    out->print(F("i2c_recoveries="));
+    out->println(I2CBus::getRecoveries());
+    break;
+  case 15:
+    out->print(F("power="));
+    out->println(power.isEnabled() ? F("on") : F("off"));
+    break;
+  case 16:
+    out->print(F("duty_permille="));
+    out->println(power.getDutyCycle());
+    break;
+  case 17:
+    out->print(F("charge_per_sample_uc="));
+    out->println(power.getChargePerSample());
+    break;
+  case 18:
+    out->print(F("sleep_idle_ms="));
+    out->println(power.getIdleMillis());
+    break;
+  case 19:
+    out->print(F("sleep_down_ms="));
+    out->println(power.getPowerDownMillis());
+    break;
+  case 20:
+    out->print(F("alert_level="));
+    out->println(alerts.getLevel());
+    break;
+  case 21:
+    out->print(F("alert_events_lost="));
+    out->println(alerts.getLostEvents());
+    break;
+#if FEATURE_GAS
+  case 22:
+    out->print(F("gas_state="));
+    out->println(gasBaseline.getState() == GasBaseline::state_valid ? F("valid") : (gasBaseline.getState() == GasBaseline::state_warm_start ? F("warm_start") : F("burn_in")));
+    break;
+  case 23:
+    out->print(F("gas_baseline="));
+    out->println(gasBaseline.getBaseline());
+    break;
+  case 24:
+    out->print(F("gas_slope_permille_h="));
+    out->println(gasBaseline.getSlope());
+    break;
+  case 25:
+    out->print(F("gas_settle_s="));
+    out->println(gasBaseline.getSettleSeconds());
+    break;
+  case 26:
+    out->print(F("gas_checkpoint="));
+    out->println(gasStore.getSequence());
+    break;
+#endif
+  case 27:
+    out->print(F("adapt="));
+    out->println(oversampling.isEnabled() ? (oversampling.isTransient() ? F("fast") : F("quiet")) : F("off"));
+    break;
+  case 28:
+    // Noise in 1/16 units, printed with two decimals: centi-°C, Pa, centi-%
+    out->print(F("noise_t="));
+    NumberFormat::print(out, (int32_t)oversampling.getNoise(0) * 25 / 4, 2);
+    out->println();
+    break;
+  case 29:
+    out->print(F("noise_p="));
+    NumberFormat::print(out, (int32_t)oversampling.getNoise(1) * 25 / 4, 2);
+    out->println();
+    break;
+  case 30:
+    out->print(F("noise_h="));
+    NumberFormat::print(out, (int32_t)oversampling.getNoise(2) * 25 / 4, 2);
+    out->println();
+    break;
+  default:
+    // Lines of statistics compiled out stay empty; then the outputs, one statistic per line
+    if (line < STATS_OUTPUT_LINE)
+    {
+      break;
+    }
+    line -= STATS_OUTPUT_LINE;
+    if (line >= 2 * OUTPUT_STATS)
+    {
+      return false;
+    }
+    if (line < OUTPUT_STATS)
+    {
+      printOutputStats(out, F("usb"), &sampleOut, &serialOut, line);
+    }
+    else
+    {
+      printOutputStats(out, F("bt"), &sampleBTOut, &serialBTOut, line - OUTPUT_STATS);
+    }
+    break;
+  }
+  return true;
+}
+
+void printOutputStats(Print *out, const __FlashStringHelper *name, SampleOutput *output, TxQueue *queue, uint8_t field)
+{
+  out->print(name);
+  switch (field)
+  {
+  case 0:
+    out->print(F("_dropped="));
+    out->println(output->getDropped());
+    break;
+  case 1:
+    out->print(F("_coalesced="));
+    out->println(output->getCoalesced());
+    break;
+  case 2:
+    out->print(F("_aggregated="));
+    out->println(output->getAggregated());
+    break;
+  case 3:
+    out->print(F("_tx_high_water="));
+    out->println(queue->getHighWater());
+    break;
+  default:
+    out->print(F("_tx_truncated="));
+    out->println(queue->getTruncated());
+    break;
+  }
 }
 
 void setupGPIO()
 {
-  pinMode(PIN_LED_RED, OUTPUT);
-  pinMode(PIN_LED_YELLOW, OUTPUT);
-  pinMode(PIN_LED_GREEN, OUTPUT);
-  pinMode(PIN_LED_BLUE, OUTPUT);
+  // LED pins and the timer playing their patterns
+  StatusLeds::begin();
 }
 
 void setupUART()
@@ -85,14 +937,57 @@ void setupUART()
 
 void setupOLED()
 {
-  // Begin OLED, generating 3.3v internally
-  if (!oled.begin(SSD1306_SWITCHCAPVCC, I2C_OLED_ADD))
+  // Begin OLED, generating 3.3v internally; begin() itself does not check the bus, so the display
+  // is probed first. Without it the firmware keeps sampling (degraded mode)
+  displayPresent = I2CBus::probe(I2C_OLED_ADD) && oled.begin(SSD1306_SWITCHCAPVCC, I2C_OLED_ADD);
+}
+
+bool setupSensor()
+{
+  // A fresh start of the sensor: calibration, configuration, first conversion (every channel)
+  converting = false;
+  uint32_t now = Clock::now();
+  uint8_t channels = availableChannels();
+  if (!bme680.begin() || !bme680.applyConfig() || !bme680.startConversion(channels))
+  {
+    return false;
+  }
+  planner.commit(channels, now, channels);
+  convertingChannels = channels;
+  converting = true;
+  lastConversionMillis = millis();
+  return true;
+}
+
+void checkDevices()
+{
+  // One address byte per device: a hung bus is recovered, a device that reappears is set up again
+  if (I2CBus::isStuck())
+  {
+    I2CBus::recover();
+  }
+  bool sensorAnswers = I2CBus::probe(I2C_BME680_ADD);
+  if (sensorAnswers && !sensorPresent)
+  {
+    sensorPresent = setupSensor();
+  }
+  else if (!sensorAnswers)
   {
-    // Fault code = continuous red led (example)
-    digitalWrite(PIN_LED_RED, HIGH);
-    // Loop infinitely
-    while (1)
+    sensorPresent = false;
+  }
+  bool displayAnswers = I2CBus::probe(I2C_OLED_ADD);
+  if (displayAnswers && !displayPresent)
+  {
+    setupOLED();
+    if (displayPresent)
     {
+      oled.printScreen(SSD1306::Screens::screen_live);
+      applyDisplayPower();
     }
   }
+  else if (!displayAnswers)
+  {
+    displayPresent = false;
+  }
+  updateLeds();
 }
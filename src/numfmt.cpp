@@ -0,0 +1,128 @@
+/**
+ * @file numfmt.cpp
+ * @author Riccardo Iacob
+ * @brief Integer-only decimal formatting of scaled fixed-point values
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "numfmt.h"
+
+static const uint32_t powersOfTen[10] PROGMEM = {
+    1000000000UL,
+    100000000UL,
+    10000000UL,
+    1000000UL,
+    100000UL,
+    10000UL,
+    1000UL,
+    100UL,
+    10UL,
+    1UL};
+
+/**
+ * @brief Writes the decimal digits of value, with at least minDigits digits (zero padded)
+ * A decimal point is inserted before the last `decimals` digits when decimals is not 0
+ */
+static uint8_t writeDigits(char *buf, uint32_t value, uint8_t minDigits, uint8_t decimals)
+{
+    uint8_t length = 0;
+    bool started = false;
+
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        uint32_t power = pgm_read_dword(&powersOfTen[i]);
+        char digit = '0';
+        while (value >= power)
+        {
+            value -= power;
+            digit++;
+        }
+        // Position counted from the right, 1 being the units digit
+        uint8_t position = 10 - i;
+        if (digit != '0' || position <= minDigits)
+        {
+            started = true;
+        }
+        if (started)
+        {
+            if (decimals != 0 && position == decimals)
+            {
+                buf[length++] = '.';
+            }
+            buf[length++] = digit;
+        }
+    }
+    buf[length] = '\0';
+    return length;
+}
+
+uint8_t NumberFormat::formatUnsigned(char *buf, uint32_t value)
+{
+    return writeDigits(buf, value, 1, 0);
+}
+
+uint8_t NumberFormat::formatFixed(char *buf, int32_t value, uint8_t decimals)
+{
+    uint8_t length = 0;
+    uint32_t magnitude;
+
+    if (value < 0)
+    {
+        buf[length++] = '-';
+        // Negate in unsigned arithmetic so INT32_MIN does not overflow
+        magnitude = 0UL - (uint32_t)value;
+    }
+    else
+    {
+        magnitude = (uint32_t)value;
+    }
+
+    if (decimals > 9)
+    {
+        decimals = 9;
+    }
+    return length + writeDigits(buf + length, magnitude, decimals + 1, decimals);
+}
+
+uint8_t NumberFormat::formatFixedWidth(char *buf, int32_t value, uint8_t decimals, uint8_t width)
+{
+    char tmp[BUFFER_SIZE];
+    uint8_t length = formatFixed(tmp, value, decimals);
+
+    if (length > width)
+    {
+        memset(buf, '#', width);
+    }
+    else
+    {
+        uint8_t padding = width - length;
+        memset(buf, ' ', padding);
+        memcpy(buf + padding, tmp, length);
+    }
+    buf[width] = '\0';
+    return width;
+}
+
+int32_t NumberFormat::dropDecimals(int32_t value, uint8_t digits)
+{
+    if (digits == 0)
+    {
+        return value;
+    }
+    if (digits > 9)
+    {
+        digits = 9;
+    }
+    int32_t divisor = (int32_t)pgm_read_dword(&powersOfTen[9 - digits]);
+    int32_t half = divisor / 2;
+    return value < 0 ? (value - half) / divisor : (value + half) / divisor;
+}
+
+size_t NumberFormat::print(Print *out, int32_t value, uint8_t decimals)
+{
+    char buf[BUFFER_SIZE];
+    uint8_t length = formatFixed(buf, value, decimals);
+    return out->write((const uint8_t *)buf, length);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file numfmt.h
+ * @author Riccardo Iacob
+ * @brief Integer-only decimal formatting of scaled fixed-point values
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include <Arduino.h>
+
+/**
+ * Values are passed as scaled integers (e.g. 2345 centi-°C with 2 decimals is "23.45").
+ * Digits are produced by subtracting powers of ten from a PROGMEM table, without floating point,
+ * and nothing is allocated: the caller owns the buffer.
+ */
+class NumberFormat
+{
+public:
+    // Buffer size large enough for any int32_t with sign, decimal point and terminator
+    static const uint8_t BUFFER_SIZE = 13;
+
+    /**
+     * @brief Writes an unsigned integer
+     *
+     * @param buf: Output buffer, at least BUFFER_SIZE bytes
+     * @param value: The value
+     * @return uint8_t: The number of characters written, terminator excluded
+     */
+    static uint8_t formatUnsigned(char *buf, uint32_t value);
+
+    /**
+     * @brief Writes a scaled fixed-point value
+     *
+     * @param buf: Output buffer, at least BUFFER_SIZE bytes
+     * @param value: The scaled value
+     * @param decimals: Number of decimal digits in value (0 to 9)
+     * @return uint8_t: The number of characters written, terminator excluded
+     */
+    static uint8_t formatFixed(char *buf, int32_t value, uint8_t decimals);
+
+    /**
+     * @brief Writes a scaled fixed-point value right-aligned in a field padded with spaces
+     * If the value does not fit, the field is filled with '#'
+     *
+     * @param buf: Output buffer, at least width + 1 bytes
+     * @param value: The scaled value
+     * @param decimals: Number of decimal digits in value (0 to 9)
+     * @param width: The field width
+     * @return uint8_t: The number of characters written (width), terminator excluded
+     */
+    static uint8_t formatFixedWidth(char *buf, int32_t value, uint8_t decimals, uint8_t width);
+
+    /**
+     * @brief Drops decimal digits from a scaled value, rounding half away from zero
+     *
+     * @param value: The scaled value
+     * @param digits: Number of decimal digits to drop
+     * @return int32_t: The rescaled value
+     */
+    static int32_t dropDecimals(int32_t value, uint8_t digits);
+
+    /**
+     * @brief Writes a scaled fixed-point value on a Print (Serial, Serial1, displays)
+     *
+     * @param out: The output
+     * @param value: The scaled value
+     * @param decimals: Number of decimal digits in value (0 to 9)
+     * @return size_t: The number of characters printed
+     */
+    static size_t print(Print *out, int32_t value, uint8_t decimals);
+};
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * @file osctrl.cpp
+ * @author Riccardo Iacob
+ * @brief Adaptive oversampling and IIR filter selection for a target sample period
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "osctrl.h"
+
+// ADC cycles of each osrs setting (skip, x1, x2, x4, x8, x16)
+static const uint8_t oversamplingCycles[6] PROGMEM = {0, 1, 2, 4, 8, 16};
+#if FEATURE_GAS
+// Heater wait multiplication factors (x1, x4, x16, x64)
+static const uint8_t heaterFactors[4] PROGMEM = {1, 4, 16, 64};
+#endif
+// IIR coefficient of each FilterCoefficients setting
+static const uint8_t filterCoefficients[8] PROGMEM = {0, 1, 3, 7, 15, 31, 63, 127};
+// SampleRecord channel flag of each controller channel
+static const uint8_t channelFlags[OversamplingController::CHANNELS] PROGMEM = {channel_temperature, channel_pressure, channel_humidity};
+// Smallest step that counts as a transient: centi-°C, Pa, centi-% (small, the IIR filter spreads steps)
+static const uint8_t minimumSteps[OversamplingController::CHANNELS] PROGMEM = {3, 5, 10};
+
+// Conversion time in microseconds, from the Bosch reference driver
+static uint32_t conversionMicros(uint8_t cycles)
+{
+    // 1963 us per ADC cycle, TPH switching (4 x 477 us), gas measurement (5 x 477 us), wake up
+    return (uint32_t)cycles * 1963 + 477 * 4 + 477 * 5 + 500;
+}
+
+static uint16_t heaterMillis(const BME680::BMEConfig *cfg)
+{
+#if FEATURE_GAS
+    if (!cfg->run_gas)
+    {
+        return 0;
+    }
+    const BME680::BMESetPointConfig *point = &cfg->set_point_cfg[cfg->set_point];
+    return (uint16_t)((uint8_t)point->gas_wait & 0x3F) * pgm_read_byte(&heaterFactors[(uint8_t)point->gas_wait_multiplier & 0x03]);
+#else
+    (void)cfg;
+    return 0;
+#endif
+}
+
+// ADC cycles of a channel, none when it is compiled out (the driver writes osrs skip)
+static uint8_t channelCycles(uint8_t osrs, bool built)
+{
+    return built ? pgm_read_byte(&oversamplingCycles[osrs % 6]) : 0;
+}
+
+OversamplingController::OversamplingController(BME680 *bme)
+{
+    sensor = bme;
+    enabled = false;
+    transient = false;
+    holdCount = 0;
+    period = 0;
+    primed = 0;
+    for (uint8_t c = 0; c < CHANNELS; c++)
+    {
+        meanDifference[0][c] = 0;
+        meanDifference[1][c] = 0;
+    }
+}
+
+uint16_t OversamplingController::measurementMillis(const BME680::BMEConfig *cfg)
+{
+    uint8_t cycles = channelCycles((uint8_t)cfg->osrs_t, true) +
+                     channelCycles((uint8_t)cfg->osrs_p, FEATURE_PRESSURE) +
+                     channelCycles((uint8_t)cfg->osrs_h, FEATURE_HUMIDITY);
+    return (conversionMicros(cycles) + 999) / 1000 + heaterMillis(cfg);
+}
+
+bool OversamplingController::configure(uint16_t periodMillis, const uint8_t *priorities)
+{
+    uint16_t heater = heaterMillis(sensor->config);
+    bool found = false;
+    uint8_t bestScore = 0;
+    uint8_t bestCycles = 0;
+
+    // 125 combinations, evaluated once per configuration change
+    for (uint8_t t = BME680::osrs_x1; t <= BME680::orsrs_x16; t++)
+    {
+        for (uint8_t p = BME680::osrs_x1; p <= BME680::orsrs_x16; p++)
+        {
+            for (uint8_t h = BME680::osrs_x1; h <= BME680::orsrs_x16; h++)
+            {
+                uint8_t cycles = channelCycles(t, true) + channelCycles(p, FEATURE_PRESSURE) + channelCycles(h, FEATURE_HUMIDITY);
+                if ((conversionMicros(cycles) + 999) / 1000 + heater > periodMillis)
+                {
+                    continue;
+                }
+                uint8_t score = priorities[0] * t + priorities[1] * p + priorities[2] * h;
+                if (!found || score > bestScore || (score == bestScore && cycles < bestCycles))
+                {
+                    found = true;
+                    bestScore = score;
+                    bestCycles = cycles;
+                    quietOsrs[0] = (BME680::OversamplingMultipliers)t;
+                    quietOsrs[1] = (BME680::OversamplingMultipliers)p;
+                    quietOsrs[2] = (BME680::OversamplingMultipliers)h;
+                }
+            }
+        }
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+    // Strongest IIR filter whose time constant fits the response limit
+    quietFilter = BME680::filter_0;
+    for (uint8_t f = BME680::filter_1; f <= BME680::filter_127; f++)
+    {
+        if ((uint32_t)pgm_read_byte(&filterCoefficients[f]) * periodMillis <= MAX_RESPONSE_MS)
+        {
+            quietFilter = (BME680::FilterCoefficients)f;
+        }
+    }
+
+    uint8_t fastCycles = channelCycles(BME680::osrs_x2, true) + channelCycles(BME680::osrs_x2, FEATURE_PRESSURE) + channelCycles(BME680::osrs_x2, FEATURE_HUMIDITY);
+    fastPeriod = (conversionMicros(fastCycles) + 999) / 1000 + heater;
+    if (fastPeriod > periodMillis)
+    {
+        fastPeriod = periodMillis;
+    }
+    if (!enabled)
+    {
+        const BME680::BMEConfig *cfg = sensor->config;
+        savedOsrs[0] = cfg->osrs_t;
+        savedOsrs[1] = cfg->osrs_p;
+        savedOsrs[2] = cfg->osrs_h;
+        savedFilter = cfg->filter;
+    }
+    period = periodMillis;
+    enabled = true;
+    transient = false;
+    holdCount = 0;
+    primed = 0;
+    apply();
+    return true;
+}
+
+void OversamplingController::apply()
+{
+    BME680::BMEConfig *cfg = sensor->config;
+    if (transient)
+    {
+        cfg->osrs_t = BME680::osrs_x2;
+        cfg->osrs_p = BME680::osrs_x2;
+        cfg->osrs_h = BME680::osrs_x2;
+        cfg->filter = BME680::filter_0;
+    }
+    else
+    {
+        cfg->osrs_t = quietOsrs[0];
+        cfg->osrs_p = quietOsrs[1];
+        cfg->osrs_h = quietOsrs[2];
+        cfg->filter = quietFilter;
+    }
+    // osrs_t and osrs_p take effect with the next startConversion()
+    sensor->applyConfig();
+}
+
+void OversamplingController::disable()
+{
+    if (!enabled)
+    {
+        return;
+    }
+    enabled = false;
+    transient = false;
+    BME680::BMEConfig *cfg = sensor->config;
+    cfg->osrs_t = savedOsrs[0];
+    cfg->osrs_p = savedOsrs[1];
+    cfg->osrs_h = savedOsrs[2];
+    cfg->filter = savedFilter;
+    sensor->applyConfig();
+}
+
+bool OversamplingController::isEnabled()
+{
+    return enabled;
+}
+
+bool OversamplingController::isTransient()
+{
+    return transient;
+}
+
+void OversamplingController::observe(const SampleRecord *sample)
+{
+    int32_t values[CHANNELS] = {sample->temperature, (int32_t)sample->pressure, sample->humidity};
+    bool step = false;
+    // The fast configuration is noisier, so each configuration has its own estimate
+    uint32_t *mean = meanDifference[transient ? 1 : 0];
+
+    for (uint8_t c = 0; c < CHANNELS; c++)
+    {
+        // Channels not measured in this conversion (multi-rate acquisition) keep their state
+        if (!(sample->channels & pgm_read_byte(&channelFlags[c])))
+        {
+            continue;
+        }
+        if (primed & (1 << c))
+        {
+            int32_t difference = values[c] - previous[c];
+            uint32_t magnitude = difference < 0 ? -difference : difference;
+
+            // Steps are compared against the noise before it is updated
+            uint8_t minimum = pgm_read_byte(&minimumSteps[c]);
+            if ((magnitude << NOISE_FRACTION_BITS) > TRANSIENT_FACTOR * mean[c] && magnitude >= minimum)
+            {
+                step = true;
+            }
+
+            // Clipped, so that steps barely move the estimate but it can still grow from zero
+            uint32_t limit = ((TRANSIENT_FACTOR * mean[c]) >> NOISE_FRACTION_BITS) + minimum;
+            if (magnitude > limit)
+            {
+                magnitude = limit;
+            }
+            mean[c] += (int32_t)((magnitude << NOISE_FRACTION_BITS) - mean[c]) >> NOISE_SHIFT;
+        }
+        previous[c] = values[c];
+        primed |= 1 << c;
+    }
+
+    if (!enabled)
+    {
+        return;
+    }
+    if (step)
+    {
+        holdCount = HOLD_SAMPLES;
+        if (!transient)
+        {
+            transient = true;
+            apply();
+        }
+    }
+    else if (transient && --holdCount == 0)
+    {
+        transient = false;
+        apply();
+    }
+}
+
+uint16_t OversamplingController::getPeriodMillis()
+{
+    if (!enabled)
+    {
+        return 0;
+    }
+    return transient ? fastPeriod : period;
+}
+
+uint16_t OversamplingController::getNoise(uint8_t channel)
+{
+    if (channel >= CHANNELS)
+    {
+        return 0;
+    }
+    // E|x[n] - x[n-1]| = 2 sigma / sqrt(pi) for white noise, so sigma = sqrt(pi) / 2 * mean ~ 0.886 * mean;
+    // 16 * 0.886 = 227 / 16, from a mean in 1/4096 units
+    uint32_t mean = meanDifference[transient ? 1 : 0][channel];
+    if (mean >= (1UL << 28))
+    {
+        return 0xFFFF;
+    }
+    uint32_t noise = ((mean >> 4) * 227 + 2048) >> 12;
+    return noise > 0xFFFF ? 0xFFFF : (uint16_t)noise;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file osctrl.h
+ * @author Riccardo Iacob
+ * @brief Adaptive oversampling and IIR filter selection for a target sample period
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef OSCTRL_H
+#define OSCTRL_H
+
+#include <Arduino.h>
+
+#include "bme680.h"
+#include "sample.h"
+
+/**
+ * Quiet configuration: among all x1..x16 combinations of osrs_t, osrs_p and osrs_h whose
+ * conversion time fits the sample period, the one maximizing sum(priority * osrs) is chosen
+ * (every osrs step doubles the oversampling, i.e. divides the noise by sqrt(2)); ties go to the
+ * shortest conversion. The IIR filter is the strongest whose time constant (coefficient * period)
+ * stays within MAX_RESPONSE_MS.
+ *
+ * Noise is measured on the readings as the running mean of |x[n] - x[n-1]|, the sample-to-sample
+ * variation actually seen after the IIR filter (for white noise sigma = sqrt(pi) / 2 * mean).
+ * The quiet and fast configurations keep separate estimates.
+ * A step larger than TRANSIENT_FACTOR times that mean (and the channel's minimum step) switches to
+ * the fast configuration: x2 on all channels, no IIR filter, sampling as fast as the conversion
+ * allows. After HOLD_SAMPLES samples without a step the quiet configuration comes back.
+ *
+ * Channel indices: 0 temperature, 1 pressure, 2 humidity (the order of the osrs fields).
+ */
+class OversamplingController
+{
+public:
+    static const uint8_t CHANNELS = 3;
+    // Highest priority accepted per channel
+    static const uint8_t MAX_PRIORITY = 3;
+    // Longest IIR time constant accepted in the quiet configuration
+    static const uint16_t MAX_RESPONSE_MS = 10000;
+    // Step size, in mean sample-to-sample differences, that counts as a transient (~4 sigma)
+    static const uint8_t TRANSIENT_FACTOR = 5;
+    // Stable samples needed to leave the fast configuration
+    static const uint8_t HOLD_SAMPLES = 10;
+    // Noise averaging: weight of a new value is 1 / (1 << NOISE_SHIFT)
+    static const uint8_t NOISE_SHIFT = 4;
+    // Fraction bits of the running mean; enough that the truncation of its updates, up to
+    // (1 << NOISE_SHIFT) LSB, stays far below the noise of a quiet channel (a fraction of a unit)
+    static const uint8_t NOISE_FRACTION_BITS = 12;
+
+private:
+    BME680 *sensor;
+    bool enabled;
+    bool transient;
+    uint8_t holdCount;
+    uint16_t period;
+
+    // Quiet configuration
+    BME680::OversamplingMultipliers quietOsrs[CHANNELS];
+    BME680::FilterCoefficients quietFilter;
+    // Conversion time of the fast configuration
+    uint16_t fastPeriod;
+    // Sensor configuration from before the controller was enabled, restored by disable()
+    BME680::OversamplingMultipliers savedOsrs[CHANNELS];
+    BME680::FilterCoefficients savedFilter;
+
+    // Noise estimator, mean |difference| in 1 / (1 << NOISE_FRACTION_BITS) units, of the quiet and
+    // fast configurations
+    int32_t previous[CHANNELS];
+    // Channels holding a previous value (bit c for channel c)
+    uint8_t primed;
+    uint32_t meanDifference[2][CHANNELS];
+
+    void apply();
+
+public:
+    /**
+     * @brief Constructs a new OversamplingController object, initially disabled
+     *
+     * @param bme: The sensor whose configuration is tuned
+     */
+    OversamplingController(BME680 *bme);
+
+    /**
+     * @brief Chooses the quiet configuration and enables the controller. The oversampling and IIR
+     * settings in use are saved when the controller goes from disabled to enabled
+     *
+     * @param periodMillis: The target sample period
+     * @param priorities: Noise priority (0 to MAX_PRIORITY) of temperature, pressure and humidity
+     * @return bool: False if not even x1 on every channel fits the period (nothing is changed then)
+     */
+    bool configure(uint16_t periodMillis, const uint8_t *priorities);
+
+    /**
+     * @brief Disables the controller and restores the oversampling and IIR settings saved by configure()
+     */
+    void disable();
+
+    /**
+     * @brief Checks whether the controller is enabled
+     */
+    bool isEnabled();
+
+    /**
+     * @brief Checks whether the fast configuration is in use
+     */
+    bool isTransient();
+
+    /**
+     * @brief Updates the noise estimate with a raw sample and re-tunes the sensor if needed
+     *
+     * @param sample: The sample, before any software filtering; only its fresh channels are used
+     */
+    void observe(const SampleRecord *sample);
+
+    /**
+     * @brief Gets the period at which conversions should be started
+     *
+     * @return uint16_t: The period in milliseconds, 0 if disabled (convert continuously)
+     */
+    uint16_t getPeriodMillis();
+
+    /**
+     * @brief Gets the measured noise of a channel in the configuration in use
+     *
+     * @param channel: The channel index
+     * @return uint16_t: The noise standard deviation, in 1/16 SampleRecord units (a quiet channel is
+     * often below one unit)
+     */
+    uint16_t getNoise(uint8_t channel);
+
+    /**
+     * @brief Computes the duration of a forced-mode conversion, heater time included
+     *
+     * @param cfg: The sensor configuration
+     * @return uint16_t: The duration in milliseconds, rounded up
+     */
+    static uint16_t measurementMillis(const BME680::BMEConfig *cfg);
+};
+
+#endif
@@ -0,0 +1,281 @@
+/**
+ * @file power.cpp
+ * @author Riccardo Iacob
+ * @brief Duty-cycled sleep between samples, with duty cycle and charge accounting
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+#include "power.h"
+#include "leds.h"
+
+// Millisecond counter of the Arduino core (wiring.c), advanced while timer 0 is stopped
+extern volatile unsigned long timer0_millis;
+
+// Watchdog step used to measure the watchdog oscillator (64 ms)
+#define CALIBRATION_STEP 2
+
+volatile bool PowerManager::uartWake = false;
+volatile bool PowerManager::wdtWake = false;
+
+// Starts the watchdog in interrupt mode (no reset) with a period of 16 ms << step, interrupts disabled
+static void startWatchdog(uint8_t step)
+{
+    uint8_t prescaler = (step & 0x07) | ((step & 0x08) ? _BV(WDP3) : 0);
+    wdt_reset();
+    // Timed sequence: the prescaler can only be changed within 4 cycles of setting WDCE
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | prescaler;
+}
+
+// Adds a time in us to a ms counter, keeping the sub-ms remainder
+static void accumulate(uint32_t &ms, uint16_t &us, uint32_t elapsed)
+{
+    uint32_t total = us + elapsed;
+    ms += total / 1000;
+    us = total % 1000;
+}
+
+PowerManager::PowerManager()
+{
+    enabled = false;
+    displayMode = display_bright;
+    holding = false;
+    lastActivity = 0;
+    wdtBaseMicros = (uint16_t)WDT_BASE_MS * 1000;
+    startMillis = 0;
+    idleMillis = 0;
+    idleMicros = 0;
+    powerDownMillis = 0;
+    powerDownMicros = 0;
+    samples = 0;
+}
+
+void PowerManager::calibrate()
+{
+    // One watchdog period timed by timer 0, waiting in idle sleep
+    wdtWake = false;
+    noInterrupts();
+    startWatchdog(CALIBRATION_STEP);
+    interrupts();
+    uint32_t start = micros();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (!wdtWake)
+    {
+        sleep_enable();
+        sleep_cpu();
+        sleep_disable();
+    }
+    uint32_t elapsed = micros() - start;
+    wdt_disable();
+    wdtBaseMicros = elapsed >> CALIBRATION_STEP;
+}
+
+void PowerManager::enable(uint8_t display)
+{
+    calibrate();
+    displayMode = display;
+    holding = false;
+    startMillis = millis();
+    idleMillis = 0;
+    idleMicros = 0;
+    powerDownMillis = 0;
+    powerDownMicros = 0;
+    samples = 0;
+    enabled = true;
+}
+
+void PowerManager::disable()
+{
+    enabled = false;
+}
+
+bool PowerManager::isEnabled()
+{
+    return enabled;
+}
+
+uint8_t PowerManager::getDisplayMode()
+{
+    return displayMode;
+}
+
+void PowerManager::noteActivity()
+{
+    holding = true;
+    lastActivity = millis();
+}
+
+void PowerManager::noteSample()
+{
+    samples++;
+}
+
+PowerManager::SleepPlan PowerManager::plan(uint32_t now, uint32_t wakeAt, bool busy)
+{
+    SleepPlan sleepPlan = {sleep_none, 0, 0};
+    int32_t window = (int32_t)(wakeAt - now);
+    if (!enabled || window <= 0)
+    {
+        return sleepPlan;
+    }
+
+    sleepPlan.mode = sleep_idle;
+    sleepPlan.millis = window > 0xFFFF ? 0xFFFF : (uint16_t)window;
+    if (holding && now - lastActivity >= ACTIVITY_HOLD_MS)
+    {
+        holding = false;
+    }
+    if (busy || holding || window < WDT_BASE_MS + WAKE_MARGIN_MS)
+    {
+        return sleepPlan;
+    }
+
+    // The longest watchdog period that ends before the deadline
+    uint32_t available = window - WAKE_MARGIN_MS;
+    uint8_t step = 0;
+    while (step < WDT_MAX_STEP && ((uint32_t)WDT_BASE_MS << (step + 1)) <= available)
+    {
+        step++;
+    }
+    sleepPlan.mode = sleep_power_down;
+    sleepPlan.millis = (uint16_t)WDT_BASE_MS << step;
+    sleepPlan.step = step;
+    return sleepPlan;
+}
+
+void PowerManager::sleep(uint32_t wakeAt, bool busy)
+{
+    SleepPlan sleepPlan = plan(millis(), wakeAt, busy);
+    if (sleepPlan.mode == sleep_idle)
+    {
+        uint32_t start = micros();
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_enable();
+        sleep_cpu();
+        sleep_disable();
+        accumulate(idleMillis, idleMicros, micros() - start);
+    }
+    else if (sleepPlan.mode == sleep_power_down)
+    {
+        powerDown(sleepPlan.step);
+    }
+}
+
+void PowerManager::powerDown(uint8_t step)
+{
+    // The buffers are empty (not busy), only the last characters may still be shifting out
+    Serial.flush();
+    Serial1.flush();
+    // Timer 3 stops too: LEDs off rather than frozen mid-pattern; ADC off
+    StatusLeds::suspend();
+    uint8_t adc = ADCSRA;
+    ADCSRA = 0;
+
+    noInterrupts();
+    uartWake = false;
+    wdtWake = false;
+    // Start bits: RX0 is PE0 (PCINT8), RX1 is PD2 (INT2, falling edge, sensed without a clock)
+    PCIFR = _BV(PCIF1);
+    PCMSK1 |= _BV(PCINT8);
+    PCICR |= _BV(PCIE1);
+    EICRA = (EICRA & ~_BV(ISC20)) | _BV(ISC21);
+    EIFR = _BV(INTF2);
+    EIMSK |= _BV(INT2);
+    startWatchdog(step);
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    // The instruction after sei always runs, so no interrupt can slip in before the sleep
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+
+    wdt_disable();
+    noInterrupts();
+    EIMSK &= ~_BV(INT2);
+    PCICR &= ~_BV(PCIE1);
+    PCMSK1 &= ~_BV(PCINT8);
+    if (wdtWake)
+    {
+        uint32_t elapsed = ((uint32_t)wdtBaseMicros << step) + powerDownMicros;
+        timer0_millis += elapsed / 1000;
+        powerDownMillis += elapsed / 1000;
+        powerDownMicros = elapsed % 1000;
+    }
+    interrupts();
+
+    ADCSRA = adc;
+    StatusLeds::resume();
+    if (uartWake)
+    {
+        noteActivity();
+    }
+}
+
+uint16_t PowerManager::getDutyCycle()
+{
+    uint32_t total = millis() - startMillis;
+    uint32_t asleep = idleMillis + powerDownMillis;
+    if (total == 0)
+    {
+        return 1000;
+    }
+    if (asleep >= total)
+    {
+        return 0;
+    }
+    return (uint16_t)((uint64_t)(total - asleep) * 1000 / total);
+}
+
+uint32_t PowerManager::getChargePerSample()
+{
+    if (samples == 0)
+    {
+        return 0;
+    }
+    uint32_t total = millis() - startMillis;
+    uint32_t asleep = idleMillis + powerDownMillis;
+    uint32_t awake = total > asleep ? total - asleep : 0;
+    // uA * ms = nC
+    uint64_t charge = (uint64_t)awake * POWER_ACTIVE_UA + (uint64_t)idleMillis * POWER_IDLE_UA + (uint64_t)powerDownMillis * POWER_DOWN_UA;
+    return (uint32_t)(charge / 1000 / samples);
+}
+
+uint32_t PowerManager::getIdleMillis()
+{
+    return idleMillis;
+}
+
+uint32_t PowerManager::getPowerDownMillis()
+{
+    return powerDownMillis;
+}
+
+void PowerManager::onUartWake()
+{
+    uartWake = true;
+}
+
+void PowerManager::onWatchdog()
+{
+    wdtWake = true;
+}
+
+ISR(WDT_vect)
+{
+    PowerManager::onWatchdog();
+}
+
+ISR(PCINT1_vect)
+{
+    PowerManager::onUartWake();
+}
+
+ISR(INT2_vect)
+{
+    PowerManager::onUartWake();
+}
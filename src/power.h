@@ -0,0 +1,188 @@
+/**
+ * @file power.h
+ * @author Riccardo Iacob
+ * @brief Duty-cycled sleep between samples, with duty cycle and charge accounting
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+#include "hardware.h"
+
+/**
+ * The main loop tells sleep() when it next has work to do (the end of the running conversion,
+ * the next conversion, the next device check) and whether anything is still in flight; plan()
+ * turns that into a sleep, without touching the hardware, so the policy can be run on any clock:
+ *   - nothing to wait for, or the deadline already passed: no sleep
+ *   - output or input pending, UART activity in the last ACTIVITY_HOLD_MS, or a window shorter
+ *     than the shortest watchdog period: idle sleep. The CPU stops, the UARTs and timers keep
+ *     running and the next interrupt (at the latest the 1 ms timer 0 tick) wakes it
+ *   - otherwise power-down for the longest watchdog period (16 ms << step) that ends
+ *     WAKE_MARGIN_MS before the deadline. Only the watchdog, a start bit on RX0 (PCINT8) or
+ *     RX1 (INT2) wake the CPU; the character carrying the start bit is lost, the hold after
+ *     it keeps the rest of a command line
+ *
+ * Timer 0 stops in power-down, so millis() is advanced by the watchdog period, measured against
+ * timer 0 when the mode is enabled (the watchdog oscillator is only accurate to about 10%).
+ * After a UART wake the time spent asleep is unknown and not added.
+ *
+ * The charge estimate weighs the time spent awake, in idle and in power-down with the board
+ * currents in hardware.h.
+ */
+class PowerManager
+{
+public:
+    /**
+     * @brief Sleep states, from lightest to deepest
+     */
+    enum SleepModes
+    {
+        sleep_none,
+        sleep_idle,
+        sleep_power_down
+    };
+
+    /**
+     * @brief What happens to the display while the mode is on
+     */
+    enum DisplayModes
+    {
+        display_bright,
+        display_dim,
+        display_blank
+    };
+
+    /**
+     * @brief A sleep decided by plan()
+     */
+    typedef struct
+    {
+        uint8_t mode;
+        // Planned length, in ms (an upper bound for idle sleep)
+        uint16_t millis;
+        // Watchdog period of a power-down, 16 ms << step
+        uint8_t step;
+    } SleepPlan;
+
+    // Shortest watchdog period, in ms, and the largest step (16 ms << 9 = 8 s)
+    static const uint8_t WDT_BASE_MS = 16;
+    static const uint8_t WDT_MAX_STEP = 9;
+    // Oscillator start-up and peripheral restore, kept free before a deadline
+    static const uint8_t WAKE_MARGIN_MS = 2;
+    // Power-down is not used for this long after UART activity
+    static const uint16_t ACTIVITY_HOLD_MS = 10000;
+
+private:
+    bool enabled;
+    uint8_t displayMode;
+    bool holding;
+    uint32_t lastActivity;
+    // Measured length of the shortest watchdog period, in us
+    uint16_t wdtBaseMicros;
+
+    // Accounting since the mode was enabled
+    uint32_t startMillis;
+    uint32_t idleMillis;
+    uint16_t idleMicros;
+    uint32_t powerDownMillis;
+    uint16_t powerDownMicros;
+    uint32_t samples;
+
+    static volatile bool uartWake;
+    static volatile bool wdtWake;
+
+    void powerDown(uint8_t step);
+    void calibrate();
+
+public:
+    PowerManager();
+
+    /**
+     * @brief Turns the mode on, measuring the watchdog period first (takes about 64 ms)
+     *
+     * @param display: What to do with the display (DisplayModes)
+     */
+    void enable(uint8_t display);
+
+    /**
+     * @brief Turns the mode off, the loop runs without sleeping again
+     */
+    void disable();
+
+    /**
+     * @brief Checks whether the mode is on
+     */
+    bool isEnabled();
+
+    /**
+     * @brief Gets the display mode set by enable()
+     */
+    uint8_t getDisplayMode();
+
+    /**
+     * @brief Records UART input, holding off power-down for ACTIVITY_HOLD_MS
+     */
+    void noteActivity();
+
+    /**
+     * @brief Counts a completed sample for the charge estimate
+     */
+    void noteSample();
+
+    /**
+     * @brief Decides how to wait for the next deadline
+     *
+     * @param now: The current time, in ms
+     * @param wakeAt: The time of the next scheduled work, in ms
+     * @param busy: True if output, input or a transfer is still in flight
+     * @return SleepPlan: The sleep to take, sleep_none when disabled
+     */
+    SleepPlan plan(uint32_t now, uint32_t wakeAt, bool busy);
+
+    /**
+     * @brief Sleeps according to plan(), restores the peripherals and accounts the time
+     *
+     * @param wakeAt: The time of the next scheduled work, in ms
+     * @param busy: True if output, input or a transfer is still in flight
+     */
+    void sleep(uint32_t wakeAt, bool busy);
+
+    /**
+     * @brief Gets the share of time spent awake since enable(), in thousandths
+     */
+    uint16_t getDutyCycle();
+
+    /**
+     * @brief Gets the estimated charge drawn per sample since enable()
+     *
+     * @return uint32_t: The charge, in uC (0 before the first sample)
+     */
+    uint32_t getChargePerSample();
+
+    /**
+     * @brief Gets the time spent in idle sleep since enable(), in ms
+     */
+    uint32_t getIdleMillis();
+
+    /**
+     * @brief Gets the time spent in power-down since enable(), in ms
+     */
+    uint32_t getPowerDownMillis();
+
+    /**
+     * @brief Records a wake-up by a start bit, called by the pin interrupts
+     */
+    static void onUartWake();
+
+    /**
+     * @brief Records a watchdog wake-up, called by the watchdog interrupt
+     */
+    static void onWatchdog();
+};
+
+#endif
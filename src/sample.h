@@ -0,0 +1,52 @@
+/**
+ * @file sample.h
+ * @author Riccardo Iacob
+ * @brief Scaled fixed-point sample record shared by logging, telemetry and display
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+// Only depends on <stdint.h> so that it also builds on the host
+#include <stdint.h>
+
+/**
+ * @brief Channel flags of SampleRecord::channels
+ */
+enum SampleChannels
+{
+    channel_temperature = 0x01,
+    channel_humidity = 0x02,
+    channel_pressure = 0x04,
+    channel_gas = 0x08,
+    channel_all = 0x0F
+};
+
+/**
+ * @brief A compensated sample, in scaled integer units
+ */
+typedef struct
+{
+    // Timestamp in seconds
+    uint32_t timestamp;
+
+    // Temperature in hundredths of °C
+    int16_t temperature;
+
+    // Relative humidity in hundredths of %
+    uint16_t humidity;
+
+    // Pressure in Pa
+    uint32_t pressure;
+
+    // Gas resistance in Ohm
+    uint32_t gasResistance;
+
+    // Channels holding a fresh value (SampleChannels flags)
+    uint8_t channels;
+} SampleRecord;
+
+#endif
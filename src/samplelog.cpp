@@ -0,0 +1,247 @@
+/**
+ * @file samplelog.cpp
+ * @author Riccardo Iacob
+ * @brief Compressed sample history in the AT24C32 I2C EEPROM
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "samplelog.h"
+
+SampleLog::SampleLog(uint8_t i2cAddress, uint16_t periodSeconds)
+{
+    i2cAdd = i2cAddress;
+    period = periodSeconds;
+    currentBlock = 0;
+    sequence = 0;
+    validBlocks = 0;
+    used = HEADER_SIZE;
+    records = 0;
+    flushedChunks = 0;
+    writeHead = 0;
+    writeCount = 0;
+    writing = false;
+    writeMillis = 0;
+    failedWrites = 0;
+}
+
+bool SampleLog::begin()
+{
+    uint8_t header[HEADER_SIZE];
+    bool found = false;
+    uint16_t newestSequence = 0;
+    uint8_t newestBlock = 0;
+
+    validBlocks = 0;
+    for (uint8_t i = 0; i < BLOCK_COUNT; i++)
+    {
+        if (readBytes((uint16_t)i * BLOCK_SIZE, header, HEADER_SIZE) != HEADER_SIZE)
+        {
+            return false;
+        }
+        uint16_t seq = (uint16_t)header[0] | ((uint16_t)header[1] << 8);
+        if (header[2] <= HEADER_SIZE || header[2] > BLOCK_SIZE || header[3] == 0)
+        {
+            continue;
+        }
+        validBlocks++;
+        if (!found || (int16_t)(seq - newestSequence) > 0)
+        {
+            found = true;
+            newestSequence = seq;
+            newestBlock = i;
+        }
+    }
+
+    // Continue after the newest block; its successor is the oldest one and gets overwritten
+    currentBlock = found ? (newestBlock + 1) % BLOCK_COUNT : 0;
+    sequence = found ? newestSequence + 1 : 0;
+    if (validBlocks > BLOCK_COUNT - 1)
+    {
+        validBlocks = BLOCK_COUNT - 1;
+    }
+    startBlock();
+    return true;
+}
+
+void SampleLog::startBlock()
+{
+    memset(block, 0xFF, BLOCK_SIZE);
+    used = HEADER_SIZE;
+    records = 0;
+    flushedChunks = 0;
+
+    // Invalidate the old header first, as its data is about to be overwritten chunk by chunk
+    uint8_t header[HEADER_SIZE] = {(uint8_t)sequence, (uint8_t)(sequence >> 8), 0, 0};
+    queueWrite((uint16_t)currentBlock * BLOCK_SIZE, header, HEADER_SIZE);
+}
+
+bool SampleLog::queueWrite(uint16_t address, const uint8_t *data, uint8_t length)
+{
+    if (writeCount >= WRITE_QUEUE_LENGTH)
+    {
+        failedWrites++;
+        return false;
+    }
+    PendingWrite *write = &writeQueue[(writeHead + writeCount) % WRITE_QUEUE_LENGTH];
+    write->address = address;
+    write->length = length;
+    memcpy(write->data, data, length);
+    writeCount++;
+    return true;
+}
+
+bool SampleLog::isCycleOver()
+{
+    // Acknowledge polling: the EEPROM does not answer while an internal write cycle is running
+    if (writing && (millis() - writeMillis >= WRITE_TIMEOUT_MS || I2CBus::probe(i2cAdd)))
+    {
+        writing = false;
+    }
+    return !writing;
+}
+
+void SampleLog::poll()
+{
+    if (writeCount == 0 || !isCycleOver())
+    {
+        return;
+    }
+
+    PendingWrite *write = &writeQueue[writeHead];
+    uint8_t address[2] = {(uint8_t)(write->address >> 8), (uint8_t)write->address};
+    if (I2CBus::write(i2cAdd, address, sizeof(address), write->data, write->length) != I2CBus::Errors::error_none)
+    {
+        failedWrites++;
+    }
+    writeHead = (writeHead + 1) % WRITE_QUEUE_LENGTH;
+    writeCount--;
+    writing = true;
+    writeMillis = millis();
+}
+
+bool SampleLog::isIdle()
+{
+    return writeCount == 0;
+}
+
+bool SampleLog::flush()
+{
+    if (records == 0)
+    {
+        return true;
+    }
+
+    uint16_t base = (uint16_t)currentBlock * BLOCK_SIZE;
+    bool ok = true;
+
+    // Data chunks (the last one possibly partial, it will be rewritten when complete)
+    uint8_t lastChunk = (used - 1) / CHUNK_SIZE;
+    for (uint8_t c = flushedChunks + 1; c <= lastChunk; c++)
+    {
+        ok &= queueWrite(base + (uint16_t)c * CHUNK_SIZE, block + c * CHUNK_SIZE, CHUNK_SIZE);
+    }
+
+    // Header chunk last
+    block[0] = (uint8_t)sequence;
+    block[1] = (uint8_t)(sequence >> 8);
+    block[2] = used;
+    block[3] = records;
+    ok &= queueWrite(base, block, CHUNK_SIZE);
+    return ok;
+}
+
+bool SampleLog::append(const SampleRecord *sample)
+{
+    uint8_t record[SeriesEncoder::MAX_KEYFRAME_SIZE];
+    uint8_t length;
+    bool ok = true;
+
+    if (records == 0)
+    {
+        length = encoder.encodeKeyframe(sample, period, record);
+    }
+    else
+    {
+        length = encoder.encodeDelta(sample, record);
+        if (used + length > BLOCK_SIZE)
+        {
+            // Block full: close it and start the next one with a keyframe
+            ok = flush();
+            if (validBlocks < BLOCK_COUNT - 1)
+            {
+                validBlocks++;
+            }
+            currentBlock = (currentBlock + 1) % BLOCK_COUNT;
+            sequence++;
+            startBlock();
+            length = encoder.encodeKeyframe(sample, period, record);
+        }
+    }
+
+    memcpy(block + used, record, length);
+    used += length;
+    records++;
+
+    // Write data chunks as soon as they are complete, chunk 0 (header) is written by flush()
+    while ((uint16_t)(flushedChunks + 2) * CHUNK_SIZE <= used)
+    {
+        flushedChunks++;
+        ok &= queueWrite((uint16_t)currentBlock * BLOCK_SIZE + (uint16_t)flushedChunks * CHUNK_SIZE, block + flushedChunks * CHUNK_SIZE, CHUNK_SIZE);
+    }
+    return ok;
+}
+
+uint8_t SampleLog::readBytes(uint16_t address, uint8_t *buf, uint8_t length)
+{
+    // Queued chunks would be missing from what is read, and a busy EEPROM does not answer
+    if (writeCount != 0 || !isCycleOver())
+    {
+        return 0;
+    }
+    uint8_t prefix[2] = {(uint8_t)(address >> 8), (uint8_t)address};
+    return I2CBus::read(i2cAdd, prefix, sizeof(prefix), buf, length);
+}
+
+uint8_t SampleLog::getOldestBlock()
+{
+    return (currentBlock + BLOCK_COUNT - validBlocks) % BLOCK_COUNT;
+}
+
+uint16_t SampleLog::getSequence()
+{
+    return sequence;
+}
+
+uint16_t SampleLog::getOldestSequence()
+{
+    return sequence - validBlocks;
+}
+
+uint8_t SampleLog::getBlockIndex(uint16_t blockSequence)
+{
+    // Blocks are consecutive in the ring, so the distance in sequence numbers is the distance in blocks
+    uint16_t back = (uint16_t)(sequence - blockSequence) % BLOCK_COUNT;
+    return (currentBlock + BLOCK_COUNT - back) % BLOCK_COUNT;
+}
+
+uint8_t SampleLog::getBlockCount()
+{
+    return validBlocks;
+}
+
+uint8_t SampleLog::getCurrentBlock()
+{
+    return currentBlock;
+}
+
+uint8_t SampleLog::getPendingRecords()
+{
+    return records;
+}
+
+uint16_t SampleLog::getFailedWrites()
+{
+    return failedWrites;
+}
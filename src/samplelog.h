@@ -0,0 +1,182 @@
+/**
+ * @file samplelog.h
+ * @author Riccardo Iacob
+ * @brief Compressed sample history in the AT24C32 I2C EEPROM
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef SAMPLELOG_H
+#define SAMPLELOG_H
+
+#include <Arduino.h>
+
+#include "sample.h"
+#include "tscodec.h"
+#include "i2cbus.h"
+
+/**
+ * The EEPROM is split in BLOCK_COUNT blocks of BLOCK_SIZE bytes used as a ring.
+ * Each block decodes on its own:
+ *   [0..1]  sequence   uint16, little endian, incremented for every block
+ *   [2]     used       bytes used in the block, header included
+ *   [3]     records    number of records in the block
+ *   [4..]   a keyframe followed by delta records (see tscodec.h)
+ * The block being filled lives in RAM. Its data is written in CHUNK_SIZE pieces as they fill up;
+ * the chunk holding the header goes last, so an interrupted block is never mistaken for a valid one.
+ *
+ * Writes never wait for the EEPROM: append() and flush() queue the chunks, and poll() sends the
+ * oldest one once the internal write cycle of the previous one is over (acknowledge polling, one
+ * probe per call). Reads are refused until the queue is empty and the last cycle is over.
+ */
+class SampleLog
+{
+public:
+    // AT24C32 size and page size
+    static const uint16_t CAPACITY = 4096;
+    static const uint8_t PAGE_SIZE = 32;
+    // Write granularity, a divisor of PAGE_SIZE that fits the Wire buffer together with the address
+    static const uint8_t CHUNK_SIZE = 16;
+    static const uint8_t BLOCK_SIZE = 128;
+    static const uint8_t BLOCK_COUNT = CAPACITY / BLOCK_SIZE;
+    static const uint8_t HEADER_SIZE = 4;
+    // Longest internal write cycle; a device still busy after it is written to anyway (and fails)
+    static const uint8_t WRITE_TIMEOUT_MS = 10;
+    // Chunk writes waiting for the EEPROM; closing a block queues at most 4
+    static const uint8_t WRITE_QUEUE_LENGTH = 4;
+
+private:
+    /**
+     * @brief A queued write, at most one chunk
+     */
+    typedef struct
+    {
+        uint16_t address;
+        uint8_t length;
+        uint8_t data[CHUNK_SIZE];
+    } PendingWrite;
+
+    uint8_t i2cAdd;
+    uint16_t period;
+    SeriesEncoder encoder;
+
+    uint8_t block[BLOCK_SIZE];
+    uint8_t used;
+    uint8_t records;
+    // Number of chunks of the current block already written, chunk 0 excluded
+    uint8_t flushedChunks;
+    uint8_t currentBlock;
+    uint16_t sequence;
+    // Number of blocks holding valid data
+    uint8_t validBlocks;
+
+    PendingWrite writeQueue[WRITE_QUEUE_LENGTH];
+    uint8_t writeHead;
+    uint8_t writeCount;
+    // An internal write cycle may be running since writeMillis
+    bool writing;
+    unsigned long writeMillis;
+    uint16_t failedWrites;
+
+    void startBlock();
+    bool queueWrite(uint16_t address, const uint8_t *data, uint8_t length);
+    bool isCycleOver();
+
+public:
+    /**
+     * @brief Constructs a new SampleLog object
+     *
+     * @param i2cAddress: The I2C address of the EEPROM
+     * @param periodSeconds: The cadence at which samples are appended
+     */
+    SampleLog(uint8_t i2cAddress, uint16_t periodSeconds);
+
+    /**
+     * @brief Scans the block headers and continues after the newest valid block
+     *
+     * @return bool: True if the EEPROM answered
+     */
+    bool begin();
+
+    /**
+     * @brief Appends a sample; it must follow the previous one by exactly one period
+     *
+     * @param sample: The sample
+     * @return bool: True on success
+     */
+    bool append(const SampleRecord *sample);
+
+    /**
+     * @brief Queues the partially filled block, so that it can be read back (e.g. before an export)
+     *
+     * @return bool: True on success
+     */
+    bool flush();
+
+    /**
+     * @brief Sends the oldest queued chunk if the EEPROM is ready, called from the main loop
+     */
+    void poll();
+
+    /**
+     * @brief Checks whether all queued chunks are written
+     */
+    bool isIdle();
+
+    /**
+     * @brief Reads raw bytes from the EEPROM
+     *
+     * @param address: The EEPROM address
+     * @param buf: Output buffer
+     * @param length: Number of bytes, at most 32 (Wire buffer size)
+     * @return uint8_t: The number of bytes read, 0 while writes are pending (try again after poll())
+     */
+    uint8_t readBytes(uint16_t address, uint8_t *buf, uint8_t length);
+
+    /**
+     * @brief Gets the index of the oldest valid block in the ring
+     */
+    uint8_t getOldestBlock();
+
+    /**
+     * @brief Gets the sequence number of the block being filled
+     * Block sequence numbers only ever increase (modulo 2^16), whatever the ring position
+     */
+    uint16_t getSequence();
+
+    /**
+     * @brief Gets the sequence number of the oldest valid block
+     */
+    uint16_t getOldestSequence();
+
+    /**
+     * @brief Gets the ring index of a block from its sequence number
+     *
+     * @param blockSequence: The sequence number, from getOldestSequence() to getSequence()
+     * @return uint8_t: The block index
+     */
+    uint8_t getBlockIndex(uint16_t blockSequence);
+
+    /**
+     * @brief Gets the number of completed blocks, the block being filled excluded
+     */
+    uint8_t getBlockCount();
+
+    /**
+     * @brief Gets the index of the block being filled
+     */
+    uint8_t getCurrentBlock();
+
+    /**
+     * @brief Gets the number of records in the block being filled
+     */
+    uint8_t getPendingRecords();
+
+    /**
+     * @brief Gets the number of chunk writes lost (queue full or failed transaction)
+     */
+    uint16_t getFailedWrites();
+};
+
+#endif
@@ -0,0 +1,300 @@
+/**
+ * @file sampleout.cpp
+ * @author Riccardo Iacob
+ * @brief Sample output with a policy for links slower than the sample rate
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "sampleout.h"
+#include "buildcfg.h"
+
+SampleOutput::Policy SampleOutput::policy = SampleOutput::Policy::policy_coalesce;
+
+SampleOutput::SampleOutput(TxQueue *txQueue)
+{
+    queue = txQueue;
+    holding = false;
+    aggregateCount = 0;
+    dropped = 0;
+    coalesced = 0;
+    aggregated = 0;
+}
+
+uint8_t SampleOutput::formatSample(char *line, int16_t t, uint32_t h, uint32_t p)
+{
+#if !FEATURE_HUMIDITY
+    (void)h;
+#endif
+#if !FEATURE_PRESSURE
+    (void)p;
+#endif
+    uint8_t length = 0;
+    switch (Console::outputMode)
+    {
+    case Console::OutputMode::mode_human:
+    {
+        length = NumberFormat::formatFixed(line, t, 2);
+    }
+    break;
+
+    case Console::OutputMode::mode_csv:
+    {
+        // Columns of channels compiled out (buildcfg.h) are left out
+        length = NumberFormat::formatFixed(line, t, 2);
+#if FEATURE_HUMIDITY
+        line[length++] = ',';
+        length += NumberFormat::formatFixed(line + length, NumberFormat::dropDecimals(h, 1), 2);
+#endif
+#if FEATURE_PRESSURE
+        line[length++] = ',';
+        length += NumberFormat::formatUnsigned(line + length, p);
+#endif
+    }
+    break;
+
+    default:
+    {
+        return 0;
+    }
+    }
+    line[length++] = '\r';
+    line[length++] = '\n';
+    return length;
+}
+
+uint8_t SampleOutput::formatSparse(char *line, const SampleRecord *sample)
+{
+    // Columns of channels compiled out (buildcfg.h) are left out, those not measured are empty
+    uint8_t length = NumberFormat::formatUnsigned(line, sample->timestamp);
+    line[length++] = ',';
+    if (sample->channels & channel_temperature)
+    {
+        length += NumberFormat::formatFixed(line + length, sample->temperature, 2);
+    }
+#if FEATURE_HUMIDITY
+    line[length++] = ',';
+    if (sample->channels & channel_humidity)
+    {
+        length += NumberFormat::formatFixed(line + length, sample->humidity, 2);
+    }
+#endif
+#if FEATURE_PRESSURE
+    line[length++] = ',';
+    if (sample->channels & channel_pressure)
+    {
+        length += NumberFormat::formatUnsigned(line + length, sample->pressure);
+    }
+#endif
+#if FEATURE_GAS
+    line[length++] = ',';
+    if (sample->channels & channel_gas)
+    {
+        length += NumberFormat::formatUnsigned(line + length, sample->gasResistance);
+    }
+#endif
+    line[length++] = '\r';
+    line[length++] = '\n';
+    return length;
+}
+
+bool SampleOutput::send(int16_t t, uint32_t h, uint32_t p)
+{
+    char line[LINE_SIZE];
+    uint8_t length = formatSample(line, t, h, p);
+    return length == 0 || queue->tryWrite((const uint8_t *)line, length);
+}
+
+bool SampleOutput::sendAggregate()
+{
+    if (aggregateCount == 1)
+    {
+        // Nothing to summarize
+        return send((int16_t)sumT, sumH * 10, sumP);
+    }
+
+    int16_t half = aggregateCount / 2;
+    int16_t meanT = (sumT >= 0) ? (sumT + half) / aggregateCount : (sumT - half) / aggregateCount;
+#if FEATURE_HUMIDITY
+    uint32_t meanH = (sumH + half) / aggregateCount;
+#endif
+#if FEATURE_PRESSURE
+    uint32_t meanP = (sumP + half) / aggregateCount;
+#endif
+
+    char line[LINE_SIZE];
+    uint8_t length = 0;
+    switch (Console::outputMode)
+    {
+    case Console::OutputMode::mode_human:
+    {
+        memcpy_P(line, PSTR("avg "), 4);
+        length = 4;
+        length += NumberFormat::formatFixed(line + length, meanT, 2);
+        memcpy_P(line + length, PSTR(" min "), 5);
+        length += 5;
+        length += NumberFormat::formatFixed(line + length, minT, 2);
+        memcpy_P(line + length, PSTR(" max "), 5);
+        length += 5;
+        length += NumberFormat::formatFixed(line + length, maxT, 2);
+        memcpy_P(line + length, PSTR(" n "), 3);
+        length += 3;
+        length += NumberFormat::formatUnsigned(line + length, aggregateCount);
+    }
+    break;
+
+    case Console::OutputMode::mode_csv:
+    {
+        length = NumberFormat::formatFixed(line, meanT, 2);
+#if FEATURE_HUMIDITY
+        line[length++] = ',';
+        length += NumberFormat::formatFixed(line + length, meanH, 2);
+#endif
+#if FEATURE_PRESSURE
+        line[length++] = ',';
+        length += NumberFormat::formatUnsigned(line + length, meanP);
+#endif
+        line[length++] = ',';
+        length += NumberFormat::formatFixed(line + length, minT, 2);
+        line[length++] = ',';
+        length += NumberFormat::formatFixed(line + length, maxT, 2);
+        line[length++] = ',';
+        length += NumberFormat::formatUnsigned(line + length, aggregateCount);
+    }
+    break;
+
+    default:
+    {
+        return true;
+    }
+    }
+    line[length++] = '\r';
+    line[length++] = '\n';
+    return queue->tryWrite((const uint8_t *)line, length);
+}
+
+void SampleOutput::accumulate(int16_t t, uint32_t h, uint32_t p)
+{
+    if (aggregateCount == 0)
+    {
+        sumT = 0;
+        sumH = 0;
+        sumP = 0;
+        minT = t;
+        maxT = t;
+    }
+    else if (aggregateCount == AGGREGATE_LIMIT)
+    {
+        dropped++;
+        return;
+    }
+    sumT += t;
+    sumH += NumberFormat::dropDecimals(h, 1);
+    sumP += p;
+    if (t < minT)
+    {
+        minT = t;
+    }
+    if (t > maxT)
+    {
+        maxT = t;
+    }
+    aggregateCount++;
+    aggregated++;
+}
+
+void SampleOutput::poll()
+{
+    if (holding && send(heldT, heldH, heldP))
+    {
+        holding = false;
+    }
+    if (aggregateCount > 0 && sendAggregate())
+    {
+        aggregateCount = 0;
+    }
+}
+
+void SampleOutput::submit(int16_t t, uint32_t h, uint32_t p)
+{
+    if (Console::outputMode == Console::OutputMode::mode_off)
+    {
+        holding = false;
+        aggregateCount = 0;
+        return;
+    }
+
+    // Older output first
+    poll();
+    if (aggregateCount > 0)
+    {
+        accumulate(t, h, p);
+        return;
+    }
+    if (holding)
+    {
+        coalesced++;
+        heldT = t;
+        heldH = h;
+        heldP = p;
+        return;
+    }
+    if (send(t, h, p))
+    {
+        return;
+    }
+
+    switch (policy)
+    {
+    case Policy::policy_coalesce:
+    {
+        holding = true;
+        heldT = t;
+        heldH = h;
+        heldP = p;
+    }
+    break;
+
+    case Policy::policy_aggregate:
+    {
+        accumulate(t, h, p);
+    }
+    break;
+
+    default:
+    {
+        dropped++;
+    }
+    break;
+    }
+}
+
+void SampleOutput::submitSparse(const SampleRecord *sample)
+{
+    // Output held in another mode is not sent in this one
+    holding = false;
+    aggregateCount = 0;
+
+    char line[LINE_SIZE];
+    uint8_t length = formatSparse(line, sample);
+    if (!queue->tryWrite((const uint8_t *)line, length))
+    {
+        dropped++;
+    }
+}
+
+uint32_t SampleOutput::getDropped()
+{
+    return dropped;
+}
+
+uint32_t SampleOutput::getCoalesced()
+{
+    return coalesced;
+}
+
+uint32_t SampleOutput::getAggregated()
+{
+    return aggregated;
+}
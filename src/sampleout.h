@@ -0,0 +1,145 @@
+/**
+ * @file sampleout.h
+ * @author Riccardo Iacob
+ * @brief Sample output with a policy for links slower than the sample rate
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef SAMPLEOUT_H
+#define SAMPLEOUT_H
+
+#include <Arduino.h>
+
+#include "txqueue.h"
+#include "numfmt.h"
+#include "sample.h"
+#include "console.h"
+
+/**
+ * Formats samples in the console output mode and queues them without waiting. When a line does
+ * not fit in the TX queue the policy decides what happens:
+ *   policy_drop       the sample is discarded
+ *   policy_coalesce   the sample is held and sent when there is room; a newer sample replaces it
+ *   policy_aggregate  samples are accumulated and sent as one line when there is room:
+ *                     human "avg <t> min <t> max <t> n <count>", csv "<t>,<h>,<p>,<t min>,<t max>,<count>"
+ * Held output is sent before newer samples, so lines keep their order.
+ *
+ * The sparse mode sends each record as it was measured, "<unix time>,<t>,<h>,<p>,<g>" with the
+ * channels not measured in that conversion left empty; its records are not merged, so the drop
+ * policy applies to them.
+ */
+class SampleOutput
+{
+public:
+    /**
+     * @brief Back-pressure policies
+     */
+    enum class Policy
+    {
+        policy_drop,
+        policy_coalesce,
+        policy_aggregate
+    };
+
+    // Longest line: the csv aggregate, six numbers, separators and CRLF
+    static const uint8_t LINE_SIZE = 6 * NumberFormat::BUFFER_SIZE + 2;
+    // Samples accumulated at most in one aggregate, keeping the sums within 32 bits
+    static const uint16_t AGGREGATE_LIMIT = 1000;
+
+    // Policy shared by all outputs
+    static Policy policy;
+
+private:
+    TxQueue *queue;
+
+    // Sample held by policy_coalesce
+    bool holding;
+    int16_t heldT;
+    uint32_t heldH;
+    uint32_t heldP;
+
+    // Aggregate built by policy_aggregate (humidity in centi-%)
+    uint16_t aggregateCount;
+    int32_t sumT;
+    int16_t minT;
+    int16_t maxT;
+    uint32_t sumH;
+    uint32_t sumP;
+
+    // Statistics, in samples
+    uint32_t dropped;
+    uint32_t coalesced;
+    uint32_t aggregated;
+
+    bool send(int16_t t, uint32_t h, uint32_t p);
+    bool sendAggregate();
+    void accumulate(int16_t t, uint32_t h, uint32_t p);
+
+public:
+    /**
+     * @brief Constructs a new SampleOutput object
+     *
+     * @param txQueue: The queue of the port samples are sent to
+     */
+    SampleOutput(TxQueue *txQueue);
+
+    /**
+     * @brief Sends a sample, or applies the policy if it does not fit
+     *
+     * @param t: Temperature, in centi-°C
+     * @param h: Humidity, in milli-%
+     * @param p: Pressure, in Pa
+     */
+    void submit(int16_t t, uint32_t h, uint32_t p);
+
+    /**
+     * @brief Sends a record in the sparse mode, or discards it if it does not fit
+     *
+     * @param sample: The record, only its fresh channels are sent
+     */
+    void submitSparse(const SampleRecord *sample);
+
+    /**
+     * @brief Sends the held sample or aggregate, if there is room now
+     */
+    void poll();
+
+    /**
+     * @brief Formats a sample in the current output mode, CRLF included
+     *
+     * @param line: Output buffer of LINE_SIZE bytes
+     * @param t: Temperature, in centi-°C
+     * @param h: Humidity, in milli-%
+     * @param p: Pressure, in Pa
+     * @return uint8_t: The line length, 0 if the output is off
+     */
+    static uint8_t formatSample(char *line, int16_t t, uint32_t h, uint32_t p);
+
+    /**
+     * @brief Formats a record in the sparse mode, CRLF included
+     *
+     * @param line: Output buffer of LINE_SIZE bytes
+     * @param sample: The record
+     * @return uint8_t: The line length
+     */
+    static uint8_t formatSparse(char *line, const SampleRecord *sample);
+
+    /**
+     * @brief Gets the number of samples discarded
+     */
+    uint32_t getDropped();
+
+    /**
+     * @brief Gets the number of held samples replaced by a newer one
+     */
+    uint32_t getCoalesced();
+
+    /**
+     * @brief Gets the number of samples merged into aggregates
+     */
+    uint32_t getAggregated();
+};
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file spscqueue.h
+ * @author Riccardo Iacob
+ * @brief Lock-free single-producer/single-consumer queue
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <stdint.h>
+
+/**
+ * Fixed-capacity ring of T, safe between one producer and one consumer running in different
+ * contexts (an interrupt and the main loop, or two threads on a host) without locks and without
+ * disabling interrupts.
+ *
+ * Each index is a single byte, so it is read and written atomically even on 8-bit AVR, and each
+ * is written by one side only: head by the producer, tail by the consumer. The indices run freely
+ * and wrap at 256; CAPACITY must be a power of two not greater than 128, so head - tail is always
+ * the fill level. The element is copied before the index that publishes it is stored (release),
+ * and the other side loads the index before touching the element (acquire).
+ *
+ * @tparam T: The element type, copied by assignment
+ * @tparam CAPACITY: Number of elements
+ */
+template <typename T, uint8_t CAPACITY>
+class SpscQueue
+{
+    static_assert(CAPACITY > 0 && CAPACITY <= 128 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "CAPACITY must be a power of two, at most 128");
+
+private:
+    static const uint8_t MASK = CAPACITY - 1;
+
+    T items[CAPACITY];
+    // Next slot written by the producer
+    uint8_t head;
+    // Next slot read by the consumer
+    uint8_t tail;
+    // Elements refused because the queue was full (producer side)
+    uint16_t overruns;
+
+public:
+    SpscQueue()
+    {
+        head = 0;
+        tail = 0;
+        overruns = 0;
+    }
+
+    /**
+     * @brief Appends an element; producer only
+     *
+     * @param item: The element
+     * @return bool: True if appended, false if the queue is full
+     */
+    bool push(const T &item)
+    {
+        uint8_t h = head;
+        if ((uint8_t)(h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) == CAPACITY)
+        {
+            overruns++;
+            return false;
+        }
+        items[h & MASK] = item;
+        __atomic_store_n(&head, (uint8_t)(h + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element; consumer only
+     *
+     * @param item: Output element (written only on success)
+     * @return bool: True if an element was removed, false if the queue is empty
+     */
+    bool pop(T &item)
+    {
+        uint8_t t = tail;
+        if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == t)
+        {
+            return false;
+        }
+        item = items[t & MASK];
+        __atomic_store_n(&tail, (uint8_t)(t + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * @brief Gets the number of queued elements (a snapshot if the other side is running)
+     */
+    uint8_t size() const
+    {
+        return (uint8_t)(__atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE));
+    }
+
+    /**
+     * @brief Checks whether the queue is empty
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Gets the number of elements refused by push(); producer side
+     */
+    uint16_t getOverruns() const
+    {
+        return overruns;
+    }
+};
+
+#endif
@@ -10,17 +10,60 @@
 
 #include "ssd1306.h"
 
+// Maximum bytes per I2C transaction of the Wire library, control byte included
+#define SSD1306_WIRE_MAX 32
+
+/**
+ * Large digit font, seven-segment style, 6 columns x 16 rows.
+ * Each glyph is 6 bytes of the top page followed by 6 bytes of the bottom page (LSB = top row).
+ * Glyph order: "0123456789-. "
+ */
+static const uint8_t largeDigits[13][2 * SSD1306::FONT_COLUMNS] PROGMEM = {
+    {0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF}, // '0'
+    {0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF}, // '1'
+    {0x83, 0x83, 0x83, 0x83, 0xFF, 0xFF, 0xFF, 0xFF, 0xC1, 0xC1, 0xC1, 0xC1}, // '2'
+    {0x83, 0x83, 0x83, 0x83, 0xFF, 0xFF, 0xC1, 0xC1, 0xC1, 0xC1, 0xFF, 0xFF}, // '3'
+    {0xFF, 0xFF, 0x80, 0x80, 0xFF, 0xFF, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xFF}, // '4'
+    {0xFF, 0xFF, 0x83, 0x83, 0x83, 0x83, 0xC1, 0xC1, 0xC1, 0xC1, 0xFF, 0xFF}, // '5'
+    {0xFF, 0xFF, 0x83, 0x83, 0x83, 0x83, 0xFF, 0xFF, 0xC1, 0xC1, 0xFF, 0xFF}, // '6'
+    {0x03, 0x03, 0x03, 0x03, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF}, // '7'
+    {0xFF, 0xFF, 0x83, 0x83, 0xFF, 0xFF, 0xFF, 0xFF, 0xC1, 0xC1, 0xFF, 0xFF}, // '8'
+    {0xFF, 0xFF, 0x83, 0x83, 0xFF, 0xFF, 0xC1, 0xC1, 0xC1, 0xC1, 0xFF, 0xFF}, // '9'
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0xC0, 0x00, 0x00}, // '.'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}  // ' '
+};
+
+// Top page and first column of each large-digit field of screen_live
+static const uint8_t fieldLayout[4][2] PROGMEM = {
+    {0, 24}, // field_temperature
+    {2, 24}, // field_humidity
+    {4, 24}, // field_pressure
+    {6, 24}  // field_iaq
+};
+
+// Page of each line of screen_status, and column of its value
+static const uint8_t statusPages[4] PROGMEM = {2, 3, 4, 5};
+static const uint8_t STATUS_VALUE_COLUMN = 64;
+
 SSD1306::SSD1306() : Adafruit_SSD1306(128, 64, &Wire, -1)
 {
+    currentScreen = Screens::screen_welcome;
+    trendHead = 0;
+    trendCount = 0;
+    markClean();
 }
 
 void SSD1306::printScreen(Screens screen)
 {
+    currentScreen = screen;
+
     switch (screen)
     {
     case Screens::screen_welcome:
     {
         clearDisplay();
+        setCursor(0, 0);
         setTextColor(SSD1306_WHITE);
         setTextSize(3);
         println("ArtuAir");
@@ -33,9 +76,305 @@ void SSD1306::printScreen(Screens screen)
     }
     break;
 
+    case Screens::screen_live:
+    {
+        // Static labels, drawn once; values are filled in by updateField()
+        clearDisplay();
+        setTextColor(SSD1306_WHITE);
+        setTextSize(1);
+        setCursor(0, 4);
+        print(F("T"));
+        setCursor(0, 20);
+        print(F("RH"));
+        setCursor(0, 36);
+        print(F("P"));
+        setCursor(0, 52);
+        print(F("IAQ"));
+        setCursor(84, 4);
+        print(F("C"));
+        setCursor(84, 20);
+        print(F("%"));
+        setCursor(84, 36);
+        print(F("hPa"));
+        for (uint8_t field = 0; field < 4; field++)
+        {
+            memset(fieldText[field], 0, FIELD_GLYPHS);
+            clearField((Fields)field);
+        }
+        display();
+    }
+    break;
+
+    case Screens::screen_trends:
+    {
+        clearDisplay();
+        setTextColor(SSD1306_WHITE);
+        setTextSize(1);
+        setCursor(0, 0);
+        print(F("Temperature trend"));
+        drawTrend();
+        display();
+    }
+    break;
+
+    case Screens::screen_status:
+    {
+        clearDisplay();
+        setTextColor(SSD1306_WHITE);
+        setTextSize(1);
+        setCursor(0, 0);
+        print(F("Status"));
+        setCursor(0, 16);
+        print(F("Samples"));
+        setCursor(0, 24);
+        print(F("Uptime s"));
+        setCursor(0, 32);
+        print(F("Cfg seq"));
+        setCursor(0, 40);
+        print(F("I2C err"));
+        display();
+    }
+    break;
+
     default:
     {
         break;
     }
     }
-}
\ No newline at end of file
+
+    markClean();
+}
+
+SSD1306::Screens SSD1306::getScreen()
+{
+    return currentScreen;
+}
+
+void SSD1306::markDirty(uint8_t page, uint8_t firstColumn, uint8_t lastColumn)
+{
+    if (firstColumn < dirtyFirst[page])
+    {
+        dirtyFirst[page] = firstColumn;
+    }
+    // 0xFF marks a clean page
+    if (dirtyLast[page] == 0xFF || lastColumn > dirtyLast[page])
+    {
+        dirtyLast[page] = lastColumn;
+    }
+}
+
+void SSD1306::markClean()
+{
+    memset(dirtyFirst, 0xFF, sizeof(dirtyFirst));
+    memset(dirtyLast, 0xFF, sizeof(dirtyLast));
+}
+
+void SSD1306::drawGlyph(uint8_t page, uint8_t column, char c)
+{
+    uint8_t index;
+    if (c >= '0' && c <= '9')
+    {
+        index = c - '0';
+    }
+    else if (c == '.')
+    {
+        index = 11;
+    }
+    else if (c == ' ')
+    {
+        index = 12;
+    }
+    else
+    {
+        // '-' and the overflow marker
+        index = 10;
+    }
+
+    // Pages are byte aligned in the framebuffer, so glyph columns are copied as they are
+    uint8_t *top = getBuffer() + (uint16_t)page * DISPLAY_WIDTH + column;
+    uint8_t *bottom = top + DISPLAY_WIDTH;
+    memcpy_P(top, &largeDigits[index][0], FONT_COLUMNS);
+    memcpy_P(bottom, &largeDigits[index][FONT_COLUMNS], FONT_COLUMNS);
+    memset(top + FONT_COLUMNS, 0, GLYPH_WIDTH - FONT_COLUMNS);
+    memset(bottom + FONT_COLUMNS, 0, GLYPH_WIDTH - FONT_COLUMNS);
+
+    markDirty(page, column, column + GLYPH_WIDTH - 1);
+    markDirty(page + 1, column, column + GLYPH_WIDTH - 1);
+}
+
+void SSD1306::updateField(Fields field, int32_t value, uint8_t decimals)
+{
+    if (currentScreen != Screens::screen_live)
+    {
+        return;
+    }
+
+    char text[FIELD_GLYPHS + 1];
+    NumberFormat::formatFixedWidth(text, value, decimals, FIELD_GLYPHS);
+
+    uint8_t page = pgm_read_byte(&fieldLayout[field][0]);
+    uint8_t column = pgm_read_byte(&fieldLayout[field][1]);
+    for (uint8_t i = 0; i < FIELD_GLYPHS; i++)
+    {
+        // Only glyphs that changed are redrawn (and later sent)
+        if (fieldText[field][i] != text[i])
+        {
+            fieldText[field][i] = text[i];
+            drawGlyph(page, column + i * GLYPH_WIDTH, text[i]);
+        }
+    }
+}
+
+void SSD1306::clearField(Fields field)
+{
+    if (currentScreen != Screens::screen_live)
+    {
+        return;
+    }
+
+    uint8_t page = pgm_read_byte(&fieldLayout[field][0]);
+    uint8_t column = pgm_read_byte(&fieldLayout[field][1]);
+    for (uint8_t i = 0; i < FIELD_GLYPHS; i++)
+    {
+        char c = (i >= FIELD_GLYPHS - 3) ? '-' : ' ';
+        if (fieldText[field][i] != c)
+        {
+            fieldText[field][i] = c;
+            drawGlyph(page, column + i * GLYPH_WIDTH, c);
+        }
+    }
+}
+
+void SSD1306::updateStatus(StatusLines line, int32_t value, uint8_t decimals)
+{
+    if (currentScreen != Screens::screen_status)
+    {
+        return;
+    }
+
+    char text[STATUS_CHARS + 1];
+    NumberFormat::formatFixedWidth(text, value, decimals, STATUS_CHARS);
+
+    uint8_t page = pgm_read_byte(&statusPages[line]);
+    // Opaque text overwrites the previous value without clearing the field first
+    setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+    setTextSize(1);
+    setCursor(STATUS_VALUE_COLUMN, page * 8);
+    print(text);
+    markDirty(page, STATUS_VALUE_COLUMN, STATUS_VALUE_COLUMN + STATUS_CHARS * 6 - 1);
+}
+
+void SSD1306::pushTrend(int16_t value)
+{
+    trend[trendHead] = value;
+    trendHead = (trendHead + 1) % TREND_LENGTH;
+    if (trendCount < TREND_LENGTH)
+    {
+        trendCount++;
+    }
+
+    if (currentScreen == Screens::screen_trends)
+    {
+        drawTrend();
+    }
+}
+
+void SSD1306::drawTrend()
+{
+    // The plot uses pages 1 to 7, two columns per value
+    const uint8_t top = 8;
+    const uint8_t span = DISPLAY_HEIGHT - top - 1;
+
+    memset(getBuffer() + DISPLAY_WIDTH, 0, (uint16_t)(DISPLAY_PAGES - 1) * DISPLAY_WIDTH);
+    for (uint8_t page = 1; page < DISPLAY_PAGES; page++)
+    {
+        markDirty(page, 0, DISPLAY_WIDTH - 1);
+    }
+
+    if (trendCount == 0)
+    {
+        return;
+    }
+
+    uint8_t oldest = (trendHead + TREND_LENGTH - trendCount) % TREND_LENGTH;
+    int16_t low = trend[oldest];
+    int16_t high = trend[oldest];
+    for (uint8_t i = 0; i < trendCount; i++)
+    {
+        int16_t v = trend[(oldest + i) % TREND_LENGTH];
+        low = min(low, v);
+        high = max(high, v);
+    }
+    int32_t range = (int32_t)high - low;
+    if (range == 0)
+    {
+        range = 1;
+    }
+
+    for (uint8_t i = 0; i < trendCount; i++)
+    {
+        int32_t v = trend[(oldest + i) % TREND_LENGTH];
+        uint8_t y = DISPLAY_HEIGHT - 1 - (uint8_t)(((v - low) * span) / range);
+        uint8_t x = (TREND_LENGTH - trendCount + i) * 2;
+        drawPixel(x, y, SSD1306_WHITE);
+        drawPixel(x + 1, y, SSD1306_WHITE);
+    }
+}
+
+void SSD1306::flush()
+{
+    uint8_t *framebuffer = getBuffer();
+    uint8_t page = 0;
+
+    while (page < DISPLAY_PAGES)
+    {
+        if (dirtyLast[page] == 0xFF)
+        {
+            page++;
+            continue;
+        }
+
+        // Consecutive pages with the same dirty columns go out in a single window
+        uint8_t first = dirtyFirst[page];
+        uint8_t last = dirtyLast[page];
+        uint8_t lastPage = page;
+        while (lastPage + 1 < DISPLAY_PAGES && dirtyFirst[lastPage + 1] == first && dirtyLast[lastPage + 1] == last)
+        {
+            lastPage++;
+        }
+
+        ssd1306_command(SSD1306_PAGEADDR);
+        ssd1306_command(page);
+        ssd1306_command(lastPage);
+        ssd1306_command(SSD1306_COLUMNADDR);
+        ssd1306_command(first);
+        ssd1306_command(last);
+
+        // Horizontal addressing wraps within the window, so the rows can be streamed back to back
+        uint8_t bytesOut = SSD1306_WIRE_MAX;
+        for (uint8_t p = page; p <= lastPage; p++)
+        {
+            uint8_t *row = framebuffer + (uint16_t)p * DISPLAY_WIDTH;
+            for (uint8_t column = first; column <= last; column++)
+            {
+                if (bytesOut >= SSD1306_WIRE_MAX)
+                {
+                    if (column != first || p != page)
+                    {
+                        wire->endTransmission();
+                    }
+                    wire->beginTransmission(i2caddr);
+                    wire->write((uint8_t)0x40);
+                    bytesOut = 1;
+                }
+                wire->write(row[column]);
+                bytesOut++;
+            }
+        }
+        wire->endTransmission();
+
+        page = lastPage + 1;
+    }
+
+    markClean();
+}
@@ -14,6 +14,8 @@
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
 
+#include "numfmt.h"
+
 class SSD1306 : public Adafruit_SSD1306
 {
 public:
@@ -28,12 +30,134 @@ public:
          * Malignani Udine
          * 5ELIA A.S. 2022/2023
          */
-        screen_welcome
+        screen_welcome,
+        /**
+         * T   [large digits] C
+         * RH  [large digits] %
+         * P   [large digits] hPa
+         * IAQ [large digits]
+         * IAQ is the gas baseline ratio index (GasBaseline::getAirQuality()); dashes while not valid
+         */
+        screen_live,
+        /**
+         * Temperature trend
+         * [min/max scaled plot of the last TREND_LENGTH values]
+         */
+        screen_trends,
+        /**
+         * Status
+         * Samples  [value]
+         * Uptime s [value]
+         * Cfg seq  [value]
+         * I2C err  [value]
+         */
+        screen_status
+    };
+
+    /**
+     * @brief Large-digit numeric fields of screen_live
+     */
+    enum Fields
+    {
+        field_temperature = 0,
+        field_humidity = 1,
+        field_pressure = 2,
+        field_iaq = 3
+    };
+
+    /**
+     * @brief Small-font numeric lines of screen_status
+     */
+    enum StatusLines
+    {
+        status_samples = 0,
+        status_uptime = 1,
+        status_config = 2,
+        status_i2c_errors = 3
     };
 
+    // Display size
+    static const uint8_t DISPLAY_WIDTH = 128;
+    static const uint8_t DISPLAY_HEIGHT = 64;
+    static const uint8_t DISPLAY_PAGES = DISPLAY_HEIGHT / 8;
+
+    // Large digit glyph size: FONT_COLUMNS wide, two pages tall, drawn in GLYPH_WIDTH wide cells
+    static const uint8_t FONT_COLUMNS = 6;
+    static const uint8_t GLYPH_WIDTH = 8;
+    // Number of glyph cells in a large-digit field
+    static const uint8_t FIELD_GLYPHS = 7;
+    // Number of characters in a status value
+    static const uint8_t STATUS_CHARS = 10;
+
+    // Number of values in the trend plot
+    static const uint8_t TREND_LENGTH = 64;
+
+private:
+    Screens currentScreen;
+
+    // Dirty column range of each page, 0xFF when the page is clean
+    uint8_t dirtyFirst[DISPLAY_PAGES];
+    uint8_t dirtyLast[DISPLAY_PAGES];
+
+    // Characters currently drawn in each large-digit field
+    char fieldText[4][FIELD_GLYPHS];
+
+    // Trend history (ring buffer)
+    int16_t trend[TREND_LENGTH];
+    uint8_t trendHead;
+    uint8_t trendCount;
+
+    void markDirty(uint8_t page, uint8_t firstColumn, uint8_t lastColumn);
+    void markClean();
+    void drawGlyph(uint8_t page, uint8_t column, char c);
+    void drawTrend();
+
 public:
     SSD1306();
     void printScreen(Screens screen);
+
+    /**
+     * @brief Gets the screen currently shown
+     */
+    Screens getScreen();
+
+    /**
+     * @brief Writes a value in a large-digit field of screen_live
+     * Only the field's glyph columns are touched; nothing is sent until flush()
+     *
+     * @param field: The field
+     * @param value: The scaled value
+     * @param decimals: Number of decimal digits in value
+     */
+    void updateField(Fields field, int32_t value, uint8_t decimals);
+
+    /**
+     * @brief Shows dashes in a large-digit field of screen_live (value not available)
+     *
+     * @param field: The field
+     */
+    void clearField(Fields field);
+
+    /**
+     * @brief Writes a value in a line of screen_status
+     *
+     * @param line: The status line
+     * @param value: The scaled value
+     * @param decimals: Number of decimal digits in value
+     */
+    void updateStatus(StatusLines line, int32_t value, uint8_t decimals);
+
+    /**
+     * @brief Appends a value to the trend history, redrawing the plot if screen_trends is shown
+     *
+     * @param value: The value (any fixed scale)
+     */
+    void pushTrend(int16_t value);
+
+    /**
+     * @brief Sends the modified page/column ranges of the framebuffer to the display
+     */
+    void flush();
 };
 
-#endif
\ No newline at end of file
+#endif
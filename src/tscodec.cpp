@@ -0,0 +1,226 @@
+/**
+ * @file tscodec.cpp
+ * @author Riccardo Iacob
+ * @brief Delta/varint compressed time-series encoding of sample records
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "tscodec.h"
+
+SeriesEncoder::SeriesEncoder()
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        previous[i] = 0;
+    }
+    channels = channel_all;
+}
+
+void SeriesEncoder::quantize(const SampleRecord *sample, int32_t *values)
+{
+    values[0] = sample->temperature;
+    values[1] = sample->humidity;
+    values[2] = (int32_t)sample->pressure;
+    // Round to the nearest gas unit
+    values[3] = (int32_t)((sample->gasResistance + (1UL << (GAS_SHIFT - 1))) >> GAS_SHIFT);
+}
+
+uint8_t SeriesEncoder::writeVarint(int32_t value, uint8_t *out)
+{
+    // Zigzag: small magnitudes of either sign become small unsigned numbers
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint8_t length = 0;
+    while (zigzag >= 0x80)
+    {
+        out[length++] = (uint8_t)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out[length++] = (uint8_t)zigzag;
+    return length;
+}
+
+uint8_t SeriesEncoder::readVarint(const uint8_t *in, uint16_t length, int32_t *value)
+{
+    uint32_t zigzag = 0;
+    for (uint8_t i = 0; i < 5 && i < length; i++)
+    {
+        zigzag |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0)
+        {
+            *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t SeriesEncoder::encodeKeyframe(const SampleRecord *sample, uint16_t period, uint8_t *out)
+{
+    uint8_t length = 0;
+
+    out[length++] = (uint8_t)sample->timestamp;
+    out[length++] = (uint8_t)(sample->timestamp >> 8);
+    out[length++] = (uint8_t)(sample->timestamp >> 16);
+    out[length++] = (uint8_t)(sample->timestamp >> 24);
+    out[length++] = (uint8_t)period;
+    out[length++] = (uint8_t)(period >> 8);
+    channels = sample->channels;
+    out[length++] = channels;
+
+    quantize(sample, previous);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        length += writeVarint(previous[i], out + length);
+    }
+    return length;
+}
+
+uint8_t SeriesEncoder::encodeDelta(const SampleRecord *sample, uint8_t *out)
+{
+    int32_t values[4];
+    uint8_t nibbles[4];
+    uint8_t length = 2;
+
+    quantize(sample, values);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        int32_t delta = values[i] - previous[i];
+        if (i == 0 && sample->channels != channels)
+        {
+            // Escaped zero T delta: the channel flags follow, then the actual T delta
+            channels = sample->channels;
+            nibbles[i] = NIBBLE_ESCAPE;
+            length += writeVarint(0, out + length);
+            out[length++] = channels;
+            length += writeVarint(delta, out + length);
+        }
+        else if (delta >= -7 && delta <= 7)
+        {
+            nibbles[i] = (uint8_t)delta & 0x0F;
+        }
+        else
+        {
+            nibbles[i] = NIBBLE_ESCAPE;
+            length += writeVarint(delta, out + length);
+        }
+        previous[i] = values[i];
+    }
+    out[0] = (nibbles[0] << 4) | nibbles[1];
+    out[1] = (nibbles[2] << 4) | nibbles[3];
+    return length;
+}
+
+SeriesDecoder::SeriesDecoder()
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        previous[i] = 0;
+    }
+    timestamp = 0;
+    period = 0;
+    channels = channel_all;
+}
+
+void SeriesDecoder::dequantize(const int32_t *values, uint32_t timestamp, uint8_t channels, SampleRecord *sample)
+{
+    sample->timestamp = timestamp;
+    sample->temperature = (int16_t)values[0];
+    sample->humidity = (uint16_t)values[1];
+    sample->pressure = (uint32_t)values[2];
+    sample->gasResistance = (uint32_t)values[3] << SeriesEncoder::GAS_SHIFT;
+    sample->channels = channels;
+}
+
+uint16_t SeriesDecoder::decodeKeyframe(const uint8_t *in, uint16_t length, SampleRecord *sample)
+{
+    if (length < 7)
+    {
+        return 0;
+    }
+
+    uint32_t t = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    uint16_t p = (uint16_t)in[4] | ((uint16_t)in[5] << 8);
+    uint8_t flags = in[6];
+    uint16_t consumed = 7;
+    int32_t values[4];
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        uint8_t n = SeriesEncoder::readVarint(in + consumed, length - consumed, &values[i]);
+        if (n == 0)
+        {
+            return 0;
+        }
+        consumed += n;
+    }
+
+    // Only commit the state once the whole record is known to be valid
+    timestamp = t;
+    period = p;
+    channels = flags;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        previous[i] = values[i];
+    }
+    dequantize(previous, timestamp, channels, sample);
+    return consumed;
+}
+
+uint16_t SeriesDecoder::decodeDelta(const uint8_t *in, uint16_t length, SampleRecord *sample)
+{
+    if (length < 2)
+    {
+        return 0;
+    }
+
+    uint8_t nibbles[4] = {(uint8_t)(in[0] >> 4), (uint8_t)(in[0] & 0x0F), (uint8_t)(in[1] >> 4), (uint8_t)(in[1] & 0x0F)};
+    uint16_t consumed = 2;
+    int32_t values[4];
+    uint8_t flags = channels;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        int32_t delta;
+        if (nibbles[i] == SeriesEncoder::NIBBLE_ESCAPE)
+        {
+            uint8_t n = SeriesEncoder::readVarint(in + consumed, length - consumed, &delta);
+            if (n == 0)
+            {
+                return 0;
+            }
+            consumed += n;
+            if (i == 0 && delta == 0)
+            {
+                // Channel flags change, the T delta follows them
+                if (consumed >= length)
+                {
+                    return 0;
+                }
+                flags = in[consumed++];
+                n = SeriesEncoder::readVarint(in + consumed, length - consumed, &delta);
+                if (n == 0)
+                {
+                    return 0;
+                }
+                consumed += n;
+            }
+        }
+        else
+        {
+            // Sign-extend the 4-bit two's complement delta
+            delta = (nibbles[i] & 0x08) ? (int32_t)nibbles[i] - 16 : (int32_t)nibbles[i];
+        }
+        values[i] = previous[i] + delta;
+    }
+
+    timestamp += period;
+    channels = flags;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        previous[i] = values[i];
+    }
+    dequantize(previous, timestamp, channels, sample);
+    return consumed;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file tscodec.h
+ * @author Riccardo Iacob
+ * @brief Delta/varint compressed time-series encoding of sample records
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef TSCODEC_H
+#define TSCODEC_H
+
+#include <stdint.h>
+
+#include "sample.h"
+
+/**
+ * A series starts with a keyframe and continues with delta records, one per period.
+ * Timestamps are implied: record n of a series is at keyframe timestamp + n * period.
+ *
+ * Keyframe:
+ *   timestamp  uint32, little endian
+ *   period     uint16, little endian, seconds
+ *   channels   uint8, SampleChannels flags of the channels holding a measured value
+ *   T, H, P, G zigzag varints of the absolute quantized values
+ *
+ * Delta record:
+ *   byte 0     T delta nibble (high) | H delta nibble (low)
+ *   byte 1     P delta nibble (high) | G delta nibble (low)
+ *   escapes    zigzag varint for every nibble equal to NIBBLE_ESCAPE, in channel order
+ * A nibble holds a delta of -7 to +7 as a 4-bit two's complement value; larger deltas use
+ * the escape. A steady signal therefore costs 2 bytes per sample instead of a raw 20-byte BMEData.
+ * An escaped T delta of 0, which a nibble would hold, is never written for a delta: it announces
+ * that the channel flags changed, and is followed by the new flags byte and the T delta varint.
+ *
+ * Quantization: T in 0.01 °C, H in 0.01 %, P in Pa, G in (1 << GAS_SHIFT) Ohm.
+ */
+class SeriesEncoder
+{
+public:
+    // Gas resistance is stored in units of (1 << GAS_SHIFT) Ohm
+    static const uint8_t GAS_SHIFT = 4;
+    // Nibble value announcing a varint delta
+    static const uint8_t NIBBLE_ESCAPE = 0x8;
+    // Worst case size of an encoded keyframe
+    static const uint8_t MAX_KEYFRAME_SIZE = 7 + 4 * 5;
+    // Worst case size of an encoded delta record, channel flags change included
+    static const uint8_t MAX_DELTA_SIZE = 2 + 2 + 4 * 5;
+
+private:
+    int32_t previous[4];
+    uint8_t channels;
+
+    static void quantize(const SampleRecord *sample, int32_t *values);
+
+public:
+    SeriesEncoder();
+
+    /**
+     * @brief Encodes a keyframe, starting a new series
+     *
+     * @param sample: The sample
+     * @param period: The cadence of the following records, in seconds
+     * @param out: Output buffer, at least MAX_KEYFRAME_SIZE bytes
+     * @return uint8_t: The number of bytes written
+     */
+    uint8_t encodeKeyframe(const SampleRecord *sample, uint16_t period, uint8_t *out);
+
+    /**
+     * @brief Encodes the next sample of the series as a delta from the previous one
+     *
+     * @param sample: The sample
+     * @param out: Output buffer, at least MAX_DELTA_SIZE bytes
+     * @return uint8_t: The number of bytes written
+     */
+    uint8_t encodeDelta(const SampleRecord *sample, uint8_t *out);
+
+    /**
+     * @brief Writes a zigzag encoded varint
+     *
+     * @param value: The signed value
+     * @param out: Output buffer, at least 5 bytes
+     * @return uint8_t: The number of bytes written
+     */
+    static uint8_t writeVarint(int32_t value, uint8_t *out);
+
+    /**
+     * @brief Reads a zigzag encoded varint
+     *
+     * @param in: Input buffer
+     * @param length: Number of bytes available
+     * @param value: The decoded value
+     * @return uint8_t: The number of bytes consumed, 0 if the input is truncated or malformed
+     */
+    static uint8_t readVarint(const uint8_t *in, uint16_t length, int32_t *value);
+};
+
+class SeriesDecoder
+{
+private:
+    int32_t previous[4];
+    uint32_t timestamp;
+    uint16_t period;
+    uint8_t channels;
+
+    static void dequantize(const int32_t *values, uint32_t timestamp, uint8_t channels, SampleRecord *sample);
+
+public:
+    SeriesDecoder();
+
+    /**
+     * @brief Decodes a keyframe, starting a new series
+     *
+     * @param in: Input buffer
+     * @param length: Number of bytes available
+     * @param sample: The decoded sample
+     * @return uint16_t: The number of bytes consumed, 0 if the input is truncated or malformed
+     */
+    uint16_t decodeKeyframe(const uint8_t *in, uint16_t length, SampleRecord *sample);
+
+    /**
+     * @brief Decodes the next delta record of the series
+     *
+     * @param in: Input buffer
+     * @param length: Number of bytes available
+     * @param sample: The decoded sample
+     * @return uint16_t: The number of bytes consumed, 0 if the input is truncated or malformed
+     */
+    uint16_t decodeDelta(const uint8_t *in, uint16_t length, SampleRecord *sample);
+};
+
+#endif
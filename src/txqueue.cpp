@@ -0,0 +1,153 @@
+/**
+ * @file txqueue.cpp
+ * @author Riccardo Iacob
+ * @brief Non-blocking transmit queue in front of a hardware serial port
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "txqueue.h"
+
+TxQueue::TxQueue(Stream *serialPort, uint8_t *queueBuffer, uint16_t queueSize)
+{
+    port = serialPort;
+    buffer = queueBuffer;
+    size = queueSize;
+    head = 0;
+    count = 0;
+    highWater = 0;
+    rejected = 0;
+    truncated = 0;
+}
+
+void TxQueue::push(const uint8_t *data, uint16_t length)
+{
+    // The caller checked the room; copy in at most two pieces
+    uint16_t tail = head + count;
+    if (tail >= size)
+    {
+        tail -= size;
+    }
+    uint16_t first = size - tail;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(buffer + tail, data, first);
+    memcpy(buffer, data + first, length - first);
+
+    count += length;
+    if (count > highWater)
+    {
+        highWater = count;
+    }
+}
+
+bool TxQueue::tryWrite(const uint8_t *data, uint16_t length)
+{
+    if (length > size - count)
+    {
+        rejected++;
+        return false;
+    }
+    push(data, length);
+    return true;
+}
+
+void TxQueue::pump()
+{
+    while (count > 0)
+    {
+        int room = port->availableForWrite();
+        if (room <= 0)
+        {
+            return;
+        }
+        // Contiguous part only, the wrapped part goes in the next iteration
+        uint16_t length = size - head;
+        if (length > count)
+        {
+            length = count;
+        }
+        if (length > (uint16_t)room)
+        {
+            length = room;
+        }
+        port->write(buffer + head, length);
+        head += length;
+        if (head >= size)
+        {
+            head -= size;
+        }
+        count -= length;
+    }
+}
+
+uint16_t TxQueue::getQueued()
+{
+    return count;
+}
+
+uint16_t TxQueue::getHighWater()
+{
+    return highWater;
+}
+
+uint32_t TxQueue::getRejected()
+{
+    return rejected;
+}
+
+uint32_t TxQueue::getTruncated()
+{
+    return truncated;
+}
+
+int TxQueue::available()
+{
+    return port->available();
+}
+
+int TxQueue::read()
+{
+    return port->read();
+}
+
+int TxQueue::peek()
+{
+    return port->peek();
+}
+
+size_t TxQueue::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t TxQueue::write(const uint8_t *data, size_t length)
+{
+    // Make what room the hardware buffer allows, then queue what fits and drop the rest
+    if (length > (size_t)(size - count))
+    {
+        pump();
+    }
+    uint16_t room = size - count;
+    uint16_t piece = length < room ? length : room;
+    push(data, piece);
+    truncated += length - piece;
+    return piece;
+}
+
+int TxQueue::availableForWrite()
+{
+    return size - count;
+}
+
+void TxQueue::flush()
+{
+    while (count > 0)
+    {
+        pump();
+    }
+    port->flush();
+}
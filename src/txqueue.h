@@ -0,0 +1,102 @@
+/**
+ * @file txqueue.h
+ * @author Riccardo Iacob
+ * @brief Non-blocking transmit queue in front of a hardware serial port
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef TXQUEUE_H
+#define TXQUEUE_H
+
+#include <Arduino.h>
+
+/**
+ * HardwareSerial only buffers 63 bytes and print() waits for room once they are used up.
+ * TxQueue adds a larger RAM queue (the buffer is supplied by the caller, so its size is chosen
+ * per port) in front of it. pump() moves only as many bytes as the hardware buffer can take,
+ * where the core's UDRE interrupt sends them out, so the loop never waits for the line.
+ *
+ * TxQueue is a Stream: reading is passed through to the port, so the same object can be given
+ * to a Console. Neither interface waits: sample output uses tryWrite(), which queues a whole record
+ * or nothing, and the Print interface (console replies) queues what fits and drops the rest,
+ * counted in getTruncated(). The Console writes only once availableForWrite() has room for the
+ * piece, so its replies are not cut short.
+ */
+class TxQueue : public Stream
+{
+private:
+    Stream *port;
+    uint8_t *buffer;
+    uint16_t size;
+    // Index of the oldest queued byte and number of queued bytes
+    uint16_t head;
+    uint16_t count;
+
+    // Statistics
+    uint16_t highWater;
+    uint32_t rejected;
+    uint32_t truncated;
+
+    void push(const uint8_t *data, uint16_t length);
+
+public:
+    /**
+     * @brief Constructs a new TxQueue object
+     *
+     * @param serialPort: The port the queue is drained into
+     * @param queueBuffer: Static storage for the queue
+     * @param queueSize: Size of the storage, in bytes
+     */
+    TxQueue(Stream *serialPort, uint8_t *queueBuffer, uint16_t queueSize);
+
+    /**
+     * @brief Queues a whole record if it fits, never waiting
+     *
+     * @param data: The record
+     * @param length: The record length
+     * @return bool: True if queued, false if there is not enough room (nothing is queued then)
+     */
+    bool tryWrite(const uint8_t *data, uint16_t length);
+
+    /**
+     * @brief Moves queued bytes into the hardware buffer, as many as fit without waiting
+     */
+    void pump();
+
+    /**
+     * @brief Gets the number of queued bytes
+     */
+    uint16_t getQueued();
+
+    /**
+     * @brief Gets the highest number of queued bytes seen
+     */
+    uint16_t getHighWater();
+
+    /**
+     * @brief Gets the number of records refused by tryWrite()
+     */
+    uint32_t getRejected();
+
+    /**
+     * @brief Gets the number of bytes of Print writes dropped for lack of room
+     */
+    uint32_t getTruncated();
+
+    // Stream
+    int available() override;
+    int read() override;
+    int peek() override;
+    // Print: queues what fits, never waits
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t length) override;
+    int availableForWrite() override;
+    // Waits until everything is handed to the hardware
+    void flush() override;
+
+    using Print::write;
+};
+
+#endif
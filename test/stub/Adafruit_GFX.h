@@ -0,0 +1,15 @@
+/**
+ * @file Adafruit_GFX.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for Adafruit GFX (drawing is done by Adafruit_SSD1306.h)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ADAFRUIT_GFX_H
+#define ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * @file Adafruit_SSD1306.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for Adafruit SSD1306: an in-memory framebuffer in the controller layout
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ADAFRUIT_SSD1306_H
+#define ADAFRUIT_SSD1306_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+/**
+ * The buffer is laid out like the controller RAM (one byte per column of 8 rows, LSB on top).
+ * Text is not rasterised: it only counts characters, the tests look at the numeric fields and
+ * plots, which are drawn directly in the buffer. display() counts full-screen transfers and
+ * ssd1306_command() records the addressing window of partial ones.
+ */
+class Adafruit_SSD1306 : public Print
+{
+private:
+    uint8_t buffer[128 * 64 / 8];
+
+protected:
+    TwoWire *wire;
+    int8_t i2caddr;
+
+public:
+    uint32_t fullTransfers;
+    uint32_t commands;
+    uint32_t textCharacters;
+
+    Adafruit_SSD1306(uint8_t, uint8_t, TwoWire *twi, int8_t)
+    {
+        wire = twi;
+        i2caddr = 0x3C;
+        fullTransfers = 0;
+        commands = 0;
+        textCharacters = 0;
+        clearDisplay();
+    }
+    bool begin(uint8_t, uint8_t address)
+    {
+        i2caddr = address;
+        return true;
+    }
+    void clearDisplay()
+    {
+        memset(buffer, 0, sizeof(buffer));
+    }
+    void display()
+    {
+        fullTransfers++;
+    }
+    void dim(bool) {}
+    void ssd1306_command(uint8_t)
+    {
+        commands++;
+    }
+    uint8_t *getBuffer()
+    {
+        return buffer;
+    }
+    int16_t width()
+    {
+        return 128;
+    }
+    int16_t height()
+    {
+        return 64;
+    }
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setTextSize(uint8_t) {}
+    void setCursor(int16_t, int16_t) {}
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || x >= 128 || y < 0 || y >= 64)
+        {
+            return;
+        }
+        uint8_t *cell = &buffer[(y / 8) * 128 + x];
+        *cell = color ? (*cell | (1 << (y & 7))) : (*cell & ~(1 << (y & 7)));
+    }
+    bool getPixel(int16_t x, int16_t y)
+    {
+        return (buffer[(y / 8) * 128 + x] >> (y & 7)) & 1;
+    }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        for (int16_t i = x; i < x + w; i++)
+        {
+            for (int16_t j = y; j < y + h; j++)
+            {
+                drawPixel(i, j, color);
+            }
+        }
+    }
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+        fillRect(x, y, w, 1, color);
+    }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+        fillRect(x, y, 1, h, color);
+    }
+    size_t write(uint8_t) override
+    {
+        textCharacters++;
+        return 1;
+    }
+    using Print::write;
+};
+
+#endif
@@ -0,0 +1,392 @@
+/**
+ * @file Arduino.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for the Arduino core used by the native unit tests
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Flash is ordinary memory on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strchr_P strchr
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define SDA 20
+#define SCL 21
+
+#define DEC 10
+#define HEX 16
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+#define _BV(bit) (1 << (bit))
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+typedef uint8_t byte;
+class __FlashStringHelper;
+
+// Interrupt vectors are plain functions, called by the tests
+#define ISR(vector) extern "C" void vector(void); void vector(void)
+#define cli()
+#define sei()
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// Fake clock: millis() is timer0_millis like in wiring.c, so code advancing it works unchanged
+extern volatile unsigned long timer0_millis;
+extern unsigned long hostMicros;
+void hostAdvanceMicros(unsigned long us);
+inline void hostAdvanceMillis(unsigned long ms)
+{
+    hostAdvanceMicros(ms * 1000UL);
+}
+inline unsigned long millis()
+{
+    return timer0_millis;
+}
+inline unsigned long micros()
+{
+    return hostMicros;
+}
+inline void delay(unsigned long ms)
+{
+    hostAdvanceMillis(ms);
+}
+inline void delayMicroseconds(unsigned int us)
+{
+    hostAdvanceMicros(us);
+}
+
+// Pins: levels are stored; a test can override digitalRead() to model a device holding a line
+#define HOST_PINS 70
+extern uint8_t hostPinLevel[HOST_PINS];
+extern uint8_t hostPinMode[HOST_PINS];
+extern int (*hostDigitalRead)(uint8_t pin);
+extern void (*hostDigitalWrite)(uint8_t pin, uint8_t level);
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+    hostPinMode[pin] = mode;
+    if (mode == INPUT_PULLUP)
+    {
+        hostPinLevel[pin] = HIGH;
+    }
+}
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+    hostPinLevel[pin] = level;
+    if (hostDigitalWrite)
+    {
+        hostDigitalWrite(pin, level);
+    }
+}
+inline int digitalRead(uint8_t pin)
+{
+    return hostDigitalRead ? hostDigitalRead(pin) : hostPinLevel[pin];
+}
+
+// Registers touched by the timer, watchdog and sleep code
+extern volatile uint8_t TCCR3A, TCCR3B, TIMSK3, WDTCSR, ADCSRA, PCIFR, PCMSK1, PCICR, EICRA, EIFR, EIMSK;
+extern volatile uint16_t TCNT3, OCR3A;
+#define WGM32 3
+#define CS32 2
+#define OCIE3A 1
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+#define WDIE 6
+#define PCIF1 1
+#define PCINT8 0
+#define PCIE1 1
+#define ISC20 4
+#define ISC21 5
+#define INTF2 2
+#define INT2 2
+
+/**
+ * Print as in the Arduino core, including its print-float routine
+ */
+class Print
+{
+private:
+    size_t printNumber(unsigned long n, uint8_t base)
+    {
+        char buf[8 * sizeof(long) + 1];
+        char *str = &buf[sizeof(buf) - 1];
+        *str = '\0';
+        if (base < 2)
+        {
+            base = 10;
+        }
+        do
+        {
+            char c = n % base;
+            n /= base;
+            *--str = c < 10 ? c + '0' : c + 'A' - 10;
+        } while (n);
+        return write(str);
+    }
+
+    size_t printFloat(double number, uint8_t digits)
+    {
+        size_t n = 0;
+        if (isnan(number))
+        {
+            return print("nan");
+        }
+        if (isinf(number))
+        {
+            return print("inf");
+        }
+        if (number > 4294967040.0 || number < -4294967040.0)
+        {
+            return print("ovf");
+        }
+        if (number < 0.0)
+        {
+            n += print('-');
+            number = -number;
+        }
+        double rounding = 0.5;
+        for (uint8_t i = 0; i < digits; ++i)
+        {
+            rounding /= 10.0;
+        }
+        number += rounding;
+        unsigned long intPart = (unsigned long)number;
+        double remainder = number - (double)intPart;
+        n += print(intPart);
+        if (digits > 0)
+        {
+            n += print('.');
+        }
+        while (digits-- > 0)
+        {
+            remainder *= 10.0;
+            unsigned int toPrint = (unsigned int)remainder;
+            n += print(toPrint);
+            remainder -= toPrint;
+        }
+        return n;
+    }
+
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+        {
+            if (!write(*buffer++))
+            {
+                break;
+            }
+            n++;
+        }
+        return n;
+    }
+    size_t write(const char *str)
+    {
+        return str ? write((const uint8_t *)str, strlen(str)) : 0;
+    }
+    size_t write(const char *buffer, size_t size)
+    {
+        return write((const uint8_t *)buffer, size);
+    }
+    virtual int availableForWrite()
+    {
+        return 0;
+    }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper *s)
+    {
+        return write((const char *)s);
+    }
+    size_t print(const char s[])
+    {
+        return write(s);
+    }
+    size_t print(char c)
+    {
+        return write((uint8_t)c);
+    }
+    size_t print(unsigned char b, int base = DEC)
+    {
+        return print((unsigned long)b, base);
+    }
+    size_t print(int n, int base = DEC)
+    {
+        return print((long)n, base);
+    }
+    size_t print(unsigned int n, int base = DEC)
+    {
+        return print((unsigned long)n, base);
+    }
+    size_t print(long n, int base = DEC)
+    {
+        if (base == 10 && n < 0)
+        {
+            size_t t = print('-');
+            return printNumber(-(unsigned long)n, 10) + t;
+        }
+        return printNumber((unsigned long)n, base);
+    }
+    size_t print(unsigned long n, int base = DEC)
+    {
+        return printNumber(n, base);
+    }
+    size_t print(double n, int digits = 2)
+    {
+        return printFloat(n, digits);
+    }
+
+    size_t println()
+    {
+        return write("\r\n");
+    }
+    template <typename T>
+    size_t println(T value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(T value, int format)
+    {
+        size_t n = print(value, format);
+        return n + println();
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+#define HOST_SERIAL_CAPTURE 16384
+
+/**
+ * A UART: input is fed by the test, output is captured. The hardware transmit buffer holds
+ * SERIAL_TX_BUFFER_SIZE - 1 bytes until drain() moves them onto the line; a write to a full
+ * buffer is where HardwareSerial would wait, and is counted in blockedWrites.
+ */
+class HardwareSerial : public Stream
+{
+private:
+    char rx[SERIAL_RX_BUFFER_SIZE * 16];
+    uint16_t rxHead;
+    uint16_t rxTail;
+
+public:
+    char output[HOST_SERIAL_CAPTURE];
+    size_t outputLength;
+    uint16_t pending;
+    uint32_t blockedWrites;
+
+    HardwareSerial()
+    {
+        reset();
+    }
+    void reset()
+    {
+        rxHead = 0;
+        rxTail = 0;
+        outputLength = 0;
+        output[0] = '\0';
+        pending = 0;
+        blockedWrites = 0;
+    }
+    void begin(unsigned long) {}
+    void feed(const char *text)
+    {
+        while (*text && rxHead < sizeof(rx))
+        {
+            rx[rxHead++] = *text++;
+        }
+    }
+    void clearOutput()
+    {
+        outputLength = 0;
+        output[0] = '\0';
+    }
+    // Moves up to count bytes from the transmit buffer onto the line
+    void drain(uint16_t count)
+    {
+        pending = count >= pending ? 0 : pending - count;
+    }
+
+    int available() override
+    {
+        return rxHead - rxTail;
+    }
+    int read() override
+    {
+        return rxTail < rxHead ? (uint8_t)rx[rxTail++] : -1;
+    }
+    int peek() override
+    {
+        return rxTail < rxHead ? (uint8_t)rx[rxTail] : -1;
+    }
+    size_t write(uint8_t c) override
+    {
+        if (pending >= SERIAL_TX_BUFFER_SIZE - 1)
+        {
+            blockedWrites++;
+            pending--;
+        }
+        pending++;
+        if (outputLength < HOST_SERIAL_CAPTURE - 1)
+        {
+            output[outputLength++] = c;
+            output[outputLength] = '\0';
+        }
+        return 1;
+    }
+    using Print::write;
+    int availableForWrite() override
+    {
+        return SERIAL_TX_BUFFER_SIZE - 1 - pending;
+    }
+    void flush() override
+    {
+        pending = 0;
+    }
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif
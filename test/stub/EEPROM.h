@@ -0,0 +1,72 @@
+/**
+ * @file EEPROM.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for the on-chip EEPROM, with write counting and power-loss injection
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <Arduino.h>
+
+#define HOST_EEPROM_SIZE 4096
+
+/**
+ * Cells start erased (0xFF). writesLeft simulates a power loss: once it reaches zero every
+ * further write is lost, so a record can be torn at any byte. -1 means no power loss.
+ */
+struct EEPROMClass
+{
+    uint8_t cells[HOST_EEPROM_SIZE];
+    uint16_t cellWrites[HOST_EEPROM_SIZE];
+    uint32_t writes;
+    int32_t writesLeft;
+
+    EEPROMClass()
+    {
+        erase();
+    }
+    void erase()
+    {
+        memset(cells, 0xFF, sizeof(cells));
+        memset(cellWrites, 0, sizeof(cellWrites));
+        writes = 0;
+        writesLeft = -1;
+    }
+    uint8_t read(int address)
+    {
+        return cells[address];
+    }
+    void write(int address, uint8_t value)
+    {
+        if (writesLeft == 0)
+        {
+            return;
+        }
+        if (writesLeft > 0)
+        {
+            writesLeft--;
+        }
+        cells[address] = value;
+        cellWrites[address]++;
+        writes++;
+    }
+    void update(int address, uint8_t value)
+    {
+        if (cells[address] != value)
+        {
+            write(address, value);
+        }
+    }
+    uint16_t length()
+    {
+        return HOST_EEPROM_SIZE;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
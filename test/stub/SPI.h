@@ -0,0 +1,13 @@
+/**
+ * @file SPI.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for the SPI library (unused)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef SPI_H
+#define SPI_H
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file Wire.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for the Wire library: a simulated bus with attachable devices and faults
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef TWOWIRE_H
+#define TWOWIRE_H
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+/**
+ * A slave on the simulated bus. The default is a register map with an auto-incrementing pointer
+ * set by the first byte written (BME680, DS3231); override receive()/transmit() for other
+ * protocols (the 24C32 EEPROM has a two-byte pointer).
+ */
+class HostI2CDevice
+{
+public:
+    uint8_t registers[256];
+    uint8_t pointer;
+    // Faults: no acknowledge at all, or the transaction hangs until the Wire timeout
+    bool absent;
+    bool hang;
+    // Traffic, in bytes, after the address
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+
+    HostI2CDevice()
+    {
+        memset(registers, 0, sizeof(registers));
+        pointer = 0;
+        absent = false;
+        hang = false;
+        bytesWritten = 0;
+        bytesRead = 0;
+    }
+    virtual ~HostI2CDevice() {}
+
+    // Returns false to NACK the data
+    virtual bool receive(const uint8_t *data, uint8_t length)
+    {
+        if (length > 0)
+        {
+            pointer = data[0];
+            for (uint8_t i = 1; i < length; i++)
+            {
+                onWrite(pointer, data[i]);
+                registers[pointer++] = data[i];
+            }
+        }
+        return true;
+    }
+    // Returns the number of bytes sent
+    virtual uint8_t transmit(uint8_t *data, uint8_t length)
+    {
+        for (uint8_t i = 0; i < length; i++)
+        {
+            data[i] = registers[pointer++];
+        }
+        return length;
+    }
+    // Called before a register is written
+    virtual void onWrite(uint8_t, uint8_t) {}
+    // Whether the address is acknowledged now (a device in a write cycle may refuse it)
+    virtual bool acknowledges()
+    {
+        return !absent;
+    }
+};
+
+class TwoWire : public Stream
+{
+private:
+    HostI2CDevice *devices[128];
+    uint8_t txAddress;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength;
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxLength;
+    uint8_t rxIndex;
+    bool timeoutFlag;
+
+    // A hang costs the whole timeout before the transaction is aborted
+    bool hung(HostI2CDevice *device)
+    {
+        if (device && device->hang)
+        {
+            hostAdvanceMicros(timeoutMicros);
+            timeoutFlag = true;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    bool started;
+    uint32_t timeoutMicros;
+    uint32_t transactions;
+
+    TwoWire()
+    {
+        memset(devices, 0, sizeof(devices));
+        reset();
+    }
+    void reset()
+    {
+        txLength = 0;
+        rxLength = 0;
+        rxIndex = 0;
+        timeoutFlag = false;
+        started = false;
+        timeoutMicros = 0;
+        transactions = 0;
+    }
+    void attach(uint8_t address, HostI2CDevice *device)
+    {
+        devices[address & 0x7F] = device;
+    }
+    void detachAll()
+    {
+        memset(devices, 0, sizeof(devices));
+    }
+
+    void begin()
+    {
+        started = true;
+    }
+    void end()
+    {
+        started = false;
+    }
+    void setClock(uint32_t) {}
+    void setWireTimeout(uint32_t timeout = 25000, bool = false)
+    {
+        timeoutMicros = timeout;
+    }
+    bool getWireTimeoutFlag()
+    {
+        return timeoutFlag;
+    }
+    void clearWireTimeoutFlag()
+    {
+        timeoutFlag = false;
+    }
+
+    void beginTransmission(uint8_t address)
+    {
+        txAddress = address & 0x7F;
+        txLength = 0;
+    }
+    size_t write(uint8_t data) override
+    {
+        if (txLength >= BUFFER_LENGTH)
+        {
+            return 0;
+        }
+        txBuffer[txLength++] = data;
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t length) override
+    {
+        size_t n = 0;
+        while (n < length && write(data[n]))
+        {
+            n++;
+        }
+        return n;
+    }
+    using Print::write;
+    uint8_t endTransmission(bool = true)
+    {
+        transactions++;
+        HostI2CDevice *device = devices[txAddress];
+        if (hung(device))
+        {
+            return 5;
+        }
+        if (!device || !device->acknowledges())
+        {
+            return 2;
+        }
+        device->bytesWritten += txLength;
+        return device->receive(txBuffer, txLength) ? 0 : 3;
+    }
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t = 1)
+    {
+        transactions++;
+        rxLength = 0;
+        rxIndex = 0;
+        HostI2CDevice *device = devices[address & 0x7F];
+        if (hung(device) || !device || !device->acknowledges())
+        {
+            return 0;
+        }
+        if (quantity > BUFFER_LENGTH)
+        {
+            quantity = BUFFER_LENGTH;
+        }
+        rxLength = device->transmit(rxBuffer, quantity);
+        device->bytesRead += rxLength;
+        return rxLength;
+    }
+    int available() override
+    {
+        return rxLength - rxIndex;
+    }
+    int read() override
+    {
+        return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+    }
+    int peek() override
+    {
+        return rxIndex < rxLength ? rxBuffer[rxIndex] : -1;
+    }
+};
+
+extern TwoWire Wire;
+
+#endif
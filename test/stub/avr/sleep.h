@@ -0,0 +1,36 @@
+/**
+ * @file sleep.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for avr/sleep.h: sleep_cpu() runs a hook set by the test
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef AVR_SLEEP_H
+#define AVR_SLEEP_H
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 2
+
+// The hook stands for the time asleep and the interrupt that ends it
+extern uint8_t hostSleepMode;
+extern void (*hostSleepHook)(uint8_t mode);
+
+inline void set_sleep_mode(uint8_t mode)
+{
+    hostSleepMode = mode;
+}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+inline void sleep_cpu()
+{
+    if (hostSleepHook)
+    {
+        hostSleepHook(hostSleepMode);
+    }
+}
+
+#endif
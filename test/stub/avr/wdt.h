@@ -0,0 +1,21 @@
+/**
+ * @file wdt.h
+ * @author Riccardo Iacob
+ * @brief Host stand-in for avr/wdt.h
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef AVR_WDT_H
+#define AVR_WDT_H
+
+#include <Arduino.h>
+
+inline void wdt_reset() {}
+inline void wdt_disable()
+{
+    WDTCSR = 0;
+}
+
+#endif
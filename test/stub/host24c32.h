@@ -0,0 +1,86 @@
+/**
+ * @file host24c32.h
+ * @author Riccardo Iacob
+ * @brief Simulated AT24C32 I2C EEPROM for the sample log tests
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef HOST24C32_H
+#define HOST24C32_H
+
+#include <Wire.h>
+
+#include "samplelog.h"
+
+#define EEPROM_ADDRESS 0x57
+// Internal write cycle of the simulated EEPROM, in microseconds
+#define WRITE_CYCLE_US 5000UL
+
+/**
+ * AT24C32: two-byte address pointer, writes wrap within a 32-byte page, and the device does not
+ * acknowledge its address for WRITE_CYCLE_US after a write
+ */
+class Host24C32 : public HostI2CDevice
+{
+public:
+    uint8_t memory[SampleLog::CAPACITY];
+    uint16_t address;
+    unsigned long busyUntil;
+    bool busy;
+    uint32_t writes;
+    uint32_t refused;
+
+    Host24C32()
+    {
+        memset(memory, 0xFF, sizeof(memory));
+        address = 0;
+        busy = false;
+        busyUntil = 0;
+        writes = 0;
+        refused = 0;
+    }
+    bool acknowledges() override
+    {
+        if (busy && (long)(hostMicros - busyUntil) < 0)
+        {
+            refused++;
+            return false;
+        }
+        busy = false;
+        return !absent;
+    }
+    bool receive(const uint8_t *data, uint8_t length) override
+    {
+        if (length < 2)
+        {
+            return true;
+        }
+        address = (((uint16_t)data[0] << 8) | data[1]) % SampleLog::CAPACITY;
+        if (length > 2)
+        {
+            uint16_t page = address & ~(SampleLog::PAGE_SIZE - 1);
+            for (uint8_t i = 2; i < length; i++)
+            {
+                memory[address] = data[i];
+                address = page | ((address + 1) & (SampleLog::PAGE_SIZE - 1));
+            }
+            writes++;
+            busy = true;
+            busyUntil = hostMicros + WRITE_CYCLE_US;
+        }
+        return true;
+    }
+    uint8_t transmit(uint8_t *data, uint8_t length) override
+    {
+        for (uint8_t i = 0; i < length; i++)
+        {
+            data[i] = memory[address];
+            address = (address + 1) % SampleLog::CAPACITY;
+        }
+        return length;
+    }
+};
+
+#endif
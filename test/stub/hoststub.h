@@ -0,0 +1,46 @@
+/**
+ * @file hoststub.h
+ * @author Riccardo Iacob
+ * @brief Definitions behind the host stand-ins; include once in every test program
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#ifndef HOSTSTUB_H
+#define HOSTSTUB_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <EEPROM.h>
+#include <avr/sleep.h>
+
+volatile unsigned long timer0_millis = 0;
+unsigned long hostMicros = 0;
+static unsigned long hostMicrosRemainder = 0;
+
+void hostAdvanceMicros(unsigned long us)
+{
+    hostMicros += us;
+    hostMicrosRemainder += us;
+    timer0_millis += hostMicrosRemainder / 1000;
+    hostMicrosRemainder %= 1000;
+}
+
+uint8_t hostPinLevel[HOST_PINS];
+uint8_t hostPinMode[HOST_PINS];
+int (*hostDigitalRead)(uint8_t pin) = nullptr;
+void (*hostDigitalWrite)(uint8_t pin, uint8_t level) = nullptr;
+
+volatile uint8_t TCCR3A, TCCR3B, TIMSK3, WDTCSR, ADCSRA, PCIFR, PCMSK1, PCICR, EICRA, EIFR, EIMSK;
+volatile uint16_t TCNT3, OCR3A;
+
+uint8_t hostSleepMode = 0;
+void (*hostSleepHook)(uint8_t mode) = nullptr;
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+#endif
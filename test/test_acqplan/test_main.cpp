@@ -0,0 +1,188 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Multi-rate acquisition planning: aligned due times, grouped channels and forced channels
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "acqplan.h"
+
+#define ALL_CHANNELS (channel_temperature | channel_humidity | channel_pressure | channel_gas)
+
+// A wall clock well past the epoch, so due times are not small numbers
+#define T0 1790000000UL
+
+/**
+ * Runs the firmware's loop once a second for `seconds`: plan, and commit the conversion when a
+ * channel is due. Counts the conversions measuring each channel into `counts`
+ */
+static void run(AcquisitionPlanner *planner, uint32_t start, uint32_t seconds, uint8_t available, uint16_t *counts)
+{
+    for (uint32_t now = start; now < start + seconds; now++)
+    {
+        uint8_t channels = planner->plan(now, available);
+        if (channels == 0)
+        {
+            continue;
+        }
+        planner->commit(channels, now, available);
+        for (uint8_t c = 0; c < AcquisitionPlanner::CHANNELS; c++)
+        {
+            counts[c] += (channels >> c) & 1;
+        }
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_every_conversion_by_default(void)
+{
+    AcquisitionPlanner planner;
+    for (uint32_t now = T0; now < T0 + 10; now++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(ALL_CHANNELS, planner.plan(now, ALL_CHANNELS));
+        TEST_ASSERT_EQUAL_UINT32(now, planner.getNextDue(now, ALL_CHANNELS));
+        planner.commit(ALL_CHANNELS, now, ALL_CHANNELS);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, planner.getConversions());
+    TEST_ASSERT_EQUAL_UINT32(0, planner.getSkippedReadings());
+    // Only the available channels are planned
+    TEST_ASSERT_EQUAL_UINT8(channel_temperature | channel_humidity,
+                            planner.plan(T0 + 10, channel_temperature | channel_humidity));
+}
+
+void test_commensurate_periods_share_conversions(void)
+{
+    AcquisitionPlanner planner;
+    planner.setPeriod(0, 3);
+    planner.setPeriod(1, 3);
+    planner.setPeriod(2, 60);
+    planner.setPeriod(3, 3);
+    // Starting off a multiple: the first conversion is immediate, the next ones on multiples
+    uint32_t start = (T0 / 60) * 60 + 1;
+    uint16_t counts[AcquisitionPlanner::CHANNELS] = {0, 0, 0, 0};
+    run(&planner, start, 599, ALL_CHANNELS, counts);
+    // 1 + 199 multiples of 3, 1 + 9 multiples of 60
+    TEST_ASSERT_EQUAL_UINT32(200, planner.getConversions());
+    TEST_ASSERT_EQUAL_UINT16(200, counts[0]);
+    TEST_ASSERT_EQUAL_UINT16(200, counts[1]);
+    TEST_ASSERT_EQUAL_UINT16(10, counts[2]);
+    TEST_ASSERT_EQUAL_UINT16(200, counts[3]);
+    TEST_ASSERT_EQUAL_UINT32(190, planner.getSkippedReadings());
+
+    // The next multiple of 60 is one of 3 too: every channel on one conversion
+    TEST_ASSERT_EQUAL_UINT32(start + 599, planner.getNextDue(start + 598, ALL_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT8(ALL_CHANNELS, planner.plan(start + 599, ALL_CHANNELS));
+}
+
+void test_humidity_and_pressure_measure_temperature(void)
+{
+    AcquisitionPlanner planner;
+    planner.setPeriod(0, 60);
+    planner.setPeriod(1, 10);
+    planner.setPeriod(2, 0);
+    planner.setPeriod(3, 60);
+    uint16_t counts[AcquisitionPlanner::CHANNELS] = {0, 0, 0, 0};
+    run(&planner, T0, 120, ALL_CHANNELS, counts);
+    // Pressure on every conversion drags the temperature along
+    TEST_ASSERT_EQUAL_UINT32(120, planner.getConversions());
+    TEST_ASSERT_EQUAL_UINT16(120, counts[0]);
+    TEST_ASSERT_EQUAL_UINT16(120, counts[2]);
+    TEST_ASSERT_TRUE(counts[1] <= 13);
+    TEST_ASSERT_TRUE(counts[3] <= 3);
+
+    // Without pressure, the temperature only comes with humidity
+    AcquisitionPlanner other;
+    other.setPeriod(0, 60);
+    other.setPeriod(1, 10);
+    uint8_t available = channel_temperature | channel_humidity;
+    TEST_ASSERT_EQUAL_UINT8(available, other.plan(T0, available));
+    other.commit(available, T0, available);
+    uint32_t next = (T0 / 10 + 1) * 10;
+    TEST_ASSERT_EQUAL_UINT32(next, other.getNextDue(T0, available));
+    TEST_ASSERT_EQUAL_UINT8(0, other.plan(next - 1, available));
+    TEST_ASSERT_EQUAL_UINT8(available, other.plan(next, available));
+}
+
+void test_next_due(void)
+{
+    AcquisitionPlanner planner;
+    planner.setPeriod(0, 30);
+    planner.setPeriod(1, 30);
+    planner.setPeriod(2, 60);
+    planner.setPeriod(3, 20);
+    uint32_t now = (T0 / 60) * 60;
+    planner.commit(ALL_CHANNELS, now, ALL_CHANNELS);
+    TEST_ASSERT_EQUAL_UINT32(now + 20, planner.getNextDue(now, ALL_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT32(now + 30, planner.getNextDue(now, channel_temperature | channel_pressure));
+    TEST_ASSERT_EQUAL_UINT8(channel_gas, planner.plan(now + 20, ALL_CHANNELS));
+    // A period change makes the channel due at once
+    planner.setPeriod(2, 120);
+    TEST_ASSERT_EQUAL_UINT32(now + 1, planner.getNextDue(now + 1, ALL_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT16(120, planner.getPeriod(2));
+    TEST_ASSERT_EQUAL_UINT16(0, planner.getPeriod(AcquisitionPlanner::CHANNELS));
+}
+
+void test_clock_set_back(void)
+{
+    AcquisitionPlanner planner;
+    planner.setPeriod(2, 60);
+    planner.commit(ALL_CHANNELS, T0, ALL_CHANNELS);
+    TEST_ASSERT_EQUAL_UINT8(channel_temperature | channel_humidity | channel_gas, planner.plan(T0 + 1, ALL_CHANNELS));
+    // From uptime to the RTC and back: the due time is far ahead, which only a set back clock explains
+    TEST_ASSERT_EQUAL_UINT8(ALL_CHANNELS, planner.plan(1000, ALL_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT32(1000, planner.getNextDue(1000, channel_pressure));
+    planner.commit(ALL_CHANNELS, 1000, ALL_CHANNELS);
+    TEST_ASSERT_EQUAL_UINT32(1020, planner.getNextDue(1000, channel_pressure));
+}
+
+void test_forced_channels(void)
+{
+    AcquisitionPlanner planner;
+    planner.setPeriod(0, 3);
+    planner.setPeriod(1, 3);
+    planner.setPeriod(2, 60);
+    planner.setPeriod(3, 60);
+    uint32_t start = (T0 / 60) * 60;
+    uint16_t counts[AcquisitionPlanner::CHANNELS] = {0, 0, 0, 0};
+    // During gas burn-in, gas is due on every conversion, whatever its period
+    planner.setForced(channel_gas);
+    TEST_ASSERT_EQUAL_UINT32(start + 1, planner.getNextDue(start + 1, channel_gas));
+    run(&planner, start, 120, channel_temperature | channel_humidity | channel_pressure, counts);
+    run(&planner, start + 120, 120, ALL_CHANNELS, counts);
+    TEST_ASSERT_EQUAL_UINT16(120, counts[3]);
+    TEST_ASSERT_EQUAL_UINT16(80, counts[0]);
+
+    // Released, gas is back on its period, aligned to the wall clock
+    planner.setForced(0);
+    uint32_t now = start + 240;
+    uint16_t after[AcquisitionPlanner::CHANNELS] = {0, 0, 0, 0};
+    run(&planner, now, 120, ALL_CHANNELS, after);
+    TEST_ASSERT_EQUAL_UINT16(2, after[3]);
+    TEST_ASSERT_EQUAL_UINT16(40, after[0]);
+
+    char message[80];
+    snprintf(message, sizeof(message), "%lu conversions, %lu readings skipped", (unsigned long)planner.getConversions(),
+             (unsigned long)planner.getSkippedReadings());
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_conversion_by_default);
+    RUN_TEST(test_commensurate_periods_share_conversions);
+    RUN_TEST(test_humidity_and_pressure_measure_temperature);
+    RUN_TEST(test_next_due);
+    RUN_TEST(test_clock_set_back);
+    RUN_TEST(test_forced_channels);
+    return UNITY_END();
+}
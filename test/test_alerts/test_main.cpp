@@ -0,0 +1,253 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Alert rules: dwell, hysteresis, stale channels, levels and the event queue
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+
+#include "alerts.h"
+
+enum TestRules
+{
+    rule_hot,
+    rule_dry,
+    rule_dew,
+    rule_pressure,
+    rule_count
+};
+
+static const AlertEngine::Rule rules[rule_count] PROGMEM = {
+    // Above 30.00 °C for 3 samples, clears below 29.50 °C
+    {AlertEngine::source_temperature, 0, AlertEngine::level_warning, 3, 50, 3000},
+    // Below 20.00 % for 2 samples, clears above 25.00 %
+    {AlertEngine::source_humidity, AlertEngine::rule_below, AlertEngine::level_info, 2, 500, 2000},
+    // Dew point above 20.00 °C, immediately
+    {AlertEngine::source_dew_point, 0, AlertEngine::level_alarm, 1, 0, 2000},
+    // Pressure below 950 hPa for 4 samples
+    {AlertEngine::source_pressure, AlertEngine::rule_below, AlertEngine::level_warning, 4, 100, 95000}};
+
+static DerivedMetrics derived;
+
+static SampleRecord makeSample(int16_t centiC, uint16_t centiRh, uint32_t pascal)
+{
+    SampleRecord sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.temperature = centiC;
+    sample.humidity = centiRh;
+    sample.pressure = pascal;
+    sample.channels = channel_temperature | channel_humidity | channel_pressure;
+    return sample;
+}
+
+static void feed(AlertEngine &engine, SampleRecord sample)
+{
+    derived.update(&sample);
+    engine.evaluate(&sample, &derived);
+}
+
+static void feedTemperature(AlertEngine &engine, int16_t centiC)
+{
+    feed(engine, makeSample(centiC, 4000, 101325));
+}
+
+static uint8_t drainEvents(AlertEngine &engine)
+{
+    AlertEngine::AlertEvent event;
+    uint8_t count = 0;
+    while (engine.popEvent(event))
+    {
+        count++;
+    }
+    return count;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_dwell_needs_consecutive_samples(void)
+{
+    AlertEngine engine(rules, rule_count);
+    // Two samples over, one under: the count starts again
+    feedTemperature(engine, 3100);
+    feedTemperature(engine, 3100);
+    feedTemperature(engine, 2900);
+    feedTemperature(engine, 3100);
+    feedTemperature(engine, 3100);
+    TEST_ASSERT_FALSE(engine.isActive(rule_hot));
+    AlertEngine::AlertEvent event;
+    TEST_ASSERT_FALSE(engine.popEvent(event));
+
+    // The third in a row raises it, with the value that did
+    feedTemperature(engine, 3150);
+    TEST_ASSERT_TRUE(engine.isActive(rule_hot));
+    TEST_ASSERT_TRUE(engine.popEvent(event));
+    TEST_ASSERT_EQUAL_UINT8(rule_hot, event.rule);
+    TEST_ASSERT_TRUE(event.active);
+    TEST_ASSERT_EQUAL_INT32(3150, event.value);
+    TEST_ASSERT_FALSE(engine.popEvent(event));
+    TEST_ASSERT_EQUAL_UINT8(AlertEngine::level_warning, engine.getLevel());
+}
+
+void test_hysteresis_band_holds(void)
+{
+    AlertEngine engine(rules, rule_count);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        feedTemperature(engine, 3100);
+    }
+    TEST_ASSERT_TRUE(engine.isActive(rule_hot));
+    drainEvents(engine);
+
+    // Inside the band, 29.50 to 30.00 °C (the edge included), it stays active however long
+    for (uint16_t i = 0; i < 500; i++)
+    {
+        feedTemperature(engine, 2950 + (i % 51));
+    }
+    TEST_ASSERT_TRUE(engine.isActive(rule_hot));
+    TEST_ASSERT_EQUAL_UINT8(0, drainEvents(engine));
+
+    // Below the band, but interrupted before the dwell is reached
+    feedTemperature(engine, 2900);
+    feedTemperature(engine, 2900);
+    feedTemperature(engine, 2960);
+    feedTemperature(engine, 2900);
+    feedTemperature(engine, 2900);
+    TEST_ASSERT_TRUE(engine.isActive(rule_hot));
+
+    feedTemperature(engine, 2949);
+    TEST_ASSERT_FALSE(engine.isActive(rule_hot));
+    AlertEngine::AlertEvent event;
+    TEST_ASSERT_TRUE(engine.popEvent(event));
+    TEST_ASSERT_FALSE(event.active);
+    TEST_ASSERT_EQUAL_INT32(2949, event.value);
+    TEST_ASSERT_EQUAL_UINT8(AlertEngine::level_none, engine.getLevel());
+}
+
+void test_noisy_signal_does_not_chatter(void)
+{
+    // A value wandering +/-40 around the threshold, less than the hysteresis
+    AlertEngine engine(rules, rule_count);
+    uint32_t state = 1;
+    uint16_t raised = 0;
+    uint16_t cleared = 0;
+    for (uint16_t i = 0; i < 5000; i++)
+    {
+        state = state * 1103515245UL + 12345;
+        feedTemperature(engine, 3000 + (int16_t)((state >> 16) % 81) - 40);
+        AlertEngine::AlertEvent event;
+        while (engine.popEvent(event))
+        {
+            event.active ? raised++ : cleared++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(1, raised);
+    TEST_ASSERT_EQUAL_UINT16(0, cleared);
+}
+
+void test_below_rule(void)
+{
+    AlertEngine engine(rules, rule_count);
+    feed(engine, makeSample(2000, 1900, 101325));
+    TEST_ASSERT_FALSE(engine.isActive(rule_dry));
+    feed(engine, makeSample(2000, 1900, 101325));
+    TEST_ASSERT_TRUE(engine.isActive(rule_dry));
+
+    // Back above the threshold but inside the band: still dry
+    feed(engine, makeSample(2000, 2400, 101325));
+    feed(engine, makeSample(2000, 2500, 101325));
+    feed(engine, makeSample(2000, 2500, 101325));
+    TEST_ASSERT_TRUE(engine.isActive(rule_dry));
+    feed(engine, makeSample(2000, 2501, 101325));
+    feed(engine, makeSample(2000, 2600, 101325));
+    TEST_ASSERT_FALSE(engine.isActive(rule_dry));
+    TEST_ASSERT_EQUAL_UINT8(2, drainEvents(engine));
+}
+
+void test_stale_channels_keep_their_count(void)
+{
+    AlertEngine engine(rules, rule_count);
+    SampleRecord low = makeSample(2000, 4000, 94000);
+    feed(engine, low);
+    feed(engine, low);
+    feed(engine, low);
+
+    // Samples without a fresh pressure (multi-rate acquisition) neither count nor reset
+    SampleRecord noPressure = makeSample(2000, 4000, 101325);
+    noPressure.channels &= ~channel_pressure;
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        feed(engine, noPressure);
+    }
+    TEST_ASSERT_FALSE(engine.isActive(rule_pressure));
+    feed(engine, low);
+    TEST_ASSERT_TRUE(engine.isActive(rule_pressure));
+
+    // A derived source needs every input fresh
+    SampleRecord humid = makeSample(2800, 9000, 101325);
+    humid.channels &= ~channel_humidity;
+    feed(engine, humid);
+    TEST_ASSERT_FALSE(engine.isActive(rule_dew));
+}
+
+void test_derived_source_and_levels(void)
+{
+    AlertEngine engine(rules, rule_count);
+    // 28 °C at 90 % has a dew point of about 26 °C: the alarm rule fires on the first sample
+    feed(engine, makeSample(2800, 9000, 101325));
+    TEST_ASSERT_TRUE(engine.isActive(rule_dew));
+    TEST_ASSERT_EQUAL_UINT8(AlertEngine::level_alarm, engine.getLevel());
+    AlertEngine::AlertEvent event;
+    TEST_ASSERT_TRUE(engine.popEvent(event));
+    TEST_ASSERT_EQUAL_UINT8(rule_dew, event.rule);
+    TEST_ASSERT_INT32_WITHIN(10, 2617, event.value);
+
+    // With a warning active as well, the alarm still decides the level; once the alarm clears the
+    // warning does
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        feed(engine, makeSample(3100, 9000, 101325));
+    }
+    TEST_ASSERT_EQUAL_UINT8(AlertEngine::level_alarm, engine.getLevel());
+    feed(engine, makeSample(3100, 3000, 101325));
+    TEST_ASSERT_FALSE(engine.isActive(rule_dew));
+    TEST_ASSERT_TRUE(engine.isActive(rule_hot));
+    TEST_ASSERT_EQUAL_UINT8(AlertEngine::level_warning, engine.getLevel());
+    TEST_ASSERT_FALSE(engine.isActive(rule_count));
+}
+
+void test_event_queue_overflow(void)
+{
+    AlertEngine engine(rules, rule_count);
+    // The dew point rule toggles on every sample: more changes than the queue holds
+    for (uint8_t i = 0; i < AlertEngine::EVENT_QUEUE_LENGTH + 5; i++)
+    {
+        feed(engine, makeSample(2800, (i & 1) ? 3000 : 9000, 101325));
+    }
+    TEST_ASSERT_EQUAL_UINT16(5, engine.getLostEvents());
+    AlertEngine::AlertEvent event;
+    for (uint8_t i = 0; i < AlertEngine::EVENT_QUEUE_LENGTH; i++)
+    {
+        TEST_ASSERT_TRUE(engine.popEvent(event));
+        TEST_ASSERT_EQUAL(!(i & 1), event.active);
+    }
+    TEST_ASSERT_FALSE(engine.popEvent(event));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dwell_needs_consecutive_samples);
+    RUN_TEST(test_hysteresis_band_holds);
+    RUN_TEST(test_noisy_signal_does_not_chatter);
+    RUN_TEST(test_below_rule);
+    RUN_TEST(test_stale_channels_keep_their_count);
+    RUN_TEST(test_derived_source_and_levels);
+    RUN_TEST(test_event_queue_overflow);
+    return UNITY_END();
+}
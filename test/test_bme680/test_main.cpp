@@ -0,0 +1,383 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief BME680 driver on a simulated chip: calibration parsing, compensation against the Bosch
+ * floating point formulas, and the control registers written per measured channel
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "bme680.h"
+#include "i2cbus.h"
+
+#define BME_ADDRESS 0x77
+
+typedef BME680::BMECalibrationRegistersAddresses cal;
+
+// A calibration set of a production part
+static const uint16_t PAR_T1 = 26125;
+static const int16_t PAR_T2 = 26370;
+static const int8_t PAR_T3 = 3;
+static const uint16_t PAR_P1 = 36136;
+static const int16_t PAR_P2 = -10378;
+static const int8_t PAR_P3 = 88;
+static const int16_t PAR_P4 = 6908;
+static const int16_t PAR_P5 = -29;
+static const int8_t PAR_P6 = 30;
+static const int8_t PAR_P7 = 30;
+static const int16_t PAR_P8 = -2891;
+static const int16_t PAR_P9 = -2390;
+static const uint8_t PAR_P10 = 30;
+static const uint16_t PAR_H1 = 782;
+static const uint16_t PAR_H2 = 1014;
+static const int8_t PAR_H3 = 0;
+static const int8_t PAR_H4 = 45;
+static const int8_t PAR_H5 = 20;
+static const uint8_t PAR_H6 = 120;
+static const int8_t PAR_H7 = -100;
+static const int8_t PAR_GH1 = -30;
+static const int16_t PAR_GH2 = -12826;
+static const int8_t PAR_GH3 = 18;
+static const int8_t RES_HEAT_VAL = 42;
+static const uint8_t RES_HEAT_RANGE = 1;
+static const int8_t RANGE_SW_ERR = -2;
+
+// A chip that counts the writes to each register
+class SimulatedChip : public HostI2CDevice
+{
+public:
+    uint16_t writes[256];
+
+    SimulatedChip()
+    {
+        memset(writes, 0, sizeof(writes));
+    }
+    void onWrite(uint8_t address, uint8_t) override
+    {
+        writes[address]++;
+    }
+};
+
+static SimulatedChip chip;
+static BME680::BMEConfig config;
+static BME680::BMECalibrationParameters calibration;
+static BME680 sensor(BME_ADDRESS);
+
+static void put16(uint8_t lsb, uint8_t msb, uint16_t value)
+{
+    chip.registers[lsb] = value & 0xFF;
+    chip.registers[msb] = value >> 8;
+}
+
+static void loadCalibration()
+{
+    chip.registers[BME680::ADD_ID] = BME680_CHIP_ID;
+    put16(cal::ADD_T1_LSB, cal::ADD_T1_MSB, PAR_T1);
+    put16(cal::ADD_T2_LSB, cal::ADD_T2_MSB, PAR_T2);
+    chip.registers[cal::ADD_T3] = PAR_T3;
+    put16(cal::ADD_P1_LSB, cal::ADD_P1_MSB, PAR_P1);
+    put16(cal::ADD_P2_LSB, cal::ADD_P2_MSB, PAR_P2);
+    chip.registers[cal::ADD_P3] = PAR_P3;
+    put16(cal::ADD_P4_LSB, cal::ADD_P4_MSB, PAR_P4);
+    put16(cal::ADD_P5_LSB, cal::ADD_P5_MSB, PAR_P5);
+    chip.registers[cal::ADD_P6] = PAR_P6;
+    chip.registers[cal::ADD_P7] = PAR_P7;
+    put16(cal::ADD_P8_LSB, cal::ADD_P8_MSB, PAR_P8);
+    put16(cal::ADD_P9_LSB, cal::ADD_P9_MSB, PAR_P9);
+    chip.registers[cal::ADD_P10] = PAR_P10;
+    // 12-bit humidity parameters sharing 0xE2
+    chip.registers[cal::ADD_H1_MSB] = PAR_H1 >> 4;
+    chip.registers[cal::ADD_H2_MSB] = PAR_H2 >> 4;
+    chip.registers[cal::ADD_H1_LSB] = ((PAR_H2 & 0x0F) << 4) | (PAR_H1 & 0x0F);
+    chip.registers[cal::ADD_H3] = PAR_H3;
+    chip.registers[cal::ADD_H4] = PAR_H4;
+    chip.registers[cal::ADD_H5] = PAR_H5;
+    chip.registers[cal::ADD_H6] = PAR_H6;
+    chip.registers[cal::ADD_H7] = PAR_H7;
+    chip.registers[cal::ADD_GH1] = PAR_GH1;
+    put16(cal::ADD_GH2_LSB, cal::ADD_GH2_MSB, PAR_GH2);
+    chip.registers[cal::ADD_GH3] = PAR_GH3;
+    chip.registers[cal::ADD_RES_HEAT_VAL] = RES_HEAT_VAL;
+    // Other bits of these registers are set, the driver must mask them out
+    chip.registers[cal::ADD_RES_HEAT_RANGE] = (RES_HEAT_RANGE << 4) | 0xC5;
+    chip.registers[cal::ADD_RANGE_SW_ERR] = (uint8_t)(RANGE_SW_ERR * 16) | 0x0A;
+}
+
+// The floating point compensation of the Bosch Sensor API, in double precision
+static double referenceTFine(uint32_t adc)
+{
+    double var1 = (adc / 16384.0 - PAR_T1 / 1024.0) * PAR_T2;
+    double var2 = (adc / 131072.0 - PAR_T1 / 8192.0) * (adc / 131072.0 - PAR_T1 / 8192.0) * (PAR_T3 * 16.0);
+    return var1 + var2;
+}
+
+static double referencePressure(uint32_t adc, double tFine)
+{
+    double var1 = tFine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * (PAR_P6 / 131072.0);
+    var2 = var2 + var1 * PAR_P5 * 2.0;
+    var2 = var2 / 4.0 + PAR_P4 * 65536.0;
+    var1 = (PAR_P3 * var1 * var1 / 16384.0 + PAR_P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * PAR_P1;
+    double pressure = 1048576.0 - adc;
+    pressure = (pressure - var2 / 4096.0) * 6250.0 / var1;
+    var1 = PAR_P9 * pressure * pressure / 2147483648.0;
+    var2 = pressure * (PAR_P8 / 32768.0);
+    double var3 = (pressure / 256.0) * (pressure / 256.0) * (pressure / 256.0) * (PAR_P10 / 131072.0);
+    return pressure + (var1 + var2 + var3 + PAR_P7 * 128.0) / 16.0;
+}
+
+static double referenceHumidity(uint32_t adc, double tFine)
+{
+    double celsius = tFine / 5120.0;
+    double var1 = adc - (PAR_H1 * 16.0 + PAR_H3 / 2.0 * celsius);
+    double var2 = var1 * (PAR_H2 / 262144.0 * (1.0 + PAR_H4 / 16384.0 * celsius + PAR_H5 / 1048576.0 * celsius * celsius));
+    double var3 = PAR_H6 / 16384.0;
+    double var4 = PAR_H7 / 2097152.0;
+    double humidity = var2 + (var3 + var4 * celsius) * var2 * var2;
+    return humidity > 100 ? 100 : humidity < 0 ? 0 : humidity;
+}
+
+static double referenceGasResistance(uint16_t adc, uint8_t range)
+{
+    static const double k1[16] = {0, 0, 0, 0, 0, -1, 0, -0.8, 0, 0, -0.2, -0.5, 0, -1, 0, 0};
+    static const double k2[16] = {0, 0, 0, 0, 0.1, 0.7, 0, -0.8, -0.1, 0, 0, 0, 0, 0, 0, 0};
+    double var1 = 1340.0 + 5.0 * RANGE_SW_ERR;
+    double var2 = var1 * (1.0 + k1[range] / 100.0);
+    double var3 = 1.0 + k2[range] / 100.0;
+    return 1.0 / (var3 * 0.000000125 * (double)(1UL << range) * ((adc - 512.0) / var2 + 1.0));
+}
+
+static void report(const char *what, double worst, const char *unit)
+{
+    char message[80];
+    snprintf(message, sizeof(message), "%s: largest error %.4f %s", what, worst, unit);
+    TEST_MESSAGE(message);
+}
+
+void setUp(void)
+{
+    Wire.reset();
+    Wire.detachAll();
+    chip = SimulatedChip();
+    loadCalibration();
+    Wire.attach(BME_ADDRESS, &chip);
+    memset(&calibration, 0, sizeof(calibration));
+    sensor = BME680(BME_ADDRESS);
+    sensor.config = &config;
+    sensor.calibration = &calibration;
+    sensor.setDefaultConfig();
+}
+
+void tearDown(void) {}
+
+void test_begin_reads_calibration(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    TEST_ASSERT_EQUAL_UINT16(1, chip.writes[BME680::ADD_RESET]);
+    TEST_ASSERT_EQUAL_UINT16(PAR_T1, calibration.par_t1);
+    TEST_ASSERT_EQUAL_INT16(PAR_T2, calibration.par_t2);
+    TEST_ASSERT_EQUAL_INT8(PAR_T3, calibration.par_t3);
+    TEST_ASSERT_EQUAL_UINT16(PAR_P1, calibration.par_p1);
+    TEST_ASSERT_EQUAL_INT16(PAR_P2, calibration.par_p2);
+    TEST_ASSERT_EQUAL_INT8(PAR_P3, calibration.par_p3);
+    TEST_ASSERT_EQUAL_INT16(PAR_P4, calibration.par_p4);
+    TEST_ASSERT_EQUAL_INT16(PAR_P5, calibration.par_p5);
+    TEST_ASSERT_EQUAL_INT8(PAR_P6, calibration.par_p6);
+    TEST_ASSERT_EQUAL_INT8(PAR_P7, calibration.par_p7);
+    TEST_ASSERT_EQUAL_INT16(PAR_P8, calibration.par_p8);
+    TEST_ASSERT_EQUAL_INT16(PAR_P9, calibration.par_p9);
+    TEST_ASSERT_EQUAL_UINT8(PAR_P10, calibration.par_p10);
+    TEST_ASSERT_EQUAL_UINT16(PAR_H1, calibration.par_h1);
+    TEST_ASSERT_EQUAL_UINT16(PAR_H2, calibration.par_h2);
+    TEST_ASSERT_EQUAL_INT8(PAR_H3, calibration.par_h3);
+    TEST_ASSERT_EQUAL_INT8(PAR_H4, calibration.par_h4);
+    TEST_ASSERT_EQUAL_INT8(PAR_H5, calibration.par_h5);
+    TEST_ASSERT_EQUAL_UINT8(PAR_H6, calibration.par_h6);
+    TEST_ASSERT_EQUAL_INT8(PAR_H7, calibration.par_h7);
+    TEST_ASSERT_EQUAL_INT8(PAR_GH1, calibration.par_gh1);
+    TEST_ASSERT_EQUAL_INT16(PAR_GH2, calibration.par_gh2);
+    TEST_ASSERT_EQUAL_INT8(PAR_GH3, calibration.par_gh3);
+    TEST_ASSERT_EQUAL_INT8(RES_HEAT_VAL, calibration.res_heat_val);
+    TEST_ASSERT_EQUAL_UINT8(RES_HEAT_RANGE, calibration.res_heat_range);
+    TEST_ASSERT_EQUAL_INT8(RANGE_SW_ERR, calibration.range_sw_err);
+
+    // Any other chip id is refused
+    chip.registers[BME680::ADD_ID] = 0x60;
+    TEST_ASSERT_FALSE(sensor.begin());
+}
+
+void test_raw_reads(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    // 20-bit temperature and pressure (xlsb<7:4>), 16-bit humidity, 10-bit gas with its flags
+    chip.registers[BME680::ADD_TEMP_MSB] = 0x7A;
+    chip.registers[BME680::ADD_TEMP_LSB] = 0xBC;
+    chip.registers[BME680::ADD_TEMP_XLSB] = 0xD5;
+    chip.registers[BME680::ADD_PRESS_MSB] = 0x4E;
+    chip.registers[BME680::ADD_PRESS_LSB] = 0x21;
+    chip.registers[BME680::ADD_PRESS_XLSB] = 0x9F;
+    chip.registers[BME680::ADD_HUM_MSB] = 0x5A;
+    chip.registers[BME680::ADD_HUM_LSB] = 0x3C;
+    chip.registers[BME680::ADD_GAS_R_MSB] = 0xA7;
+    chip.registers[BME680::ADD_GAS_R_LSB] = 0x80 | 0x30 | 0x0B;
+    TEST_ASSERT_EQUAL_UINT32(0x7ABCD, sensor.readRawTemperature());
+    TEST_ASSERT_EQUAL_UINT32(0x4E219, sensor.readRawPressure());
+    TEST_ASSERT_EQUAL_UINT32(0x5A3C, sensor.readRawHumidity());
+    uint16_t adc;
+    uint8_t range;
+    TEST_ASSERT_TRUE(sensor.readRawGas(&adc, &range));
+    TEST_ASSERT_EQUAL_UINT16(0x29E, adc);
+    TEST_ASSERT_EQUAL_UINT8(0x0B, range);
+    // Not valid without both gas_valid and heat_stab
+    chip.registers[BME680::ADD_GAS_R_LSB] = 0x80 | 0x20 | 0x0B;
+    TEST_ASSERT_FALSE(sensor.readRawGas(&adc, &range));
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_none, sensor.getError());
+}
+
+void test_temperature_compensation(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    // Every 64th code from -40 °C to 85 °C
+    double worst = 0;
+    for (uint32_t adc = 300000; adc <= 660000; adc += 64)
+    {
+        double celsius = referenceTFine(adc) / 5120.0;
+        if (celsius < -40 || celsius > 85)
+        {
+            continue;
+        }
+        double error = fabs(sensor.calculateTemperature(adc) / 100.0 - celsius);
+        worst = error > worst ? error : worst;
+    }
+    report("temperature", worst, "C");
+    // The result is rounded to the centi-degree
+    TEST_ASSERT_TRUE(worst <= 0.006);
+}
+
+void test_pressure_compensation(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    double worst = 0;
+    // Up to 110 kPa at every temperature, where the intermediate terms pass 2^31
+    for (int16_t centiC = -4000; centiC <= 8500; centiC += 500)
+    {
+        // The raw temperature for this temperature, by bisection on the reference
+        uint32_t low = 200000;
+        uint32_t high = 800000;
+        while (high - low > 1)
+        {
+            uint32_t middle = (low + high) / 2;
+            (referenceTFine(middle) / 51.2 < centiC ? low : high) = middle;
+        }
+        sensor.calculateTemperature(high);
+        double tFine = referenceTFine(high);
+        for (uint32_t adc = 150000; adc <= 750000; adc += 997)
+        {
+            double expected = referencePressure(adc, tFine);
+            if (expected < 30000 || expected > 110000)
+            {
+                continue;
+            }
+            double error = fabs(sensor.calculatePressure(adc) - expected);
+            worst = error > worst ? error : worst;
+        }
+    }
+    report("pressure", worst, "Pa");
+    // The truncations of the integer formula, a sixth of the sensor's absolute accuracy
+    TEST_ASSERT_TRUE(worst <= 10);
+}
+
+void test_humidity_compensation(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    double worst = 0;
+    for (uint32_t tAdc = 350000; tAdc <= 600000; tAdc += 25000)
+    {
+        sensor.calculateTemperature(tAdc);
+        double tFine = referenceTFine(tAdc);
+        for (uint32_t adc = 12000; adc <= 50000; adc += 37)
+        {
+            double expected = referenceHumidity(adc, tFine);
+            double error = fabs(sensor.calculateHumidity(adc) / 1000.0 - expected);
+            worst = error > worst ? error : worst;
+        }
+    }
+    report("humidity", worst, "%RH");
+    TEST_ASSERT_TRUE(worst <= 0.05);
+}
+
+void test_gas_resistance(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    double worst = 0;
+    for (uint8_t range = 0; range < 16; range++)
+    {
+        for (uint16_t adc = 0; adc < 1024; adc++)
+        {
+            double expected = referenceGasResistance(adc, range);
+            // Beyond the truncation to a whole ohm, which dominates on the top ranges
+            double error = (fabs(sensor.calculateGasResistance(adc, range) - expected) - 1) / expected;
+            worst = error > worst ? error : worst;
+        }
+    }
+    report("gas resistance beyond 1 ohm", worst * 100, "%");
+    TEST_ASSERT_TRUE(worst <= 0.0001);
+}
+
+void test_channels_not_measured_are_skipped(void)
+{
+    TEST_ASSERT_TRUE(sensor.begin());
+    TEST_ASSERT_TRUE(sensor.applyConfig());
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x16, chip.registers[BME680::ADD_CTRL_HUM]);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_127 << 2, chip.registers[BME680::ADD_CONFIG]);
+    TEST_ASSERT_EQUAL_UINT8(0x10 | BME680::point_0, chip.registers[BME680::ADD_CTRL_GAS_1]);
+
+    // Everything: forced mode with the configured oversampling
+    TEST_ASSERT_TRUE(sensor.startConversion(channel_all));
+    TEST_ASSERT_EQUAL_UINT8((BME680::orsrs_x16 << 5) | (BME680::orsrs_x16 << 2) | 0x01, chip.registers[BME680::ADD_CTRL_MEAS]);
+
+    // Temperature only: pressure, humidity and the heater skipped
+    TEST_ASSERT_TRUE(sensor.startConversion(channel_temperature));
+    TEST_ASSERT_EQUAL_UINT8((BME680::orsrs_x16 << 5) | 0x01, chip.registers[BME680::ADD_CTRL_MEAS]);
+    TEST_ASSERT_EQUAL_UINT8(0, chip.registers[BME680::ADD_CTRL_HUM]);
+    TEST_ASSERT_EQUAL_UINT8(BME680::point_0, chip.registers[BME680::ADD_CTRL_GAS_1]);
+
+    // The same channels again: only ctrl_meas is written
+    uint16_t hum = chip.writes[BME680::ADD_CTRL_HUM];
+    uint16_t gas = chip.writes[BME680::ADD_CTRL_GAS_1];
+    uint16_t meas = chip.writes[BME680::ADD_CTRL_MEAS];
+    TEST_ASSERT_TRUE(sensor.startConversion(channel_temperature));
+    TEST_ASSERT_EQUAL_UINT16(hum, chip.writes[BME680::ADD_CTRL_HUM]);
+    TEST_ASSERT_EQUAL_UINT16(gas, chip.writes[BME680::ADD_CTRL_GAS_1]);
+    TEST_ASSERT_EQUAL_UINT16(meas + 1, chip.writes[BME680::ADD_CTRL_MEAS]);
+
+    // Temperature and humidity, as the tracker units measure
+    TEST_ASSERT_TRUE(sensor.startConversion(channel_temperature | channel_humidity));
+    TEST_ASSERT_EQUAL_UINT8((BME680::orsrs_x16 << 5) | 0x01, chip.registers[BME680::ADD_CTRL_MEAS]);
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x16, chip.registers[BME680::ADD_CTRL_HUM]);
+
+    // After a reset the cached control registers are written again
+    TEST_ASSERT_TRUE(sensor.begin());
+    hum = chip.writes[BME680::ADD_CTRL_HUM];
+    TEST_ASSERT_TRUE(sensor.startConversion(channel_temperature | channel_humidity));
+    TEST_ASSERT_EQUAL_UINT16(hum + 1, chip.writes[BME680::ADD_CTRL_HUM]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_reads_calibration);
+    RUN_TEST(test_raw_reads);
+    RUN_TEST(test_temperature_compensation);
+    RUN_TEST(test_pressure_compensation);
+    RUN_TEST(test_humidity_compensation);
+    RUN_TEST(test_gas_resistance);
+    RUN_TEST(test_channels_not_measured_are_skipped);
+    return UNITY_END();
+}
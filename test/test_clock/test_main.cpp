@@ -0,0 +1,152 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Wall clock kept from a simulated DS3231 as an offset to millis()
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "clock.h"
+
+#define RTC_ADDRESS 0x68
+
+// 2026-10-19 12:00:00 UTC
+#define RTC_TIME 1792411200UL
+
+static HostI2CDevice chip;
+static DS3231 rtc(RTC_ADDRESS);
+
+static void loadTime(uint32_t seconds)
+{
+    DS3231::unixToRegisters(seconds, chip.registers + DS3231::ADD_SECONDS);
+    chip.registers[DS3231::ADD_STATUS] = 0;
+}
+
+void setUp(void)
+{
+    Wire.reset();
+    Wire.detachAll();
+    chip = HostI2CDevice();
+    Wire.attach(RTC_ADDRESS, &chip);
+    hostMicros = 0;
+    timer0_millis = 0;
+}
+
+void tearDown(void) {}
+
+void test_uptime_until_read(void)
+{
+    // The oscillator stopped: the time is not trusted, the clock counts uptime
+    chip.registers[DS3231::ADD_STATUS] = 0x80;
+    Clock::begin(&rtc);
+    TEST_ASSERT_FALSE(Clock::isSynced());
+    hostAdvanceMillis(5500);
+    TEST_ASSERT_EQUAL_UINT32(5, Clock::now());
+    uint32_t seconds = 0;
+    TEST_ASSERT_FALSE(Clock::accessTime(false, &seconds));
+    TEST_ASSERT_EQUAL_UINT32(5, seconds);
+}
+
+void test_offset_follows_rtc(void)
+{
+    hostAdvanceMillis(7000);
+    loadTime(RTC_TIME);
+    TEST_ASSERT_TRUE(Clock::sync());
+    TEST_ASSERT_TRUE(Clock::isSynced());
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME, Clock::now());
+    hostAdvanceMillis(2500);
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 2, Clock::now());
+    // millis() and wall clock convert both ways, on whole seconds
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 60, Clock::toSeconds(millis() + 58000));
+    TEST_ASSERT_EQUAL_UINT32(7000 + 60000, Clock::toMillis(RTC_TIME + 60));
+
+    // A missing RTC keeps the last offset
+    chip.absent = true;
+    TEST_ASSERT_FALSE(Clock::sync());
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 2, Clock::now());
+}
+
+void test_set_time(void)
+{
+    uint32_t seconds = RTC_TIME + 86400;
+    TEST_ASSERT_TRUE(Clock::accessTime(true, &seconds));
+    // The offset follows at once, without waiting for the next device check
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 86400, Clock::now());
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 86400, DS3231::registersToUnix(chip.registers + DS3231::ADD_SECONDS));
+    seconds = 0;
+    TEST_ASSERT_TRUE(Clock::accessTime(false, &seconds));
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 86400, seconds);
+
+    // Out of the DS3231's century: refused, the clock unchanged
+    seconds = 100;
+    TEST_ASSERT_FALSE(Clock::accessTime(true, &seconds));
+    TEST_ASSERT_EQUAL_UINT32(RTC_TIME + 86400, Clock::now());
+}
+
+/**
+ * Runs for an hour with the RTC `phaseMillis` into its second at boot and ticking `rtcPerMille`
+ * thousandths of a millis() second, syncing every 10 s plus a random lateness below a second (the
+ * loop reaches the device check after some work). Returns the largest error of the stamped time
+ * against the RTC, after checking it never decreased
+ */
+static uint32_t runAgainstRtc(uint16_t phaseMillis, uint16_t rtcPerMille)
+{
+    uint32_t random = phaseMillis + 1;
+    loadTime(RTC_TIME);
+    Clock::begin(&rtc);
+    uint32_t last = Clock::now();
+    uint32_t worst = 0;
+    uint32_t nextSync = 10000;
+    for (uint32_t ms = 50; ms <= 3600000UL; ms += 50)
+    {
+        hostAdvanceMillis(50);
+        uint32_t rtcTime = RTC_TIME + (phaseMillis + (uint64_t)ms * rtcPerMille / 1000) / 1000;
+        loadTime(rtcTime);
+        if (ms >= nextSync)
+        {
+            TEST_ASSERT_TRUE(Clock::sync());
+            random = random * 1103515245UL + 12345;
+            nextSync = ms + 10000 + (random >> 16) % 20 * 50;
+        }
+        uint32_t now = Clock::now();
+        TEST_ASSERT_TRUE(now >= last);
+        last = now;
+        uint32_t error = now > rtcTime ? now - rtcTime : rtcTime - now;
+        worst = error > worst ? error : worst;
+    }
+    return worst;
+}
+
+void test_resync_never_steps_back(void)
+{
+    // Same rate: the offset read wavers by a second with the phases, the one in use does not
+    for (uint16_t phase = 0; phase < 1000; phase += 125)
+    {
+        hostMicros = 0;
+        timer0_millis = 0;
+        TEST_ASSERT_TRUE(runAgainstRtc(phase, 1000) <= 1);
+    }
+    // millis() 0.1% slow, as after a long power-down: 3.6 s in the hour, caught up in RESYNC_S steps
+    hostMicros = 0;
+    timer0_millis = 0;
+    uint32_t worst = runAgainstRtc(500, 1001);
+    char message[64];
+    snprintf(message, sizeof(message), "millis() 0.1%% slow: largest error %lu s", (unsigned long)worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst <= Clock::RESYNC_S);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_uptime_until_read);
+    RUN_TEST(test_offset_follows_rtc);
+    RUN_TEST(test_set_time);
+    RUN_TEST(test_resync_never_steps_back);
+    return UNITY_END();
+}
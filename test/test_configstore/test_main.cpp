@@ -0,0 +1,251 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Config store on a simulated EEPROM: rotation, torn writes, corruption, wrap-around, migration
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+
+#include "configstore.h"
+
+#define BASE 16
+#define SLOTS 4
+#define SLOT_SIZE 48
+
+typedef struct
+{
+    uint32_t counter;
+    uint8_t pattern[12];
+} Payload;
+
+static void fill(Payload *payload, uint32_t counter)
+{
+    payload->counter = counter;
+    for (uint8_t i = 0; i < sizeof(payload->pattern); i++)
+    {
+        payload->pattern[i] = (uint8_t)(counter * 31 + i * 7);
+    }
+}
+
+// A reboot: a new store object scanning the EEPROM as it is
+static bool loadFresh(Payload *payload)
+{
+    ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    return store.begin() && store.loadRecord(payload, sizeof(Payload));
+}
+
+void setUp(void)
+{
+    EEPROM.erase();
+}
+
+void tearDown(void) {}
+
+void test_empty(void)
+{
+    ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    Payload payload;
+    TEST_ASSERT_FALSE(store.begin());
+    TEST_ASSERT_FALSE(store.loadRecord(&payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_UINT8(SLOTS, store.getSlot());
+}
+
+void test_rotation_spreads_wear(void)
+{
+    ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    store.begin();
+    Payload payload;
+    for (uint32_t i = 0; i < 400; i++)
+    {
+        fill(&payload, i);
+        TEST_ASSERT_TRUE(store.saveRecord(&payload, sizeof(payload), 1));
+        TEST_ASSERT_EQUAL_UINT8(i % SLOTS, store.getSlot());
+    }
+    Payload loaded;
+    TEST_ASSERT_TRUE(loadFresh(&loaded));
+    TEST_ASSERT_EQUAL_UINT32(399, loaded.counter);
+
+    // Every cell of every slot takes about a quarter of the saves, no cell more than one per save
+    uint16_t most = 0;
+    for (uint16_t a = BASE; a < BASE + SLOTS * SLOT_SIZE; a++)
+    {
+        most = EEPROM.cellWrites[a] > most ? EEPROM.cellWrites[a] : most;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(400 / SLOTS, most);
+    // Nothing outside the store is touched
+    TEST_ASSERT_EQUAL_UINT16(0, EEPROM.cellWrites[BASE - 1]);
+    TEST_ASSERT_EQUAL_UINT16(0, EEPROM.cellWrites[BASE + SLOTS * SLOT_SIZE]);
+}
+
+void test_power_loss_at_every_byte(void)
+{
+    // For each number of bytes that reach the EEPROM before power is lost, a reboot finds either
+    // the previous record or the new one, never anything else
+    for (int32_t cut = 0; cut < 40; cut++)
+    {
+        EEPROM.erase();
+        ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+        store.begin();
+        Payload payload;
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            fill(&payload, i);
+            TEST_ASSERT_TRUE(store.saveRecord(&payload, sizeof(payload), 1));
+        }
+
+        fill(&payload, 1000);
+        EEPROM.writesLeft = cut;
+        bool saved = store.saveRecord(&payload, sizeof(payload), 1);
+        bool finished = EEPROM.writesLeft != 0;
+        EEPROM.writesLeft = -1;
+
+        Payload loaded;
+        TEST_ASSERT_TRUE(loadFresh(&loaded));
+        Payload expected;
+        fill(&expected, saved ? 1000 : 5);
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &loaded, sizeof(Payload));
+        // A save reports success only when the whole record made it
+        TEST_ASSERT_TRUE(!saved || finished || cut > 0);
+    }
+}
+
+void test_corruption_falls_back(void)
+{
+    ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    store.begin();
+    Payload payload;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        fill(&payload, i);
+        store.saveRecord(&payload, sizeof(payload), 1);
+    }
+    uint8_t newest = store.getSlot();
+
+    // Any single flipped bit in the newest slot (header, payload or CRC) invalidates it
+    uint16_t recordBytes = ConfigStore::HEADER_SIZE + sizeof(Payload) + ConfigStore::CRC_SIZE;
+    for (uint16_t byte = 0; byte < recordBytes; byte++)
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            uint16_t address = BASE + newest * SLOT_SIZE + byte;
+            EEPROM.cells[address] ^= 1 << bit;
+            Payload loaded;
+            TEST_ASSERT_TRUE(loadFresh(&loaded));
+            TEST_ASSERT_TRUE(loaded.counter == 1 || loaded.counter == 2);
+            // Only a flip that leaves a valid record (none in practice) may keep the newest
+            if (loaded.counter == 2)
+            {
+                TEST_ASSERT_EQUAL_UINT8(3, byte);
+            }
+            EEPROM.cells[address] ^= 1 << bit;
+        }
+    }
+}
+
+void test_sequence_wraps(void)
+{
+    ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    store.begin();
+    Payload payload;
+    for (uint32_t i = 0; i < 65536UL + 10; i++)
+    {
+        fill(&payload, i);
+        store.saveRecord(&payload, sizeof(payload), 1);
+        // Reboot across the wrap of the 16-bit sequence number
+        if (i >= 65530UL)
+        {
+            Payload loaded;
+            TEST_ASSERT_TRUE(loadFresh(&loaded));
+            TEST_ASSERT_EQUAL_UINT32(i, loaded.counter);
+        }
+    }
+}
+
+void test_other_store_ignored(void)
+{
+    // A store of another record type sharing the range is not mistaken for a record
+    ConfigStore other(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_GAS_BASELINE);
+    other.begin();
+    Payload payload;
+    fill(&payload, 9);
+    TEST_ASSERT_TRUE(other.saveRecord(&payload, sizeof(payload), 1));
+    Payload loaded;
+    TEST_ASSERT_FALSE(loadFresh(&loaded));
+}
+
+void test_config_migration(void)
+{
+    BME680 sensor(0x77);
+    BME680::BMEConfig config;
+    sensor.config = &config;
+    sensor.setDefaultConfig();
+    ConfigStore store(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    store.begin();
+
+    // A version 0 record without the heater fields: they keep their current values
+    ConfigStore::StoredConfig old;
+    memset(&old, 0, sizeof(old));
+    old.osrs_t = BME680::osrs_x2;
+    old.osrs_p = BME680::osrs_x4;
+    old.osrs_h = 9;
+    old.filter = BME680::filter_3;
+    TEST_ASSERT_TRUE(store.saveRecord(&old, 4, 0));
+
+    BME680::BMEConfig loaded = config;
+    ConfigStore reboot(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    TEST_ASSERT_TRUE(reboot.begin());
+    TEST_ASSERT_TRUE(reboot.load(&loaded));
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x2, loaded.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x4, loaded.osrs_p);
+    // Out of range values are clamped
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x16, loaded.osrs_h);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_3, loaded.filter);
+#if FEATURE_GAS
+    TEST_ASSERT_EQUAL_INT(config.target_temp, loaded.target_temp);
+    TEST_ASSERT_EQUAL_UINT8(config.set_point, loaded.set_point);
+#endif
+
+    // A version 1 record without the acquisition periods: the planner keeps its own
+    AcquisitionPlanner planner;
+    planner.setPeriod(2, 60);
+    old.osrs_t = BME680::osrs_x1;
+    TEST_ASSERT_TRUE(reboot.saveRecord(&old, offsetof(ConfigStore::StoredConfig, periods), 1));
+    TEST_ASSERT_TRUE(reboot.load(&loaded, &planner));
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x1, loaded.osrs_t);
+    TEST_ASSERT_EQUAL_UINT16(0, planner.getPeriod(0));
+    TEST_ASSERT_EQUAL_UINT16(60, planner.getPeriod(2));
+
+    // The current layout round-trips, periods included
+    loaded.osrs_t = BME680::orsrs_x8;
+    planner.setPeriod(0, 3);
+    planner.setPeriod(3, 600);
+    TEST_ASSERT_TRUE(reboot.save(&loaded, &planner));
+    BME680::BMEConfig again = config;
+    AcquisitionPlanner boot;
+    ConfigStore reboot2(BASE, SLOTS, SLOT_SIZE, ConfigStore::TYPE_CONFIG);
+    reboot2.begin();
+    TEST_ASSERT_TRUE(reboot2.load(&again, &boot));
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x8, again.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x16, again.osrs_h);
+    TEST_ASSERT_EQUAL_UINT16(3, boot.getPeriod(0));
+    TEST_ASSERT_EQUAL_UINT16(0, boot.getPeriod(1));
+    TEST_ASSERT_EQUAL_UINT16(60, boot.getPeriod(2));
+    TEST_ASSERT_EQUAL_UINT16(600, boot.getPeriod(3));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty);
+    RUN_TEST(test_rotation_spreads_wear);
+    RUN_TEST(test_power_loss_at_every_byte);
+    RUN_TEST(test_corruption_falls_back);
+    RUN_TEST(test_sequence_wraps);
+    RUN_TEST(test_other_store_ignored);
+    RUN_TEST(test_config_migration);
+    return UNITY_END();
+}
@@ -0,0 +1,469 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Console parser: number/token parsing, command replies and a random-input fuzz run
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "console.h"
+#include "configstore.h"
+#include "osctrl.h"
+#include "power.h"
+#include "txqueue.h"
+
+// Fuzz input length, in bytes
+#define FUZZ_BYTES 400000UL
+
+static BME680 sensor(0x77);
+static BME680::BMEConfig config;
+static BME680::BMECalibrationParameters calibration;
+static ConfigStore store(16, 4, 48, ConfigStore::TYPE_CONFIG);
+static AcquisitionPlanner planner;
+// As in the firmware, the console writes into a transmit queue in front of the UART
+static uint8_t txBuffer[256];
+static TxQueue queue(&Serial, txBuffer, sizeof(txBuffer));
+static Console console(&queue, &sensor, &store);
+
+static uint32_t random32;
+
+static uint32_t nextRandom()
+{
+    // xorshift32, fixed seed: every run feeds the same input
+    random32 ^= random32 << 13;
+    random32 ^= random32 >> 17;
+    random32 ^= random32 << 5;
+    return random32;
+}
+
+// Longer than the transmit queue
+#define STATS_LINES 40
+
+static bool printStats(Print *out, uint8_t line)
+{
+    if (line >= STATS_LINES)
+    {
+        return false;
+    }
+    out->print(F("stat_"));
+    out->print(line);
+    out->println(F("=1234567890"));
+    return true;
+}
+
+static bool selectScreen(uint8_t screen)
+{
+    return screen < 4;
+}
+
+static bool startExport(Stream *, bool resume, uint16_t blockSequence)
+{
+    return !resume || blockSequence < 100;
+}
+
+static ChannelFilter filters[SampleFilter::filter_channels];
+
+static ChannelFilter *getFilter(uint8_t channel)
+{
+    return channel < SampleFilter::filter_channels ? &filters[channel] : nullptr;
+}
+
+static bool adapt(uint16_t periodMillis, const uint8_t *priorities)
+{
+    if (periodMillis == 0)
+    {
+        return true;
+    }
+    for (uint8_t i = 0; i < OversamplingController::CHANNELS; i++)
+    {
+        TEST_ASSERT_LESS_OR_EQUAL(OversamplingController::MAX_PRIORITY, priorities[i]);
+    }
+    return periodMillis >= 100;
+}
+
+static bool printDerived(Print *out, uint8_t line, uint16_t seaLevelHpa)
+{
+    TEST_ASSERT_TRUE(seaLevelHpa == 0 || (line == 0 && seaLevelHpa >= 300 && seaLevelHpa <= 1100));
+    if (line > 0)
+    {
+        return false;
+    }
+    out->println(F("dew_point=10.0"));
+    return true;
+}
+
+static void setPower(bool, uint8_t display)
+{
+    TEST_ASSERT_LESS_OR_EQUAL(PowerManager::display_blank, display);
+}
+
+static AcquisitionPlanner *getPlanner()
+{
+    return &planner;
+}
+
+static bool accessTime(bool set, uint32_t *seconds)
+{
+    if (!set)
+    {
+        *seconds = 1800000000UL;
+    }
+    return true;
+}
+
+// Puts the reply in progress on the line, as the loop does
+static void drainReply()
+{
+    for (uint16_t i = 0; console.isReplying() || queue.getQueued() > 0; i++)
+    {
+        TEST_ASSERT_TRUE(i < 1000);
+        queue.pump();
+        Serial.flush();
+        console.poll();
+    }
+}
+
+// Feeds a line, returns the last line of the reply
+static const char *command(const char *text)
+{
+    static char last[64];
+    Serial.clearOutput();
+    while (*text)
+    {
+        console.feed(*text++);
+    }
+    console.feed('\r');
+    console.feed('\n');
+    drainReply();
+    // The reply is the last non-empty line
+    const char *end = Serial.output + Serial.outputLength;
+    while (end > Serial.output && (end[-1] == '\r' || end[-1] == '\n'))
+    {
+        end--;
+    }
+    const char *start = end;
+    while (start > Serial.output && start[-1] != '\n')
+    {
+        start--;
+    }
+    size_t length = end - start < (long)sizeof(last) - 1 ? end - start : sizeof(last) - 1;
+    memcpy(last, start, length);
+    last[length] = '\0';
+    return last;
+}
+
+static bool isReply(const char *line)
+{
+    return strcmp(line, "OK") == 0 || strncmp(line, "ERR ", 4) == 0;
+}
+
+void setUp(void)
+{
+    // Any reply of a previous test
+    drainReply();
+    Serial.reset();
+    EEPROM.erase();
+    sensor.config = &config;
+    sensor.calibration = &calibration;
+    sensor.setDefaultConfig();
+    store.begin();
+    Console::setStatsHandler(printStats);
+    Console::setScreenHandler(selectScreen);
+    Console::setExportHandler(startExport);
+    Console::setFilterHandler(getFilter);
+    Console::setAdaptHandler(adapt);
+    Console::setDerivedHandler(printDerived);
+    Console::setPowerHandler(setPower);
+    Console::setRateHandler(getPlanner);
+    Console::setTimeHandler(accessTime);
+    Console::outputMode = Console::OutputMode::mode_human;
+    // Any partial line of a previous test
+    console.feed('\n');
+}
+
+void tearDown(void) {}
+
+void test_parse_unsigned(void)
+{
+    uint16_t v = 7;
+    TEST_ASSERT_TRUE(Console::parseUnsigned("0", &v));
+    TEST_ASSERT_EQUAL_UINT16(0, v);
+    TEST_ASSERT_TRUE(Console::parseUnsigned("65535", &v));
+    TEST_ASSERT_EQUAL_UINT16(65535, v);
+    TEST_ASSERT_FALSE(Console::parseUnsigned("65536", &v));
+    TEST_ASSERT_FALSE(Console::parseUnsigned("", &v));
+    TEST_ASSERT_FALSE(Console::parseUnsigned("-1", &v));
+    TEST_ASSERT_FALSE(Console::parseUnsigned("12a", &v));
+    TEST_ASSERT_EQUAL_UINT16(65535, v);
+
+    uint32_t l;
+    TEST_ASSERT_TRUE(Console::parseUnsignedLong("4294967295", &l));
+    TEST_ASSERT_EQUAL_UINT32(4294967295UL, l);
+    TEST_ASSERT_FALSE(Console::parseUnsignedLong("4294967296", &l));
+    TEST_ASSERT_FALSE(Console::parseUnsignedLong("99999999999999999999", &l));
+}
+
+void test_tokenize(void)
+{
+    char line[] = "  set\tosrs_t   3 ";
+    char *tokens[Console::MAX_TOKENS];
+    TEST_ASSERT_EQUAL_UINT8(3, Console::tokenize(line, tokens));
+    TEST_ASSERT_EQUAL_STRING("set", tokens[0]);
+    TEST_ASSERT_EQUAL_STRING("osrs_t", tokens[1]);
+    TEST_ASSERT_EQUAL_STRING("3", tokens[2]);
+
+    char many[] = "a b c d e f";
+    TEST_ASSERT_EQUAL_UINT8(Console::MAX_TOKENS + 1, Console::tokenize(many, tokens));
+
+    char blank[] = " \t ";
+    TEST_ASSERT_EQUAL_UINT8(0, Console::tokenize(blank, tokens));
+}
+
+void test_commands(void)
+{
+    TEST_ASSERT_EQUAL_STRING("OK", command("set osrs_t 3"));
+    TEST_ASSERT_EQUAL_UINT8(3, config.osrs_t);
+    TEST_ASSERT_EQUAL_STRING("ERR unknown key or value out of range", command("set osrs_t 6"));
+    TEST_ASSERT_EQUAL_UINT8(3, config.osrs_t);
+    TEST_ASSERT_EQUAL_STRING("ERR invalid value", command("set filter x"));
+    TEST_ASSERT_EQUAL_STRING("ERR usage: set <key> <value>", command("set filter"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("mode csv"));
+    TEST_ASSERT_TRUE(Console::outputMode == Console::OutputMode::mode_csv);
+    TEST_ASSERT_EQUAL_STRING("ERR unknown mode", command("mode loud"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("rate p 60"));
+    TEST_ASSERT_EQUAL_UINT16(60, planner.getPeriod(2));
+    TEST_ASSERT_EQUAL_STRING("ERR usage: rate [<t|h|p|g> <seconds>]", command("rate x 60"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("filter g 5 40 2"));
+    TEST_ASSERT_EQUAL_UINT8(5, filters[SampleFilter::filter_gas].getParameters()->window);
+    TEST_ASSERT_EQUAL_STRING("ERR window out of range", command("filter g 0 40 2"));
+    TEST_ASSERT_EQUAL_STRING("ERR unknown command", command("reboot"));
+    TEST_ASSERT_EQUAL_STRING("ERR too many arguments", command("set a b c d e"));
+
+    // Save and load go through the config store, acquisition periods included
+    TEST_ASSERT_EQUAL_STRING("OK", command("save"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("set osrs_t 1"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("rate p 0"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("load"));
+    TEST_ASSERT_EQUAL_UINT8(3, config.osrs_t);
+    TEST_ASSERT_EQUAL_UINT16(60, planner.getPeriod(2));
+
+    command("get");
+    TEST_ASSERT_NOT_NULL(strstr(Serial.output, "osrs_t=3\r\n"));
+
+    // Replies written one line at a time end with OK too
+    TEST_ASSERT_EQUAL_STRING("OK", command("stats"));
+    TEST_ASSERT_NOT_NULL(strstr(Serial.output, "stat_39=1234567890\r\nOK\r\n"));
+    TEST_ASSERT_EQUAL_STRING("OK", command("derived 1013"));
+    TEST_ASSERT_EQUAL_STRING("dew_point=10.0\r\nOK\r\n", Serial.output);
+    TEST_ASSERT_EQUAL_STRING("OK", command("filter"));
+    TEST_ASSERT_NOT_NULL(strstr(Serial.output, "g: window=5 noise=40 process=2\r\n"));
+}
+
+void test_overlong_line(void)
+{
+    char line[Console::LINE_LENGTH + 20];
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    TEST_ASSERT_EQUAL_STRING("ERR line too long", command(line));
+    // The parser is usable right after
+    TEST_ASSERT_EQUAL_STRING("OK", command("get"));
+
+    // The longest accepted line
+    char longest[Console::LINE_LENGTH];
+    memset(longest, ' ', sizeof(longest) - 1);
+    memcpy(longest + sizeof(longest) - 4, "get", 3);
+    longest[sizeof(longest) - 1] = '\0';
+    TEST_ASSERT_EQUAL_STRING("OK", command(longest));
+}
+
+void test_poll_budget(void)
+{
+    // Three commands in the receive buffer: poll() never takes more than POLL_BUDGET bytes
+    Serial.feed("set osrs_t 2\r\nset filter 1\r\nmode off\r\n");
+    int before = Serial.available();
+    console.poll();
+    TEST_ASSERT_EQUAL_INT(Console::POLL_BUDGET, before - Serial.available());
+    TEST_ASSERT_EQUAL_UINT8(2, config.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(1, config.filter);
+    console.poll();
+    TEST_ASSERT_EQUAL_INT(0, Serial.available());
+    TEST_ASSERT_TRUE(Console::outputMode == Console::OutputMode::mode_off);
+}
+
+void test_reply_to_stalled_link(void)
+{
+    // The link takes nothing: the UART buffer is full and stays full
+    Serial.pending = SERIAL_TX_BUFFER_SIZE - 1;
+    Serial.feed("help\r\nstats\r\n");
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        console.poll();
+        queue.pump();
+    }
+    // poll() returned with help in part in the queue, and the input after its CR not read yet
+    TEST_ASSERT_TRUE(console.isReplying());
+    TEST_ASSERT_TRUE(queue.getQueued() > sizeof(txBuffer) - Console::REPLY_ROOM);
+    TEST_ASSERT_EQUAL_INT(8, Serial.available());
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+    TEST_ASSERT_EQUAL_size_t(0, Serial.outputLength);
+
+    // The link comes back, slowly: both replies arrive whole and in order
+    for (uint16_t i = 0; console.isReplying() || queue.getQueued() > 0 || Serial.available() > 0; i++)
+    {
+        TEST_ASSERT_TRUE(i < 10000);
+        Serial.drain(4);
+        queue.pump();
+        console.poll();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(Serial.output, "get | set <key> <value>", 23));
+    const char *help = strstr(Serial.output, "export [block]\r\nkeys: osrs_t");
+    TEST_ASSERT_NOT_NULL(help);
+    const char *stats = strstr(help, "OK\r\nstat_0=1234567890\r\n");
+    TEST_ASSERT_NOT_NULL(stats);
+    const char *last = "stat_39=1234567890\r\nOK\r\n";
+    TEST_ASSERT_EQUAL_STRING(last, Serial.output + Serial.outputLength - strlen(last));
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(txBuffer), queue.getHighWater());
+    char message[64];
+    snprintf(message, sizeof(message), "help reply: %u bytes", (unsigned)(stats + 4 - Serial.output));
+    TEST_MESSAGE(message);
+}
+
+// Words the fuzzer strings together, so most lines reach the command handlers
+static const char *const vocabulary[] = {
+    "help", "get", "set", "defaults", "save", "load", "stats", "mode", "policy", "filter",
+    "adapt", "derived", "power", "rate", "time", "screen", "export", "osrs_t", "osrs_p", "osrs_h",
+    "gas", "target", "point", "off", "on", "human", "csv", "sparse", "drop", "coalesce", "aggregate",
+    "t", "h", "p", "g", "dim", "blank", "bright", "0", "1", "3", "7", "65535", "65536", "4294967296"};
+
+void test_fuzz(void)
+{
+    random32 = 0x2545F491UL;
+    char mirror[256];
+    uint16_t mirrorLength = 0;
+    uint32_t lines = 0;
+    uint32_t replies = 0;
+
+    for (uint32_t n = 0; n < FUZZ_BYTES;)
+    {
+        // A chunk: random bytes, a vocabulary word, a number or a separator
+        char chunk[24];
+        uint8_t chunkLength = 0;
+        uint32_t r = nextRandom();
+        switch (r % 8)
+        {
+        case 0:
+        {
+            chunkLength = 1 + (r >> 8) % 8;
+            for (uint8_t i = 0; i < chunkLength; i++)
+            {
+                chunk[i] = (char)nextRandom();
+            }
+        }
+        break;
+        case 1:
+        {
+            chunkLength = snprintf(chunk, sizeof(chunk), "%lu", (unsigned long)nextRandom() >> ((r >> 8) % 32));
+        }
+        break;
+        case 2:
+        {
+            chunk[0] = "\r\n\t "[(r >> 8) % 4];
+            chunkLength = 1;
+        }
+        break;
+        default:
+        {
+            const char *word = vocabulary[(r >> 8) % (sizeof(vocabulary) / sizeof(vocabulary[0]))];
+            chunkLength = strlen(word);
+            memcpy(chunk, word, chunkLength);
+            chunk[chunkLength++] = ' ';
+        }
+        break;
+        }
+
+        for (uint8_t i = 0; i < chunkLength; i++, n++)
+        {
+            char c = chunk[i];
+            Serial.clearOutput();
+            bool complete = console.feed(c);
+            drainReply();
+            if (c != '\r' && c != '\n')
+            {
+                if (mirrorLength < sizeof(mirror))
+                {
+                    mirror[mirrorLength] = c;
+                }
+                mirrorLength++;
+                TEST_ASSERT_FALSE(complete);
+                TEST_ASSERT_EQUAL_size_t(0, Serial.outputLength);
+                continue;
+            }
+
+            // A line is executed (one reply) if it was too long or holds a token before any NUL
+            bool expected = mirrorLength > Console::LINE_LENGTH - 1;
+            for (uint16_t j = 0; !expected && j < mirrorLength && mirror[j] != '\0'; j++)
+            {
+                expected = mirror[j] != ' ' && mirror[j] != '\t';
+            }
+            if (expected)
+            {
+                TEST_ASSERT_TRUE(complete);
+                lines++;
+            }
+            uint32_t found = 0;
+            const char *line = Serial.output;
+            while (*line)
+            {
+                const char *end = strstr(line, "\r\n");
+                TEST_ASSERT_NOT_NULL(end);
+                char text[160];
+                size_t length = end - line < (long)sizeof(text) - 1 ? end - line : sizeof(text) - 1;
+                memcpy(text, line, length);
+                text[length] = '\0';
+                found += isReply(text) ? 1 : 0;
+                line = end + 2;
+            }
+            // export replies OK before handing the stream over, and ERR if it cannot start
+            TEST_ASSERT_TRUE(found == (expected ? 1u : 0u) || (found == 2 && strstr(Serial.output, "ERR offset") != nullptr));
+            replies += found ? 1 : 0;
+            mirrorLength = 0;
+
+            // The configuration never leaves its valid range
+            TEST_ASSERT_LESS_OR_EQUAL(BME680::orsrs_x16, config.osrs_t);
+            TEST_ASSERT_LESS_OR_EQUAL(BME680::orsrs_x16, config.osrs_p);
+            TEST_ASSERT_LESS_OR_EQUAL(BME680::orsrs_x16, config.osrs_h);
+            TEST_ASSERT_LESS_OR_EQUAL(BME680::filter_127, config.filter);
+            TEST_ASSERT_LESS_OR_EQUAL(400, config.target_temp);
+            TEST_ASSERT_LESS_OR_EQUAL(BME680::point_9, config.set_point);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(lines, replies);
+    TEST_ASSERT_GREATER_THAN(1000, lines);
+    char message[80];
+    snprintf(message, sizeof(message), "fuzz: %lu bytes, %lu lines executed", FUZZ_BYTES, (unsigned long)lines);
+    TEST_MESSAGE(message);
+
+    // Still in a sane state once the last partial line is ended
+    console.feed('\n');
+    TEST_ASSERT_EQUAL_STRING("OK", command("get"));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_unsigned);
+    RUN_TEST(test_tokenize);
+    RUN_TEST(test_commands);
+    RUN_TEST(test_overlong_line);
+    RUN_TEST(test_poll_budget);
+    RUN_TEST(test_reply_to_stalled_link);
+    RUN_TEST(test_fuzz);
+    return UNITY_END();
+}
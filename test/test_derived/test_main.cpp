@@ -0,0 +1,212 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Derived metrics from the PROGMEM tables against the double-precision formulas
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "derived.h"
+
+// Magnus saturation vapour pressure over water, in Pa
+static double magnus(double celsius)
+{
+    return 611.2 * exp(17.62 * celsius / (243.12 + celsius));
+}
+
+static double dewPointReference(double celsius, double rh)
+{
+    double gamma = log(magnus(celsius) * rh / 100 / 611.2);
+    return 243.12 * gamma / (17.62 - gamma);
+}
+
+static double absoluteHumidityReference(double celsius, double rh)
+{
+    return 2.167 * magnus(celsius) * rh / 100 / (celsius + 273.15);
+}
+
+static double altitudeReference(double pascal, double seaLevelPascal)
+{
+    return 44330.77 * (1 - pow(pascal / seaLevelPascal, 0.190263));
+}
+
+static SampleRecord makeSample(int16_t centiC, uint16_t centiRh, uint32_t pascal)
+{
+    SampleRecord sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.temperature = centiC;
+    sample.humidity = centiRh;
+    sample.pressure = pascal;
+    sample.channels = channel_temperature | channel_humidity | channel_pressure;
+    return sample;
+}
+
+static void report(const char *what, double worst, const char *unit)
+{
+    char message[80];
+    snprintf(message, sizeof(message), "%s: largest error %.3f %s", what, worst, unit);
+    TEST_MESSAGE(message);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_saturation_pressure(void)
+{
+    // The table and its interpolation, against Magnus, every 0.01 °C of the range. Beyond the one
+    // deci-Pa resolution of the table (which dominates in the cold, where es is a few hundred dPa),
+    // the error is relative
+    double worst = 0;
+    for (int16_t centiC = -4000; centiC <= 8500; centiC++)
+    {
+        double expected = magnus(centiC / 100.0) * 10;
+        double error = fabs(DerivedMetrics::saturationPressure(centiC) - expected) - 1;
+        worst = error / expected > worst ? error / expected : worst;
+    }
+    report("saturation pressure beyond 1 dPa", worst * 100, "%");
+    TEST_ASSERT_TRUE(worst <= 0.001);
+}
+
+void test_dew_point(void)
+{
+    DerivedMetrics metrics;
+    double worst = 0;
+    for (int16_t centiC = -4000; centiC <= 8500; centiC += 37)
+    {
+        for (uint16_t centiRh = 100; centiRh <= 10000; centiRh += 53)
+        {
+            double expected = dewPointReference(centiC / 100.0, centiRh / 100.0);
+            if (expected < -40 || expected > 85)
+            {
+                continue;
+            }
+            SampleRecord sample = makeSample(centiC, centiRh, DerivedMetrics::STANDARD_SEA_LEVEL);
+            metrics.update(&sample);
+            double error = fabs(metrics.getDewPoint() / 100.0 - expected);
+            worst = error > worst ? error : worst;
+        }
+    }
+    report("dew point", worst, "C");
+    TEST_ASSERT_TRUE(worst <= 0.07);
+}
+
+void test_absolute_humidity(void)
+{
+    DerivedMetrics metrics;
+    double worst = 0;
+    double worstBelow50 = 0;
+    for (int16_t centiC = -4000; centiC <= 8500; centiC += 37)
+    {
+        for (uint16_t centiRh = 0; centiRh <= 10000; centiRh += 53)
+        {
+            double expected = absoluteHumidityReference(centiC / 100.0, centiRh / 100.0);
+            SampleRecord sample = makeSample(centiC, centiRh, DerivedMetrics::STANDARD_SEA_LEVEL);
+            metrics.update(&sample);
+            double error = fabs(metrics.getAbsoluteHumidity() / 100.0 - expected);
+            worst = error > worst ? error : worst;
+            if (centiC < 5000)
+            {
+                worstBelow50 = error > worstBelow50 ? error : worstBelow50;
+            }
+        }
+    }
+    report("absolute humidity", worst, "g/m^3");
+    report("absolute humidity below 50 C", worstBelow50, "g/m^3");
+    TEST_ASSERT_TRUE(worst <= 0.06);
+    TEST_ASSERT_TRUE(worstBelow50 <= 0.03);
+}
+
+void test_altitude(void)
+{
+    // Several sea level references, every pressure from 30 kPa up to the bottom of the table
+    static const uint32_t seaLevels[] = {95000, 98000, 101325, 103000, 105000};
+    double worstLow = 0;
+    double worstHigh = 0;
+    for (uint8_t s = 0; s < sizeof(seaLevels) / sizeof(seaLevels[0]); s++)
+    {
+        for (uint32_t pascal = 30000; pascal <= 110000; pascal += 7)
+        {
+            double expected = altitudeReference(pascal, seaLevels[s]);
+            if (expected > 9000 || expected < -880)
+            {
+                continue;
+            }
+            double error = fabs(DerivedMetrics::barometricAltitude(pascal, seaLevels[s]) / 10.0 - expected);
+            if (expected < 2000)
+            {
+                worstLow = error > worstLow ? error : worstLow;
+            }
+            else
+            {
+                worstHigh = error > worstHigh ? error : worstHigh;
+            }
+        }
+    }
+    report("altitude below 2000 m", worstLow, "m");
+    report("altitude 2000 m to 9000 m", worstHigh, "m");
+    TEST_ASSERT_TRUE(worstLow <= 0.16);
+    TEST_ASSERT_TRUE(worstHigh <= 0.51);
+
+    // At the reference pressure the altitude is zero whatever the reference
+    for (uint8_t s = 0; s < sizeof(seaLevels) / sizeof(seaLevels[0]); s++)
+    {
+        TEST_ASSERT_INT32_WITHIN(1, 0, DerivedMetrics::barometricAltitude(seaLevels[s], seaLevels[s]));
+    }
+}
+
+void test_clamped_outside_tables(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(DerivedMetrics::saturationPressure(-4000), DerivedMetrics::saturationPressure(-6000));
+    TEST_ASSERT_EQUAL_UINT32(DerivedMetrics::saturationPressure(8500), DerivedMetrics::saturationPressure(12000));
+    TEST_ASSERT_EQUAL_INT16(-4000, DerivedMetrics::saturationTemperature(0));
+    TEST_ASSERT_EQUAL_INT16(8500, DerivedMetrics::saturationTemperature(0xFFFFFFFF));
+    TEST_ASSERT_EQUAL_INT32(DerivedMetrics::barometricAltitude(29000, 101325),
+                            DerivedMetrics::barometricAltitude(1000, 101325));
+    TEST_ASSERT_EQUAL_INT32(DerivedMetrics::barometricAltitude(113000, 101325),
+                            DerivedMetrics::barometricAltitude(200000, 101325));
+    TEST_ASSERT_EQUAL_INT32(0, DerivedMetrics::barometricAltitude(101325, 0));
+}
+
+void test_cache_invalidation(void)
+{
+    DerivedMetrics metrics;
+    SampleRecord sample = makeSample(2000, 5000, 95000);
+    metrics.update(&sample);
+    int32_t altitude = metrics.getAltitude();
+    int16_t dewPoint = metrics.getDewPoint();
+    TEST_ASSERT_EQUAL_INT32(DerivedMetrics::barometricAltitude(95000, DerivedMetrics::STANDARD_SEA_LEVEL), altitude);
+
+    // A new sea level reference only changes the altitude
+    metrics.setSeaLevelPressure(98000);
+    TEST_ASSERT_EQUAL_UINT32(98000, metrics.getSeaLevelPressure());
+    TEST_ASSERT_EQUAL_INT32(DerivedMetrics::barometricAltitude(95000, 98000), metrics.getAltitude());
+    TEST_ASSERT_EQUAL_INT16(dewPoint, metrics.getDewPoint());
+
+    // A new sample changes everything
+    sample = makeSample(3000, 8000, 98000);
+    metrics.update(&sample);
+    TEST_ASSERT_INT32_WITHIN(1, 0, metrics.getAltitude());
+    TEST_ASSERT_INT16_WITHIN(7, (int16_t)lround(dewPointReference(30, 80) * 100), metrics.getDewPoint());
+    // Humidity above 100% is read as 100%
+    sample = makeSample(2500, 10500, 98000);
+    metrics.update(&sample);
+    TEST_ASSERT_INT16_WITHIN(7, 2500, metrics.getDewPoint());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_saturation_pressure);
+    RUN_TEST(test_dew_point);
+    RUN_TEST(test_absolute_humidity);
+    RUN_TEST(test_altitude);
+    RUN_TEST(test_clamped_outside_tables);
+    RUN_TEST(test_cache_invalidation);
+    return UNITY_END();
+}
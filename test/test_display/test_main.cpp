@@ -0,0 +1,188 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Display rendering: glyph bytes, dirty-range transfers, trend plot and the IAQ field
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+
+#include "ssd1306.h"
+#include "gasbaseline.h"
+
+#define OLED_ADDRESS 0x3C
+
+// Glyph bytes of '2' and '-', top page then bottom page, as in the font table
+static const uint8_t glyphTwo[12] = {0x83, 0x83, 0x83, 0x83, 0xFF, 0xFF, 0xFF, 0xFF, 0xC1, 0xC1, 0xC1, 0xC1};
+static const uint8_t glyphDash[12] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
+
+// Records the data stream sent to the controller (control byte 0x40 + GDDRAM bytes)
+class HostDisplay : public HostI2CDevice
+{
+public:
+    uint32_t transfers;
+    uint32_t dataBytes;
+
+    HostDisplay() : transfers(0), dataBytes(0) {}
+    bool receive(const uint8_t *data, uint8_t length) override
+    {
+        transfers++;
+        if (length > 0 && data[0] == 0x40)
+        {
+            dataBytes += length - 1;
+        }
+        return true;
+    }
+};
+
+static HostDisplay device;
+static SSD1306 *oled;
+
+// Checks the glyph cell at a field position (page of the field, glyph index within it)
+static void checkGlyph(uint8_t page, uint8_t glyph, const uint8_t *expected)
+{
+    uint8_t *top = oled->getBuffer() + page * SSD1306::DISPLAY_WIDTH + 24 + glyph * SSD1306::GLYPH_WIDTH;
+    TEST_ASSERT_EQUAL_MEMORY(expected, top, SSD1306::FONT_COLUMNS);
+    TEST_ASSERT_EQUAL_MEMORY(expected + SSD1306::FONT_COLUMNS, top + SSD1306::DISPLAY_WIDTH, SSD1306::FONT_COLUMNS);
+    // The gap between glyphs stays blank
+    TEST_ASSERT_EQUAL_HEX8(0, top[SSD1306::FONT_COLUMNS]);
+    TEST_ASSERT_EQUAL_HEX8(0, top[SSD1306::DISPLAY_WIDTH + SSD1306::GLYPH_WIDTH - 1]);
+}
+
+void setUp(void)
+{
+    device = HostDisplay();
+    Wire.detachAll();
+    Wire.attach(OLED_ADDRESS, &device);
+    oled = new SSD1306();
+    oled->printScreen(SSD1306::Screens::screen_live);
+}
+
+void tearDown(void)
+{
+    delete oled;
+}
+
+void test_live_screen_starts_with_dashes(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(1, oled->fullTransfers);
+    for (uint8_t field = 0; field < 4; field++)
+    {
+        checkGlyph(field * 2, SSD1306::FIELD_GLYPHS - 1, glyphDash);
+    }
+    // printScreen() sent everything: nothing left for flush()
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(0, device.transfers);
+}
+
+void test_field_glyph_bytes(void)
+{
+    // "  23.45": the '2' is the third glyph
+    oled->updateField(SSD1306::field_temperature, 2345, 2);
+    checkGlyph(0, 2, glyphTwo);
+    // The other fields are untouched
+    checkGlyph(2, SSD1306::FIELD_GLYPHS - 1, glyphDash);
+}
+
+void test_flush_sends_only_changed_glyphs(void)
+{
+    oled->updateField(SSD1306::field_temperature, 2345, 2);
+    oled->flush();
+    // "    ---" to "  23.45": the two leading blanks are kept, 5 cells x 8 columns x 2 pages in one window
+    TEST_ASSERT_EQUAL_UINT32(5 * 8 * 2, device.dataBytes);
+    TEST_ASSERT_EQUAL_UINT32(6, oled->commands);
+
+    // Same value: nothing is sent
+    device.dataBytes = 0;
+    oled->commands = 0;
+    oled->updateField(SSD1306::field_temperature, 2345, 2);
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(0, device.dataBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, oled->commands);
+
+    // Last digit changes: one glyph, 16 bytes, in a single Wire transaction
+    device.transfers = 0;
+    oled->updateField(SSD1306::field_temperature, 2346, 2);
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(16, device.dataBytes);
+    TEST_ASSERT_EQUAL_UINT32(1, device.transfers);
+    TEST_ASSERT_EQUAL_UINT32(1, oled->fullTransfers);
+}
+
+void test_flush_splits_wire_transactions(void)
+{
+    // Two fields on different pages, different columns: two windows, each under the Wire buffer
+    oled->updateField(SSD1306::field_temperature, 2345, 2);
+    oled->updateField(SSD1306::field_humidity, 5012, 2);
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(2 * 5 * 8 * 2, device.dataBytes);
+    // Each window streams 80 bytes, at most 31 per transaction after the control byte
+    TEST_ASSERT_EQUAL_UINT32(2 * ((80 + 30) / 31), device.transfers);
+}
+
+void test_updates_off_screen_ignored(void)
+{
+    oled->printScreen(SSD1306::Screens::screen_status);
+    oled->updateField(SSD1306::field_temperature, 2345, 2);
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(0, device.dataBytes);
+
+    // A status line marks only its value columns
+    oled->updateStatus(SSD1306::status_samples, 42, 0);
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(SSD1306::STATUS_CHARS * 6, device.dataBytes);
+}
+
+void test_trend_plot(void)
+{
+    oled->printScreen(SSD1306::Screens::screen_trends);
+    for (int16_t i = 0; i < SSD1306::TREND_LENGTH; i++)
+    {
+        oled->pushTrend(2000 + i * 10);
+    }
+    // Oldest (lowest) value at the bottom left, newest (highest) at the top right
+    TEST_ASSERT_TRUE(oled->getPixel(0, 63));
+    TEST_ASSERT_TRUE(oled->getPixel(1, 63));
+    TEST_ASSERT_TRUE(oled->getPixel(126, 8));
+    TEST_ASSERT_TRUE(oled->getPixel(127, 8));
+    // The title page is left alone
+    oled->flush();
+    TEST_ASSERT_EQUAL_UINT32(7 * SSD1306::DISPLAY_WIDTH, device.dataBytes);
+}
+
+void test_iaq_from_gas_baseline(void)
+{
+    static const GasBaseline::BurnInStep noSteps[1] PROGMEM = {{0, 0, 0}};
+    GasBaseline gas(noSteps, 0);
+    GasBaseline::Checkpoint checkpoint = {200000UL, GasBaseline::checkpoint_valid};
+    gas.restore(&checkpoint);
+    TEST_ASSERT_EQUAL_UINT32(200000UL, gas.getBaseline());
+
+    // At or above the baseline: clean air
+    TEST_ASSERT_EQUAL_UINT16(0, gas.getAirQuality(200000UL));
+    TEST_ASSERT_EQUAL_UINT16(0, gas.getAirQuality(GasBaseline::MAX_RESISTANCE));
+    // Linear in the ratio to the baseline
+    TEST_ASSERT_EQUAL_UINT16(250, gas.getAirQuality(100000UL));
+    TEST_ASSERT_EQUAL_UINT16(400, gas.getAirQuality(40000UL));
+    TEST_ASSERT_EQUAL_UINT16(GasBaseline::AIR_QUALITY_MAX, gas.getAirQuality(0));
+
+    oled->updateField(SSD1306::field_iaq, gas.getAirQuality(100000UL), 0);
+    // "    250": the '2' is the fifth glyph of the bottom field
+    checkGlyph(6, 4, glyphTwo);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_live_screen_starts_with_dashes);
+    RUN_TEST(test_field_glyph_bytes);
+    RUN_TEST(test_flush_sends_only_changed_glyphs);
+    RUN_TEST(test_flush_splits_wire_transactions);
+    RUN_TEST(test_updates_off_screen_ignored);
+    RUN_TEST(test_trend_plot);
+    RUN_TEST(test_iaq_from_gas_baseline);
+    return UNITY_END();
+}
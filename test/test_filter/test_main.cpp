@@ -0,0 +1,285 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Channel filter: 32-bit arithmetic against a 64-bit reference, step and noise response
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "filter.h"
+
+// The same filter with 64-bit intermediates, to check the 32-bit version bit for bit
+class ReferenceFilter
+{
+private:
+    uint32_t noiseRatio;
+    bool initialized;
+    int32_t estimate;
+    uint16_t remainder;
+    uint32_t variance;
+    bool bypass;
+
+public:
+    ReferenceFilter(uint16_t measurementNoise, uint16_t processNoise)
+    {
+        bypass = processNoise == 0;
+        uint32_t r = measurementNoise > 0 ? measurementNoise : 1;
+        uint64_t ratio = ((uint64_t)processNoise * processNoise << 16) / (r * r);
+        noiseRatio = ratio > 0x7FFFFFFF ? 0x7FFFFFFF : (uint32_t)ratio;
+        initialized = false;
+    }
+
+    int32_t update(int32_t value)
+    {
+        if (!initialized || bypass)
+        {
+            initialized = true;
+            estimate = value;
+            remainder = 0;
+            variance = 65536;
+            return value;
+        }
+        variance += noiseRatio;
+        uint32_t numerator = variance;
+        uint32_t denominator = variance + 65536;
+        while (numerator >= 65536)
+        {
+            numerator >>= 1;
+            denominator >>= 1;
+        }
+        uint16_t gain = (numerator << 16) / denominator;
+        variance = gain;
+        int64_t step = ((int64_t)value - estimate) * gain - (((uint32_t)remainder * gain) >> 16) + remainder;
+        estimate = (int32_t)(estimate + (step >> 16));
+        remainder = (uint16_t)step;
+        return estimate + (remainder >> 15);
+    }
+};
+
+static uint32_t randomState = 12345;
+
+static uint32_t random32()
+{
+    randomState = randomState * 1664525UL + 1013904223UL;
+    return randomState;
+}
+
+// Roughly normal noise: the sum of 12 uniform values, scaled to the given standard deviation
+static int32_t gaussian(uint16_t sigma)
+{
+    int32_t sum = 0;
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        sum += (int32_t)(random32() >> 20) - 2048;
+    }
+    return (int32_t)((int64_t)sum * sigma / 4096);
+}
+
+static ChannelFilter makeFilter(uint8_t window, uint16_t measurementNoise, uint16_t processNoise)
+{
+    ChannelFilter::Parameters params = {window, measurementNoise, processNoise};
+    ChannelFilter filter;
+    filter.configure(&params);
+    return filter;
+}
+
+void setUp(void)
+{
+    randomState = 12345;
+}
+
+void tearDown(void) {}
+
+void test_matches_64bit_reference(void)
+{
+    // Values up to the whole int32 range in both directions, over many noise settings
+    static const uint16_t noises[][2] = {{1, 1},  {4, 1},      {40, 5},         {2000, 300},
+                                         {3, 60000}, {65535, 1}, {65535, 65535}, {1, 65535}};
+    for (uint8_t n = 0; n < sizeof(noises) / sizeof(noises[0]); n++)
+    {
+        ChannelFilter filter = makeFilter(1, noises[n][0], noises[n][1]);
+        ReferenceFilter reference(noises[n][0], noises[n][1]);
+        for (uint32_t i = 0; i < 20000; i++)
+        {
+            uint8_t shift = random32() % 31;
+            int32_t value = (int32_t)(random32() >> 1) >> shift;
+            value = (random32() & 1) ? -value : value;
+            int32_t expected = reference.update(value);
+            int32_t actual = filter.update(value);
+            if (expected != actual)
+            {
+                char message[96];
+                snprintf(message, sizeof(message), "r=%u q=%u sample %lu", noises[n][0], noises[n][1],
+                         (unsigned long)i);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+void test_noise_ratio_exact(void)
+{
+    // configure() divides in 32 bits only; the ratio must still equal floor(q^2 * 2^16 / r^2)
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        uint16_t r = (uint16_t)(random32() >> (16 + random32() % 16));
+        uint16_t q = (uint16_t)(random32() >> (16 + random32() % 16));
+        ReferenceFilter reference(r, q);
+        ChannelFilter filter = makeFilter(1, r, q);
+        // The ratio sets every gain, so a wrong bit shows up in the output of a large step
+        filter.update(0);
+        reference.update(0);
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            TEST_ASSERT_EQUAL_INT32(reference.update(1000000000), filter.update(1000000000));
+        }
+    }
+}
+
+void test_gain_converges_to_steady_state(void)
+{
+    // Random walk: the steady gain solves k^2 + s k - s = 0 with s = q^2 / r^2
+    static const uint16_t noises[][2] = {{4, 1}, {20, 4}, {3, 1}, {2000, 300}, {10, 10}};
+    for (uint8_t n = 0; n < sizeof(noises) / sizeof(noises[0]); n++)
+    {
+        ChannelFilter filter = makeFilter(1, noises[n][0], noises[n][1]);
+        for (uint8_t i = 0; i < 200; i++)
+        {
+            filter.update(0);
+        }
+        double s = (double)noises[n][1] * noises[n][1] / ((double)noises[n][0] * noises[n][0]);
+        double k = (-s + sqrt(s * s + 4 * s)) / 2;
+        TEST_ASSERT_FLOAT_WITHIN(0.002, k, filter.getGain() / 65536.0);
+    }
+}
+
+void test_step_response(void)
+{
+    // A 500 count step, no noise: monotonic, no overshoot, and it settles on the new value
+    ChannelFilter filter = makeFilter(3, 40, 5);
+    for (uint8_t i = 0; i < 50; i++)
+    {
+        filter.update(1000);
+    }
+    int32_t previous = 1000;
+    int16_t reached = -1;
+    for (uint8_t i = 0; i < 200; i++)
+    {
+        int32_t out = filter.update(1500);
+        TEST_ASSERT_TRUE(out >= previous);
+        TEST_ASSERT_TRUE(out <= 1500);
+        if (reached < 0 && out >= 1450)
+        {
+            reached = i;
+        }
+        previous = out;
+    }
+    TEST_ASSERT_EQUAL_INT32(1500, previous);
+    // The median delays by one sample, the steady gain of about 0.12 does the rest
+    TEST_ASSERT_TRUE(reached > 5 && reached < 30);
+    char message[64];
+    snprintf(message, sizeof(message), "90%% of the step after %d samples", reached + 1);
+    TEST_MESSAGE(message);
+}
+
+void test_no_dead_band(void)
+{
+    // With a gain far below 1 / step, the carried fraction still walks the estimate all the way
+    ChannelFilter filter = makeFilter(1, 2000, 10);
+    filter.update(0);
+    int32_t out = 0;
+    for (uint16_t i = 0; i < 20000; i++)
+    {
+        out = filter.update(3);
+    }
+    TEST_ASSERT_EQUAL_INT32(3, out);
+    for (uint16_t i = 0; i < 20000; i++)
+    {
+        out = filter.update(-3);
+    }
+    TEST_ASSERT_EQUAL_INT32(-3, out);
+}
+
+void test_noise_and_spike_rejection(void)
+{
+    // Sigma 40 noise with a +3000 spike every 25 samples around a constant value
+    ChannelFilter filter = makeFilter(3, 40, 5);
+    double rawSquares = 0;
+    double filteredSquares = 0;
+    int32_t worst = 0;
+    const uint16_t count = 5000;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        int32_t noise = gaussian(40);
+        int32_t value = 10000 + noise + (i % 25 == 24 ? 3000 : 0);
+        int32_t out = filter.update(value);
+        rawSquares += (double)noise * noise;
+        if (i >= 100)
+        {
+            int32_t error = out - 10000;
+            filteredSquares += (double)error * error;
+            worst = abs(error) > worst ? abs(error) : worst;
+        }
+    }
+    double rawRms = sqrt(rawSquares / count);
+    double filteredRms = sqrt(filteredSquares / (count - 100));
+    // The median removes every spike, the Kalman stage cuts the noise by more than half
+    TEST_ASSERT_TRUE(worst < 200);
+    TEST_ASSERT_TRUE(filteredRms < rawRms / 2);
+    char message[64];
+    snprintf(message, sizeof(message), "RMS error %.1f in, %.1f out", rawRms, filteredRms);
+    TEST_MESSAGE(message);
+}
+
+void test_disabled_stages_pass_through(void)
+{
+    ChannelFilter filter = makeFilter(1, 40, 0);
+    for (int32_t i = -1000; i < 1000; i += 37)
+    {
+        TEST_ASSERT_EQUAL_INT32(i * 1000, filter.update(i * 1000));
+    }
+}
+
+void test_sample_clamps(void)
+{
+    SampleFilter filters;
+    SampleRecord sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.channels = channel_temperature | channel_humidity;
+    sample.temperature = 2000;
+    sample.humidity = 9990;
+    filters.apply(&sample);
+    // Humidity overshooting 100% through a spike-free run is still clamped
+    sample.humidity = 10000;
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        filters.apply(&sample);
+        TEST_ASSERT_TRUE(sample.humidity <= 10000);
+        sample.humidity = 10000;
+    }
+    // Channels not in the sample are left alone
+    sample.channels = channel_temperature;
+    sample.pressure = 123;
+    filters.apply(&sample);
+    TEST_ASSERT_EQUAL_UINT32(123, sample.pressure);
+    TEST_ASSERT_NULL(filters.getChannel(SampleFilter::filter_channels));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_64bit_reference);
+    RUN_TEST(test_noise_ratio_exact);
+    RUN_TEST(test_gain_converges_to_steady_state);
+    RUN_TEST(test_step_response);
+    RUN_TEST(test_no_dead_band);
+    RUN_TEST(test_noise_and_spike_rejection);
+    RUN_TEST(test_disabled_stages_pass_through);
+    RUN_TEST(test_sample_clamps);
+    return UNITY_END();
+}
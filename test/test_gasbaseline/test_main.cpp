@@ -0,0 +1,260 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Gas burn-in and warm start replayed on simulated MOX traces, with the checkpoints in a
+ * ConfigStore on the simulated EEPROM as the firmware keeps them
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "gasbaseline.h"
+#include "configstore.h"
+#include "hardware.h"
+
+// The schedule of the firmware: 30 min at 400 °C, 30 min at 360 °C
+static const GasBaseline::BurnInStep schedule[] PROGMEM = {
+    {1, 400, 1800},
+    {2, 360, 1800},
+};
+#define STEPS (sizeof(schedule) / sizeof(schedule[0]))
+
+// Sample period of the replays, in seconds
+#define SAMPLE_S 3
+
+/**
+ * A MOX trace: clean air resistance `clean`, approached exponentially from clean * (1 + drift)
+ * with time constant `tau` seconds, with +/-`noise` relative uniform noise
+ */
+typedef struct
+{
+    double clean;
+    double drift;
+    double tau;
+    double noise;
+    uint32_t seed;
+} Trace;
+
+static uint32_t traceAt(Trace *trace, uint32_t t)
+{
+    trace->seed = trace->seed * 1103515245UL + 12345;
+    double uniform = ((trace->seed >> 8) & 0xFFFF) / 32767.5 - 1;
+    return (uint32_t)(trace->clean * (1 + trace->drift * exp(-(double)t / trace->tau)) * (1 + trace->noise * uniform));
+}
+
+/**
+ * One boot of the firmware, as setupGas() and updateGas() in main.cpp: restore from the newest
+ * checkpoint, then feed the trace and write the checkpoints that fall due, until `seconds` have
+ * passed or the readings are valid (when `untilValid`)
+ */
+static GasBaseline *boot(Trace *trace, uint32_t seconds, bool untilValid)
+{
+    static GasBaseline *baseline = nullptr;
+    delete baseline;
+    baseline = new GasBaseline(schedule, STEPS);
+    ConfigStore store(EEPROM_GAS_ADD, EEPROM_GAS_SLOTS, EEPROM_GAS_SLOT_SIZE, ConfigStore::TYPE_GAS_BASELINE);
+    GasBaseline::Checkpoint checkpoint = {0, 0};
+    if (store.begin() && store.loadRecord(&checkpoint, sizeof(checkpoint)))
+    {
+        baseline->restore(&checkpoint);
+    }
+    for (uint32_t t = 0; t < seconds && !(untilValid && baseline->isValid()); t += SAMPLE_S)
+    {
+        baseline->update(traceAt(trace, t), true, t);
+        if (baseline->isCheckpointDue(t))
+        {
+            baseline->getCheckpoint(&checkpoint);
+            baseline->markCheckpoint(t, store.saveRecord(&checkpoint, sizeof(checkpoint), GasBaseline::CHECKPOINT_VERSION));
+        }
+    }
+    return baseline;
+}
+
+static void report(const char *what, uint32_t seconds)
+{
+    char message[80];
+    snprintf(message, sizeof(message), "%s: valid after %lu s", what, (unsigned long)seconds);
+    TEST_MESSAGE(message);
+}
+
+void setUp(void)
+{
+    EEPROM.erase();
+}
+
+void tearDown(void) {}
+
+void test_schedule_then_operating_profile(void)
+{
+    GasBaseline baseline(schedule, STEPS);
+    uint8_t point = 0xFF;
+    uint16_t temp = 0;
+    baseline.update(100000, true, 0);
+    TEST_ASSERT_TRUE(baseline.getHeater(&point, &temp));
+    TEST_ASSERT_EQUAL_UINT8(1, point);
+    TEST_ASSERT_EQUAL_UINT16(400, temp);
+    baseline.update(100000, true, 1799);
+    TEST_ASSERT_TRUE(baseline.getHeater(&point, &temp));
+    TEST_ASSERT_EQUAL_UINT16(400, temp);
+    baseline.update(100000, true, 1800);
+    TEST_ASSERT_TRUE(baseline.getHeater(&point, &temp));
+    TEST_ASSERT_EQUAL_UINT8(2, point);
+    TEST_ASSERT_EQUAL_UINT16(360, temp);
+    // A gap in the samples skips the steps it covers
+    baseline.update(100000, false, 4000);
+    TEST_ASSERT_FALSE(baseline.getHeater(&point, &temp));
+    TEST_ASSERT_EQUAL_UINT8(GasBaseline::state_burn_in, baseline.getState());
+}
+
+void test_window_mean_at_a_high_rate(void)
+{
+    // Ten samples a second, 600 per window, half of them past the clamp: the mean is of all of
+    // them, and their sum is beyond 32 bits
+    GasBaseline baseline(schedule, 0);
+    const uint32_t low = 100000;
+    for (uint16_t i = 0; !baseline.isValid(); i++)
+    {
+        TEST_ASSERT_TRUE(i / 10 < 3600);
+        baseline.update(i % 600 < 300 ? low : 0xFFFFFFFFUL, true, i / 10);
+    }
+    // The first sample of a window closes the previous one, so every window but the first holds
+    // 300 of each
+    TEST_ASSERT_EQUAL_UINT32((low + GasBaseline::MAX_RESISTANCE) / 2, baseline.getBaseline());
+}
+
+void test_cold_then_warm_start(void)
+{
+    // A new sensor: 60% above its clean air resistance, settling with a 40 min time constant
+    Trace cold = {120000, 0.6, 2400, 0.01, 1};
+    GasBaseline *baseline = boot(&cold, 8 * 3600UL, true);
+    TEST_ASSERT_TRUE(baseline->isValid());
+    uint32_t coldSettle = baseline->getSettleSeconds();
+    report("cold start", coldSettle);
+    // Past the schedule, once the slope stays below 60 permille/h
+    TEST_ASSERT_TRUE(coldSettle >= 2 * 3600UL);
+    TEST_ASSERT_UINT32_WITHIN(120000 / 50, 120000, baseline->getBaseline());
+
+    // Powered off once valid (the checkpoint is written then), and on again a while later: the
+    // sensor restarts 15% high and settles with a 5 min time constant
+    Trace warm = {120000, 0.15, 300, 0.01, 2};
+    baseline = boot(&warm, 3600, true);
+    TEST_ASSERT_TRUE(baseline->isValid());
+    uint32_t warmSettle = baseline->getSettleSeconds();
+    report("warm start", warmSettle);
+    TEST_ASSERT_TRUE(warmSettle * 5 < coldSettle);
+
+    // After a short power cut: 3% high, 2 min time constant. The slope window fills in 8 minutes
+    Trace brief = {120000, 0.03, 120, 0.01, 3};
+    baseline = boot(&brief, 3600, true);
+    TEST_ASSERT_TRUE(baseline->isValid());
+    uint32_t briefSettle = baseline->getSettleSeconds();
+    report("warm start after a short power cut", briefSettle);
+    TEST_ASSERT_TRUE(briefSettle <= (GasBaseline::SLOPE_WINDOWS + GasBaseline::WARM_STABLE_WINDOWS + 2) * GasBaseline::WINDOW_S);
+}
+
+void test_warm_start_falls_back_to_burn_in(void)
+{
+    Trace cold = {120000, 0.6, 2400, 0.01, 3};
+    TEST_ASSERT_TRUE(boot(&cold, 8 * 3600UL, true)->isValid());
+
+    // A replaced sensor: flat, but at a third of the stored baseline
+    Trace other = {40000, 0, 1, 0.01, 4};
+    GasBaseline *baseline = boot(&other, GasBaseline::WARM_TIMEOUT_S + 10 * SAMPLE_S, false);
+    TEST_ASSERT_EQUAL_UINT8(GasBaseline::state_burn_in, baseline->getState());
+    uint8_t point;
+    uint16_t temp;
+    TEST_ASSERT_TRUE(baseline->getHeater(&point, &temp));
+
+    // The stored baseline was invalidated: the next boot is a cold one
+    baseline = boot(&other, SAMPLE_S, false);
+    TEST_ASSERT_EQUAL_UINT8(GasBaseline::state_burn_in, baseline->getState());
+}
+
+void test_checkpoints_are_rate_limited(void)
+{
+    // Valid for three days on a baseline wandering +/-10% over a day
+    Trace cold = {120000, 0.6, 2400, 0.01, 5};
+    GasBaseline *baseline = boot(&cold, 8 * 3600UL, true);
+    TEST_ASSERT_TRUE(baseline->isValid());
+    ConfigStore store(EEPROM_GAS_ADD, EEPROM_GAS_SLOTS, EEPROM_GAS_SLOT_SIZE, ConfigStore::TYPE_GAS_BASELINE);
+    TEST_ASSERT_TRUE(store.begin());
+    uint16_t sequence = store.getSequence();
+
+    GasBaseline::Checkpoint checkpoint;
+    uint32_t writes = 0;
+    uint32_t start = baseline->getSettleSeconds();
+    for (uint32_t t = start + SAMPLE_S; t < start + 3 * 86400UL; t += SAMPLE_S)
+    {
+        double day = 2 * M_PI * t / 86400;
+        baseline->update((uint32_t)(120000 * (1 + 0.1 * sin(day))), true, t);
+        if (baseline->isCheckpointDue(t))
+        {
+            baseline->getCheckpoint(&checkpoint);
+            baseline->markCheckpoint(t, store.saveRecord(&checkpoint, sizeof(checkpoint), GasBaseline::CHECKPOINT_VERSION));
+            writes++;
+        }
+    }
+    // At most one an hour, and only while the baseline moves by 2%
+    TEST_ASSERT_TRUE(writes > 0);
+    TEST_ASSERT_TRUE(writes <= 72);
+    TEST_ASSERT_EQUAL_UINT16(sequence + writes, store.getSequence());
+    char message[64];
+    snprintf(message, sizeof(message), "%lu checkpoints in 3 days", (unsigned long)writes);
+    TEST_MESSAGE(message);
+
+    // Failed writes are retried once per window, not on every sample
+    EEPROM.writesLeft = 0;
+    uint32_t t = start + 3 * 86400UL;
+    while (!baseline->isCheckpointDue(t))
+    {
+        baseline->update(200000, true, t += SAMPLE_S);
+    }
+    uint16_t attempts = 0;
+    for (uint32_t end = t + 10 * GasBaseline::WINDOW_S; t < end; t += SAMPLE_S)
+    {
+        baseline->update(200000, true, t);
+        if (baseline->isCheckpointDue(t))
+        {
+            baseline->getCheckpoint(&checkpoint);
+            baseline->markCheckpoint(t, store.saveRecord(&checkpoint, sizeof(checkpoint), GasBaseline::CHECKPOINT_VERSION));
+            attempts++;
+        }
+    }
+    TEST_ASSERT_UINT16_WITHIN(1, 10, attempts);
+}
+
+void test_air_quality(void)
+{
+    GasBaseline baseline(schedule, STEPS);
+    GasBaseline::Checkpoint checkpoint = {200000, GasBaseline::checkpoint_valid};
+    TEST_ASSERT_TRUE(baseline.restore(&checkpoint));
+    TEST_ASSERT_EQUAL_UINT8(GasBaseline::state_warm_start, baseline.getState());
+    TEST_ASSERT_EQUAL_UINT16(0, baseline.getAirQuality(250000));
+    TEST_ASSERT_EQUAL_UINT16(0, baseline.getAirQuality(200000));
+    TEST_ASSERT_EQUAL_UINT16(250, baseline.getAirQuality(100000));
+    TEST_ASSERT_EQUAL_UINT16(GasBaseline::AIR_QUALITY_MAX, baseline.getAirQuality(0));
+
+    // A checkpoint without the valid flag, or without a baseline, is a cold start
+    GasBaseline cold(schedule, STEPS);
+    checkpoint.flags = 0;
+    TEST_ASSERT_FALSE(cold.restore(&checkpoint));
+    checkpoint = {0, GasBaseline::checkpoint_valid};
+    TEST_ASSERT_FALSE(cold.restore(&checkpoint));
+    TEST_ASSERT_EQUAL_UINT8(GasBaseline::state_burn_in, cold.getState());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_schedule_then_operating_profile);
+    RUN_TEST(test_window_mean_at_a_high_rate);
+    RUN_TEST(test_cold_then_warm_start);
+    RUN_TEST(test_warm_start_falls_back_to_burn_in);
+    RUN_TEST(test_checkpoints_are_rate_limited);
+    RUN_TEST(test_air_quality);
+    return UNITY_END();
+}
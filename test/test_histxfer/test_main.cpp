@@ -0,0 +1,439 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief History export over a lossy link: go-back-N recovery and resume after the ring moved
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <deque>
+#include <vector>
+#include <hoststub.h>
+
+#include "histxfer.h"
+#include "samplelog.h"
+#include "configstore.h"
+#include <host24c32.h>
+
+#define LOG_PERIOD_S 60
+// Link throughput, in bytes per simulated millisecond each way
+#define LINK_BYTES_PER_MS 4
+// Longest simulated transfer, in milliseconds
+#define MAX_TRANSFER_MS 3600000UL
+
+static uint32_t random32;
+
+static uint32_t nextRandom()
+{
+    random32 ^= random32 << 13;
+    random32 ^= random32 >> 17;
+    random32 ^= random32 << 5;
+    return random32;
+}
+
+/**
+ * The device end of the serial link: what the host sends arrives in rx, what the device writes
+ * waits in a 63-byte transmit buffer until the link carries it
+ */
+class DeviceLink : public Stream
+{
+public:
+    std::deque<uint8_t> rx;
+    std::deque<uint8_t> tx;
+
+    int available() override
+    {
+        return rx.size();
+    }
+    int read() override
+    {
+        if (rx.empty())
+        {
+            return -1;
+        }
+        uint8_t c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    int peek() override
+    {
+        return rx.empty() ? -1 : rx.front();
+    }
+    size_t write(uint8_t c) override
+    {
+        TEST_ASSERT_LESS_THAN(SERIAL_TX_BUFFER_SIZE - 1, tx.size());
+        tx.push_back(c);
+        return 1;
+    }
+    using Print::write;
+    int availableForWrite() override
+    {
+        return SERIAL_TX_BUFFER_SIZE - 1 - tx.size();
+    }
+};
+
+/**
+ * The receiving side of tools/histdl.cpp: accepts data frames in order, acknowledges
+ * cumulatively, repeats its acknowledgement after a silence
+ */
+class HostReceiver
+{
+public:
+    std::vector<uint8_t> buffer;
+    bool started;
+    bool resume;
+    bool done;
+    uint16_t expected;
+    uint16_t firstSeq;
+    unsigned long lastFrame;
+    unsigned long lastAck;
+    std::deque<uint8_t> acks;
+    // Received blocks, in order
+    std::vector<std::vector<uint8_t> > blocks;
+    std::vector<uint16_t> sequences;
+
+    HostReceiver()
+    {
+        reset(false, 0);
+    }
+    void reset(bool resumeFrom, uint16_t block)
+    {
+        buffer.clear();
+        started = false;
+        resume = resumeFrom;
+        done = false;
+        expected = block;
+        firstSeq = 0;
+        lastFrame = millis();
+        lastAck = 0;
+        acks.clear();
+    }
+    void sendAck(uint16_t seq)
+    {
+        uint8_t frame[7] = {HistoryExport::SYNC, HistoryExport::FRAME_ACK, (uint8_t)seq, (uint8_t)(seq >> 8), 0, 0, 0};
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 1; i < 5; i++)
+        {
+            crc = ConfigStore::crc16(crc, frame[i]);
+        }
+        frame[5] = crc >> 8;
+        frame[6] = crc & 0xFF;
+        acks.insert(acks.end(), frame, frame + 7);
+        lastAck = millis();
+    }
+    void receive(uint8_t c)
+    {
+        buffer.push_back(c);
+        for (;;)
+        {
+            size_t start = 0;
+            while (start < buffer.size() && buffer[start] != HistoryExport::SYNC)
+            {
+                start++;
+            }
+            buffer.erase(buffer.begin(), buffer.begin() + start);
+            if (buffer.size() < 5 || buffer.size() < (size_t)buffer[4] + 7)
+            {
+                return;
+            }
+            size_t total = buffer[4] + 7;
+            uint16_t crc = 0xFFFF;
+            for (size_t i = 1; i < total - 2; i++)
+            {
+                crc = ConfigStore::crc16(crc, buffer[i]);
+            }
+            if (crc != ((buffer[total - 2] << 8) | buffer[total - 1]))
+            {
+                buffer.erase(buffer.begin());
+                continue;
+            }
+            handle(total);
+            buffer.erase(buffer.begin(), buffer.begin() + total);
+        }
+    }
+    void handle(size_t total)
+    {
+        uint8_t type = buffer[1];
+        uint16_t seq = buffer[2] | (buffer[3] << 8);
+        if (!started && (type == HistoryExport::FRAME_DATA || type == HistoryExport::FRAME_END))
+        {
+            firstSeq = seq;
+            expected = seq;
+            started = true;
+        }
+        if (type == HistoryExport::FRAME_DATA && seq == expected)
+        {
+            blocks.push_back(std::vector<uint8_t>(buffer.begin() + 5, buffer.begin() + 5 + buffer[4]));
+            sequences.push_back(seq);
+            expected++;
+            sendAck(expected);
+        }
+        else if (type == HistoryExport::FRAME_END && seq == expected)
+        {
+            sendAck(expected + 1);
+            done = true;
+        }
+        else
+        {
+            sendAck(expected);
+        }
+        lastFrame = millis();
+        (void)total;
+    }
+    void idle()
+    {
+        if (started && millis() - lastFrame > 500 && millis() - lastAck > 500)
+        {
+            sendAck(expected);
+        }
+    }
+};
+
+static Host24C32 *eeprom;
+static SampleLog *sampleLog;
+static HistoryExport *historyExport;
+static DeviceLink link;
+static HostReceiver host;
+static SampleRecord sample;
+static std::vector<SampleRecord> appended;
+
+static void drainLog()
+{
+    while (!sampleLog->isIdle())
+    {
+        sampleLog->poll();
+        hostAdvanceMicros(1000);
+    }
+}
+
+static void appendSamples(uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint32_t r = nextRandom();
+        sample.timestamp += LOG_PERIOD_S;
+        sample.temperature += (int16_t)(r & 0x1F) - 15;
+        sample.humidity = (uint16_t)constrain((int32_t)sample.humidity + (int32_t)((r >> 5) & 0x0F) - 7, 0, 10000);
+        sample.pressure += (int32_t)((r >> 9) & 0x3F) - 31;
+        sample.gasResistance += (r >> 15) & 0xFF;
+        appended.push_back(sample);
+        sampleLog->append(&sample);
+        drainLog();
+    }
+}
+
+/**
+ * Runs device and host until the transfer ends or stopAfter blocks have been received. Each
+ * byte on the link is corrupted with probability 1 / corruptOneIn (0 = lossless), each way.
+ */
+static void runTransfer(uint32_t corruptOneIn, size_t stopAfter)
+{
+    unsigned long start = millis();
+    while (historyExport->isActive() && millis() - start < MAX_TRANSFER_MS)
+    {
+        historyExport->poll();
+        sampleLog->poll();
+        for (uint8_t i = 0; i < LINK_BYTES_PER_MS && !link.tx.empty(); i++)
+        {
+            uint8_t c = link.tx.front();
+            link.tx.pop_front();
+            if (corruptOneIn != 0 && nextRandom() % corruptOneIn == 0)
+            {
+                c ^= 1 << (nextRandom() & 7);
+            }
+            host.receive(c);
+        }
+        host.idle();
+        if (stopAfter != 0 && host.blocks.size() >= stopAfter)
+        {
+            // Link lost: nothing more reaches the device, which gives up after IDLE_TIMEOUT_MS
+            host.acks.clear();
+            hostAdvanceMillis(HistoryExport::IDLE_TIMEOUT_MS + 1);
+            for (uint8_t i = 0; i < 100 && historyExport->isActive(); i++)
+            {
+                link.tx.clear();
+                historyExport->poll();
+            }
+            link.tx.clear();
+            return;
+        }
+        for (uint8_t i = 0; i < LINK_BYTES_PER_MS && !host.acks.empty(); i++)
+        {
+            uint8_t c = host.acks.front();
+            host.acks.pop_front();
+            if (corruptOneIn != 0 && nextRandom() % corruptOneIn == 0)
+            {
+                c ^= 1 << (nextRandom() & 7);
+            }
+            link.rx.push_back(c);
+        }
+        hostAdvanceMillis(1);
+    }
+}
+
+/**
+ * Decodes the received blocks; the samples must be exactly the appended ones from the first
+ * decoded timestamp on, one period apart: nothing skipped, nothing repeated
+ */
+static size_t checkReceived(size_t fromBlock)
+{
+    size_t count = 0;
+    uint32_t previous = 0;
+    for (size_t b = fromBlock; b < host.blocks.size(); b++)
+    {
+        const std::vector<uint8_t> &block = host.blocks[b];
+        if (block.empty())
+        {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT16(host.sequences[b], block[0] | (block[1] << 8));
+        SeriesDecoder decoder;
+        uint16_t offset = SampleLog::HEADER_SIZE;
+        for (uint8_t i = 0; i < block[3]; i++)
+        {
+            SampleRecord decoded;
+            uint16_t n = (i == 0) ? decoder.decodeKeyframe(&block[offset], block.size() - offset, &decoded)
+                                  : decoder.decodeDelta(&block[offset], block.size() - offset, &decoded);
+            TEST_ASSERT_TRUE(n != 0);
+            offset += n;
+            if (count > 0)
+            {
+                TEST_ASSERT_EQUAL_UINT32(previous + LOG_PERIOD_S, decoded.timestamp);
+            }
+            previous = decoded.timestamp;
+            size_t index = (decoded.timestamp - appended[0].timestamp) / LOG_PERIOD_S;
+            TEST_ASSERT_EQUAL_INT16(appended[index].temperature, decoded.temperature);
+            TEST_ASSERT_EQUAL_UINT32(appended[index].pressure, decoded.pressure);
+            count++;
+        }
+    }
+    return count;
+}
+
+void setUp(void)
+{
+    random32 = 0x2545F491;
+    eeprom = new Host24C32();
+    Wire.detachAll();
+    Wire.attach(EEPROM_ADDRESS, eeprom);
+    sampleLog = new SampleLog(EEPROM_ADDRESS, LOG_PERIOD_S);
+    sampleLog->begin();
+    drainLog();
+    historyExport = new HistoryExport(sampleLog);
+    link.rx.clear();
+    link.tx.clear();
+    host = HostReceiver();
+    appended.clear();
+    SampleRecord first = {1700000000UL, 2150, 4500, 101325, 120000, channel_all};
+    sample = first;
+}
+
+void tearDown(void)
+{
+    delete historyExport;
+    delete sampleLog;
+    delete eeprom;
+}
+
+void test_lossless_transfer(void)
+{
+    appendSamples(300);
+    TEST_ASSERT_TRUE(historyExport->start(&link, false, 0));
+    runTransfer(0, 0);
+    TEST_ASSERT_TRUE(host.done);
+    TEST_ASSERT_FALSE(historyExport->isActive());
+    TEST_ASSERT_EQUAL_UINT16(0, historyExport->getRetransmissions());
+    // Every block, the one being filled included, and every sample
+    TEST_ASSERT_EQUAL_size_t(sampleLog->getBlockCount() + 1, host.blocks.size());
+    TEST_ASSERT_EQUAL_UINT16(sampleLog->getOldestSequence(), host.firstSeq);
+    TEST_ASSERT_EQUAL_size_t(300, checkReceived(0));
+}
+
+void test_lossy_link_recovers(void)
+{
+    // Enough samples to wrap the ring, so frames carry the sequence numbers, not ring positions
+    appendSamples(2000);
+    TEST_ASSERT_TRUE(historyExport->start(&link, false, 0));
+    // About one frame in four is corrupted
+    runTransfer(500, 0);
+    TEST_ASSERT_TRUE(host.done);
+    TEST_ASSERT_GREATER_THAN(0, historyExport->getRetransmissions());
+    TEST_ASSERT_EQUAL_size_t(sampleLog->getBlockCount() + 1, host.blocks.size());
+    // In order, each exactly once
+    for (size_t i = 1; i < host.sequences.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_UINT16(host.sequences[i - 1] + 1, host.sequences[i]);
+    }
+    size_t samples = checkReceived(0);
+    TEST_ASSERT_EQUAL_UINT32(appended.back().timestamp, appended[appended.size() - samples].timestamp + (samples - 1) * LOG_PERIOD_S);
+
+    char message[80];
+    snprintf(message, sizeof(message), "%u blocks, %u go-back-N retransmissions", (unsigned)host.blocks.size(),
+             historyExport->getRetransmissions());
+    TEST_MESSAGE(message);
+}
+
+void test_resume_after_ring_moved(void)
+{
+    appendSamples(2000);
+    TEST_ASSERT_TRUE(historyExport->start(&link, false, 0));
+    runTransfer(0, 10);
+    TEST_ASSERT_FALSE(historyExport->isActive());
+    uint16_t resumeFrom = host.expected;
+    uint16_t oldestBefore = sampleLog->getOldestSequence();
+
+    // The log keeps going while the link is down: the oldest blocks are overwritten
+    appendSamples(200);
+    TEST_ASSERT_GREATER_THAN(oldestBefore, sampleLog->getOldestSequence());
+    TEST_ASSERT_TRUE((int16_t)(resumeFrom - sampleLog->getOldestSequence()) > 0);
+
+    host.reset(true, resumeFrom);
+    TEST_ASSERT_TRUE(historyExport->start(&link, true, resumeFrom));
+    runTransfer(0, 0);
+    TEST_ASSERT_TRUE(host.done);
+    // The transfer continues exactly where it stopped
+    TEST_ASSERT_EQUAL_UINT16(resumeFrom, host.firstSeq);
+    checkReceived(0);
+}
+
+void test_resume_after_block_overwritten(void)
+{
+    appendSamples(2000);
+    TEST_ASSERT_TRUE(historyExport->start(&link, false, 0));
+    runTransfer(0, 3);
+    uint16_t resumeFrom = host.expected;
+
+    // Down long enough for the block to resume from to be overwritten
+    appendSamples(1200);
+    TEST_ASSERT_TRUE((int16_t)(resumeFrom - sampleLog->getOldestSequence()) < 0);
+
+    size_t before = host.blocks.size();
+    host.reset(true, resumeFrom);
+    TEST_ASSERT_TRUE(historyExport->start(&link, true, resumeFrom));
+    runTransfer(0, 0);
+    TEST_ASSERT_TRUE(host.done);
+    // The oldest block left, the gap visible from the sequence numbers
+    TEST_ASSERT_EQUAL_UINT16(sampleLog->getOldestSequence(), host.firstSeq);
+    checkReceived(before);
+}
+
+void test_resume_beyond_end_refused(void)
+{
+    appendSamples(100);
+    uint16_t end = sampleLog->getSequence() + 1;
+    TEST_ASSERT_FALSE(historyExport->start(&link, true, end + 1));
+    TEST_ASSERT_TRUE(historyExport->start(&link, true, end));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lossless_transfer);
+    RUN_TEST(test_lossy_link_recovers);
+    RUN_TEST(test_resume_after_ring_moved);
+    RUN_TEST(test_resume_after_block_overwritten);
+    RUN_TEST(test_resume_beyond_end_refused);
+    return UNITY_END();
+}
@@ -0,0 +1,252 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief I2C bus faults injected on the simulated bus: NACKs, short reads, hangs and a held SDA line
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+
+#include "i2cbus.h"
+#include "bme680.h"
+
+#define DEVICE_ADDRESS 0x42
+#define BME_ADDRESS 0x77
+
+// A slave that refuses data after its address
+class NackingDevice : public HostI2CDevice
+{
+public:
+    bool receive(const uint8_t *, uint8_t) override
+    {
+        return false;
+    }
+};
+
+// A slave that stops sending early
+class ShortDevice : public HostI2CDevice
+{
+public:
+    uint8_t transmit(uint8_t *data, uint8_t length) override
+    {
+        return HostI2CDevice::transmit(data, length / 2);
+    }
+};
+
+/**
+ * Line model: a slave interrupted mid-byte holds SDA low until it has seen `holdPulses` SCL
+ * clocks (0xFF: never). Lines are open drain, so a line reads low when anyone pulls it low.
+ */
+static uint8_t holdPulses;
+static uint8_t pulses;
+
+static void lineWrite(uint8_t pin, uint8_t level)
+{
+    if (pin == PIN_I2C_SCL && level == LOW && hostPinMode[pin] == OUTPUT)
+    {
+        pulses++;
+    }
+}
+
+static int lineRead(uint8_t pin)
+{
+    if (pin == PIN_I2C_SDA && (holdPulses == 0xFF || pulses < holdPulses))
+    {
+        return LOW;
+    }
+    return hostPinLevel[pin];
+}
+
+static HostI2CDevice device;
+
+void setUp(void)
+{
+    Wire.reset();
+    Wire.detachAll();
+    device = HostI2CDevice();
+    Wire.attach(DEVICE_ADDRESS, &device);
+    memset(hostPinLevel, 0, sizeof(hostPinLevel));
+    memset(hostPinMode, 0, sizeof(hostPinMode));
+    holdPulses = 0;
+    pulses = 0;
+    hostDigitalRead = lineRead;
+    hostDigitalWrite = lineWrite;
+    I2CBus::begin();
+}
+
+void tearDown(void)
+{
+    hostDigitalRead = nullptr;
+    hostDigitalWrite = nullptr;
+}
+
+void test_begin_arms_timeout(void)
+{
+    TEST_ASSERT_TRUE(Wire.started);
+    TEST_ASSERT_EQUAL_UINT32(I2C_TIMEOUT_US, Wire.timeoutMicros);
+}
+
+void test_transactions(void)
+{
+    uint16_t errors = I2CBus::getErrors();
+    const uint8_t reg = 0x10;
+    const uint8_t data[3] = {1, 2, 3};
+    TEST_ASSERT_TRUE(I2CBus::probe(DEVICE_ADDRESS));
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_none, I2CBus::write(DEVICE_ADDRESS, &reg, 1, data, 3));
+    TEST_ASSERT_EQUAL_MEMORY(data, &device.registers[0x10], 3);
+
+    uint8_t buf[3] = {0, 0, 0};
+    TEST_ASSERT_EQUAL_UINT8(3, I2CBus::read(DEVICE_ADDRESS, &reg, 1, buf, 3));
+    TEST_ASSERT_EQUAL_MEMORY(data, buf, 3);
+    TEST_ASSERT_EQUAL_UINT16(errors, I2CBus::getErrors());
+}
+
+void test_address_nack(void)
+{
+    uint16_t errors = I2CBus::getErrors();
+    device.absent = true;
+    const uint8_t reg = 0;
+    uint8_t buf[2] = {0xAA, 0xAA};
+    // A probe's NACK is its answer, not an error
+    TEST_ASSERT_FALSE(I2CBus::probe(DEVICE_ADDRESS));
+    TEST_ASSERT_FALSE(I2CBus::probe(0x11));
+    TEST_ASSERT_EQUAL_UINT16(errors, I2CBus::getErrors());
+
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_address_nack, I2CBus::write(DEVICE_ADDRESS, &reg, 1, buf, 2));
+    TEST_ASSERT_EQUAL_UINT8(0, I2CBus::read(DEVICE_ADDRESS, &reg, 1, buf, 2));
+    TEST_ASSERT_EQUAL_UINT8(0xAA, buf[0]);
+    TEST_ASSERT_EQUAL_UINT16(errors + 2, I2CBus::getErrors());
+    // Nothing to recover from
+    I2CBus::poll();
+    TEST_ASSERT_FALSE(Wire.getWireTimeoutFlag());
+}
+
+void test_data_nack_and_short_read(void)
+{
+    uint16_t errors = I2CBus::getErrors();
+    NackingDevice nacking;
+    ShortDevice shortDevice;
+    Wire.attach(0x20, &nacking);
+    Wire.attach(0x21, &shortDevice);
+    const uint8_t reg = 0;
+    uint8_t buf[8];
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_data_nack, I2CBus::write(0x20, &reg, 1, buf, 4));
+    // Four bytes of eight is a failed read, not a partial one
+    TEST_ASSERT_EQUAL_UINT8(0, I2CBus::read(0x21, &reg, 1, buf, 8));
+    TEST_ASSERT_EQUAL_UINT16(errors + 2, I2CBus::getErrors());
+}
+
+void test_hang_is_bounded_and_recovered(void)
+{
+    uint16_t timeouts = I2CBus::getTimeouts();
+    uint16_t recoveries = I2CBus::getRecoveries();
+    device.hang = true;
+    const uint8_t reg = 0;
+    uint8_t buf[2];
+
+    // Each hung transaction costs the timeout, not forever
+    unsigned long start = micros();
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_timeout, I2CBus::write(DEVICE_ADDRESS, &reg, 1, buf, 2));
+    TEST_ASSERT_EQUAL_UINT8(0, I2CBus::read(DEVICE_ADDRESS, &reg, 1, buf, 2));
+    TEST_ASSERT_EQUAL_UINT32(2 * I2C_TIMEOUT_US, micros() - start);
+    TEST_ASSERT_TRUE(Wire.getWireTimeoutFlag());
+
+    // One recovery per poll that finds the flag; the bus is free, so no clock pulses are needed
+    device.hang = false;
+    I2CBus::poll();
+    TEST_ASSERT_EQUAL_UINT16(timeouts + 1, I2CBus::getTimeouts());
+    TEST_ASSERT_EQUAL_UINT16(recoveries + 1, I2CBus::getRecoveries());
+    TEST_ASSERT_EQUAL_UINT8(0, pulses);
+    TEST_ASSERT_FALSE(I2CBus::isStuck());
+    TEST_ASSERT_FALSE(Wire.getWireTimeoutFlag());
+    TEST_ASSERT_TRUE(Wire.started);
+    TEST_ASSERT_EQUAL_UINT32(I2C_TIMEOUT_US, Wire.timeoutMicros);
+    I2CBus::poll();
+    TEST_ASSERT_EQUAL_UINT16(recoveries + 1, I2CBus::getRecoveries());
+
+    // The bus works again
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_none, I2CBus::write(DEVICE_ADDRESS, &reg, 1, buf, 2));
+}
+
+void test_recovery_clocks_until_sda_released(void)
+{
+    // A slave stopped after any number of bits lets go within the nine pulses
+    for (uint8_t hold = 1; hold <= I2CBus::RECOVERY_PULSES; hold++)
+    {
+        holdPulses = hold;
+        pulses = 0;
+        TEST_ASSERT_TRUE(I2CBus::recover());
+        TEST_ASSERT_EQUAL_UINT8(hold, pulses);
+        TEST_ASSERT_FALSE(I2CBus::isStuck());
+        // Both lines end released, and Wire is running again
+        TEST_ASSERT_EQUAL_UINT8(INPUT_PULLUP, hostPinMode[PIN_I2C_SDA]);
+        TEST_ASSERT_EQUAL_UINT8(INPUT_PULLUP, hostPinMode[PIN_I2C_SCL]);
+        TEST_ASSERT_TRUE(Wire.started);
+    }
+}
+
+void test_recovery_gives_up_on_a_stuck_line(void)
+{
+    holdPulses = 0xFF;
+    unsigned long start = micros();
+    TEST_ASSERT_FALSE(I2CBus::recover());
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::RECOVERY_PULSES, pulses);
+    TEST_ASSERT_TRUE(I2CBus::isStuck());
+    // Bounded: the pulses, the STOP and the settling time, about a tenth of a millisecond
+    TEST_ASSERT_EQUAL_UINT32((2 * I2CBus::RECOVERY_PULSES + 3) * I2C_HALF_PERIOD_US, micros() - start);
+    TEST_ASSERT_TRUE(Wire.started);
+
+    // Once the slave lets go, the next recovery clears the state
+    holdPulses = 0;
+    TEST_ASSERT_TRUE(I2CBus::recover());
+    TEST_ASSERT_FALSE(I2CBus::isStuck());
+}
+
+void test_sensor_reports_faults(void)
+{
+    HostI2CDevice chip;
+    chip.registers[BME680::ADD_ID] = BME680_CHIP_ID;
+    Wire.attach(BME_ADDRESS, &chip);
+    BME680::BMEConfig config;
+    BME680::BMECalibrationParameters calibration;
+    BME680 sensor(BME_ADDRESS);
+    sensor.config = &config;
+    sensor.calibration = &calibration;
+    sensor.setDefaultConfig();
+    TEST_ASSERT_TRUE(sensor.begin());
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_none, sensor.getError());
+
+    chip.absent = true;
+    uint16_t failed = sensor.getErrorCount();
+    TEST_ASSERT_FALSE(sensor.begin());
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_address_nack, sensor.getError());
+    TEST_ASSERT_TRUE(sensor.getErrorCount() > failed);
+
+    chip.absent = false;
+    chip.hang = true;
+    TEST_ASSERT_FALSE(sensor.begin());
+    TEST_ASSERT_EQUAL_UINT8(I2CBus::error_timeout, sensor.getError());
+    TEST_ASSERT_FALSE(sensor.applyConfig());
+
+    chip.hang = false;
+    I2CBus::poll();
+    TEST_ASSERT_TRUE(sensor.begin());
+    TEST_ASSERT_TRUE(sensor.applyConfig());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_arms_timeout);
+    RUN_TEST(test_transactions);
+    RUN_TEST(test_address_nack);
+    RUN_TEST(test_data_nack_and_short_read);
+    RUN_TEST(test_hang_is_bounded_and_recovered);
+    RUN_TEST(test_recovery_clocks_until_sda_released);
+    RUN_TEST(test_recovery_gives_up_on_a_stuck_line);
+    RUN_TEST(test_sensor_reports_faults);
+    return UNITY_END();
+}
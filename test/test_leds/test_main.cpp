@@ -0,0 +1,116 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Status LEDs: timer setup and the patterns played tick by tick
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+
+#include "leds.h"
+
+// The interrupt vector, a plain function on the host (see ISR() in the Arduino stub)
+extern "C" void TIMER3_COMPA_vect(void);
+
+static const uint8_t pins[StatusLeds::led_count] = {PIN_LED_GREEN, PIN_LED_YELLOW, PIN_LED_RED, PIN_LED_BLUE};
+
+// Plays one second through the timer interrupt and returns the pin levels of a LED as a pattern
+static uint8_t playSecond(uint8_t led)
+{
+    uint8_t seen = 0;
+    for (uint8_t tick = 0; tick < StatusLeds::TICKS_PER_SECOND; tick++)
+    {
+        TIMER3_COMPA_vect();
+        seen |= hostPinLevel[pins[led]] << tick;
+    }
+    return seen;
+}
+
+void setUp(void)
+{
+    memset(hostPinLevel, 0, sizeof(hostPinLevel));
+    memset(hostPinMode, 0, sizeof(hostPinMode));
+    for (uint8_t i = 0; i < StatusLeds::led_count; i++)
+    {
+        StatusLeds::setPattern(i, StatusLeds::pattern_off);
+    }
+}
+
+void tearDown(void) {}
+
+void test_begin(void)
+{
+    StatusLeds::begin();
+    for (uint8_t i = 0; i < StatusLeds::led_count; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(OUTPUT, hostPinMode[pins[i]]);
+    }
+    // CTC with prescaler 256: the compare value gives TICKS_PER_SECOND interrupts within 0.01%
+    TEST_ASSERT_EQUAL_UINT8(_BV(WGM32) | _BV(CS32), TCCR3B);
+    TEST_ASSERT_UINT32_WITHIN(F_CPU / 10000, F_CPU, (uint32_t)256 * (OCR3A + 1) * StatusLeds::TICKS_PER_SECOND);
+    TEST_ASSERT_EQUAL_UINT8(_BV(OCIE3A), TIMSK3);
+}
+
+void test_patterns_play_bit_by_bit(void)
+{
+    // Whatever tick the timer is at, a whole second replays every pattern exactly
+    static const uint8_t patterns[StatusLeds::led_count] = {StatusLeds::pattern_on, StatusLeds::pattern_blip,
+                                                            StatusLeds::pattern_slow, 0xA3};
+    for (uint8_t offset = 0; offset < StatusLeds::TICKS_PER_SECOND; offset++)
+    {
+        for (uint8_t i = 0; i < offset; i++)
+        {
+            TIMER3_COMPA_vect();
+        }
+        for (uint8_t led = 0; led < StatusLeds::led_count; led++)
+        {
+            StatusLeds::setPattern(led, patterns[led]);
+        }
+        for (uint8_t led = 0; led < StatusLeds::led_count; led++)
+        {
+            uint8_t seen = playSecond(led);
+            // The same bits, rotated by the tick the second started at
+            uint8_t phase = 0;
+            while (phase < StatusLeds::TICKS_PER_SECOND &&
+                   (uint8_t)((seen << phase) | (seen >> (8 - phase))) != patterns[led])
+            {
+                phase++;
+            }
+            TEST_ASSERT_TRUE(phase < StatusLeds::TICKS_PER_SECOND);
+        }
+    }
+    // Out of range LEDs are ignored
+    StatusLeds::setPattern(StatusLeds::led_count, StatusLeds::pattern_on);
+}
+
+void test_suspend_and_resume(void)
+{
+    StatusLeds::begin();
+    StatusLeds::setPattern(StatusLeds::led_red, StatusLeds::pattern_on);
+    TIMER3_COMPA_vect();
+    TEST_ASSERT_EQUAL_UINT8(HIGH, hostPinLevel[PIN_LED_RED]);
+
+    StatusLeds::suspend();
+    TEST_ASSERT_EQUAL_UINT8(0, TIMSK3);
+    for (uint8_t i = 0; i < StatusLeds::led_count; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(LOW, hostPinLevel[pins[i]]);
+    }
+
+    StatusLeds::resume();
+    TEST_ASSERT_EQUAL_UINT8(_BV(OCIE3A), TIMSK3);
+    TIMER3_COMPA_vect();
+    TEST_ASSERT_EQUAL_UINT8(HIGH, hostPinLevel[PIN_LED_RED]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin);
+    RUN_TEST(test_patterns_play_bit_by_bit);
+    RUN_TEST(test_suspend_and_resume);
+    return UNITY_END();
+}
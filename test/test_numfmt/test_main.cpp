@@ -0,0 +1,252 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Fixed-point formatting against printf, and a host timing comparison with Print::print(float)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "numfmt.h"
+
+// Random values checked per number of decimals, on top of the edge cases
+#define RANDOM_VALUES 200000UL
+// Calls timed per formatter in the benchmark
+#define BENCH_CALLS 200000UL
+
+static const uint32_t scale[10] = {1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL,
+                                   100000000UL, 1000000000UL};
+
+static uint32_t random32;
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t nextRandom()
+{
+    random32 ^= random32 << 13;
+    random32 ^= random32 >> 17;
+    random32 ^= random32 << 5;
+    return random32;
+}
+
+// What formatFixed() must produce, built with printf on the split integer and fraction
+static void reference(char *buf, size_t size, int32_t value, uint8_t decimals)
+{
+    uint32_t magnitude = value < 0 ? 0UL - (uint32_t)value : (uint32_t)value;
+    const char *sign = value < 0 ? "-" : "";
+    if (decimals == 0)
+    {
+        snprintf(buf, size, "%s%lu", sign, (unsigned long)magnitude);
+    }
+    else
+    {
+        snprintf(buf, size, "%s%lu.%0*lu", sign, (unsigned long)(magnitude / scale[decimals]), decimals,
+                 (unsigned long)(magnitude % scale[decimals]));
+    }
+}
+
+static void checkFixed(int32_t value, uint8_t decimals)
+{
+    char expected[32];
+    char actual[NumberFormat::BUFFER_SIZE];
+    reference(expected, sizeof(expected), value, decimals);
+    uint8_t length = NumberFormat::formatFixed(actual, value, decimals);
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_EQUAL_UINT8(strlen(expected), length);
+}
+
+// Discards what is printed, so the benchmark measures the formatting alone
+class NullPrint : public Print
+{
+public:
+    size_t count;
+    NullPrint() : count(0) {}
+    size_t write(uint8_t) override
+    {
+        count++;
+        return 1;
+    }
+    using Print::write;
+};
+
+void setUp(void)
+{
+    random32 = 0x2545F491;
+}
+
+void tearDown(void) {}
+
+void test_unsigned_matches_printf(void)
+{
+    char expected[16];
+    char actual[NumberFormat::BUFFER_SIZE];
+    const uint32_t edges[] = {0, 1, 9, 10, 99, 100, 999999999UL, 1000000000UL, 4294967295UL};
+    for (uint8_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)edges[i]);
+        NumberFormat::formatUnsigned(actual, edges[i]);
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+    for (uint32_t i = 0; i < RANDOM_VALUES; i++)
+    {
+        uint32_t value = nextRandom() >> (i % 32);
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)value);
+        TEST_ASSERT_EQUAL_UINT8(strlen(expected), NumberFormat::formatUnsigned(actual, value));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+}
+
+void test_fixed_matches_printf(void)
+{
+    const int32_t edges[] = {0, 1, -1, 9, -9, 10, -10, 99, 100, -100, 12345, -12345,
+                             INT32_MAX, INT32_MIN, INT32_MIN + 1};
+    for (uint8_t decimals = 0; decimals <= 9; decimals++)
+    {
+        for (uint8_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+        {
+            checkFixed(edges[i], decimals);
+        }
+        // Every value around each power of ten, where digit counts change
+        for (uint8_t p = 0; p <= 9; p++)
+        {
+            for (int32_t d = -2; d <= 2; d++)
+            {
+                checkFixed((int32_t)scale[p] + d, decimals);
+                checkFixed(-(int32_t)scale[p] + d, decimals);
+            }
+        }
+        for (uint32_t i = 0; i < RANDOM_VALUES; i++)
+        {
+            // Shifting spreads the magnitudes over the whole range
+            checkFixed((int32_t)nextRandom() >> (i % 32), decimals);
+        }
+    }
+}
+
+void test_decimals_clamped(void)
+{
+    char buf[NumberFormat::BUFFER_SIZE];
+    NumberFormat::formatFixed(buf, 5, 12);
+    TEST_ASSERT_EQUAL_STRING("0.000000005", buf);
+}
+
+void test_fixed_width(void)
+{
+    char buf[16];
+    TEST_ASSERT_EQUAL_UINT8(7, NumberFormat::formatFixedWidth(buf, 2345, 2, 7));
+    TEST_ASSERT_EQUAL_STRING("  23.45", buf);
+    NumberFormat::formatFixedWidth(buf, -5, 1, 5);
+    TEST_ASSERT_EQUAL_STRING(" -0.5", buf);
+    NumberFormat::formatFixedWidth(buf, 101325, 0, 6);
+    TEST_ASSERT_EQUAL_STRING("101325", buf);
+    // Too wide: the field is filled, never truncated to a misleading number
+    NumberFormat::formatFixedWidth(buf, 1013250, 1, 6);
+    TEST_ASSERT_EQUAL_STRING("######", buf);
+
+    char expected[32];
+    for (uint32_t i = 0; i < RANDOM_VALUES; i++)
+    {
+        int32_t value = (int32_t)nextRandom() >> (i % 32);
+        uint8_t decimals = i % 4;
+        uint8_t width = 4 + i % 9;
+        char plain[NumberFormat::BUFFER_SIZE];
+        reference(plain, sizeof(plain), value, decimals);
+        if (strlen(plain) > width)
+        {
+            memset(expected, '#', width);
+            expected[width] = '\0';
+        }
+        else
+        {
+            snprintf(expected, sizeof(expected), "%*s", width, plain);
+        }
+        NumberFormat::formatFixedWidth(buf, value, decimals, width);
+        TEST_ASSERT_EQUAL_STRING(expected, buf);
+    }
+}
+
+void test_drop_decimals(void)
+{
+    TEST_ASSERT_EQUAL_INT32(235, NumberFormat::dropDecimals(2345, 1));
+    TEST_ASSERT_EQUAL_INT32(-235, NumberFormat::dropDecimals(-2345, 1));
+    TEST_ASSERT_EQUAL_INT32(23, NumberFormat::dropDecimals(2345, 2));
+    TEST_ASSERT_EQUAL_INT32(2345, NumberFormat::dropDecimals(2345, 0));
+    // Half away from zero, like round()
+    for (uint32_t i = 0; i < RANDOM_VALUES; i++)
+    {
+        int32_t value = ((int32_t)nextRandom() >> (i % 32)) / 2;
+        uint8_t digits = 1 + i % 9;
+        int32_t expected = (int32_t)round((double)value / scale[digits]);
+        TEST_ASSERT_EQUAL_INT32(expected, NumberFormat::dropDecimals(value, digits));
+    }
+}
+
+void test_print_matches_print_float(void)
+{
+    // Where the float path is exact (small values) both print the same text
+    for (int32_t value = -20000; value <= 20000; value += 7)
+    {
+        Serial.clearOutput();
+        NumberFormat::print(&Serial, value, 2);
+        char fixed[16];
+        strcpy(fixed, Serial.output);
+        Serial.clearOutput();
+        Serial.print(value / 100.0, 2);
+        TEST_ASSERT_EQUAL_STRING(Serial.output, fixed);
+    }
+    Serial.reset();
+}
+
+void test_benchmark_against_print_float(void)
+{
+    // Host timing only: relative cost of the two paths, not AVR cycle counts
+    NullPrint sink;
+    int32_t values[256];
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        values[i] = (int32_t)(nextRandom() % 200000UL) - 100000L;
+    }
+
+    double start = nowNs();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++)
+    {
+        NumberFormat::print(&sink, values[i & 0xFF], 2);
+    }
+    double middle = nowNs();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++)
+    {
+        sink.print(values[i & 0xFF] / 100.0f, 2);
+    }
+    double end = nowNs();
+
+    double fixedNs = (middle - start) / BENCH_CALLS;
+    double floatNs = (end - middle) / BENCH_CALLS;
+    char message[96];
+    snprintf(message, sizeof(message), "host ns/call: NumberFormat::print %.1f, Print::print(float) %.1f",
+             fixedNs, floatNs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN(0, sink.count);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_unsigned_matches_printf);
+    RUN_TEST(test_fixed_matches_printf);
+    RUN_TEST(test_decimals_clamped);
+    RUN_TEST(test_fixed_width);
+    RUN_TEST(test_drop_decimals);
+    RUN_TEST(test_print_matches_print_float);
+    RUN_TEST(test_benchmark_against_print_float);
+    return UNITY_END();
+}
@@ -0,0 +1,327 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Oversampling controller against a simulated sensor whose noise follows its configuration
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "osctrl.h"
+
+#define BME_ADDRESS 0x77
+
+// Noise of a single ADC cycle: centi-°C, Pa, centi-% (controller channel order)
+static const double BASE_NOISE[OversamplingController::CHANNELS] = {6.0, 14.0, 30.0};
+static const uint8_t ADC_CYCLES[6] = {0, 1, 2, 4, 8, 16};
+static const uint8_t IIR_COEFFICIENTS[8] = {0, 1, 3, 7, 15, 31, 63, 127};
+
+static HostI2CDevice chip;
+static BME680::BMEConfig bmeConfig;
+static BME680::BMECalibrationParameters calibration;
+static BME680 bme(BME_ADDRESS);
+
+static uint32_t randomState;
+
+static double uniform()
+{
+    randomState = randomState * 1664525UL + 1013904223UL;
+    return (randomState >> 8) / 16777216.0;
+}
+
+static double gaussian()
+{
+    double sum = 0;
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        sum += uniform();
+    }
+    return sum - 6;
+}
+
+/**
+ * Readings as the sensor would produce them: white noise falling with the square root of the
+ * oversampling, then the IIR filter on temperature and pressure (the BME680 does not filter
+ * humidity)
+ */
+class SimulatedSensor
+{
+private:
+    double output[OversamplingController::CHANNELS];
+    bool started;
+
+public:
+    double truth[OversamplingController::CHANNELS];
+
+    SimulatedSensor()
+    {
+        truth[0] = 2250;
+        truth[1] = 101325;
+        truth[2] = 4500;
+        started = false;
+    }
+
+    SampleRecord read()
+    {
+        const BME680::OversamplingMultipliers osrs[OversamplingController::CHANNELS] = {
+            bmeConfig.osrs_t, bmeConfig.osrs_p, bmeConfig.osrs_h};
+        double coefficient = IIR_COEFFICIENTS[bmeConfig.filter & 0x07];
+        for (uint8_t c = 0; c < OversamplingController::CHANNELS; c++)
+        {
+            double x = truth[c] + gaussian() * BASE_NOISE[c] / sqrt((double)ADC_CYCLES[osrs[c] % 6]);
+            bool filtered = c != 2 && started;
+            output[c] = filtered ? output[c] + (x - output[c]) / (coefficient + 1) : x;
+        }
+        started = true;
+
+        SampleRecord sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.temperature = (int16_t)lround(output[0]);
+        sample.pressure = (uint32_t)lround(output[1]);
+        sample.humidity = (uint16_t)lround(output[2]);
+        sample.channels = channel_temperature | channel_pressure | channel_humidity;
+        return sample;
+    }
+};
+
+static const uint8_t EQUAL_PRIORITIES[OversamplingController::CHANNELS] = {1, 1, 1};
+
+static int32_t channelValue(const SampleRecord *sample, uint8_t c)
+{
+    return c == 0 ? sample->temperature : (c == 1 ? (int32_t)sample->pressure : sample->humidity);
+}
+
+void setUp(void)
+{
+    randomState = 2024;
+    Wire.detachAll();
+    chip = HostI2CDevice();
+    Wire.attach(BME_ADDRESS, &chip);
+    bme.config = &bmeConfig;
+    bme.calibration = &calibration;
+    bme.setDefaultConfig();
+    bmeConfig.osrs_t = BME680::osrs_x2;
+    bmeConfig.osrs_p = BME680::orsrs_x8;
+    bmeConfig.osrs_h = BME680::osrs_x1;
+    bmeConfig.filter = BME680::filter_3;
+}
+
+void tearDown(void) {}
+
+void test_quiet_choice_fits_period(void)
+{
+    static const uint16_t periods[] = {300, 500, 1000, 3000, 10000};
+    for (uint8_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++)
+    {
+        OversamplingController controller(&bme);
+        TEST_ASSERT_TRUE(controller.configure(periods[i], EQUAL_PRIORITIES));
+        TEST_ASSERT_TRUE(OversamplingController::measurementMillis(&bmeConfig) <= periods[i]);
+        // The IIR time constant stays within the response limit
+        TEST_ASSERT_TRUE((uint32_t)IIR_COEFFICIENTS[bmeConfig.filter] * periods[i] <=
+                         OversamplingController::MAX_RESPONSE_MS);
+        TEST_ASSERT_EQUAL_UINT16(periods[i], controller.getPeriodMillis());
+        // The filter setting reached the chip
+        TEST_ASSERT_EQUAL_UINT8(bmeConfig.filter << 2, chip.registers[BME680::ADD_CONFIG]);
+        controller.disable();
+    }
+
+    // Priorities steer the cycles to the channel that asks for them
+    OversamplingController controller(&bme);
+    const uint8_t temperatureFirst[OversamplingController::CHANNELS] = {3, 0, 0};
+    TEST_ASSERT_TRUE(controller.configure(300, temperatureFirst));
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x16, bmeConfig.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x1, bmeConfig.osrs_p);
+}
+
+void test_period_too_short(void)
+{
+    OversamplingController controller(&bme);
+    TEST_ASSERT_FALSE(controller.configure(5, EQUAL_PRIORITIES));
+    TEST_ASSERT_FALSE(controller.isEnabled());
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x2, bmeConfig.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_3, bmeConfig.filter);
+    TEST_ASSERT_EQUAL_UINT16(0, controller.getPeriodMillis());
+}
+
+void test_noise_estimate_matches_model(void)
+{
+    // The estimate follows the sample-to-sample variation: sigma = sqrt(pi) / 2 * mean |difference|,
+    // which for white noise is rms(difference) / sqrt(2)
+    OversamplingController controller(&bme);
+    TEST_ASSERT_TRUE(controller.configure(1000, EQUAL_PRIORITIES));
+    SimulatedSensor sensor;
+    double squares[OversamplingController::CHANNELS] = {0, 0, 0};
+    double magnitudes[OversamplingController::CHANNELS] = {0, 0, 0};
+    double estimates[OversamplingController::CHANNELS] = {0, 0, 0};
+    int32_t previous[OversamplingController::CHANNELS];
+    uint16_t counted = 0;
+    // The estimate starts from zero, so the first samples count as steps; only the quiet
+    // configuration after that is measured
+    for (uint16_t i = 0; i < 5000; i++)
+    {
+        bool quiet = !controller.isTransient();
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+        quiet = quiet && !controller.isTransient() && i >= 1000;
+        for (uint8_t c = 0; c < OversamplingController::CHANNELS; c++)
+        {
+            int32_t value = channelValue(&sample, c);
+            if (quiet)
+            {
+                squares[c] += (double)(value - previous[c]) * (value - previous[c]);
+                magnitudes[c] += fabs((double)(value - previous[c]));
+                estimates[c] += controller.getNoise(c) / 16.0;
+            }
+            previous[c] = value;
+        }
+        counted += quiet;
+    }
+    TEST_ASSERT_FALSE(controller.isTransient());
+    TEST_ASSERT_TRUE(counted > 3000);
+    for (uint8_t c = 0; c < OversamplingController::CHANNELS; c++)
+    {
+        // The estimate is a short running mean, so it is averaged over the run. Below one unit the
+        // readings are mostly 0 or 1 apart and the two formulas part ways: the estimator is held
+        // to its own, the white-noise one is reported
+        double expected = sqrt(M_PI) / 2 * magnitudes[c] / counted;
+        double rms = sqrt(squares[c] / counted / 2);
+        double estimated = estimates[c] / counted;
+        char message[80];
+        snprintf(message, sizeof(message), "channel %u: expected %.3f (rms %.3f), estimated %.3f", c, expected, rms, estimated);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE(estimated > 0);
+        TEST_ASSERT_FLOAT_WITHIN(expected * 0.05, expected, estimated);
+    }
+}
+
+void test_rare_false_transients(void)
+{
+    // Pure noise, no change in the true values
+    OversamplingController controller(&bme);
+    TEST_ASSERT_TRUE(controller.configure(1000, EQUAL_PRIORITIES));
+    SimulatedSensor sensor;
+    uint16_t entered = 0;
+    const uint16_t count = 20000;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        bool before = controller.isTransient();
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+        if (!before && controller.isTransient())
+        {
+            entered++;
+        }
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "%u false transients in %u samples", entered, count);
+    TEST_MESSAGE(message);
+    // The threshold sits near 4 sigma of a difference, on three channels
+    TEST_ASSERT_TRUE(entered * 200 < count);
+}
+
+void test_step_switches_and_returns(void)
+{
+    OversamplingController controller(&bme);
+    TEST_ASSERT_TRUE(controller.configure(1000, EQUAL_PRIORITIES));
+    BME680::BMEConfig quiet = bmeConfig;
+    SimulatedSensor sensor;
+    for (uint16_t i = 0; i < 500; i++)
+    {
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+    }
+    TEST_ASSERT_FALSE(controller.isTransient());
+
+    // A 2 °C step: the fast configuration is applied at once
+    sensor.truth[0] += 200;
+    uint8_t samples = 0;
+    while (!controller.isTransient() && samples < 5)
+    {
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+        samples++;
+    }
+    TEST_ASSERT_TRUE(controller.isTransient());
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x2, bmeConfig.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x2, bmeConfig.osrs_h);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_0, bmeConfig.filter);
+    TEST_ASSERT_EQUAL_UINT8(0, chip.registers[BME680::ADD_CONFIG]);
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x2, chip.registers[BME680::ADD_CTRL_HUM]);
+    TEST_ASSERT_TRUE(controller.getPeriodMillis() < 1000);
+    TEST_ASSERT_EQUAL_UINT16(OversamplingController::measurementMillis(&bmeConfig), controller.getPeriodMillis());
+
+    // Once the readings settle the quiet configuration comes back
+    uint16_t settle = 0;
+    while (controller.isTransient() && settle < 200)
+    {
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+        settle++;
+    }
+    TEST_ASSERT_FALSE(controller.isTransient());
+    TEST_ASSERT_TRUE(settle >= OversamplingController::HOLD_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT8(quiet.osrs_t, bmeConfig.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(quiet.filter, bmeConfig.filter);
+    TEST_ASSERT_EQUAL_UINT16(1000, controller.getPeriodMillis());
+}
+
+void test_disable_restores_configuration(void)
+{
+    OversamplingController controller(&bme);
+    TEST_ASSERT_TRUE(controller.configure(1000, EQUAL_PRIORITIES));
+    // Re-configuring while enabled keeps the settings saved the first time
+    TEST_ASSERT_TRUE(controller.configure(400, EQUAL_PRIORITIES));
+    SimulatedSensor sensor;
+    for (uint16_t i = 0; i < 200; i++)
+    {
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+    }
+    sensor.truth[1] += 500;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        SampleRecord sample = sensor.read();
+        controller.observe(&sample);
+    }
+    TEST_ASSERT_TRUE(controller.isTransient());
+
+    // Disabled in the middle of a transient
+    controller.disable();
+    TEST_ASSERT_FALSE(controller.isEnabled());
+    TEST_ASSERT_FALSE(controller.isTransient());
+    TEST_ASSERT_EQUAL_UINT16(0, controller.getPeriodMillis());
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x2, bmeConfig.osrs_t);
+    TEST_ASSERT_EQUAL_UINT8(BME680::orsrs_x8, bmeConfig.osrs_p);
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x1, bmeConfig.osrs_h);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_3, bmeConfig.filter);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_3 << 2, chip.registers[BME680::ADD_CONFIG]);
+    TEST_ASSERT_EQUAL_UINT8(BME680::osrs_x1, chip.registers[BME680::ADD_CTRL_HUM]);
+
+    // A second disable does not touch the sensor again
+    uint32_t written = chip.bytesWritten;
+    bmeConfig.filter = BME680::filter_31;
+    controller.disable();
+    TEST_ASSERT_EQUAL_UINT32(written, chip.bytesWritten);
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_31, bmeConfig.filter);
+
+    // Enabling again saves the settings in use at that time
+    TEST_ASSERT_TRUE(controller.configure(1000, EQUAL_PRIORITIES));
+    controller.disable();
+    TEST_ASSERT_EQUAL_UINT8(BME680::filter_31, bmeConfig.filter);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_quiet_choice_fits_period);
+    RUN_TEST(test_period_too_short);
+    RUN_TEST(test_noise_estimate_matches_model);
+    RUN_TEST(test_rare_false_transients);
+    RUN_TEST(test_step_switches_and_returns);
+    RUN_TEST(test_disable_restores_configuration);
+    return UNITY_END();
+}
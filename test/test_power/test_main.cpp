@@ -0,0 +1,231 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Sleep planning on a fake clock, and a duty-cycled run against a simulated watchdog
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "power.h"
+
+extern "C" void WDT_vect(void);
+extern "C" void INT2_vect(void);
+
+// The watchdog oscillator runs 7% slow, as the datasheet allows
+#define WDT_TRUE_BASE_US 17120UL
+
+/**
+ * The sleep hook stands for the hardware: idle sleep ends at the next timer 0 tick (or the
+ * watchdog, when it is running), power-down at the watchdog or at a start bit. Timer 0 stops in
+ * power-down, so that time is kept apart and only the firmware moves millis() across it.
+ */
+static unsigned long powerDownRealMicros;
+// A start bit arriving this many us into the next power-down (0: none)
+static unsigned long startBitAfter;
+static uint16_t powerDowns;
+static uint8_t lastStep;
+
+static uint8_t watchdogStep()
+{
+    return (WDTCSR & 0x07) | ((WDTCSR & _BV(WDP3)) ? 8 : 0);
+}
+
+static void sleepHook(uint8_t mode)
+{
+    bool watchdog = WDTCSR & _BV(WDIE);
+    if (mode == SLEEP_MODE_IDLE)
+    {
+        if (watchdog)
+        {
+            hostAdvanceMicros(WDT_TRUE_BASE_US << watchdogStep());
+            WDT_vect();
+        }
+        else
+        {
+            hostAdvanceMicros(1000 - hostMicros % 1000);
+        }
+        return;
+    }
+    TEST_ASSERT_TRUE(watchdog);
+    powerDowns++;
+    lastStep = watchdogStep();
+    unsigned long period = WDT_TRUE_BASE_US << lastStep;
+    if (startBitAfter > 0 && startBitAfter < period)
+    {
+        powerDownRealMicros += startBitAfter;
+        startBitAfter = 0;
+        INT2_vect();
+        return;
+    }
+    powerDownRealMicros += period;
+    WDT_vect();
+}
+
+static unsigned long realMillis()
+{
+    return (hostMicros + powerDownRealMicros) / 1000;
+}
+
+void setUp(void)
+{
+    hostMicros = 0;
+    timer0_millis = 0;
+    powerDownRealMicros = 0;
+    startBitAfter = 0;
+    powerDowns = 0;
+    WDTCSR = 0;
+    hostSleepHook = sleepHook;
+}
+
+void tearDown(void)
+{
+    hostSleepHook = nullptr;
+}
+
+void test_disabled_or_no_window(void)
+{
+    PowerManager power;
+    PowerManager::SleepPlan plan = power.plan(1000, 5000, false);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_none, plan.mode);
+
+    power.enable(PowerManager::display_dim);
+    TEST_ASSERT_TRUE(power.isEnabled());
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::display_dim, power.getDisplayMode());
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_none, power.plan(5000, 5000, false).mode);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_none, power.plan(5001, 5000, false).mode);
+    power.disable();
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_none, power.plan(1000, 5000, false).mode);
+}
+
+void test_idle_when_busy_or_short(void)
+{
+    PowerManager power;
+    power.enable(PowerManager::display_bright);
+    PowerManager::SleepPlan plan = power.plan(1000, 4000, true);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_idle, plan.mode);
+    TEST_ASSERT_EQUAL_UINT16(3000, plan.millis);
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, power.plan(0, 100000, true).millis);
+
+    // Shorter than the shortest watchdog period plus the wake margin
+    uint16_t shortest = PowerManager::WDT_BASE_MS + PowerManager::WAKE_MARGIN_MS;
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_idle, power.plan(1000, 1000 + shortest - 1, false).mode);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_power_down, power.plan(1000, 1000 + shortest, false).mode);
+}
+
+void test_power_down_step_fits_window(void)
+{
+    PowerManager power;
+    power.enable(PowerManager::display_bright);
+    for (uint32_t window = PowerManager::WDT_BASE_MS + PowerManager::WAKE_MARGIN_MS; window < 20000; window++)
+    {
+        // Across the wrap of millis() too
+        uint32_t now = window & 1 ? 123456 : 0xFFFFFFFFUL - window / 2;
+        PowerManager::SleepPlan plan = power.plan(now, now + window, false);
+        TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_power_down, plan.mode);
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)PowerManager::WDT_BASE_MS << plan.step, plan.millis);
+        // Ends at least the wake margin before the deadline, and no longer step would
+        TEST_ASSERT_TRUE((uint32_t)plan.millis + PowerManager::WAKE_MARGIN_MS <= window);
+        TEST_ASSERT_TRUE(plan.step == PowerManager::WDT_MAX_STEP ||
+                         ((uint32_t)PowerManager::WDT_BASE_MS << (plan.step + 1)) + PowerManager::WAKE_MARGIN_MS > window);
+    }
+}
+
+void test_activity_holds_off_power_down(void)
+{
+    PowerManager power;
+    power.enable(PowerManager::display_bright);
+    uint32_t now = millis();
+    power.noteActivity();
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_idle, power.plan(now + 100, now + 3000, false).mode);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_idle,
+                            power.plan(now + PowerManager::ACTIVITY_HOLD_MS - 1, now + 20000, false).mode);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_power_down,
+                            power.plan(now + PowerManager::ACTIVITY_HOLD_MS, now + 20000, false).mode);
+}
+
+void test_duty_cycled_run(void)
+{
+    // A 3 s sample period with 150 ms of work per sample, for 10 minutes
+    const uint32_t period = 3000;
+    const uint32_t work = 150;
+    PowerManager power;
+    power.enable(PowerManager::display_blank);
+    uint32_t next = millis();
+    uint16_t overshoots = 0;
+    for (uint16_t sample = 0; sample < 200; sample++)
+    {
+        hostAdvanceMillis(work);
+        power.noteSample();
+        next += period;
+        while ((int32_t)(next - millis()) > 0)
+        {
+            PowerManager::SleepPlan plan = power.plan(millis(), next, false);
+            uint16_t before = powerDowns;
+            power.sleep(next, false);
+            if (powerDowns != before)
+            {
+                // The watchdog ran the step plan() chose, and woke before the deadline in real time
+                TEST_ASSERT_EQUAL_UINT8(plan.step, lastStep);
+                overshoots += (int32_t)(realMillis() - next) > 0;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, overshoots);
+    TEST_ASSERT_TRUE(powerDowns > 200);
+
+    // millis() followed the real clock across power-down, thanks to the calibration
+    TEST_ASSERT_UINT32_WITHIN(2, realMillis(), millis());
+
+    // Awake 150 ms of every 3000 ms: 50 thousandths
+    TEST_ASSERT_UINT32_WITHIN(2, 50, power.getDutyCycle());
+    uint32_t asleep = power.getIdleMillis() + power.getPowerDownMillis();
+    TEST_ASSERT_UINT32_WITHIN(3, 200 * (period - work), asleep);
+    TEST_ASSERT_TRUE(power.getPowerDownMillis() > power.getIdleMillis() * 10);
+
+    // uA * ms / 1000 = uC per sample, with the board currents of hardware.h
+    double expected = ((double)work * POWER_ACTIVE_UA + (double)power.getIdleMillis() / 200 * POWER_IDLE_UA +
+                       (double)power.getPowerDownMillis() / 200 * POWER_DOWN_UA) / 1000;
+    TEST_ASSERT_UINT32_WITHIN(expected / 50, (uint32_t)expected, power.getChargePerSample());
+
+    char message[96];
+    snprintf(message, sizeof(message), "duty %u/1000, %lu uC per sample, %u power-downs", power.getDutyCycle(),
+             (unsigned long)power.getChargePerSample(), powerDowns);
+    TEST_MESSAGE(message);
+}
+
+void test_uart_wake(void)
+{
+    PowerManager power;
+    power.enable(PowerManager::display_bright);
+    uint32_t now = millis();
+    uint32_t powerDown = power.getPowerDownMillis();
+    // A start bit 100 ms into a long power-down
+    startBitAfter = 100000;
+    power.sleep(now + 8000, false);
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::WDT_MAX_STEP - 1, lastStep);
+    // The time asleep is unknown and not added; the activity hold starts
+    TEST_ASSERT_EQUAL_UINT32(powerDown, power.getPowerDownMillis());
+    TEST_ASSERT_EQUAL_UINT32(now, millis());
+    TEST_ASSERT_EQUAL_UINT8(PowerManager::sleep_idle, power.plan(millis() + 10, now + 8000, false).mode);
+    // The watchdog and the wake-up interrupts are off again
+    TEST_ASSERT_EQUAL_UINT8(0, WDTCSR);
+    TEST_ASSERT_FALSE(EIMSK & _BV(INT2));
+    TEST_ASSERT_FALSE(PCICR & _BV(PCIE1));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_or_no_window);
+    RUN_TEST(test_idle_when_busy_or_short);
+    RUN_TEST(test_power_down_step_fits_window);
+    RUN_TEST(test_activity_holds_off_power_down);
+    RUN_TEST(test_duty_cycled_run);
+    RUN_TEST(test_uart_wake);
+    return UNITY_END();
+}
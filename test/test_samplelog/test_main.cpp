@@ -0,0 +1,311 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Time-series codec round trip, and the sample log on a simulated AT24C32
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+
+#include "tscodec.h"
+#include "samplelog.h"
+#include <host24c32.h>
+
+static Host24C32 *eeprom;
+static uint32_t random32;
+
+static uint32_t nextRandom()
+{
+    random32 ^= random32 << 13;
+    random32 ^= random32 >> 17;
+    random32 ^= random32 << 5;
+    return random32;
+}
+
+// A random walk with mostly small steps, some large ones and the channel extremes
+static void nextSample(SampleRecord *sample, uint16_t period)
+{
+    uint32_t r = nextRandom();
+    sample->timestamp += period;
+    int32_t step = (r & 0x10) ? (int32_t)(r >> 20) - 2048 : (int32_t)(r & 0x0F) - 7;
+    int32_t t = constrain(sample->temperature + step, -4000, 8500);
+    sample->temperature = (int16_t)t;
+    sample->humidity = (uint16_t)constrain((int32_t)sample->humidity + ((int32_t)((r >> 8) & 0x0F) - 7), 0, 10000);
+    sample->pressure = (uint32_t)constrain((int32_t)sample->pressure + ((int32_t)((r >> 12) & 0xFF) - 128), 30000, 110000);
+    sample->gasResistance = (r & 0x01000000) ? (nextRandom() % 16000000UL) : sample->gasResistance + (r & 0x3F);
+    // Channels come and go now and then (gas burn-in, a channel compiled out in another build)
+    if ((r >> 26) == 0)
+    {
+        sample->channels = (uint8_t)(nextRandom() & channel_all);
+    }
+}
+
+static void checkDecoded(const SampleRecord *expected, const SampleRecord *actual)
+{
+    TEST_ASSERT_EQUAL_UINT32(expected->timestamp, actual->timestamp);
+    TEST_ASSERT_EQUAL_INT16(expected->temperature, actual->temperature);
+    TEST_ASSERT_EQUAL_UINT16(expected->humidity, actual->humidity);
+    TEST_ASSERT_EQUAL_UINT32(expected->pressure, actual->pressure);
+    // Gas is stored in (1 << GAS_SHIFT) Ohm units, rounded
+    uint32_t gas = ((expected->gasResistance + (1UL << (SeriesEncoder::GAS_SHIFT - 1))) >> SeriesEncoder::GAS_SHIFT) << SeriesEncoder::GAS_SHIFT;
+    TEST_ASSERT_EQUAL_UINT32(gas, actual->gasResistance);
+    TEST_ASSERT_EQUAL_HEX8(expected->channels, actual->channels);
+}
+
+// Runs the main loop until the log has written everything, returns the number of poll() calls
+static uint32_t drain(SampleLog *log)
+{
+    uint32_t polls = 0;
+    while (!log->isIdle() && polls < 100000UL)
+    {
+        log->poll();
+        hostAdvanceMicros(100);
+        polls++;
+    }
+    // Let the last write cycle end too
+    hostAdvanceMicros(WRITE_CYCLE_US);
+    return polls;
+}
+
+// Decodes every valid block of the simulated EEPROM, oldest first, into out
+static uint16_t readBack(SampleRecord *out, uint16_t max)
+{
+    SampleLog log(EEPROM_ADDRESS, 60);
+    TEST_ASSERT_TRUE(log.begin());
+    // begin() queued the invalidation of the block it continues in
+    drain(&log);
+    uint16_t count = 0;
+    for (uint8_t b = 0; b < log.getBlockCount(); b++)
+    {
+        uint8_t block[SampleLog::BLOCK_SIZE];
+        uint16_t base = (uint16_t)((log.getOldestBlock() + b) % SampleLog::BLOCK_COUNT) * SampleLog::BLOCK_SIZE;
+        for (uint8_t position = 0; position < SampleLog::BLOCK_SIZE; position += 32)
+        {
+            TEST_ASSERT_EQUAL_UINT8(32, log.readBytes(base + position, block + position, 32));
+        }
+        SeriesDecoder decoder;
+        uint16_t offset = SampleLog::HEADER_SIZE;
+        for (uint8_t i = 0; i < block[3] && count < max; i++)
+        {
+            uint16_t n = (i == 0) ? decoder.decodeKeyframe(block + offset, block[2] - offset, &out[count])
+                                  : decoder.decodeDelta(block + offset, block[2] - offset, &out[count]);
+            TEST_ASSERT_NOT_EQUAL(0, n);
+            offset += n;
+            count++;
+        }
+        TEST_ASSERT_EQUAL_UINT16(block[2], offset);
+    }
+    return count;
+}
+
+void setUp(void)
+{
+    random32 = 0x2545F491;
+    eeprom = new Host24C32();
+    Wire.detachAll();
+    Wire.attach(EEPROM_ADDRESS, eeprom);
+}
+
+void tearDown(void)
+{
+    delete eeprom;
+}
+
+void test_varint_round_trip(void)
+{
+    const int32_t edges[] = {0, 1, -1, 63, -64, 64, -65, 8191, -8192, INT32_MAX, INT32_MIN};
+    uint8_t buf[5];
+    for (uint8_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        uint8_t length = SeriesEncoder::writeVarint(edges[i], buf);
+        int32_t value;
+        TEST_ASSERT_EQUAL_UINT8(length, SeriesEncoder::readVarint(buf, length, &value));
+        TEST_ASSERT_EQUAL_INT32(edges[i], value);
+        // Truncated input is rejected
+        TEST_ASSERT_EQUAL_UINT8(0, SeriesEncoder::readVarint(buf, length - 1, &value));
+    }
+    // Small magnitudes of either sign take one byte
+    TEST_ASSERT_EQUAL_UINT8(1, SeriesEncoder::writeVarint(-64, buf));
+    TEST_ASSERT_EQUAL_UINT8(1, SeriesEncoder::writeVarint(63, buf));
+}
+
+void test_codec_round_trip(void)
+{
+    SeriesEncoder encoder;
+    SeriesDecoder decoder;
+    SampleRecord sample = {1700000000UL, 2150, 4500, 101325, 120000, channel_all};
+    uint8_t buf[SeriesEncoder::MAX_KEYFRAME_SIZE];
+    uint32_t bytes = 0;
+
+    uint8_t length = encoder.encodeKeyframe(&sample, 60, buf);
+    SampleRecord decoded;
+    TEST_ASSERT_EQUAL_UINT16(length, decoder.decodeKeyframe(buf, length, &decoded));
+    checkDecoded(&sample, &decoded);
+    for (uint32_t i = 0; i < 100000UL; i++)
+    {
+        nextSample(&sample, 60);
+        length = encoder.encodeDelta(&sample, buf);
+        TEST_ASSERT_LESS_OR_EQUAL(SeriesEncoder::MAX_DELTA_SIZE, length);
+        // A truncated record is rejected, not misread
+        SeriesDecoder copy = decoder;
+        TEST_ASSERT_EQUAL_UINT16(0, copy.decodeDelta(buf, length - 1, &decoded));
+        TEST_ASSERT_EQUAL_UINT16(length, decoder.decodeDelta(buf, length, &decoded));
+        checkDecoded(&sample, &decoded);
+        bytes += length;
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "random walk: %.2f bytes per delta record", bytes / 100000.0);
+    TEST_MESSAGE(message);
+}
+
+void test_steady_signal_costs_two_bytes(void)
+{
+    SeriesEncoder encoder;
+    SampleRecord sample = {0, 2150, 4500, 101325, 120000, channel_all};
+    uint8_t buf[SeriesEncoder::MAX_KEYFRAME_SIZE];
+    encoder.encodeKeyframe(&sample, 60, buf);
+    for (uint8_t i = 0; i < 50; i++)
+    {
+        sample.temperature += (i & 1) ? 3 : -3;
+        TEST_ASSERT_EQUAL_UINT8(2, encoder.encodeDelta(&sample, buf));
+    }
+    // A change of the channel flags costs 3 bytes once: escape, flags, T delta
+    sample.channels = channel_temperature | channel_humidity;
+    TEST_ASSERT_EQUAL_UINT8(5, encoder.encodeDelta(&sample, buf));
+    TEST_ASSERT_EQUAL_UINT8(2, encoder.encodeDelta(&sample, buf));
+}
+
+void test_log_survives_reboot_and_rotation(void)
+{
+    static SampleRecord appended[4000];
+    static SampleRecord decoded[4000];
+    SampleLog log(EEPROM_ADDRESS, 60);
+    TEST_ASSERT_TRUE(log.begin());
+    SampleRecord sample = {1700000000UL, 2150, 4500, 101325, 120000, channel_all};
+    uint16_t count = 0;
+    // Enough samples to go round the ring more than once
+    for (; count < 4000; count++)
+    {
+        nextSample(&sample, 60);
+        appended[count] = sample;
+        TEST_ASSERT_TRUE(log.append(&sample));
+        drain(&log);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, log.getFailedWrites());
+    TEST_ASSERT_EQUAL_UINT8(SampleLog::BLOCK_COUNT - 1, log.getBlockCount());
+
+    // After a reboot, the completed blocks hold the newest samples, in order
+    uint16_t pending = log.getPendingRecords();
+    uint16_t found = readBack(decoded, 4000);
+    TEST_ASSERT_GREATER_THAN(0, found);
+    for (uint16_t i = 0; i < found; i++)
+    {
+        checkDecoded(&appended[count - pending - found + i], &decoded[i]);
+    }
+}
+
+void test_flush_makes_partial_block_readable(void)
+{
+    SampleLog log(EEPROM_ADDRESS, 60);
+    log.begin();
+    drain(&log);
+    SampleRecord sample = {1700000000UL, 2150, 4500, 101325, 120000, channel_all};
+    SampleRecord appended[5];
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        nextSample(&sample, 60);
+        appended[i] = sample;
+        log.append(&sample);
+    }
+    TEST_ASSERT_TRUE(log.flush());
+    // Reads are refused until the queued chunks are in
+    uint8_t buf[32];
+    TEST_ASSERT_EQUAL_UINT8(0, log.readBytes(0, buf, 32));
+    drain(&log);
+    TEST_ASSERT_EQUAL_UINT8(32, log.readBytes(0, buf, 32));
+
+    SampleRecord decoded[5];
+    TEST_ASSERT_EQUAL_UINT16(5, readBack(decoded, 5));
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        checkDecoded(&appended[i], &decoded[i]);
+    }
+}
+
+void test_writes_never_wait(void)
+{
+    SampleLog log(EEPROM_ADDRESS, 60);
+    log.begin();
+    SampleRecord sample = {1700000000UL, 2150, 4500, 101325, 120000, channel_all};
+    uint32_t polls = 0;
+    uint32_t busyPolls = 0;
+    for (uint16_t i = 0; i < 300; i++)
+    {
+        nextSample(&sample, 60);
+        unsigned long before = hostMicros;
+        log.append(&sample);
+        // No call advances the clock: nothing waits for the write cycle
+        TEST_ASSERT_EQUAL_UINT32(before, hostMicros);
+        while (!log.isIdle())
+        {
+            uint32_t writes = eeprom->writes;
+            before = hostMicros;
+            log.poll();
+            TEST_ASSERT_EQUAL_UINT32(before, hostMicros);
+            // At most one chunk per call
+            TEST_ASSERT_LESS_OR_EQUAL(writes + 1, eeprom->writes);
+            busyPolls += eeprom->writes == writes ? 1 : 0;
+            polls++;
+            hostAdvanceMicros(500);
+        }
+    }
+    // Calls made during a write cycle found the EEPROM busy and returned
+    TEST_ASSERT_GREATER_THAN(0, busyPolls);
+    TEST_ASSERT_GREATER_THAN(0, eeprom->refused);
+    // A busy EEPROM is expected, not an error
+    TEST_ASSERT_EQUAL_UINT16(0, I2CBus::getErrors());
+    TEST_ASSERT_EQUAL_UINT16(0, log.getFailedWrites());
+}
+
+void test_missing_eeprom_is_counted(void)
+{
+    SampleLog log(EEPROM_ADDRESS, 60);
+    log.begin();
+    drain(&log);
+    eeprom->absent = true;
+    uint16_t errors = I2CBus::getErrors();
+
+    SampleRecord sample = {1700000000UL, 2150, 4500, 101325, 120000, channel_all};
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        nextSample(&sample, 60);
+        log.append(&sample);
+        unsigned long before = hostMicros;
+        log.poll();
+        TEST_ASSERT_EQUAL_UINT32(before, hostMicros);
+        hostAdvanceMicros(SampleLog::WRITE_TIMEOUT_MS * 1000UL);
+        log.poll();
+    }
+    // Failed transactions go to the bus error count, lost chunks to the log
+    TEST_ASSERT_GREATER_THAN(errors, I2CBus::getErrors());
+    TEST_ASSERT_GREATER_THAN(0, log.getFailedWrites());
+    uint8_t buf[32];
+    drain(&log);
+    TEST_ASSERT_EQUAL_UINT8(0, log.readBytes(0, buf, 32));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_codec_round_trip);
+    RUN_TEST(test_steady_signal_costs_two_bytes);
+    RUN_TEST(test_log_survives_reboot_and_rotation);
+    RUN_TEST(test_flush_makes_partial_block_readable);
+    RUN_TEST(test_writes_never_wait);
+    RUN_TEST(test_missing_eeprom_is_counted);
+    return UNITY_END();
+}
@@ -0,0 +1,267 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief Sample output on a port slower than the sample rate: policies, ordering, no waiting
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "txqueue.h"
+#include "sampleout.h"
+
+// Simulated time, in milliseconds, and sample interval: 100 lines/s against a 9600 baud port
+#define RUN_MS 8000UL
+#define SAMPLE_INTERVAL_MS 10
+// Bytes the port sends per millisecond (9600 baud, 10 bits per byte)
+#define PORT_BYTES_PER_MS 1
+#define QUEUE_SIZE 128
+
+static uint8_t queueBuffer[QUEUE_SIZE];
+static TxQueue *queue;
+static SampleOutput *output;
+
+typedef struct
+{
+    uint32_t submitted;
+    // Lines found in the port output
+    uint32_t lines;
+    // Samples represented by them (aggregates count their n)
+    uint32_t represented;
+} RunResult;
+
+// Temperature ramp: sample i is 20.00 °C + i centi-°C, so every line tells which samples it holds
+static int16_t temperatureOf(uint32_t i)
+{
+    return 2000 + (int16_t)i;
+}
+
+static RunResult run(SampleOutput::Policy policy)
+{
+    SampleOutput::policy = policy;
+    RunResult result = {0, 0, 0};
+    for (uint32_t ms = 0; ms < RUN_MS; ms++)
+    {
+        if (ms % SAMPLE_INTERVAL_MS == 0)
+        {
+            output->submit(temperatureOf(result.submitted), 45120, 101325);
+            result.submitted++;
+        }
+        output->poll();
+        queue->pump();
+        Serial.drain(PORT_BYTES_PER_MS);
+        hostAdvanceMillis(1);
+    }
+    // Let the link catch up, then what is held goes out
+    for (uint16_t ms = 0; ms < 2000; ms++)
+    {
+        output->poll();
+        queue->pump();
+        Serial.drain(PORT_BYTES_PER_MS);
+    }
+    return result;
+}
+
+// Parses the captured csv output; checks lines are whole and in sample order
+static void parse(RunResult *result)
+{
+    char *save = nullptr;
+    int32_t previous = -1;
+    for (char *line = strtok_r(Serial.output, "\n", &save); line != nullptr; line = strtok_r(nullptr, "\n", &save))
+    {
+        TEST_ASSERT_EQUAL_CHAR('\r', line[strlen(line) - 1]);
+        double t, h, minT, maxT;
+        unsigned long p, n;
+        int fields = sscanf(line, "%lf,%lf,%lu,%lf,%lf,%lu", &t, &h, &p, &minT, &maxT, &n);
+        TEST_ASSERT_TRUE(fields == 3 || fields == 6);
+        TEST_ASSERT_EQUAL_UINT32(101325, p);
+        int32_t first = (int32_t)lround((fields == 6 ? minT : t) * 100) - 2000;
+        int32_t last = (int32_t)lround((fields == 6 ? maxT : t) * 100) - 2000;
+        // Output never goes back in time
+        TEST_ASSERT_GREATER_THAN(previous, first);
+        if (fields == 6)
+        {
+            // An aggregate of a ramp: consecutive samples, the mean in the middle
+            TEST_ASSERT_EQUAL_UINT32(last - first + 1, n);
+            TEST_ASSERT_INT_WITHIN(1, 2000 + (first + last) / 2, (int32_t)lround(t * 100));
+            result->represented += n;
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_INT32(45120 / 10, (int32_t)lround(h * 100));
+            result->represented++;
+        }
+        previous = last;
+        result->lines++;
+    }
+}
+
+void setUp(void)
+{
+    Serial.reset();
+    Console::outputMode = Console::OutputMode::mode_csv;
+    queue = new TxQueue(&Serial, queueBuffer, QUEUE_SIZE);
+    output = new SampleOutput(queue);
+}
+
+void tearDown(void)
+{
+    delete output;
+    delete queue;
+}
+
+void test_fast_port_sends_everything(void)
+{
+    SampleOutput::policy = SampleOutput::Policy::policy_drop;
+    for (uint16_t i = 0; i < 100; i++)
+    {
+        output->submit(temperatureOf(i), 45120, 101325);
+        queue->pump();
+        Serial.drain(1000);
+    }
+    RunResult result = {100, 0, 0};
+    parse(&result);
+    TEST_ASSERT_EQUAL_UINT32(100, result.lines);
+    TEST_ASSERT_EQUAL_UINT32(0, output->getDropped());
+}
+
+void test_drop_policy(void)
+{
+    RunResult result = run(SampleOutput::Policy::policy_drop);
+    parse(&result);
+    // Every sample is either sent or counted as dropped
+    TEST_ASSERT_GREATER_THAN(0, output->getDropped());
+    TEST_ASSERT_EQUAL_UINT32(result.submitted, result.represented + output->getDropped());
+    // Nothing ever waited for the port
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+    TEST_ASSERT_LESS_OR_EQUAL(QUEUE_SIZE, queue->getHighWater());
+}
+
+void test_coalesce_policy(void)
+{
+    RunResult result = run(SampleOutput::Policy::policy_coalesce);
+    // The newest sample always makes it out, as the last line
+    char last[32];
+    snprintf(last, sizeof(last), "%d.%02d,45.12,101325\r\n", temperatureOf(result.submitted - 1) / 100,
+             temperatureOf(result.submitted - 1) % 100);
+    TEST_ASSERT_EQUAL_STRING(last, Serial.output + Serial.outputLength - strlen(last));
+    parse(&result);
+    // Replaced samples are counted
+    TEST_ASSERT_GREATER_THAN(0, output->getCoalesced());
+    TEST_ASSERT_EQUAL_UINT32(result.submitted, result.represented + output->getCoalesced());
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+}
+
+void test_aggregate_policy(void)
+{
+    RunResult result = run(SampleOutput::Policy::policy_aggregate);
+    parse(&result);
+    // No sample is lost: the aggregates hold all the samples that did not fit
+    TEST_ASSERT_EQUAL_UINT32(0, output->getDropped());
+    TEST_ASSERT_EQUAL_UINT32(result.submitted, result.represented);
+    TEST_ASSERT_GREATER_THAN(0, output->getAggregated());
+    // Fewer lines than samples: the port could not have carried one line per sample
+    TEST_ASSERT_LESS_THAN(result.submitted, result.lines);
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+
+    char message[96];
+    snprintf(message, sizeof(message), "%lu samples in %lu lines, %lu merged", (unsigned long)result.submitted,
+             (unsigned long)result.lines, (unsigned long)output->getAggregated());
+    TEST_MESSAGE(message);
+}
+
+void test_sparse_records_dropped_not_merged(void)
+{
+    Console::outputMode = Console::OutputMode::mode_sparse;
+    SampleRecord record = {1700000000UL, 2150, 4512, 101325, 120000, channel_temperature | channel_pressure};
+    uint32_t sent = 0;
+    for (uint16_t i = 0; i < 100; i++)
+    {
+        output->submitSparse(&record);
+        record.timestamp++;
+        queue->pump();
+        Serial.drain(10);
+    }
+    while (queue->getQueued() > 0)
+    {
+        queue->pump();
+        Serial.drain(10);
+    }
+    for (char *c = Serial.output; *c; c++)
+    {
+        sent += *c == '\n';
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, sent + output->getDropped());
+    TEST_ASSERT_GREATER_THAN(0, output->getDropped());
+    // Channels not measured are left empty
+    TEST_ASSERT_EQUAL_INT(0, strncmp(Serial.output, "1700000000,21.50,,101325,\r\n", 27));
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+}
+
+void test_queue_wraps(void)
+{
+    // Records that straddle the end of the ring come out intact
+    uint8_t record[50];
+    for (uint8_t i = 0; i < sizeof(record); i++)
+    {
+        record[i] = 'a' + i % 26;
+    }
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        TEST_ASSERT_TRUE(queue->tryWrite(record, sizeof(record)));
+        TEST_ASSERT_FALSE(queue->tryWrite(record, QUEUE_SIZE));
+        while (queue->getQueued() > 0)
+        {
+            queue->pump();
+            Serial.drain(7);
+        }
+    }
+    TEST_ASSERT_EQUAL_size_t(20 * sizeof(record), Serial.outputLength);
+    for (size_t i = 0; i < Serial.outputLength; i++)
+    {
+        TEST_ASSERT_EQUAL_CHAR(record[i % sizeof(record)], Serial.output[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, queue->getRejected());
+}
+
+void test_print_to_stalled_port(void)
+{
+    // A console reply longer than the queue (help is 462 bytes) to a port that takes nothing
+    char reply[481];
+    for (uint16_t i = 0; i < sizeof(reply) - 1; i++)
+    {
+        reply[i] = i % 60 == 59 ? '\n' : 'a' + i % 26;
+    }
+    reply[sizeof(reply) - 1] = '\0';
+    Serial.pending = SERIAL_TX_BUFFER_SIZE - 1;
+    // The write returns with what fits, the rest is counted
+    TEST_ASSERT_EQUAL_size_t(QUEUE_SIZE, queue->print(reply));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(reply) - 1 - QUEUE_SIZE, queue->getTruncated());
+    TEST_ASSERT_EQUAL_INT(0, queue->availableForWrite());
+    TEST_ASSERT_EQUAL_size_t(0, queue->print('x'));
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+
+    // Once the port takes bytes again, a write first makes room in its hardware buffer
+    Serial.drain(20);
+    TEST_ASSERT_EQUAL_size_t(20, queue->write((const uint8_t *)reply, 40));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(reply) - 1 - QUEUE_SIZE + 1 + 20, queue->getTruncated());
+    TEST_ASSERT_EQUAL_INT(0, strncmp(Serial.output, reply, 20));
+    TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fast_port_sends_everything);
+    RUN_TEST(test_drop_policy);
+    RUN_TEST(test_coalesce_policy);
+    RUN_TEST(test_aggregate_policy);
+    RUN_TEST(test_sparse_records_dropped_not_merged);
+    RUN_TEST(test_queue_wraps);
+    RUN_TEST(test_print_to_stalled_port);
+    return UNITY_END();
+}
@@ -0,0 +1,157 @@
+/**
+ * @file test_main.cpp
+ * @author Riccardo Iacob
+ * @brief SPSC queue stress test with a real producer thread and consumer thread
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <unity.h>
+#include <thread>
+#include <hoststub.h>
+#include <stdio.h>
+
+#include "spscqueue.h"
+#include "sample.h"
+
+// Elements passed through the queue per run
+#define STRESS_ITEMS 200000UL
+
+// Every field is derived from the sequence number, so a torn copy cannot go unnoticed
+static SampleRecord makeRecord(uint32_t sequence)
+{
+    SampleRecord record;
+    record.timestamp = sequence;
+    record.temperature = (int16_t)(sequence * 7);
+    record.humidity = (uint16_t)(sequence ^ 0xA5A5);
+    record.pressure = ~sequence;
+    record.gasResistance = sequence * 2654435761UL;
+    record.channels = (uint8_t)(sequence >> 3);
+    return record;
+}
+
+static bool isIntact(const SampleRecord &record)
+{
+    SampleRecord expected = makeRecord(record.timestamp);
+    return record.temperature == expected.temperature && record.humidity == expected.humidity &&
+           record.pressure == expected.pressure && record.gasResistance == expected.gasResistance &&
+           record.channels == expected.channels;
+}
+
+/**
+ * The producer retries refused elements, so the consumer must see 0, 1, 2, ... with nothing
+ * missing, repeated, reordered or torn
+ */
+template <uint8_t CAPACITY>
+static void stress(const char *name)
+{
+    static SpscQueue<SampleRecord, CAPACITY> queue;
+    uint32_t refused = 0;
+    uint32_t errors = 0;
+    uint32_t received = 0;
+
+    std::thread producer([&refused]() {
+        for (uint32_t i = 0; i < STRESS_ITEMS;)
+        {
+            if (queue.push(makeRecord(i)))
+            {
+                i++;
+            }
+            else
+            {
+                refused++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::thread consumer([&errors, &received]() {
+        SampleRecord record;
+        while (received < STRESS_ITEMS)
+        {
+            if (queue.pop(record))
+            {
+                if (record.timestamp != received || !isIntact(record))
+                {
+                    errors++;
+                }
+                received++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+            // size() is read from the other side while both run; it must stay in range
+            if (queue.size() > CAPACITY)
+            {
+                errors++;
+            }
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(STRESS_ITEMS, received);
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_TRUE(queue.empty());
+    // Every refusal is counted (the counter is 16 bits)
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)refused, queue.getOverruns());
+
+    char message[96];
+    snprintf(message, sizeof(message), "%s: %lu elements, %lu refused pushes", name, (unsigned long)received,
+             (unsigned long)refused);
+    TEST_MESSAGE(message);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_single_thread_semantics(void)
+{
+    SpscQueue<uint8_t, 4> queue;
+    uint8_t value;
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_FALSE(queue.pop(value));
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(9));
+    TEST_ASSERT_EQUAL_UINT16(1, queue.getOverruns());
+    TEST_ASSERT_EQUAL_UINT8(4, queue.size());
+    // The free-running indices wrap at 256 many times over
+    for (uint16_t i = 4; i < 2000; i++)
+    {
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)(i - 4), value);
+        TEST_ASSERT_TRUE(queue.push((uint8_t)i));
+        TEST_ASSERT_EQUAL_UINT8(4, queue.size());
+    }
+}
+
+void test_stress_capacity_2(void)
+{
+    // Almost every operation meets the other side at the boundary
+    stress<2>("capacity 2");
+}
+
+void test_stress_capacity_16(void)
+{
+    stress<16>("capacity 16");
+}
+
+void test_stress_capacity_128(void)
+{
+    stress<128>("capacity 128");
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_single_thread_semantics);
+    RUN_TEST(test_stress_capacity_2);
+    RUN_TEST(test_stress_capacity_16);
+    RUN_TEST(test_stress_capacity_128);
+    return UNITY_END();
+}
@@ -0,0 +1,289 @@
+/**
+ * @file histdl.cpp
+ * @author Riccardo Iacob
+ * @brief Host tool downloading the sample history over the Bluetooth serial link
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Build (Linux):
+ *   g++ -O2 -Isrc -o histdl tools/histdl.cpp src/tscodec.cpp
+ * Usage:
+ *   histdl <tty> [block] [raw output file]
+ * Decoded samples are printed as CSV (timestamp,temperature,humidity,pressure,gas) on stdout,
+ * with the fields of channels the record flags as not measured left empty.
+ * The tty can be the HC-05 rfcomm device or, for testing, one end of a pseudo-terminal pair.
+ * If the link drops, the sequence number of the block to resume from is printed; pass it as block
+ * to continue. Block numbers do not depend on the ring position, so resuming later is safe.
+ * The frame format is described in src/histxfer.h.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tscodec.h"
+
+static const uint8_t SYNC = 0x7E;
+static const uint8_t FRAME_DATA = 'D';
+static const uint8_t FRAME_END = 'E';
+static const uint8_t FRAME_ACK = 'A';
+static const uint8_t HEADER_SIZE = 4;
+static const int SILENCE_MS = 500;
+static const int GIVE_UP_MS = 10000;
+
+// Same CRC-16/CCITT as ConfigStore::crc16
+static uint16_t crc16(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static long nowMillis()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+static int openPort(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B38400);
+        cfsetospeed(&tio, B38400);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+static void sendAck(int fd, uint16_t seq)
+{
+    uint8_t frame[7] = {SYNC, FRAME_ACK, (uint8_t)seq, (uint8_t)(seq >> 8), 0, 0, 0};
+    uint16_t crc = 0xFFFF;
+    for (int i = 1; i < 5; i++)
+    {
+        crc = crc16(crc, frame[i]);
+    }
+    frame[5] = crc >> 8;
+    frame[6] = crc & 0xFF;
+    if (write(fd, frame, sizeof(frame)) != (ssize_t)sizeof(frame))
+    {
+        perror("write");
+    }
+}
+
+static void decodeBlock(const uint8_t *block, uint16_t length)
+{
+    if (length <= HEADER_SIZE)
+    {
+        return;
+    }
+    SeriesDecoder decoder;
+    SampleRecord sample;
+    uint8_t records = block[3];
+    uint16_t offset = HEADER_SIZE;
+    for (uint8_t i = 0; i < records; i++)
+    {
+        uint16_t n = (i == 0) ? decoder.decodeKeyframe(block + offset, length - offset, &sample)
+                              : decoder.decodeDelta(block + offset, length - offset, &sample);
+        if (n == 0)
+        {
+            fprintf(stderr, "malformed block\n");
+            return;
+        }
+        offset += n;
+        // Channels without a measured value (compiled out, gas burn-in) are left empty
+        printf("%lu,", (unsigned long)sample.timestamp);
+        if (sample.channels & channel_temperature)
+        {
+            printf("%d.%02d", sample.temperature / 100, abs(sample.temperature % 100));
+        }
+        putchar(',');
+        if (sample.channels & channel_humidity)
+        {
+            printf("%u.%02u", sample.humidity / 100, sample.humidity % 100);
+        }
+        putchar(',');
+        if (sample.channels & channel_pressure)
+        {
+            printf("%lu", (unsigned long)sample.pressure);
+        }
+        putchar(',');
+        if (sample.channels & channel_gas)
+        {
+            printf("%lu", (unsigned long)sample.gasResistance);
+        }
+        putchar('\n');
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <tty> [block] [raw output file]\n", argv[0]);
+        return 2;
+    }
+    int fd = openPort(argv[1]);
+    if (fd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    bool resume = argc > 2;
+    uint16_t expected = resume ? (uint16_t)strtoul(argv[2], nullptr, 10) : 0;
+    FILE *raw = argc > 3 ? fopen(argv[3], "ab") : nullptr;
+    unsigned received = 0;
+
+    char command[32];
+    int length = resume ? snprintf(command, sizeof(command), "\nexport %u\n", expected)
+                        : snprintf(command, sizeof(command), "\nexport\n");
+    if (write(fd, command, length) != length)
+    {
+        perror("write");
+        return 1;
+    }
+
+    // Frame reassembly buffer: header, up to 255 payload bytes, CRC
+    uint8_t frame[5 + 255 + 2];
+    size_t have = 0;
+    long lastFrame = nowMillis();
+    long lastAck = 0;
+    bool started = false;
+
+    for (;;)
+    {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, 100);
+        long now = nowMillis();
+
+        if (ready > 0)
+        {
+            ssize_t n = read(fd, frame + have, sizeof(frame) - have);
+            if (n < 0 && errno != EINTR && errno != EAGAIN)
+            {
+                // Link dropped (e.g. rfcomm disconnect)
+                break;
+            }
+            if (n > 0)
+            {
+                have += n;
+            }
+        }
+
+        // Parse every complete frame in the buffer
+        for (;;)
+        {
+            // Drop anything before SYNC (console text, line noise)
+            size_t start = 0;
+            while (start < have && frame[start] != SYNC)
+            {
+                start++;
+            }
+            memmove(frame, frame + start, have - start);
+            have -= start;
+            if (have < 5 || have < (size_t)frame[4] + 7)
+            {
+                break;
+            }
+            size_t total = frame[4] + 7;
+            uint16_t crc = 0xFFFF;
+            for (size_t i = 1; i < total - 2; i++)
+            {
+                crc = crc16(crc, frame[i]);
+            }
+            uint16_t seq = frame[2] | (frame[3] << 8);
+            bool valid = crc == ((frame[total - 2] << 8) | frame[total - 1]);
+            if (!valid)
+            {
+                // False SYNC or corrupted frame: skip the SYNC byte and rescan
+                memmove(frame, frame + 1, have - 1);
+                have--;
+                continue;
+            }
+
+            if (!started && (frame[1] == FRAME_DATA || frame[1] == FRAME_END))
+            {
+                // The first frame tells where the transfer starts: the oldest block, or where
+                // the resumed transfer stopped unless that block has been overwritten since
+                if (resume && seq != expected)
+                {
+                    fprintf(stderr, "%u blocks overwritten since the last transfer\n", (uint16_t)(seq - expected));
+                }
+                expected = seq;
+            }
+
+            if (frame[1] == FRAME_DATA && seq == expected)
+            {
+                if (raw != nullptr)
+                {
+                    fwrite(frame + 5, 1, frame[4], raw);
+                }
+                decodeBlock(frame + 5, frame[4]);
+                expected++;
+                received++;
+                sendAck(fd, expected);
+                lastAck = now;
+            }
+            else if (frame[1] == FRAME_END && seq == expected)
+            {
+                sendAck(fd, expected + 1);
+                fprintf(stderr, "done, %u blocks\n", received);
+                if (raw != nullptr)
+                {
+                    fclose(raw);
+                }
+                close(fd);
+                return 0;
+            }
+            else if (frame[1] == FRAME_DATA || frame[1] == FRAME_END)
+            {
+                // Out of order: repeat the cumulative acknowledgement
+                sendAck(fd, expected);
+                lastAck = now;
+            }
+            started = true;
+            lastFrame = now;
+            memmove(frame, frame + total, have - total);
+            have -= total;
+        }
+
+        if (now - lastFrame > GIVE_UP_MS)
+        {
+            break;
+        }
+        if (started && now - lastFrame > SILENCE_MS && now - lastAck > SILENCE_MS)
+        {
+            // Acknowledgement probably lost
+            sendAck(fd, expected);
+            lastAck = now;
+        }
+    }
+
+    fprintf(stderr, "link lost, resume with block %u\n", expected);
+    if (raw != nullptr)
+    {
+        fclose(raw);
+    }
+    close(fd);
+    return 1;
+}